@@ -142,6 +142,14 @@ ZMQ_EXPORT size_t zmq_msg_size (zmq_msg_t *msg);
 ZMQ_EXPORT void *zmq_init (int io_threads);
 ZMQ_EXPORT int zmq_term (void *context);
 
+/*  Context options.                                                          */
+#define ZMQ_MSG_POOL 1
+#define ZMQ_IO_URING 2
+#define ZMQ_RESOLVE_TTL 3
+
+ZMQ_EXPORT int zmq_ctx_set (void *context, int option, int optval);
+ZMQ_EXPORT int zmq_ctx_get (void *context, int option);
+
 /******************************************************************************/
 /*  0MQ socket definition.                                                    */
 /******************************************************************************/
@@ -185,11 +193,23 @@ ZMQ_EXPORT int zmq_term (void *context);
 #define ZMQ_RCVTIMEO 27
 #define ZMQ_SNDTIMEO 28
 #define ZMQ_RCVLABEL 29
+#define ZMQ_SPIN 30
+#define ZMQ_SNDHWM_BYTES 31
+#define ZMQ_RCVHWM_BYTES 32
+#define ZMQ_TOPIC_LENGTH 33
+#define ZMQ_TOPIC_DELIMITER 34
+#define ZMQ_CONFLATE 35
+#define ZMQ_LAST_VALUE 36
+#define ZMQ_BROADCAST 37
+#define ZMQ_EARLY_FILTER 38
+#define ZMQ_REUSEPORT 39
+#define ZMQ_MEMFD_THRESHOLD 40
 
 /*  Send/recv options.                                                        */
 #define ZMQ_DONTWAIT 1
 #define ZMQ_SNDMORE 2
 #define ZMQ_SNDLABEL 4
+#define ZMQ_NOFLUSH 8
 
 ZMQ_EXPORT void *zmq_socket (void *context, int type);
 ZMQ_EXPORT int zmq_close (void *s);
@@ -203,6 +223,9 @@ ZMQ_EXPORT int zmq_send (void *s, const void *buf, size_t len, int flags);
 ZMQ_EXPORT int zmq_recv (void *s, void *buf, size_t len, int flags);
 ZMQ_EXPORT int zmq_sendmsg (void *s, zmq_msg_t *msg, int flags);
 ZMQ_EXPORT int zmq_recvmsg (void *s, zmq_msg_t *msg, int flags);
+ZMQ_EXPORT int zmq_sendmmsg (void *s, zmq_msg_t *msgs, int count, int flags);
+ZMQ_EXPORT int zmq_recvmmsg (void *s, zmq_msg_t *msgs, int count, int flags);
+ZMQ_EXPORT int zmq_flush (void *s);
 
 /******************************************************************************/
 /*  I/O multiplexing.                                                         */
@@ -226,6 +249,34 @@ typedef struct
 
 ZMQ_EXPORT int zmq_poll (zmq_pollitem_t *items, int nitems, long timeout);
 
+/*  Persistent poller.                                                        */
+#if defined _WIN32
+typedef SOCKET zmq_fd_t;
+#else
+typedef int zmq_fd_t;
+#endif
+
+typedef struct
+{
+    void *socket;
+    zmq_fd_t fd;
+    void *user_data;
+    short events;
+} zmq_poller_event_t;
+
+ZMQ_EXPORT void *zmq_poller_new (void);
+ZMQ_EXPORT int zmq_poller_destroy (void *poller);
+ZMQ_EXPORT int zmq_poller_add (void *poller, void *s, void *user_data,
+    short events);
+ZMQ_EXPORT int zmq_poller_modify (void *poller, void *s, short events);
+ZMQ_EXPORT int zmq_poller_remove (void *poller, void *s);
+ZMQ_EXPORT int zmq_poller_add_fd (void *poller, zmq_fd_t fd, void *user_data,
+    short events);
+ZMQ_EXPORT int zmq_poller_modify_fd (void *poller, zmq_fd_t fd, short events);
+ZMQ_EXPORT int zmq_poller_remove_fd (void *poller, zmq_fd_t fd);
+ZMQ_EXPORT int zmq_poller_wait (void *poller, zmq_poller_event_t *events,
+    int n_events, long timeout);
+
 #undef ZMQ_EXPORT
 
 #ifdef __cplusplus
@@ -0,0 +1,122 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+#include <vector>
+
+#include "../src/identity_map.hpp"
+#include "../src/clock.hpp"
+
+//  Measures the cost of looking up the pipe to route a message to based
+//  on the peer identity, as done by ROUTER sockets, for different numbers
+//  of peers. The identity table is internal to the library, so the test
+//  is linked with the relevant sources directly. For comparison, the
+//  lookup in a std::map, as used previously, is measured as well.
+
+static void report (const char *name_, int count_, uint64_t elapsed_)
+{
+    if (!elapsed_)
+        elapsed_ = 1;
+    printf ("%s: %d [lookups/s]\n", name_,
+        (int) ((double) count_ * 1000000 / elapsed_));
+}
+
+static void run (int peer_count_, int lookup_count_)
+{
+    int i;
+    uint64_t start;
+
+    printf ("peer count: %d\n", peer_count_);
+
+    //  Generate the identities the same way as the library does for
+    //  anonymous peers, i.e. zero byte followed by 16 random bytes.
+    std::vector <zmq::blob_t> identities (peer_count_);
+    for (i = 0; i != peer_count_; i++) {
+        unsigned char identity [17];
+        identity [0] = 0;
+        for (int j = 1; j != 17; j++)
+            identity [j] = (unsigned char) rand ();
+        identities [i].assign (identity, 17);
+    }
+
+    //  The sequence of identities to route the messages to.
+    std::vector <int> targets (lookup_count_);
+    for (i = 0; i != lookup_count_; i++)
+        targets [i] = rand () % peer_count_;
+
+    zmq::identity_map_t <int> map;
+    for (i = 0; i != peer_count_; i++)
+        map.insert (identities [i], zmq::identity_map_t <int>::hash (
+            identities [i]), i);
+
+    int found = 0;
+    start = zmq::clock_t::now_us ();
+    for (i = 0; i != lookup_count_; i++) {
+        const zmq::blob_t &identity = identities [targets [i]];
+        int *value = map.find (identity.data (), identity.size (),
+            zmq::identity_map_t <int>::hash (identity.data (),
+            identity.size ()));
+        if (value && *value == targets [i])
+            found++;
+    }
+    report ("identity_map_t", lookup_count_, zmq::clock_t::now_us () - start);
+    if (found != lookup_count_) {
+        printf ("error: %d identities not found\n", lookup_count_ - found);
+        exit (1);
+    }
+
+    //  The message data are converted to blob_t for each lookup.
+    std::map <zmq::blob_t, int> tree;
+    for (i = 0; i != peer_count_; i++)
+        tree.insert (std::make_pair (identities [i], i));
+
+    found = 0;
+    start = zmq::clock_t::now_us ();
+    for (i = 0; i != lookup_count_; i++) {
+        const zmq::blob_t &identity = identities [targets [i]];
+        zmq::blob_t key (identity.data (), identity.size ());
+        std::map <zmq::blob_t, int>::iterator it = tree.find (key);
+        if (it != tree.end () && it->second == targets [i])
+            found++;
+    }
+    report ("std::map", lookup_count_, zmq::clock_t::now_us () - start);
+    if (found != lookup_count_) {
+        printf ("error: %d identities not found\n", lookup_count_ - found);
+        exit (1);
+    }
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc > 2) {
+        printf ("usage: identity_thr [lookup-count]\n");
+        return 1;
+    }
+    int lookup_count = argc == 2 ? atoi (argv [1]) : 1000000;
+    srand (0);
+
+    run (1000, lookup_count);
+    run (10000, lookup_count);
+    run (100000, lookup_count);
+
+    return 0;
+}
@@ -36,6 +36,7 @@
 
 static size_t message_size;
 static int roundtrip_count;
+static int spin;
 
 #if defined ZMQ_HAVE_WINDOWS
 static unsigned int __stdcall worker (void *ctx_)
@@ -54,6 +55,12 @@ static void *worker (void *ctx_)
         exit (1);
     }
 
+    rc = zmq_setsockopt (s, ZMQ_SPIN, &spin, sizeof (spin));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
     rc = zmq_connect (s, "inproc://lat_test");
     if (rc != 0) {
         printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
@@ -114,13 +121,15 @@ int main (int argc, char *argv [])
     unsigned long elapsed;
     double latency;
 
-    if (argc != 3) {
-        printf ("usage: inproc_lat <message-size> <roundtrip-count>\n");
+    if (argc != 3 && argc != 4) {
+        printf ("usage: inproc_lat <message-size> <roundtrip-count> "
+            "[spin]\n");
         return 1;
     }
 
     message_size = atoi (argv [1]);
     roundtrip_count = atoi (argv [2]);
+    spin = argc == 4 ? atoi (argv [3]) : 0;
 
     ctx = zmq_init (1);
     if (!ctx) {
@@ -134,6 +143,12 @@ int main (int argc, char *argv [])
         return -1;
     }
 
+    rc = zmq_setsockopt (s, ZMQ_SPIN, &spin, sizeof (spin));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
     rc = zmq_bind (s, "inproc://lat_test");
     if (rc != 0) {
         printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
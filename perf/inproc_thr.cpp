@@ -36,6 +36,7 @@
 
 static int message_count;
 static size_t message_size;
+static int batch_size;
 
 #if defined ZMQ_HAVE_WINDOWS
 static unsigned int __stdcall worker (void *ctx_)
@@ -46,7 +47,16 @@ static void *worker (void *ctx_)
     void *s;
     int rc;
     int i;
-    zmq_msg_t msg;
+    int j;
+    int count;
+    int sent;
+    zmq_msg_t *msgs;
+
+    msgs = (zmq_msg_t*) malloc (sizeof (zmq_msg_t) * batch_size);
+    if (!msgs) {
+        printf ("error in malloc\n");
+        exit (1);
+    }
 
     s = zmq_socket (ctx_, ZMQ_PUSH);
     if (!s) {
@@ -60,29 +70,52 @@ static void *worker (void *ctx_)
         exit (1);
     }
 
-    for (i = 0; i != message_count; i++) {
+    for (i = 0; i != message_count; i += count) {
 
-        rc = zmq_msg_init_size (&msg, message_size);
-        if (rc != 0) {
-            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
-            exit (1);
-        }
+        count = message_count - i < batch_size ? message_count - i :
+            batch_size;
+
+        for (j = 0; j != count; j++) {
+            rc = zmq_msg_init_size (&msgs [j], message_size);
+            if (rc != 0) {
+                printf ("error in zmq_msg_init_size: %s\n",
+                    zmq_strerror (errno));
+                exit (1);
+            }
 #if defined ZMQ_MAKE_VALGRIND_HAPPY
-        memset (zmq_msg_data (&msg), 0, message_size);
+            memset (zmq_msg_data (&msgs [j]), 0, message_size);
 #endif
+        }
 
-        rc = zmq_sendmsg (s, &msg, 0);
-        if (rc < 0) {
-            printf ("error in zmq_sendmsg: %s\n", zmq_strerror (errno));
-            exit (1);
+        if (batch_size == 1) {
+            rc = zmq_sendmsg (s, &msgs [0], 0);
+            if (rc < 0) {
+                printf ("error in zmq_sendmsg: %s\n", zmq_strerror (errno));
+                exit (1);
+            }
         }
-        rc = zmq_msg_close (&msg);
-        if (rc != 0) {
-            printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
-            exit (1);
+        else {
+            for (sent = 0; sent != count; sent += rc) {
+                rc = zmq_sendmmsg (s, msgs + sent, count - sent, 0);
+                if (rc < 0) {
+                    printf ("error in zmq_sendmmsg: %s\n",
+                        zmq_strerror (errno));
+                    exit (1);
+                }
+            }
+        }
+
+        for (j = 0; j != count; j++) {
+            rc = zmq_msg_close (&msgs [j]);
+            if (rc != 0) {
+                printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+                exit (1);
+            }
         }
     }
 
+    free (msgs);
+
     rc = zmq_close (s);
     if (rc != 0) {
         printf ("error in zmq_close: %s\n", zmq_strerror (errno));
@@ -107,19 +140,40 @@ int main (int argc, char *argv [])
     void *s;
     int rc;
     int i;
+    int j;
     zmq_msg_t msg;
+    zmq_msg_t *msgs;
     void *watch;
     unsigned long elapsed;
     unsigned long throughput;
     double megabits;
+    int msg_pool;
 
-    if (argc != 3) {
-        printf ("usage: thread_thr <message-size> <message-count>\n");
+    if (argc < 3 || argc > 5) {
+        printf ("usage: thread_thr <message-size> <message-count> "
+            "[msg-pool] [batch-size]\n");
         return 1;
     }
 
     message_size = atoi (argv [1]);
     message_count = atoi (argv [2]);
+    msg_pool = argc >= 4 ? atoi (argv [3]) : 0;
+    batch_size = argc == 5 ? atoi (argv [4]) : 1;
+    if (batch_size < 1)
+        batch_size = 1;
+
+    msgs = (zmq_msg_t*) malloc (sizeof (zmq_msg_t) * batch_size);
+    if (!msgs) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+    for (j = 0; j != batch_size; j++) {
+        rc = zmq_msg_init (&msgs [j]);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
 
     ctx = zmq_init (1);
     if (!ctx) {
@@ -127,6 +181,14 @@ int main (int argc, char *argv [])
         return -1;
     }
 
+    if (msg_pool) {
+        rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 1);
+        if (rc != 0) {
+            printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
     s = zmq_socket (ctx, ZMQ_PULL);
     if (!s) {
         printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
@@ -175,15 +237,33 @@ int main (int argc, char *argv [])
 
     watch = zmq_stopwatch_start ();
 
-    for (i = 0; i != message_count - 1; i++) {
-        rc = zmq_recvmsg (s, &msg, 0);
-        if (rc < 0) {
-            printf ("error in zmq_recvmsg: %s\n", zmq_strerror (errno));
-            return -1;
+    if (batch_size == 1) {
+        for (i = 0; i != message_count - 1; i++) {
+            rc = zmq_recvmsg (s, &msg, 0);
+            if (rc < 0) {
+                printf ("error in zmq_recvmsg: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+            if (zmq_msg_size (&msg) != message_size) {
+                printf ("message of incorrect size received\n");
+                return -1;
+            }
         }
-        if (zmq_msg_size (&msg) != message_size) {
-            printf ("message of incorrect size received\n");
-            return -1;
+    }
+    else {
+        for (i = 0; i != message_count - 1; i += rc) {
+            rc = zmq_recvmmsg (s, msgs, message_count - 1 - i < batch_size ?
+                message_count - 1 - i : batch_size, 0);
+            if (rc < 0) {
+                printf ("error in zmq_recvmmsg: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+            for (j = 0; j != rc; j++) {
+                if (zmq_msg_size (&msgs [j]) != message_size) {
+                    printf ("message of incorrect size received\n");
+                    return -1;
+                }
+            }
         }
     }
 
@@ -197,6 +277,15 @@ int main (int argc, char *argv [])
         return -1;
     }
 
+    for (j = 0; j != batch_size; j++) {
+        rc = zmq_msg_close (&msgs [j]);
+        if (rc != 0) {
+            printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+    free (msgs);
+
 #if defined ZMQ_HAVE_WINDOWS
     DWORD rc2 = WaitForSingleObject (local_thread, INFINITE);
     if (rc2 == WAIT_FAILED) {
@@ -37,14 +37,17 @@ int main (int argc, char *argv [])
     unsigned long elapsed;
     unsigned long throughput;
     double megabits;
+    int msg_pool;
 
-    if (argc != 4) {
-        printf ("usage: local_thr <bind-to> <message-size> <message-count>\n");
+    if (argc != 4 && argc != 5) {
+        printf ("usage: local_thr <bind-to> <message-size> <message-count> "
+            "[msg-pool]\n");
         return 1;
     }
     bind_to = argv [1];
     message_size = atoi (argv [2]);
     message_count = atoi (argv [3]);
+    msg_pool = argc == 5 ? atoi (argv [4]) : 0;
 
     ctx = zmq_init (1);
     if (!ctx) {
@@ -52,6 +55,14 @@ int main (int argc, char *argv [])
         return -1;
     }
 
+    if (msg_pool) {
+        rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 1);
+        if (rc != 0) {
+            printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
     s = zmq_socket (ctx, ZMQ_PULL);
     if (!s) {
         printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
@@ -0,0 +1,93 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../src/mailbox.hpp"
+#include "../src/thread.hpp"
+#include "../src/clock.hpp"
+
+//  Measures throughput of the command mailbox with several threads sending
+//  commands to a single receiver, the way application threads send commands
+//  to an I/O thread. The mailbox is internal to the library, so the test is
+//  linked with the relevant sources directly.
+
+static zmq::mailbox_t *mailbox;
+static int command_count;
+
+static void sender (void *arg_)
+{
+    zmq::command_t cmd;
+    cmd.destination = NULL;
+    cmd.type = zmq::command_t::activate_read;
+    for (int i = 0; i != command_count; i++)
+        mailbox->send (cmd);
+}
+
+int main (int argc, char *argv [])
+{
+    int sender_count;
+    uint64_t start;
+    uint64_t elapsed;
+    int total;
+    int i;
+
+    if (argc != 3) {
+        printf ("usage: mailbox_thr <sender-count> <command-count>\n");
+        return 1;
+    }
+    sender_count = atoi (argv [1]);
+    command_count = atoi (argv [2]);
+    total = sender_count * command_count;
+
+    mailbox = new zmq::mailbox_t;
+    std::vector <zmq::thread_t> senders (sender_count);
+
+    start = zmq::clock_t::now_us ();
+    for (i = 0; i != sender_count; i++)
+        senders [i].start (sender, NULL);
+
+    for (i = 0; i != total; i++) {
+        zmq::command_t cmd;
+        int rc = mailbox->recv (&cmd, -1);
+        if (rc != 0 || cmd.type != zmq::command_t::activate_read) {
+            printf ("error in mailbox_t::recv\n");
+            return 1;
+        }
+    }
+    elapsed = zmq::clock_t::now_us () - start;
+
+    for (i = 0; i != sender_count; i++)
+        senders [i].stop ();
+
+    if (!elapsed)
+        elapsed = 1;
+    printf ("sender count: %d\n", sender_count);
+    printf ("command count: %d\n", total);
+    printf ("mean throughput: %d [commands/s]\n",
+        (int) ((double) total * 1000000 / elapsed));
+    printf ("wakeups: %d\n", (int) mailbox->get_wakeups ());
+    printf ("stalls: %d\n", (int) mailbox->get_stalls ());
+
+    delete mailbox;
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+#if defined __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "../src/mtrie.hpp"
+#include "../src/clock.hpp"
+
+//  Measures the memory used by the subscription trie of XPUB sockets and
+//  the latency of matching a message against it. The trie is internal to
+//  the library, so the test is linked with the relevant sources directly.
+//  The pipes are never dereferenced by the trie, thus fake pointers are
+//  used instead of actual pipes.
+
+static size_t heap_size ()
+{
+#if defined __GLIBC__ && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2 ();
+    return info.uordblks + info.hblkhd;
+#elif defined __GLIBC__
+    struct mallinfo info = mallinfo ();
+    return (size_t) (unsigned int) info.uordblks +
+        (size_t) (unsigned int) info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+static void count_pipe (zmq::pipe_t *pipe_, void *arg_)
+{
+    (*(int*) arg_)++;
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc > 4) {
+        printf ("usage: mtrie_thr [subscriber-count] [topic-count] "
+            "[match-count]\n");
+        return 1;
+    }
+    int subscriber_count = argc > 1 ? atoi (argv [1]) : 2000;
+    int topic_count = argc > 2 ? atoi (argv [2]) : 100000;
+    int match_count = argc > 3 ? atoi (argv [3]) : 1000000;
+    int i;
+    srand (0);
+
+    //  Generate topics with long common prefixes, as seen with hierarchical
+    //  naming schemes, e.g. "market.data.equities.NASDAQ.000123.trades".
+    const char *classes [] = {"equities", "options", "futures", "bonds"};
+    const char *venues [] = {"NASDAQ", "NYSE", "ARCA", "BATS", "LSE", "XETRA"};
+    const char *kinds [] = {"trades", "quotes", "depth"};
+    std::vector <std::string> topics (topic_count);
+    for (i = 0; i != topic_count; i++) {
+        char topic [128];
+        sprintf (topic, "market.data.%s.%s.%06d.%s", classes [rand () % 4],
+            venues [rand () % 6], rand () % 1000000, kinds [rand () % 3]);
+        topics [i] = topic;
+    }
+
+    //  Each topic is subscribed to by one to three subscribers.
+    size_t heap_before = heap_size ();
+    zmq::mtrie_t *trie = new zmq::mtrie_t;
+    uint64_t start = zmq::clock_t::now_us ();
+    int subscriptions = 0;
+    for (i = 0; i != topic_count; i++) {
+        int count = 1 + rand () % 3;
+        for (int j = 0; j != count; j++) {
+            zmq::pipe_t *pipe = (zmq::pipe_t*) (size_t)
+                (8 * (1 + rand () % subscriber_count));
+            trie->add ((unsigned char*) topics [i].data (), topics [i].size (),
+                pipe);
+            subscriptions++;
+        }
+    }
+    uint64_t elapsed = zmq::clock_t::now_us () - start;
+    size_t memory = heap_size () - heap_before;
+
+    printf ("subscribers: %d\n", subscriber_count);
+    printf ("topics: %d\n", topic_count);
+    printf ("subscriptions: %d\n", subscriptions);
+    printf ("insertion time: %.3f [us/subscription]\n",
+        (double) elapsed / subscriptions);
+#if defined __GLIBC__
+    printf ("memory used: %.1f [MB]\n", (double) memory / (1024 * 1024));
+    printf ("memory used: %.1f [B/topic]\n", (double) memory / topic_count);
+#endif
+
+    //  Match messages published on the subscribed topics.
+    std::vector <int> targets (match_count);
+    for (i = 0; i != match_count; i++)
+        targets [i] = rand () % topic_count;
+    int matched = 0;
+    start = zmq::clock_t::now_us ();
+    for (i = 0; i != match_count; i++) {
+        const std::string &topic = topics [targets [i]];
+        trie->match ((unsigned char*) topic.data (), topic.size (),
+            count_pipe, &matched);
+    }
+    elapsed = zmq::clock_t::now_us () - start;
+    if (matched < match_count) {
+        printf ("error: %d messages not matched\n", match_count - matched);
+        return 1;
+    }
+    printf ("match latency: %.3f [us]\n", (double) elapsed / match_count);
+
+    delete trie;
+    return 0;
+}
@@ -34,15 +34,17 @@ int main (int argc, char *argv [])
     int rc;
     int i;
     zmq_msg_t msg;
+    int msg_pool;
 
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
         printf ("usage: remote_thr <connect-to> <message-size> "
-            "<message-count>\n");
+            "<message-count> [msg-pool]\n");
         return 1;
     }
     connect_to = argv [1];
     message_size = atoi (argv [2]);
     message_count = atoi (argv [3]);
+    msg_pool = argc == 5 ? atoi (argv [4]) : 0;
 
     ctx = zmq_init (1);
     if (!ctx) {
@@ -50,6 +52,14 @@ int main (int argc, char *argv [])
         return -1;
     }
 
+    if (msg_pool) {
+        rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 1);
+        if (rc != 0) {
+            printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
     s = zmq_socket (ctx, ZMQ_PUSH);
     if (!s) {
         printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
@@ -0,0 +1,126 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+#include "../src/poller_base.hpp"
+#include "../src/i_poll_events.hpp"
+#include "../src/clock.hpp"
+
+//  Measures the cost of adding, cancelling and executing timers in the
+//  I/O thread's timer store. The timer store is internal to the library,
+//  so the test is linked with the relevant sources directly.
+
+class poller_t : public zmq::poller_base_t
+{
+public:
+
+    uint64_t execute ()
+    {
+        return execute_timers ();
+    }
+};
+
+class sink_t : public zmq::i_poll_events
+{
+public:
+
+    sink_t () :
+        fired (0)
+    {
+    }
+
+    void in_event ()
+    {
+    }
+
+    void out_event ()
+    {
+    }
+
+    void timer_event (int id_)
+    {
+        fired++;
+    }
+
+    int fired;
+};
+
+static void report (const char *name_, int count_, uint64_t elapsed_)
+{
+    if (!elapsed_)
+        elapsed_ = 1;
+    printf ("%s: %d [timers/s]\n", name_,
+        (int) ((double) count_ * 1000000 / elapsed_));
+}
+
+int main (int argc, char *argv [])
+{
+    int timer_count;
+    poller_t poller;
+    sink_t sink;
+    std::vector <zmq::poller_base_t::timer_handle_t> handles;
+    uint64_t start;
+    int i;
+
+    if (argc > 2) {
+        printf ("usage: timer_thr [timer-count]\n");
+        return 1;
+    }
+    timer_count = argc == 2 ? atoi (argv [1]) : 100000;
+    handles.resize (timer_count);
+    srand (0);
+
+    printf ("timer count: %d\n", timer_count);
+
+    //  Timeouts of up to one hour, as used for reconnection and lingering.
+    start = zmq::clock_t::now_us ();
+    for (i = 0; i != timer_count; i++)
+        handles [i] = poller.add_timer (1 + rand () % 3600000, &sink, i);
+    report ("add", timer_count, zmq::clock_t::now_us () - start);
+
+    //  Cancel the timers in random order.
+    for (i = timer_count - 1; i > 0; i--)
+        std::swap (handles [i], handles [rand () % (i + 1)]);
+    start = zmq::clock_t::now_us ();
+    for (i = 0; i != timer_count; i++)
+        poller.cancel_timer (handles [i]);
+    report ("cancel", timer_count, zmq::clock_t::now_us () - start);
+
+    //  Add timers expiring within the next 100 milliseconds, let them all
+    //  expire and execute them in one go.
+    for (i = 0; i != timer_count; i++)
+        poller.add_timer (rand () % 100, &sink, i);
+    start = zmq::clock_t::now_us ();
+    while (zmq::clock_t::now_us () - start < 110000)
+        ;
+    start = zmq::clock_t::now_us ();
+    poller.execute ();
+    report ("execute", timer_count, zmq::clock_t::now_us () - start);
+    if (sink.fired != timer_count) {
+        printf ("error: %d timers executed\n", sink.fired);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <string>
+
+#if defined __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "../src/trie.hpp"
+#include "../src/clock.hpp"
+
+//  Measures the memory used by the subscription trie of SUB sockets and
+//  the cost of filtering a message against it. The trie is internal to
+//  the library, so the test is linked with the relevant sources directly.
+
+static size_t heap_size ()
+{
+#if defined __GLIBC__ && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2 ();
+    return info.uordblks + info.hblkhd;
+#elif defined __GLIBC__
+    struct mallinfo info = mallinfo ();
+    return (size_t) (unsigned int) info.uordblks +
+        (size_t) (unsigned int) info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc > 3) {
+        printf ("usage: trie_thr [subscription-count] [message-count]\n");
+        return 1;
+    }
+    int subscription_count = argc > 1 ? atoi (argv [1]) : 100000;
+    int message_count = argc > 2 ? atoi (argv [2]) : 1000000;
+    int i;
+    srand (0);
+
+    //  Generate topics with long common prefixes, as seen with hierarchical
+    //  naming schemes, e.g. "market.data.equities.NASDAQ.000123.trades".
+    const char *classes [] = {"equities", "options", "futures", "bonds"};
+    const char *venues [] = {"NASDAQ", "NYSE", "ARCA", "BATS", "LSE", "XETRA"};
+    const char *kinds [] = {"trades", "quotes", "depth"};
+    std::vector <std::string> topics (subscription_count * 2);
+    for (i = 0; i != subscription_count * 2; i++) {
+        char topic [128];
+        sprintf (topic, "market.data.%s.%s.%06d.%s", classes [rand () % 4],
+            venues [rand () % 6], rand () % 1000000, kinds [rand () % 3]);
+        topics [i] = topic;
+    }
+
+    //  Subscribe to the first half of the topics.
+    size_t heap_before = heap_size ();
+    zmq::trie_t *trie = new zmq::trie_t;
+    uint64_t start = zmq::clock_t::now_us ();
+    for (i = 0; i != subscription_count; i++)
+        trie->add ((unsigned char*) topics [i].data (), topics [i].size ());
+    uint64_t elapsed = zmq::clock_t::now_us () - start;
+
+    printf ("subscriptions: %d\n", subscription_count);
+    printf ("insertion time: %.3f [us/subscription]\n",
+        (double) elapsed / subscription_count);
+    printf ("memory used by the trie: %.1f [MB]\n",
+        (double) trie->get_memory () / (1024 * 1024));
+#if defined __GLIBC__
+    printf ("memory allocated: %.1f [MB]\n",
+        (double) (heap_size () - heap_before) / (1024 * 1024));
+#endif
+
+    //  Filter messages, half of them matching a subscription and half
+    //  of them not.
+    std::vector <int> messages (message_count);
+    for (i = 0; i != message_count; i++)
+        messages [i] = rand () % (subscription_count * 2);
+    int matched = 0;
+    start = zmq::clock_t::now_us ();
+    for (i = 0; i != message_count; i++) {
+        const std::string &topic = topics [messages [i]];
+        if (trie->check ((unsigned char*) topic.data (), topic.size ()))
+            matched++;
+    }
+    elapsed = zmq::clock_t::now_us () - start;
+    printf ("messages matched: %d of %d\n", matched, message_count);
+    printf ("filter latency: %.3f [us]\n", (double) elapsed / message_count);
+
+    delete trie;
+    return 0;
+}
@@ -128,11 +128,74 @@ namespace zmq
 #endif
         }
 
+        //  Compare and swap. Sets the counter to val_ if it is equal
+        //  to cmp_. Returns the original value in any case.
+        inline integer_t cas (integer_t cmp_, integer_t val_)
+        {
+#if defined ZMQ_ATOMIC_COUNTER_WINDOWS
+            return (integer_t) InterlockedCompareExchange ((LONG*) &value,
+                (LONG) val_, (LONG) cmp_);
+#elif defined ZMQ_ATOMIC_COUNTER_ATOMIC_H
+            return atomic_cas_32 (&value, cmp_, val_);
+#elif defined ZMQ_ATOMIC_COUNTER_X86
+            integer_t old;
+            __asm__ volatile (
+                "lock; cmpxchg %2, %3"
+                : "=a" (old), "=m" (value)
+                : "r" (val_), "m" (value), "0" (cmp_)
+                : "cc", "memory");
+            return old;
+#elif defined ZMQ_ATOMIC_COUNTER_MUTEX
+            sync.lock ();
+            integer_t old = value;
+            if (value == cmp_)
+                value = val_;
+            sync.unlock ();
+            return old;
+#else
+#error atomic_counter is not implemented for this platform
+#endif
+        }
+
         inline integer_t get ()
         {
             return value;
         }
 
+        //  Read the value of the counter. Subsequent memory accesses are not
+        //  reordered before the read, i.e. the data written before the value
+        //  was set by another thread are visible once the value is seen.
+        inline integer_t load ()
+        {
+#if defined ZMQ_ATOMIC_COUNTER_WINDOWS
+            integer_t result = value;
+            _ReadWriteBarrier ();
+            return result;
+#elif defined ZMQ_ATOMIC_COUNTER_ATOMIC_H
+            integer_t result = value;
+            membar_consumer ();
+            return result;
+#elif defined ZMQ_ATOMIC_COUNTER_X86
+            integer_t result = value;
+            __asm__ volatile ("" : : : "memory");
+            return result;
+#elif defined ZMQ_ATOMIC_COUNTER_MUTEX
+            sync.lock ();
+            integer_t result = value;
+            sync.unlock ();
+            return result;
+#else
+#error atomic_counter is not implemented for this platform
+#endif
+        }
+
+        //  Address of the value. Allows to wait for the value to change
+        //  using OS primitives such as futex.
+        inline volatile integer_t *address ()
+        {
+            return &value;
+        }
+
     private:
 
         volatile integer_t value;
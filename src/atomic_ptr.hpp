@@ -71,6 +71,32 @@ namespace zmq
             this->ptr = ptr_;
         }
 
+        //  Read the value of the pointer. Accesses to the memory the pointer
+        //  refers to are not reordered before the read.
+        inline T *load ()
+        {
+#if defined ZMQ_ATOMIC_PTR_WINDOWS
+            T *result = (T*) ptr;
+            _ReadWriteBarrier ();
+            return result;
+#elif defined ZMQ_ATOMIC_PTR_ATOMIC_H
+            T *result = (T*) ptr;
+            membar_consumer ();
+            return result;
+#elif defined ZMQ_ATOMIC_PTR_X86
+            T *result = (T*) ptr;
+            __asm__ volatile ("" : : : "memory");
+            return result;
+#elif defined ZMQ_ATOMIC_PTR_MUTEX
+            sync.lock ();
+            T *result = (T*) ptr;
+            sync.unlock ();
+            return result;
+#else
+#error atomic_ptr is not implemented for this platform
+#endif
+        }
+
         //  Perform atomic 'exchange pointers' operation. Pointer is set
         //  to the 'val' value. Old value is returned.
         inline T *xchg (T *val_)
@@ -50,7 +50,8 @@ namespace zmq
             term_ack,
             reap,
             reaped,
-            done
+            done,
+            resolved
         } type;
 
         union {
@@ -91,9 +92,10 @@ namespace zmq
             } activate_read;
 
             //  Sent by pipe reader to inform pipe writer about how many
-            //  messages it has read so far.
+            //  messages and bytes it has read so far.
             struct {
                 uint64_t msgs_read;
+                uint64_t bytes_read;
             } activate_write;
 
             //  Sent by pipe reader to writer after creating a new inpipe.
@@ -143,6 +145,13 @@ namespace zmq
             struct {
             } done;
 
+            //  Sent by the resolver thread to the object that requested
+            //  the host name lookup once the lookup is done. The error is
+            //  zero if the lookup was successful, errno value otherwise.
+            struct {
+                int error;
+            } resolved;
+
         } args;
     };
 
@@ -36,9 +36,18 @@ namespace zmq
         //  memory allocation by approximately 99.6%
         message_pipe_granularity = 256,
 
+        //  Maximum number of messages the reader takes from the message pipe
+        //  in one go. The messages are then passed to the user one by one.
+        message_pipe_prefetch = 32,
+
         //  Commands in pipe per allocation event.
         command_pipe_granularity = 16,
 
+        //  Maximum number of nodes the command mailbox's receiver collects
+        //  before passing them back to the senders for reuse. Nodes beyond
+        //  this limit are deallocated.
+        command_node_cache = 64,
+
         //  Determines how often does socket poll for new commands when it
         //  still has unprocessed messages to handle. Thus, if it is set to 100,
         //  socket will process 100 inbound messages before doing the poll.
@@ -53,18 +62,53 @@ namespace zmq
         //  unnecessary network stack traversals.
         in_batch_size = 8192,
 
+        //  When this many bytes of a message body remain to be received,
+        //  they are read directly into the message rather than being copied
+        //  from the batch buffer.
+        in_batch_zero_copy = 1024,
+
         //  Maximal batching size for engines with sending functionality.
         //  So, if there are 10 messages that fit into the batch size, all of
         //  them may be written by a single 'send' system call, thus avoiding
         //  unnecessary network stack traversals.
         out_batch_size = 8192,
 
+        //  When sending vectored batches, message bodies of this size or
+        //  larger are passed to the kernel directly from the message rather
+        //  than being copied to the batch buffer.
+        out_batch_zero_copy = 1024,
+
+        //  Maximal number of chunks in a single vectored batch.
+        out_batch_max_iov = 64,
+
         //  Maximal delta between high and low watermark.
         max_wm_delta = 1024,
 
         //  Maximum number of events the I/O thread can process in one go.
         max_io_events = 256,
 
+        //  Sizes of the submission and completion queues of the io_uring
+        //  instance used by the I/O thread. There's one poll request in
+        //  flight per file descriptor, so the completion queue has to be
+        //  considerably larger.
+        io_uring_sq_entries = 256,
+        io_uring_cq_entries = 4096,
+
+        //  Size of the shared memory ring passing messages in each direction
+        //  of a shm connection. Must be a power of two.
+        shm_ring_size = 262144,
+
+        //  Messages of this size or larger are passed to the shm peer via
+        //  slots of the shared memory segment, so that the receiver doesn't
+        //  have to copy them. Number and size of the slots per direction.
+        shm_slot_min = 8192,
+        shm_slot_count = 8,
+        shm_slot_size = 1048576,
+
+        //  Default time (in milliseconds) the resolved host names are
+        //  cached for.
+        resolve_ttl = 60000,
+
         //  Maximal delay to process command in API thread (in CPU ticks).
         //  3,000,000 ticks equals to 1 - 2 milliseconds on current CPUs.
         //  Note that delay is only applied when there is continuous stream of
@@ -79,7 +123,24 @@ namespace zmq
         clock_precision = 1000000,
 
         //  Maximum transport data unit size for PGM (TPDU).
-        pgm_max_tpdu = 1500
+        pgm_max_tpdu = 1500,
+
+        //  Largest message content block (in bytes) served by the message
+        //  pool. Bigger blocks are allocated directly from the heap.
+        msg_pool_max_block = 65536,
+
+        //  Amount of memory (in bytes) moved between a thread's message pool
+        //  cache and the shared depot in one go. A thread caches up to two
+        //  such batches per size class.
+        msg_pool_batch_bytes = 65536,
+
+        //  Maximal number of batches kept in the shared depot per size class.
+        //  Surplus blocks are returned to the heap.
+        msg_pool_max_batches = 64,
+
+        //  Number of messages held by the ring shared by inproc subscribers
+        //  when there's no high water mark. Rounded up to a power of two.
+        default_ring_size = 1024
     };
 
 }
@@ -0,0 +1,180 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+#include <string.h>
+#include <algorithm>
+
+#include "conflate_pipe.hpp"
+#include "err.hpp"
+
+zmq::conflate_pipe_t::conflate_pipe_t (int topic_length_,
+      int topic_delimiter_) :
+    topic_length (topic_length_),
+    topic_delimiter (topic_delimiter_),
+    current (NULL),
+    current_pos (0),
+    unflushed (false),
+    asleep (false)
+{
+}
+
+zmq::conflate_pipe_t::~conflate_pipe_t ()
+{
+    if (current) {
+        current->parts.erase (current->parts.begin (),
+            current->parts.begin () + current_pos);
+        close_parts (current->parts);
+        delete current;
+    }
+    while (!queue.empty ()) {
+        close_parts (queue.front ()->parts);
+        delete queue.front ();
+        queue.pop_front ();
+    }
+}
+
+zmq::conflate_pipe_t *zmq::conflate_pipe_t::create ()
+{
+    conflate_pipe_t *pipe = new (std::nothrow) conflate_pipe_t (topic_length,
+        topic_delimiter);
+    alloc_assert (pipe);
+    return pipe;
+}
+
+void zmq::conflate_pipe_t::write (const msg_t &value_, bool incomplete_)
+{
+    partial.push_back (value_);
+    if (incomplete_)
+        return;
+
+    //  Find out the topic of the message. If topics are not used, all
+    //  the messages share the empty topic.
+    msg_t &first = partial.front ();
+    bool replaceable = !first.is_delimiter ();
+    const unsigned char *data = replaceable ?
+        (const unsigned char*) first.data () : NULL;
+    size_t size = 0;
+    if (replaceable && topic_length > 0)
+        size = std::min (first.size (), (size_t) topic_length);
+    else if (replaceable && topic_delimiter >= 0) {
+        const unsigned char *end = (const unsigned char*) memchr (data,
+            topic_delimiter, first.size ());
+        size = end ? end - data : first.size ();
+    }
+    uint32_t hash = topics_t::hash (data, size);
+
+    sync.lock ();
+
+    //  If there's a message with the same topic waiting, replace it.
+    //  The replaced parts are deallocated outside of the critical section.
+    entry_t **entry = replaceable ? topics.find (data, size, hash) : NULL;
+    if (entry) {
+        (*entry)->parts.swap (partial);
+        unflushed = true;
+        sync.unlock ();
+        close_parts (partial);
+        return;
+    }
+
+    entry_t *e = new (std::nothrow) entry_t;
+    alloc_assert (e);
+    e->topic.assign (data, size);
+    e->parts.swap (partial);
+    e->replaceable = replaceable;
+    if (replaceable)
+        topics.insert (e->topic, hash, e);
+    queue.push_back (e);
+    unflushed = true;
+    sync.unlock ();
+}
+
+bool zmq::conflate_pipe_t::unwrite (msg_t *value_)
+{
+    if (partial.empty ())
+        return false;
+    *value_ = partial.back ();
+    partial.pop_back ();
+    return true;
+}
+
+bool zmq::conflate_pipe_t::flush ()
+{
+    sync.lock ();
+    bool wake = unflushed && asleep;
+    unflushed = false;
+    if (wake)
+        asleep = false;
+    sync.unlock ();
+    return !wake;
+}
+
+bool zmq::conflate_pipe_t::check_read ()
+{
+    if (current && current_pos != current->parts.size ())
+        return true;
+
+    //  All the parts of the current message were passed to the reader.
+    delete current;
+    current = NULL;
+    current_pos = 0;
+
+    //  Take the next message. From now on it can't be replaced.
+    sync.lock ();
+    if (queue.empty ()) {
+        asleep = true;
+        sync.unlock ();
+        return false;
+    }
+    current = queue.front ();
+    queue.pop_front ();
+    if (current->replaceable)
+        topics.erase (current->topic, topics_t::hash (current->topic));
+    sync.unlock ();
+    return true;
+}
+
+bool zmq::conflate_pipe_t::read (msg_t *value_)
+{
+    if (!check_read ())
+        return false;
+    *value_ = current->parts [current_pos++];
+    return true;
+}
+
+int zmq::conflate_pipe_t::read_batch (msg_t *values_, int count_)
+{
+    //  Only the parts of the current message are returned. The messages
+    //  still in the queue must stay there so that they can be replaced.
+    int nread = 0;
+    if (count_ && check_read ())
+        while (nread != count_ && current_pos != current->parts.size ())
+            values_ [nread++] = current->parts [current_pos++];
+    return nread;
+}
+
+void zmq::conflate_pipe_t::close_parts (parts_t &parts_)
+{
+    for (parts_t::size_type i = 0; i != parts_.size (); i++) {
+        int rc = parts_ [i].close ();
+        errno_assert (rc == 0);
+    }
+    parts_.clear ();
+}
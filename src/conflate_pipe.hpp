@@ -0,0 +1,116 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_CONFLATE_PIPE_HPP_INCLUDED__
+#define __ZMQ_CONFLATE_PIPE_HPP_INCLUDED__
+
+#include <deque>
+#include <vector>
+
+#include "ypipe_base.hpp"
+#include "identity_map.hpp"
+#include "mutex.hpp"
+#include "msg.hpp"
+
+namespace zmq
+{
+
+    //  Queue of messages that holds at most one message per topic. When
+    //  a message is written while there's a message with the same topic
+    //  not yet read, the old message is dropped and the new one takes
+    //  its place in the queue. The topic is defined by ZMQ_TOPIC_LENGTH
+    //  and ZMQ_TOPIC_DELIMITER options; if neither is set, all messages
+    //  share the same topic, i.e. only the last message is kept.
+    //
+    //  Unlike ypipe_t the queue is not lock-free. Writes become visible
+    //  to the reader immediately, flush is used only to find out whether
+    //  the reader has to be woken up.
+
+    class conflate_pipe_t : public ypipe_base_t <msg_t>
+    {
+    public:
+
+        conflate_pipe_t (int topic_length_, int topic_delimiter_);
+        ~conflate_pipe_t ();
+
+        //  Creates a new empty pipe extracting the topics the same way.
+        conflate_pipe_t *create ();
+
+        //  Implementation of ypipe_base_t.
+        void write (const msg_t &value_, bool incomplete_);
+        bool unwrite (msg_t *value_);
+        bool flush ();
+        bool check_read ();
+        bool read (msg_t *value_);
+        int read_batch (msg_t *values_, int count_);
+
+    private:
+
+        typedef std::vector <msg_t> parts_t;
+
+        //  Message waiting to be read, possibly multi-part.
+        struct entry_t
+        {
+            blob_t topic;
+            parts_t parts;
+
+            //  Delimiters are never replaced.
+            bool replaceable;
+        };
+
+        //  Closes all the message parts and empties the array.
+        static void close_parts (parts_t &parts_);
+
+        //  See options_t.
+        int topic_length;
+        int topic_delimiter;
+
+        //  Parts of the message being written. Used exclusively by the
+        //  writer thread.
+        parts_t partial;
+
+        //  Message being read and the index of the next part to read. Used
+        //  exclusively by the reader thread.
+        entry_t *current;
+        parts_t::size_type current_pos;
+
+        //  Messages waiting to be read, in the order of arrival of their
+        //  topics, and the map from the topics to the messages.
+        typedef identity_map_t <entry_t*> topics_t;
+        std::deque <entry_t*> queue;
+        topics_t topics;
+
+        //  True if messages were written since the last flush.
+        bool unflushed;
+
+        //  True if the reader found out there are no messages to read. It's
+        //  cleared when the reader is woken up by the writer.
+        bool asleep;
+
+        //  Synchronisation of queue, topics, unflushed and asleep.
+        mutex_t sync;
+
+        conflate_pipe_t (const conflate_pipe_t&);
+        const conflate_pipe_t &operator = (const conflate_pipe_t&);
+    };
+
+}
+
+#endif
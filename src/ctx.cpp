@@ -34,14 +34,20 @@
 #include "reaper.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
+#include "likely.hpp"
 #include "msg.hpp"
+#include "msg_pool.hpp"
 
 zmq::ctx_t::ctx_t (uint32_t io_threads_) :
     tag (0xbadcafe0),
-    terminating (false)
+    starting (true),
+    terminating (false),
+    io_thread_count (io_threads_),
+    log_socket (NULL),
+    msg_pool (false),
+    io_uring (false),
+    resolver (this)
 {
-    int rc;
-
     //  Initialise the array of mailboxes. Additional three slots are for
     //  internal log socket and the zmq_term thread the reaper thread.
     slot_count = max_sockets + io_threads_ + 3;
@@ -57,14 +63,9 @@ zmq::ctx_t::ctx_t (uint32_t io_threads_) :
     slots [reaper_tid] = reaper->get_mailbox ();
     reaper->start ();
 
-    //  Create I/O thread objects and launch them.
-    for (uint32_t i = 2; i != io_threads_ + 2; i++) {
-        io_thread_t *io_thread = new (std::nothrow) io_thread_t (this, i);
-        alloc_assert (io_thread);
-        io_threads.push_back (io_thread);
-        slots [i] = io_thread->get_mailbox ();
-        io_thread->start ();
-    }
+    //  Slots of the I/O threads are filled in when the threads are launched.
+    for (uint32_t i = 2; i != io_threads_ + 2; i++)
+        slots [i] = NULL;
 
     //  In the unused part of the slot array, create a list of empty slots.
     for (int32_t i = (int32_t) slot_count - 1;
@@ -73,13 +74,26 @@ zmq::ctx_t::ctx_t (uint32_t io_threads_) :
         slots [i] = NULL;
     }
 
-    //  Create the logging infrastructure.
-    log_socket = create_socket (ZMQ_PUB);
+    //  Create the logging infrastructure. The log socket doesn't need
+    //  the I/O threads, so it doesn't launch them.
+    log_socket = make_socket (ZMQ_PUB);
     zmq_assert (log_socket);
-    rc = log_socket->bind ("sys://log");
+    int rc = log_socket->bind ("sys://log");
     zmq_assert (rc == 0);
 }
 
+void zmq::ctx_t::start_io_threads ()
+{
+    //  Create I/O thread objects and launch them.
+    for (uint32_t i = 2; i != io_thread_count + 2; i++) {
+        io_thread_t *io_thread = new (std::nothrow) io_thread_t (this, i);
+        alloc_assert (io_thread);
+        io_threads.push_back (io_thread);
+        slots [i] = io_thread->get_mailbox ();
+        io_thread->start ();
+    }
+}
+
 bool zmq::ctx_t::check_tag ()
 {
     return tag == 0xbadcafe0;
@@ -102,6 +116,14 @@ zmq::ctx_t::~ctx_t ()
     //  Deallocate the reaper thread object.
     delete reaper;
 
+    //  There are no more objects to pass the resolved addresses to, so the
+    //  resolver thread can be shut down.
+    resolver.stop ();
+
+    //  Stop counting this context among the message pool users.
+    if (msg_pool)
+        msg_pool_release ();
+
     //  Deallocate the array of mailboxes. No special work is
     //  needed as mailboxes themselves were deallocated with their
     //  corresponding io_thread/socket objects.
@@ -157,6 +179,73 @@ int zmq::ctx_t::terminate ()
     return 0;
 }
 
+int zmq::ctx_t::set (int option_, int optval_)
+{
+    switch (option_) {
+
+    case ZMQ_MSG_POOL:
+        opt_sync.lock ();
+        if (optval_ && !msg_pool)
+            msg_pool_acquire ();
+        else if (!optval_ && msg_pool)
+            msg_pool_release ();
+        msg_pool = optval_ ? true : false;
+        opt_sync.unlock ();
+        return 0;
+
+    case ZMQ_IO_URING:
+
+        //  The option can't be changed once the I/O threads are running.
+        slot_sync.lock ();
+        if (!starting) {
+            slot_sync.unlock ();
+            break;
+        }
+        opt_sync.lock ();
+        io_uring = optval_ ? true : false;
+        opt_sync.unlock ();
+        slot_sync.unlock ();
+        return 0;
+
+    case ZMQ_RESOLVE_TTL:
+        if (optval_ < 0)
+            break;
+        resolver.set_ttl (optval_);
+        return 0;
+    }
+
+    errno = EINVAL;
+    return -1;
+}
+
+int zmq::ctx_t::get (int option_)
+{
+    switch (option_) {
+
+    case ZMQ_MSG_POOL:
+        {
+            opt_sync.lock ();
+            int result = msg_pool ? 1 : 0;
+            opt_sync.unlock ();
+            return result;
+        }
+
+    case ZMQ_IO_URING:
+        {
+            opt_sync.lock ();
+            int result = io_uring ? 1 : 0;
+            opt_sync.unlock ();
+            return result;
+        }
+
+    case ZMQ_RESOLVE_TTL:
+        return resolver.get_ttl ();
+    }
+
+    errno = EINVAL;
+    return -1;
+}
+
 zmq::socket_base_t *zmq::ctx_t::create_socket (int type_)
 {
     slot_sync.lock ();
@@ -168,9 +257,22 @@ zmq::socket_base_t *zmq::ctx_t::create_socket (int type_)
         return NULL;
     }
 
+    //  The I/O threads are launched when the first socket is created so
+    //  that context options affecting them can be set after zmq_init.
+    if (unlikely (starting)) {
+        starting = false;
+        start_io_threads ();
+    }
+
+    socket_base_t *s = make_socket (type_);
+    slot_sync.unlock ();
+    return s;
+}
+
+zmq::socket_base_t *zmq::ctx_t::make_socket (int type_)
+{
     //  If max_sockets limit was reached, return error.
     if (empty_slots.empty ()) {
-        slot_sync.unlock ();
         errno = EMFILE;
         return NULL;
     }
@@ -183,14 +285,11 @@ zmq::socket_base_t *zmq::ctx_t::create_socket (int type_)
     socket_base_t *s = socket_base_t::create (type_, this, slot);
     if (!s) {
         empty_slots.push_back (slot);
-        slot_sync.unlock ();
         return NULL;
     }
     sockets.push_back (s);
     slots [slot] = s->get_mailbox ();
 
-    slot_sync.unlock ();
-
     return s;
 }
 
@@ -219,6 +318,11 @@ zmq::object_t *zmq::ctx_t::get_reaper ()
     return reaper;
 }
 
+zmq::resolver_t *zmq::ctx_t::get_resolver ()
+{
+    return &resolver;
+}
+
 void zmq::ctx_t::send_command (uint32_t tid_, const command_t &command_)
 {
     slots [tid_]->send (command_);
@@ -245,6 +349,14 @@ zmq::io_thread_t *zmq::ctx_t::choose_io_thread (uint64_t affinity_)
     return io_threads [result];
 }
 
+void zmq::ctx_t::choose_io_threads (uint64_t affinity_,
+    std::vector <io_thread_t*> &io_threads_)
+{
+    for (io_threads_t::size_type i = 0; i != io_threads.size (); i++)
+        if (!affinity_ || (affinity_ & (uint64_t (1) << i)))
+            io_threads_.push_back (io_threads [i]);
+}
+
 int zmq::ctx_t::register_endpoint (const char *addr_, endpoint_t &endpoint_)
 {
     endpoints_sync.lock ();
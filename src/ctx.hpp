@@ -35,6 +35,7 @@
 #include "stdint.hpp"
 #include "thread.hpp"
 #include "options.hpp"
+#include "resolver.hpp"
 
 namespace zmq
 {
@@ -67,6 +68,12 @@ namespace zmq
         //  after the last one is closed.
         int terminate ();
 
+        //  Set and get context options. Options affect sockets created
+        //  after the call. Options affecting I/O threads have to be set
+        //  before the first socket is created.
+        int set (int option_, int optval_);
+        int get (int option_);
+
         //  Create and destroy a socket.
         class socket_base_t *create_socket (int type_);
         void destroy_socket (class socket_base_t *socket_);
@@ -79,9 +86,17 @@ namespace zmq
         //  Returns NULL is no I/O thread is available.
         class io_thread_t *choose_io_thread (uint64_t affinity_);
 
+        //  Appends all the I/O threads eligible given the affinity
+        //  (0 = all) to the vector.
+        void choose_io_threads (uint64_t affinity_,
+            std::vector <class io_thread_t*> &io_threads_);
+
         //  Returns reaper thread object.
         class object_t *get_reaper ();
 
+        //  Returns the host name resolver shared by the context's sockets.
+        resolver_t *get_resolver ();
+
         //  Management of inproc endpoints.
         int register_endpoint (const char *addr_, endpoint_t &endpoint_);
         void unregister_endpoints (class socket_base_t *socket_);
@@ -99,6 +114,13 @@ namespace zmq
 
         ~ctx_t ();
 
+        //  Launches the I/O threads.
+        void start_io_threads ();
+
+        //  Creates a socket in a free slot. Must be called with slot_sync
+        //  locked.
+        class socket_base_t *make_socket (int type_);
+
         //  Used to check whether the object is a context.
         uint32_t tag;
 
@@ -112,11 +134,14 @@ namespace zmq
         typedef std::vector <uint32_t> emtpy_slots_t;
         emtpy_slots_t empty_slots;
 
+        //  If true, the I/O threads were not launched yet.
+        bool starting;
+
         //  If true, zmq_term was already called.
         bool terminating;
 
         //  Synchronisation of accesses to global slot-related data:
-        //  sockets, empty_slots, terminating. It also synchronises
+        //  sockets, empty_slots, starting, terminating. It also synchronises
         //  access to zombie sockets as such (as oposed to slots) and provides
         //  a memory barrier to ensure that all CPU cores see the same data.
         mutex_t slot_sync;
@@ -128,6 +153,9 @@ namespace zmq
         typedef std::vector <class io_thread_t*> io_threads_t;
         io_threads_t io_threads;
 
+        //  Number of I/O threads to launch.
+        uint32_t io_thread_count;
+
         //  Array of pointers to mailboxes for both application and I/O threads.
         uint32_t slot_count;
         mailbox_t **slots;
@@ -147,6 +175,19 @@ namespace zmq
         class socket_base_t *log_socket;
         mutex_t log_sync;
 
+        //  If true, sockets allocate message content from the message pool.
+        bool msg_pool;
+
+        //  If true, I/O threads wait for events using io_uring rather than
+        //  epoll where available.
+        bool io_uring;
+
+        //  Synchronisation of access to context options.
+        mutex_t opt_sync;
+
+        //  Resolves host names for the I/O threads.
+        resolver_t resolver;
+
         ctx_t (const ctx_t&);
         const ctx_t &operator = (const ctx_t&);
     };
@@ -20,16 +20,36 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+
+#include "platform.hpp"
+#if !defined ZMQ_HAVE_WINDOWS
+#include <unistd.h>
+#endif
 
 #include "decoder.hpp"
 #include "i_engine.hpp"
+#include "filter.hpp"
+#include "memfd.hpp"
 #include "wire.hpp"
 #include "err.hpp"
 
-zmq::decoder_t::decoder_t (size_t bufsize_, int64_t maxmsgsize_) :
+zmq::decoder_t::decoder_t (size_t bufsize_, int64_t maxmsgsize_,
+      bool pooled_) :
     decoder_base_t <decoder_t> (bufsize_),
     sink (NULL),
-    maxmsgsize (maxmsgsize_)
+    filter (NULL),
+    body_size (0),
+    flags (0),
+    more (false),
+    first (true),
+    dropping (false),
+    peekbuf (NULL),
+    peekbuf_size (0),
+    peek_size (0),
+    to_drop (0),
+    maxmsgsize (maxmsgsize_),
+    pooled (pooled_)
 {
     int rc = in_progress.init ();
     errno_assert (rc == 0);
@@ -42,6 +62,14 @@ zmq::decoder_t::~decoder_t ()
 {
     int rc = in_progress.close ();
     errno_assert (rc == 0);
+    free (peekbuf);
+#if !defined ZMQ_HAVE_WINDOWS
+    while (!fds.empty ()) {
+        rc = close (fds.front ());
+        errno_assert (rc == 0);
+        fds.pop_front ();
+    }
+#endif
 }
 
 void zmq::decoder_t::set_sink (i_engine_sink *sink_)
@@ -49,66 +77,199 @@ void zmq::decoder_t::set_sink (i_engine_sink *sink_)
     sink = sink_;
 }
 
+void zmq::decoder_t::set_filter (filter_t *filter_)
+{
+    filter = filter_;
+    if (filter && !peekbuf) {
+        peekbuf_size = 256;
+        peekbuf = (unsigned char*) malloc (peekbuf_size);
+        alloc_assert (peekbuf);
+    }
+}
+
+void zmq::decoder_t::push_fd (fd_t fd_)
+{
+    fds.push_back (fd_);
+}
+
 bool zmq::decoder_t::one_byte_size_ready ()
 {
     //  First byte of size is read. If it is 0xff read 8-byte size.
-    //  Otherwise allocate the buffer for message data and read the
-    //  message data into it.
-    if (*tmpbuf == 0xff)
+    //  Otherwise proceed to reading the flags.
+    if (*tmpbuf == 0xff) {
         next_step (tmpbuf, 8, &decoder_t::eight_byte_size_ready);
-    else {
+        return true;
+    }
+    return size_ready (*tmpbuf);
+}
 
-        //  There has to be at least one byte (the flags) in the message).
-        if (!*tmpbuf) {
+bool zmq::decoder_t::eight_byte_size_ready ()
+{
+    //  8-byte size is read. Proceed to reading the flags.
+    return size_ready (get_uint64 (tmpbuf));
+}
+
+bool zmq::decoder_t::size_ready (uint64_t size_)
+{
+    //  There has to be at least one byte (the flags) in the message).
+    if (!size_) {
+        decoding_error ();
+        return false;
+    }
+
+    if (maxmsgsize >= 0 && (int64_t) (size_ - 1) > maxmsgsize) {
+        decoding_error ();
+        return false;
+    }
+
+    body_size = (size_t) (size_ - 1);
+    next_step (tmpbuf, 1, &decoder_t::flags_ready);
+    return true;
+}
+
+bool zmq::decoder_t::flags_ready ()
+{
+    flags = tmpbuf [0];
+    first = !more;
+    more = flags & (msg_t::more | msg_t::label) ? true : false;
+
+    //  The content of the message part is passed as a memory file. Only
+    //  its size is read from the stream.
+    if (flags & wire_memfd) {
+        if (body_size != 8) {
             decoding_error ();
             return false;
         }
+        next_step (tmpbuf, 8, &decoder_t::memfd_ready);
+        return true;
+    }
 
-        //  in_progress is initialised at this point so in theory we should
-        //  close it before calling zmq_msg_init_size, however, it's a 0-byte
-        //  message and thus we can treat it as uninitialised...
-        int rc;
-        if (maxmsgsize >= 0 && (int64_t) (*tmpbuf - 1) > maxmsgsize) {
-            rc = -1;
-            errno = ENOMEM;
+    //  If there's a filter, the beginning of the first part of the message
+    //  is read aside to be matched. The remaining parts of the message
+    //  share the fate of the first one. Only the first max_size () + 1
+    //  bytes are needed to find out whether the message matches.
+    if (filter) {
+        if (first) {
+            dropping = false;
+            peek_size = std::min (body_size, filter->max_size () + 1);
+            if (peek_size > peekbuf_size) {
+                free (peekbuf);
+                peekbuf_size = peek_size;
+                peekbuf = (unsigned char*) malloc (peekbuf_size);
+                alloc_assert (peekbuf);
+            }
+            next_step (peekbuf, peek_size, &decoder_t::peek_ready);
+            return true;
         }
-        else
-            rc = in_progress.init_size (*tmpbuf - 1);
-        if (rc != 0 && errno == ENOMEM) {
-            rc = in_progress.init ();
-            errno_assert (rc == 0);
-            decoding_error ();
-            return false;
-        }
-        errno_assert (rc == 0);
+        if (dropping)
+            return drop (body_size);
+    }
 
-        next_step (tmpbuf, 1, &decoder_t::flags_ready);
+    if (!alloc_body ())
+        return false;
+    next_step (in_progress.data (), in_progress.size (),
+        &decoder_t::message_ready);
+    return true;
+}
+
+bool zmq::decoder_t::peek_ready ()
+{
+    if (filter && !filter->match (peekbuf, peek_size)) {
+        dropping = true;
+        return drop (body_size - peek_size);
     }
+
+    //  The message matches. Move the data read so far to the message
+    //  and read the rest of it.
+    if (!alloc_body ())
+        return false;
+    memcpy (in_progress.data (), peekbuf, peek_size);
+    next_step ((unsigned char*) in_progress.data () + peek_size,
+        body_size - peek_size, &decoder_t::message_ready);
     return true;
 }
 
-bool zmq::decoder_t::eight_byte_size_ready ()
+bool zmq::decoder_t::drop (size_t size_)
 {
-    //  8-byte size is read. Allocate the buffer for message body and
-    //  read the message data into it.
-    size_t size = (size_t) get_uint64 (tmpbuf);
+    to_drop = size_;
+    return drop_ready ();
+}
 
-    //  There has to be at least one byte (the flags) in the message).
-    if (!size) {
+bool zmq::decoder_t::drop_ready ()
+{
+    //  Once the whole body is thrown away, start reading new message part.
+    if (!to_drop) {
+        next_step (tmpbuf, 1, &decoder_t::one_byte_size_ready);
+        return true;
+    }
+
+    size_t size = std::min (to_drop, peekbuf_size);
+    to_drop -= size;
+    next_step (peekbuf, size, &decoder_t::drop_ready);
+    return true;
+}
+
+bool zmq::decoder_t::memfd_ready ()
+{
+#if defined ZMQ_HAVE_MEMFD
+    uint64_t size = get_uint64 (tmpbuf);
+
+    //  There has to be a file descriptor for each such message part.
+    if (fds.empty () || !size || (size_t) size != size ||
+          (maxmsgsize >= 0 && size > (uint64_t) maxmsgsize)) {
+        decoding_error ();
+        return false;
+    }
+    fd_t fd = fds.front ();
+    fds.pop_front ();
+
+    //  The remaining parts of a dropped message are not mapped at all.
+    if (filter && !first && dropping) {
+        int rc = close (fd);
+        errno_assert (rc == 0);
+        next_step (tmpbuf, 1, &decoder_t::one_byte_size_ready);
+        return true;
+    }
+
+    void *data = memfd_map (fd, (size_t) size);
+    if (!data) {
         decoding_error ();
         return false;
     }
+    int rc = in_progress.init_data (data, (size_t) size, memfd_unmap,
+        (void*) (size_t) size);
+    errno_assert (rc == 0);
+    in_progress.set_flags (flags & ~wire_memfd);
+
+    //  The whole message is available, so it can be matched straight away.
+    if (filter && first) {
+        dropping = !filter->match ((unsigned char*) in_progress.data (),
+            in_progress.size ());
+        if (dropping) {
+            rc = in_progress.close ();
+            errno_assert (rc == 0);
+            rc = in_progress.init ();
+            errno_assert (rc == 0);
+            next_step (tmpbuf, 1, &decoder_t::one_byte_size_ready);
+            return true;
+        }
+    }
+
+    next_step (NULL, 0, &decoder_t::message_ready);
+    return true;
+#else
+    //  Memory files are not supported on this platform.
+    decoding_error ();
+    return false;
+#endif
+}
 
+bool zmq::decoder_t::alloc_body ()
+{
     //  in_progress is initialised at this point so in theory we should
     //  close it before calling zmq_msg_init_size, however, it's a 0-byte
     //  message and thus we can treat it as uninitialised...
-    int rc;
-    if (maxmsgsize >= 0 && (int64_t) (size - 1) > maxmsgsize) {
-        rc = -1;
-        errno = ENOMEM;
-    }
-    else
-        rc = in_progress.init_size (size - 1);
+    int rc = in_progress.init_size (body_size, pooled);
     if (rc != 0 && errno == ENOMEM) {
         rc = in_progress.init ();
         errno_assert (rc == 0);
@@ -117,18 +278,8 @@ bool zmq::decoder_t::eight_byte_size_ready ()
     }
     errno_assert (rc == 0);
 
-    next_step (tmpbuf, 1, &decoder_t::flags_ready);
-    return true;
-}
-
-bool zmq::decoder_t::flags_ready ()
-{
     //  Store the flags from the wire into the message structure.
-    in_progress.set_flags (tmpbuf [0]);
-
-    next_step (in_progress.data (), in_progress.size (),
-        &decoder_t::message_ready);
-    
+    in_progress.set_flags (flags);
     return true;
 }
 
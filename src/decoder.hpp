@@ -25,10 +25,18 @@
 #include <string.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <deque>
+
+#include "platform.hpp"
+#if !defined ZMQ_HAVE_WINDOWS
+#include <sys/uio.h>
+#endif
 
 #include "err.hpp"
 #include "msg.hpp"
 #include "stdint.hpp"
+#include "fd.hpp"
+#include "config.hpp"
 
 namespace zmq
 {
@@ -86,6 +94,37 @@ namespace zmq
             *size_ = bufsize;
         }
 
+#if !defined ZMQ_HAVE_WINDOWS
+
+        //  Vectored version of get_buffer. If at least in_batch_zero_copy
+        //  bytes of message body remain to be read, the first entry points
+        //  directly to the message and the second one to the decoder's
+        //  buffer, so that the body is received without copying while any
+        //  data following it land in the buffer. Otherwise only the buffer
+        //  is returned. *count_ is the size of iov_ on input and the number
+        //  of entries used on output. The caller is expected to pass the
+        //  bytes that landed in iov_ [0] and the bytes that landed in
+        //  iov_ [1] to process_buffer separately.
+        inline void get_iovec (iovec *iov_, int *count_)
+        {
+            zmq_assert (*count_ >= 2);
+
+            if (to_read >= in_batch_zero_copy) {
+                iov_ [0].iov_base = read_pos;
+                iov_ [0].iov_len = to_read;
+                iov_ [1].iov_base = buf;
+                iov_ [1].iov_len = bufsize;
+                *count_ = 2;
+                return;
+            }
+
+            iov_ [0].iov_base = buf;
+            iov_ [0].iov_len = bufsize;
+            *count_ = 1;
+        }
+
+#endif
+
         //  Processes the data in the buffer previously allocated using
         //  get_buffer function. size_ argument specifies nemuber of bytes
         //  actually filled into the buffer. Function returns number of
@@ -181,24 +220,71 @@ namespace zmq
     {
     public:
 
-        decoder_t (size_t bufsize_, int64_t maxmsgsize_);
+        decoder_t (size_t bufsize_, int64_t maxmsgsize_, bool pooled_);
         ~decoder_t ();
 
         void set_sink (struct i_engine_sink *sink_);
 
+        //  If filter is set, messages matching none of its subscriptions
+        //  are dropped without being allocated.
+        void set_filter (class filter_t *filter_);
+
+        //  Passes a file descriptor received along with the data to the
+        //  decoder. Message parts passed as memory files take the
+        //  descriptors in the order they were received.
+        void push_fd (fd_t fd_);
+
     private:
 
         bool one_byte_size_ready ();
         bool eight_byte_size_ready ();
         bool flags_ready ();
+        bool peek_ready ();
+        bool drop_ready ();
+        bool memfd_ready ();
         bool message_ready ();
 
+        //  Helpers for the states above.
+        bool size_ready (uint64_t size_);
+        bool alloc_body ();
+        bool drop (size_t size_);
+
         struct i_engine_sink *sink;
+        class filter_t *filter;
         unsigned char tmpbuf [8];
         msg_t in_progress;
 
+        //  Size of the body and flags of the message part being read.
+        size_t body_size;
+        unsigned char flags;
+
+        //  True if the message part being read is not the first part of
+        //  the message.
+        bool more;
+
+        //  True if the message part being read is the first part of the
+        //  message.
+        bool first;
+
+        //  True if the message part being read belongs to a dropped message.
+        bool dropping;
+
+        //  Buffer the beginning of the message is read into to be matched
+        //  against the filter. Data of the dropped messages are read into it
+        //  as well, to be thrown away.
+        unsigned char *peekbuf;
+        size_t peekbuf_size;
+        size_t peek_size;
+        size_t to_drop;
+
         int64_t maxmsgsize;
 
+        //  File descriptors received but not used yet.
+        std::deque <fd_t> fds;
+
+        //  If true, message bodies are allocated from the message pool.
+        bool pooled;
+
         decoder_t (const decoder_t&);
         void operator = (const decoder_t&);
     };
@@ -102,6 +102,24 @@ void zmq::dist_t::activated (pipe_t *pipe_)
     }
 }
 
+void zmq::dist_t::deactivated (pipe_t *pipe_)
+{
+    //  Move the pipe to the passive state, adjusting the number of
+    //  matching, active and eligible pipes on the way.
+    if (pipes.index (pipe_) < matching) {
+        pipes.swap (pipes.index (pipe_), matching - 1);
+        matching--;
+    }
+    if (pipes.index (pipe_) < active) {
+        pipes.swap (pipes.index (pipe_), active - 1);
+        active--;
+    }
+    if (pipes.index (pipe_) < eligible) {
+        pipes.swap (pipes.index (pipe_), eligible - 1);
+        eligible--;
+    }
+}
+
 int zmq::dist_t::send_to_all (msg_t *msg_, int flags_)
 {
     matching = active;
@@ -143,7 +161,7 @@ void zmq::dist_t::distribute (msg_t *msg_, int flags_)
 
     //  Push copy of the message to each matching pipe.
     for (pipes_t::size_type i = 0; i < matching; ++i) {
-        if (!write (pipes [i], msg_))
+        if (!write (pipes [i], msg_, flags_))
             msg_->rm_refs (1);
     }
 
@@ -158,7 +176,7 @@ bool zmq::dist_t::has_out ()
     return true;
 }
 
-bool zmq::dist_t::write (pipe_t *pipe_, msg_t *msg_)
+bool zmq::dist_t::write (pipe_t *pipe_, msg_t *msg_, int flags_)
 {
     if (!pipe_->write (msg_)) {
         pipes.swap (pipes.index (pipe_), matching - 1);
@@ -169,8 +187,12 @@ bool zmq::dist_t::write (pipe_t *pipe_, msg_t *msg_)
         eligible--;
         return false;
     }
-    if (!(msg_->flags () & (msg_t::more | msg_t::label)))
-        pipe_->flush ();
+    if (!(msg_->flags () & (msg_t::more | msg_t::label))) {
+        if (flags_ & send_noflush)
+            pipe_->defer_flush ();
+        else
+            pipe_->flush ();
+    }
     return true;
 }
 
@@ -44,6 +44,11 @@ namespace zmq
         //  Activates pipe that have previously reached high watermark.
         void activated (class pipe_t *pipe_);
 
+        //  Deactivates the pipe that has reached high watermark while
+        //  the messages were written to it directly rather than by the
+        //  distributor object.
+        void deactivated (class pipe_t *pipe_);
+
         //  Mark the pipe as matching. Subsequent call to send_to_matching
         //  will send message also to this pipe.
         void match (class pipe_t *pipe_);
@@ -66,7 +71,7 @@ namespace zmq
 
         //  Write the message to the pipe. Make the pipe inactive if writing
         //  fails. In such a case false is returned.
-        bool write (class pipe_t *pipe_, class msg_t *msg_);
+        bool write (class pipe_t *pipe_, class msg_t *msg_, int flags_);
 
         //  Put the message to all active pipes.
         void distribute (class msg_t *msg_, int flags_);
@@ -18,13 +18,22 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "platform.hpp"
+#if !defined ZMQ_HAVE_WINDOWS
+#include <unistd.h>
+#endif
+
 #include "encoder.hpp"
 #include "i_engine.hpp"
+#include "memfd.hpp"
 #include "wire.hpp"
 
 zmq::encoder_t::encoder_t (size_t bufsize_) :
     encoder_base_t <encoder_t> (bufsize_),
-    sink (NULL)
+    sink (NULL),
+    hold_in_progress (false),
+    memfd_threshold (0),
+    memfd (retired_fd)
 {
     int rc = in_progress.init ();
     errno_assert (rc == 0);
@@ -37,6 +46,13 @@ zmq::encoder_t::~encoder_t ()
 {
     int rc = in_progress.close ();
     errno_assert (rc == 0);
+    release ();
+#if !defined ZMQ_HAVE_WINDOWS
+    if (memfd != retired_fd) {
+        rc = close (memfd);
+        errno_assert (rc == 0);
+    }
+#endif
 }
 
 void zmq::encoder_t::set_sink (i_engine_sink *sink_)
@@ -44,6 +60,25 @@ void zmq::encoder_t::set_sink (i_engine_sink *sink_)
     sink = sink_;
 }
 
+void zmq::encoder_t::hold ()
+{
+    hold_in_progress = true;
+}
+
+void zmq::encoder_t::release ()
+{
+    for (held_t::iterator it = held.begin (); it != held.end (); ++it) {
+        int rc = it->close ();
+        errno_assert (rc == 0);
+    }
+    held.clear ();
+}
+
+void zmq::encoder_t::set_memfd_threshold (size_t threshold_)
+{
+    memfd_threshold = threshold_;
+}
+
 bool zmq::encoder_t::size_ready ()
 {
     //  Write message body into the buffer.
@@ -54,9 +89,17 @@ bool zmq::encoder_t::size_ready ()
 
 bool zmq::encoder_t::message_ready ()
 {
-    //  Destroy content of the old message.
-    int rc = in_progress.close ();
-    errno_assert (rc == 0);
+    //  Destroy content of the old message. If its data are still referenced
+    //  by the batch being sent, keep it alive till the batch is written.
+    int rc;
+    if (hold_in_progress) {
+        held.push_back (in_progress);
+        hold_in_progress = false;
+    }
+    else {
+        rc = in_progress.close ();
+        errno_assert (rc == 0);
+    }
 
     //  Read new message. If there is none, return false.
     //  Note that new state is set only if write is successful. That way
@@ -68,6 +111,23 @@ bool zmq::encoder_t::message_ready ()
         return false;
     }
 
+#if defined ZMQ_HAVE_MEMFD
+    //  Large message parts are copied into a memory file which is passed
+    //  to the peer along with the header. The size of the content follows
+    //  the header instead of the content itself.
+    if (memfd_threshold && in_progress.size () >= memfd_threshold) {
+        memfd = memfd_store (in_progress.data (), in_progress.size ());
+        if (memfd != retired_fd) {
+            tmpbuf [0] = 9;
+            tmpbuf [1] = (in_progress.flags () & ~msg_t::shared) | wire_memfd;
+            put_uint64 (tmpbuf + 2, in_progress.size ());
+            next_step (tmpbuf, 10, &encoder_t::message_ready,
+                !(in_progress.flags () & (msg_t::more | msg_t::label)));
+            return true;
+        }
+    }
+#endif
+
     //  Get the message size.
     size_t size = in_progress.size ();
 
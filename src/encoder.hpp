@@ -25,9 +25,17 @@
 #include <string.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <vector>
+
+#include "platform.hpp"
+#if !defined ZMQ_HAVE_WINDOWS
+#include <sys/uio.h>
+#endif
 
 #include "err.hpp"
 #include "msg.hpp"
+#include "fd.hpp"
+#include "config.hpp"
 
 namespace zmq
 {
@@ -123,6 +131,92 @@ namespace zmq
             }
         }
 
+#if !defined ZMQ_HAVE_WINDOWS
+
+        //  Vectored version of get_data. Fills in up to *count_ entries of
+        //  iov_ and sets *count_ to the number of entries actually used and
+        //  *size_ to the overall number of bytes. Short chunks, such as
+        //  message headers and small message bodies, are coalesced in the
+        //  encoder's buffer while bodies of at least out_batch_zero_copy
+        //  bytes are referenced directly. Messages referenced this way are
+        //  kept alive until the next invocation of this function, thus the
+        //  caller has to write all the data before asking for more. If the
+        //  batch starts with a message part passed as a file descriptor,
+        //  *fd_ is set to the descriptor, otherwise to retired_fd. The caller
+        //  has to send it along with the first byte of the batch and close it.
+        inline void get_iovec (iovec *iov_, int *count_, size_t *size_,
+            fd_t *fd_)
+        {
+            //  The data returned by the previous call have been written.
+            static_cast <T*> (this)->release ();
+            *fd_ = retired_fd;
+
+            int max = *count_;
+            int count = 0;
+            size_t pos = 0;
+            size_t total = 0;
+
+            while (true) {
+
+                //  If there are no more data to return, run the state machine.
+                //  Don't start a new message once the batch is complete.
+                if (!to_write) {
+                    if (total >= bufsize ||
+                          !(static_cast <T*> (this)->*next) ())
+                        break;
+                    continue;
+                }
+
+                //  The file descriptor is received along with the first byte
+                //  of the batch, so the message part it belongs to has to
+                //  start the batch.
+                if (static_cast <T*> (this)->fd_pending ()) {
+                    if (total)
+                        break;
+                    *fd_ = static_cast <T*> (this)->take_fd ();
+                }
+
+                //  Large chunks are sent directly from the message.
+                if (to_write >= out_batch_zero_copy) {
+                    if (count == max)
+                        break;
+                    static_cast <T*> (this)->hold ();
+                    iov_ [count].iov_base = write_pos;
+                    iov_ [count].iov_len = to_write;
+                    count++;
+                    total += to_write;
+                    write_pos = NULL;
+                    to_write = 0;
+                    continue;
+                }
+
+                //  Small chunks are copied to the buffer. If the previous
+                //  entry points to the buffer as well, extend it.
+                if (pos == bufsize)
+                    break;
+                if (!count || (unsigned char*) iov_ [count - 1].iov_base +
+                      iov_ [count - 1].iov_len != buf + pos) {
+                    if (count == max)
+                        break;
+                    iov_ [count].iov_base = buf + pos;
+                    iov_ [count].iov_len = 0;
+                    count++;
+                }
+                size_t to_copy = std::min (to_write, bufsize - pos);
+                memcpy (buf + pos, write_pos, to_copy);
+                iov_ [count - 1].iov_len += to_copy;
+                pos += to_copy;
+                total += to_copy;
+                write_pos += to_copy;
+                to_write -= to_copy;
+            }
+
+            *count_ = count;
+            *size_ = total;
+        }
+
+#endif
+
     protected:
 
         //  Prototype of state machine action.
@@ -165,6 +259,33 @@ namespace zmq
 
         void set_sink (struct i_engine_sink *sink_);
 
+        //  Keeps the message being encoded alive after the encoder moves
+        //  on to the next one, until release is called. Used when the data
+        //  are referenced from the message rather than copied.
+        void hold ();
+
+        //  Closes all the messages kept alive by hold.
+        void release ();
+
+        //  Message parts of at least threshold_ bytes are passed as memory
+        //  files. Zero means never.
+        void set_memfd_threshold (size_t threshold_);
+
+        //  Returns true if there is a memory file to be passed along with
+        //  the data that follow.
+        inline bool fd_pending ()
+        {
+            return memfd != retired_fd;
+        }
+
+        //  Hands the memory file over to the caller.
+        inline fd_t take_fd ()
+        {
+            fd_t fd = memfd;
+            memfd = retired_fd;
+            return fd;
+        }
+
     private:
 
         bool size_ready ();
@@ -174,6 +295,19 @@ namespace zmq
         msg_t in_progress;
         unsigned char tmpbuf [10];
 
+        //  If true, in_progress is not closed but moved to held once
+        //  it's fully encoded.
+        bool hold_in_progress;
+
+        //  Encoded messages whose data are still being sent.
+        typedef std::vector <msg_t> held_t;
+        held_t held;
+
+        //  Size starting from which message parts are passed as memory
+        //  files and the file of the message part being encoded.
+        size_t memfd_threshold;
+        fd_t memfd;
+
         encoder_t (const encoder_t&);
         const encoder_t &operator = (const encoder_t&);
     };
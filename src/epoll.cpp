@@ -23,6 +23,10 @@
 #ifdef ZMQ_HAVE_LINUX
 
 #include <sys/epoll.h>
+#if defined ZMQ_HAVE_IO_URING
+#include <poll.h>
+#include <endian.h>
+#endif
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -34,9 +38,18 @@
 #include "config.hpp"
 #include "i_poll_events.hpp"
 
-zmq::epoll_t::epoll_t () :
+zmq::epoll_t::epoll_t (bool io_uring_) :
+    epoll_fd (retired_fd),
     stopping (false)
 {
+#if defined ZMQ_HAVE_IO_URING
+    //  If io_uring is not available, fall back to epoll silently.
+    use_uring = io_uring_ &&
+        uring.init (io_uring_sq_entries, io_uring_cq_entries) == 0;
+    if (use_uring)
+        return;
+#endif
+
     epoll_fd = epoll_create (1);
     errno_assert (epoll_fd != -1);
 }
@@ -46,9 +59,19 @@ zmq::epoll_t::~epoll_t ()
     //  Wait till the worker thread exits.
     worker.stop ();
 
-    close (epoll_fd);
+    if (epoll_fd != retired_fd)
+        close (epoll_fd);
     for (retired_t::iterator it = retired.begin (); it != retired.end (); ++it)
         delete *it;
+#if defined ZMQ_HAVE_IO_URING
+
+    //  Once the ring is closed, no poll request is in flight any more and
+    //  all the removed entries can be deallocated.
+    uring.close ();
+    for (pending_t::iterator it = retiring.begin (); it != retiring.end ();
+          ++it)
+        delete *it;
+#endif
 }
 
 zmq::epoll_t::handle_t zmq::epoll_t::add_fd (fd_t fd_, i_poll_events *events_)
@@ -65,6 +88,14 @@ zmq::epoll_t::handle_t zmq::epoll_t::add_fd (fd_t fd_, i_poll_events *events_)
     pe->ev.data.ptr = pe;
     pe->events = events_;
 
+#if defined ZMQ_HAVE_IO_URING
+    if (use_uring) {
+        uring_update (pe);
+        adjust_load (1);
+        return pe;
+    }
+#endif
+
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd_, &pe->ev);
     errno_assert (rc != -1);
 
@@ -77,6 +108,18 @@ zmq::epoll_t::handle_t zmq::epoll_t::add_fd (fd_t fd_, i_poll_events *events_)
 void zmq::epoll_t::rm_fd (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
+
+#if defined ZMQ_HAVE_IO_URING
+    //  The entry is deallocated once its poll request is finished.
+    if (use_uring) {
+        pe->fd = retired_fd;
+        uring_update (pe);
+        retiring.push_back (pe);
+        adjust_load (-1);
+        return;
+    }
+#endif
+
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_DEL, pe->fd, &pe->ev);
     errno_assert (rc != -1);
     pe->fd = retired_fd;
@@ -90,6 +133,12 @@ void zmq::epoll_t::set_pollin (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
     pe->ev.events |= EPOLLIN;
+#if defined ZMQ_HAVE_IO_URING
+    if (use_uring) {
+        uring_update (pe);
+        return;
+    }
+#endif
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
     errno_assert (rc != -1);
 }
@@ -98,6 +147,12 @@ void zmq::epoll_t::reset_pollin (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
     pe->ev.events &= ~((short) EPOLLIN);
+#if defined ZMQ_HAVE_IO_URING
+    if (use_uring) {
+        uring_update (pe);
+        return;
+    }
+#endif
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
     errno_assert (rc != -1);
 }
@@ -106,6 +161,12 @@ void zmq::epoll_t::set_pollout (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
     pe->ev.events |= EPOLLOUT;
+#if defined ZMQ_HAVE_IO_URING
+    if (use_uring) {
+        uring_update (pe);
+        return;
+    }
+#endif
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
     errno_assert (rc != -1);
 }
@@ -114,6 +175,12 @@ void zmq::epoll_t::reset_pollout (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
     pe->ev.events &= ~((short) EPOLLOUT);
+#if defined ZMQ_HAVE_IO_URING
+    if (use_uring) {
+        uring_update (pe);
+        return;
+    }
+#endif
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
     errno_assert (rc != -1);
 }
@@ -130,6 +197,13 @@ void zmq::epoll_t::stop ()
 
 void zmq::epoll_t::loop ()
 {
+#if defined ZMQ_HAVE_IO_URING
+    if (use_uring) {
+        uring_loop ();
+        return;
+    }
+#endif
+
     epoll_event ev_buf [max_io_events];
 
     while (!stopping) {
@@ -169,6 +243,134 @@ void zmq::epoll_t::loop ()
     }
 }
 
+#if defined ZMQ_HAVE_IO_URING
+
+void zmq::epoll_t::uring_update (poll_entry_t *pe_)
+{
+    if (!pe_->pending) {
+        pe_->pending = true;
+        pending.push_back (pe_);
+    }
+}
+
+void zmq::epoll_t::uring_submit ()
+{
+    pending_t::size_type i;
+    for (i = 0; i != pending.size (); i++) {
+        poll_entry_t *pe = pending [i];
+
+        //  Source retired. If the poll request is still in flight, cancel it.
+        if (pe->fd == retired_fd) {
+            if (!pe->armed || pe->cancelling) {
+                pe->pending = false;
+                continue;
+            }
+        }
+
+        //  Poll request is in flight. As long as it doesn't miss any events
+        //  the user is interested in, there's no need to touch it. Events
+        //  that are no longer wanted are filtered out on completion.
+        //  Otherwise, cancel the request and re-submit it on completion.
+        else if (pe->armed) {
+            if (pe->cancelling || !(pe->ev.events & ~pe->armed_events)) {
+                pe->pending = false;
+                continue;
+            }
+        }
+
+        io_uring_sqe *sqe = uring.get_sqe ();
+        if (!sqe)
+            break;
+        if (pe->armed) {
+            sqe->opcode = IORING_OP_POLL_REMOVE;
+            sqe->fd = -1;
+            sqe->addr = (__u64) (unsigned long) pe;
+            sqe->user_data = 0;
+            pe->cancelling = true;
+        }
+        else {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = pe->fd;
+#if __BYTE_ORDER == __BIG_ENDIAN
+            sqe->poll32_events = (pe->ev.events << 16) | (pe->ev.events >> 16);
+#else
+            sqe->poll32_events = pe->ev.events;
+#endif
+            sqe->user_data = (__u64) (unsigned long) pe;
+            pe->armed = true;
+            pe->armed_events = pe->ev.events;
+        }
+        pe->pending = false;
+    }
+
+    //  Entries that haven't fit into the submission ring stay pending.
+    pending.erase (pending.begin (), pending.begin () + i);
+}
+
+void zmq::epoll_t::uring_loop ()
+{
+    while (!stopping) {
+
+        //  Execute any due timers.
+        int timeout = (int) execute_timers ();
+
+        //  Submit the changes made during the last iteration and wait for
+        //  events. If some changes haven't fit into the ring, don't block.
+        uring_submit ();
+        uring.enter (!pending.empty () ? 0 : timeout ? timeout : -1);
+
+        for (int n = 0; n != max_io_events; n++) {
+            io_uring_cqe *cqe = uring.peek_cqe ();
+            if (!cqe)
+                break;
+            poll_entry_t *pe = (poll_entry_t*) (unsigned long) cqe->user_data;
+            int res = cqe->res;
+            uring.cqe_seen ();
+
+            //  Completions of cancel requests are of no interest.
+            if (!pe)
+                continue;
+
+            pe->armed = false;
+            pe->cancelling = false;
+            if (pe->fd == retired_fd)
+                continue;
+
+            //  The request is one-shot. Re-submit it in the next iteration.
+            uring_update (pe);
+            if (res <= 0)
+                continue;
+
+            //  Ignore events the user is no longer interested in.
+            uint32_t events = res & (pe->ev.events | POLLERR | POLLHUP);
+            if (events & (POLLERR | POLLHUP))
+                pe->events->in_event ();
+            if (pe->fd == retired_fd)
+               continue;
+            if (events & POLLOUT)
+                pe->events->out_event ();
+            if (pe->fd == retired_fd)
+                continue;
+            if (events & POLLIN)
+                pe->events->in_event ();
+        }
+
+        //  Destroy retired event sources that have no poll request in
+        //  flight and are not going to be submitted.
+        pending_t::size_type kept = 0;
+        for (pending_t::size_type i = 0; i != retiring.size (); i++) {
+            poll_entry_t *pe = retiring [i];
+            if (pe->armed || pe->pending)
+                retiring [kept++] = pe;
+            else
+                delete pe;
+        }
+        retiring.resize (kept);
+    }
+}
+
+#endif
+
 void zmq::epoll_t::worker_routine (void *arg_)
 {
     ((epoll_t*) arg_)->loop ();
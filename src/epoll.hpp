@@ -31,12 +31,19 @@
 #include "fd.hpp"
 #include "thread.hpp"
 #include "poller_base.hpp"
+#if defined ZMQ_HAVE_IO_URING
+#include "uring.hpp"
+#endif
 
 namespace zmq
 {
 
     //  This class implements socket polling mechanism using the Linux-specific
-    //  epoll mechanism.
+    //  epoll mechanism. Optionally, io_uring can be used instead of epoll.
+    //  In that case a one-shot poll request is kept in flight for each file
+    //  descriptor and all the changes to the poll requests made during one
+    //  iteration of the event loop are submitted together with the wait for
+    //  new events, using a single system call.
 
     class epoll_t : public poller_base_t
     {
@@ -44,7 +51,9 @@ namespace zmq
 
         typedef void* handle_t;
 
-        epoll_t ();
+        //  If io_uring_ is true, io_uring is used if it is supported by
+        //  the system. Otherwise epoll is used.
+        epoll_t (bool io_uring_ = false);
         ~epoll_t ();
 
         //  "poller" concept.
@@ -73,6 +82,19 @@ namespace zmq
             fd_t fd;
             epoll_event ev;
             struct i_poll_events *events;
+#if defined ZMQ_HAVE_IO_URING
+            //  Events the poll request in flight waits for.
+            uint32_t armed_events;
+
+            //  True if there's a poll request in flight.
+            bool armed;
+
+            //  True if the poll request in flight is being cancelled.
+            bool cancelling;
+
+            //  True if the entry is in the list of pending entries.
+            bool pending;
+#endif
         };
 
         //  List of retired event sources.
@@ -82,6 +104,33 @@ namespace zmq
         //  If true, thread is in the process of shutting down.
         bool stopping;
 
+#if defined ZMQ_HAVE_IO_URING
+
+        //  Event loop used when polling via io_uring.
+        void uring_loop ();
+
+        //  Marks the entry as needing its poll request to be (re)submitted
+        //  or cancelled.
+        void uring_update (poll_entry_t *pe_);
+
+        //  Translates pending entries to submission entries.
+        void uring_submit ();
+
+        //  True if io_uring is used instead of epoll.
+        bool use_uring;
+
+        //  The ring, if used.
+        uring_t uring;
+
+        //  Entries whose poll requests are to be submitted or cancelled.
+        typedef std::vector <poll_entry_t*> pending_t;
+        pending_t pending;
+
+        //  Entries removed from the poller. They are deallocated once their
+        //  poll requests are finished.
+        pending_t retiring;
+#endif
+
         //  Handle of the physical thread doing the I/O work.
         thread_t worker;
 
@@ -0,0 +1,121 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filter.hpp"
+#include "options.hpp"
+#include "blob.hpp"
+
+zmq::filter_t::filter_t (const options_t &options_) :
+    options (options_),
+    longest (0),
+    count (0)
+{
+}
+
+zmq::filter_t::~filter_t ()
+{
+}
+
+bool zmq::filter_t::add (unsigned char *topic_, size_t size_)
+{
+    if (size_ > longest)
+        longest = size_;
+
+    if (!options.exact_match ()) {
+        if (!subscriptions.add (topic_, size_))
+            return false;
+        count++;
+        return true;
+    }
+
+    uint32_t hash = exact_subscriptions_t::hash (topic_, size_);
+    uint32_t *refcnt = exact_subscriptions.find (topic_, size_, hash);
+    if (refcnt) {
+        ++*refcnt;
+        return false;
+    }
+    exact_subscriptions.insert (blob_t (topic_, size_), hash, 1);
+    count++;
+    return true;
+}
+
+bool zmq::filter_t::rm (unsigned char *topic_, size_t size_)
+{
+    if (!options.exact_match ()) {
+        if (!subscriptions.rm (topic_, size_))
+            return false;
+        count--;
+        return true;
+    }
+
+    uint32_t hash = exact_subscriptions_t::hash (topic_, size_);
+    uint32_t *refcnt = exact_subscriptions.find (topic_, size_, hash);
+    if (!refcnt)
+        return false;
+    if (--*refcnt)
+        return false;
+    exact_subscriptions.erase (blob_t (topic_, size_), hash);
+    count--;
+    return true;
+}
+
+void zmq::filter_t::clear ()
+{
+    subscriptions.clear ();
+    exact_subscriptions.clear ();
+    longest = 0;
+    count = 0;
+}
+
+bool zmq::filter_t::empty ()
+{
+    return count == 0;
+}
+
+bool zmq::filter_t::match (unsigned char *data_, size_t size_)
+{
+    if (!options.exact_match ())
+        return subscriptions.check (data_, size_);
+
+    //  Look up the topic itself and, for non-empty topics, the empty
+    //  subscription matching all the messages.
+    size_t topic_size = options.topic_size (data_, size_);
+    if (exact_subscriptions.find (data_, topic_size,
+          exact_subscriptions_t::hash (data_, topic_size)))
+        return true;
+    return topic_size && exact_subscriptions.find (data_, 0,
+        exact_subscriptions_t::hash (data_, 0));
+}
+
+size_t zmq::filter_t::max_size ()
+{
+    return longest;
+}
+
+void zmq::filter_t::apply (void (*func_) (unsigned char *data_,
+    size_t size_, void *arg_), void *arg_)
+{
+    subscriptions.apply (func_, arg_);
+    for (size_t pos = 0; pos != exact_subscriptions.capacity (); pos++)
+        if (exact_subscriptions.used (pos)) {
+            const blob_t &topic = exact_subscriptions.key (pos);
+            func_ ((unsigned char*) topic.data (), topic.size (), arg_);
+        }
+}
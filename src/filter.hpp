@@ -0,0 +1,94 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_FILTER_HPP_INCLUDED__
+#define __ZMQ_FILTER_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "trie.hpp"
+#include "identity_map.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Subscriptions of a (X)SUB socket. The subscriptions are matched
+    //  either as prefixes of the messages or, if ZMQ_TOPIC_LENGTH or
+    //  ZMQ_TOPIC_DELIMITER option is set, exactly against the topics of
+    //  the messages.
+
+    class filter_t
+    {
+    public:
+
+        filter_t (const struct options_t &options_);
+        ~filter_t ();
+
+        //  Add or remove the subscription. Return true if the subscription
+        //  was actually added or removed rather than its reference count
+        //  adjusted.
+        bool add (unsigned char *topic_, size_t size_);
+        bool rm (unsigned char *topic_, size_t size_);
+
+        //  Remove all the subscriptions.
+        void clear ();
+
+        //  Returns true if there are no subscriptions.
+        bool empty ();
+
+        //  Check whether the message matches at least one subscription.
+        bool match (unsigned char *data_, size_t size_);
+
+        //  Returns the size of the longest subscription added so far. Only
+        //  the first max_size () + 1 bytes of a message are needed to find
+        //  out whether it matches.
+        size_t max_size ();
+
+        //  Apply the function supplied to each subscription.
+        void apply (void (*func_) (unsigned char *data_, size_t size_,
+            void *arg_), void *arg_);
+
+    private:
+
+        //  Options of the socket defining the way to match the messages.
+        const struct options_t &options;
+
+        //  The subscriptions matched as prefixes.
+        trie_t subscriptions;
+
+        //  The subscriptions matched exactly. Maps the topics to the number
+        //  of times they were subscribed to.
+        typedef identity_map_t <uint32_t> exact_subscriptions_t;
+        exact_subscriptions_t exact_subscriptions;
+
+        //  Size of the longest subscription added so far.
+        size_t longest;
+
+        //  Number of distinct subscriptions.
+        size_t count;
+
+        filter_t (const filter_t&);
+        const filter_t &operator = (const filter_t&);
+    };
+
+}
+
+#endif
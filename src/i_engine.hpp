@@ -67,6 +67,11 @@ namespace zmq
 
         //  Engine is dead. Drop all the references to it.
         virtual void detach () = 0;
+
+        //  Returns the subscriptions the engine can use to drop the messages
+        //  received before passing them to the sink or NULL if all the
+        //  messages have to be passed.
+        virtual class filter_t *get_filter () = 0;
     };
 
 }
@@ -0,0 +1,250 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_IDENTITY_MAP_HPP_INCLUDED__
+#define __ZMQ_IDENTITY_MAP_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include "blob.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Hash table mapping peer identities to values of type T. Open
+    //  addressing with linear probing is used, so a lookup is a single
+    //  hash computation followed by a short scan of adjacent slots.
+    //  The hash is passed in by the caller to allow it to be computed
+    //  once and cached, e.g. for the lifetime of a pipe. Lookups can be
+    //  done using raw data, so that no blob_t has to be constructed.
+
+    template <typename T> class identity_map_t
+    {
+    public:
+
+        inline identity_map_t () :
+            count (0)
+        {
+        }
+
+        //  Computes the hash of the identity (32-bit FNV-1a).
+        static inline uint32_t hash (const unsigned char *data_, size_t size_)
+        {
+            uint32_t h = 2166136261u;
+            for (size_t i = 0; i != size_; i++) {
+                h ^= data_ [i];
+                h *= 16777619u;
+            }
+            return h;
+        }
+
+        static inline uint32_t hash (const blob_t &key_)
+        {
+            return hash (key_.data (), key_.size ());
+        }
+
+        inline size_t size ()
+        {
+            return count;
+        }
+
+        inline bool empty ()
+        {
+            return count == 0;
+        }
+
+        //  Returns pointer to the value stored under the identity or NULL
+        //  if there's no such identity. The pointer is valid till the next
+        //  modification of the map.
+        inline T *find (const unsigned char *data_, size_t size_,
+            uint32_t hash_)
+        {
+            size_t pos;
+            if (!lookup (data_, size_, hash_, &pos))
+                return NULL;
+            return &slots [pos].value;
+        }
+
+        inline T *find (const blob_t &key_, uint32_t hash_)
+        {
+            return find (key_.data (), key_.size (), hash_);
+        }
+
+        //  Inserts the value under the identity. Returns false if the
+        //  identity is already present in the map.
+        inline bool insert (const blob_t &key_, uint32_t hash_,
+            const T &value_)
+        {
+            size_t pos;
+            if (lookup (key_.data (), key_.size (), hash_, &pos))
+                return false;
+
+            //  Keep the load factor below 1/2 so that the probe sequences
+            //  stay short.
+            if ((count + 1) * 2 > slots.size ())
+                resize (slots.empty () ? 16 : slots.size () * 2);
+
+            slot_t &slot = slots [probe (hash_)];
+            slot.used = true;
+            slot.hash = hash_;
+            slot.key = key_;
+            slot.value = value_;
+            count++;
+            return true;
+        }
+
+        //  Removes the identity from the map. Returns false if there's no
+        //  such identity.
+        inline bool erase (const blob_t &key_, uint32_t hash_)
+        {
+            size_t hole;
+            if (!lookup (key_.data (), key_.size (), hash_, &hole))
+                return false;
+
+            //  Shift the subsequent entries of the probe sequence backwards
+            //  so that no tombstones are needed.
+            size_t mask = slots.size () - 1;
+            size_t pos = hole;
+            while (true) {
+                pos = (pos + 1) & mask;
+                if (!slots [pos].used)
+                    break;
+                size_t ideal = slots [pos].hash & mask;
+                if ((pos > hole && (ideal <= hole || ideal > pos)) ||
+                      (pos < hole && ideal <= hole && ideal > pos)) {
+                    swap_slots (slots [hole], slots [pos]);
+                    hole = pos;
+                }
+            }
+            slots [hole].used = false;
+            slots [hole].key.clear ();
+            slots [hole].value = T ();
+            count--;
+            return true;
+        }
+
+        //  Removes all the identities from the map.
+        inline void clear ()
+        {
+            slots.clear ();
+            count = 0;
+        }
+
+        //  The entries can be iterated over by position, from zero up to
+        //  capacity (). Positions are valid till the next modification
+        //  of the map.
+        inline size_t capacity ()
+        {
+            return slots.size ();
+        }
+
+        inline bool used (size_t pos_)
+        {
+            return slots [pos_].used;
+        }
+
+        inline const blob_t &key (size_t pos_)
+        {
+            return slots [pos_].key;
+        }
+
+        inline T &value (size_t pos_)
+        {
+            return slots [pos_].value;
+        }
+
+    private:
+
+        struct slot_t
+        {
+            T value;
+            blob_t key;
+            uint32_t hash;
+            bool used;
+        };
+
+        //  Finds position of the identity. Returns false if it's not
+        //  present in the map.
+        inline bool lookup (const unsigned char *data_, size_t size_,
+            uint32_t hash_, size_t *pos_)
+        {
+            if (!count)
+                return false;
+            size_t mask = slots.size () - 1;
+            for (size_t pos = hash_ & mask; slots [pos].used;
+                  pos = (pos + 1) & mask) {
+                slot_t &slot = slots [pos];
+                if (slot.hash == hash_ && slot.key.size () == size_ &&
+                      memcmp (slot.key.data (), data_, size_) == 0) {
+                    *pos_ = pos;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //  Returns position of the first free slot in the probe sequence.
+        inline size_t probe (uint32_t hash_)
+        {
+            size_t mask = slots.size () - 1;
+            size_t pos = hash_ & mask;
+            while (slots [pos].used)
+                pos = (pos + 1) & mask;
+            return pos;
+        }
+
+        inline static void swap_slots (slot_t &a_, slot_t &b_)
+        {
+            std::swap (a_.value, b_.value);
+            a_.key.swap (b_.key);
+            std::swap (a_.hash, b_.hash);
+            std::swap (a_.used, b_.used);
+        }
+
+        inline void resize (size_t size_)
+        {
+            slot_t empty;
+            empty.value = T ();
+            empty.hash = 0;
+            empty.used = false;
+            std::vector <slot_t> old (size_, empty);
+            old.swap (slots);
+            for (size_t i = 0; i != old.size (); i++)
+                if (old [i].used)
+                    swap_slots (slots [probe (old [i].hash)], old [i]);
+        }
+
+        //  The number of slots is always a power of two.
+        std::vector <slot_t> slots;
+
+        //  Number of identities in the map.
+        size_t count;
+
+        identity_map_t (const identity_map_t&);
+        const identity_map_t &operator = (const identity_map_t&);
+    };
+
+}
+
+#endif
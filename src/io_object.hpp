@@ -49,6 +49,7 @@ namespace zmq
     protected:
 
         typedef poller_t::handle_t handle_t;
+        typedef poller_t::timer_handle_t timer_handle_t;
 
         //  Methods to access underlying poller object.
         handle_t add_fd (fd_t fd_);
@@ -57,8 +58,8 @@ namespace zmq
         void reset_pollin (handle_t handle_);
         void set_pollout (handle_t handle_);
         void reset_pollout (handle_t handle_);
-        void add_timer (int timout_, int id_);
-        void cancel_timer (int id_);
+        timer_handle_t add_timer (int timout_, int id_);
+        void cancel_timer (timer_handle_t handle_);
 
         //  i_poll_events interface implementation.
         void in_event ();
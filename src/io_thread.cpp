@@ -28,7 +28,11 @@
 zmq::io_thread_t::io_thread_t (ctx_t *ctx_, uint32_t tid_) :
     object_t (ctx_, tid_)
 {
+#if defined ZMQ_USE_EPOLL && defined ZMQ_HAVE_IO_URING
+    poller = new (std::nothrow) poller_t (ctx_->get (ZMQ_IO_URING) == 1);
+#else
     poller = new (std::nothrow) poller_t;
+#endif
     alloc_assert (poller);
 
     mailbox_handle = poller->add_fd (mailbox.get_fd (), this);
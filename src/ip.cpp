@@ -301,7 +301,7 @@ int zmq::resolve_ip_interface (sockaddr_storage* addr_, socklen_t *addr_len_,
 }
 
 int zmq::resolve_ip_hostname (sockaddr_storage *addr_, socklen_t *addr_len_,
-    const char *hostname_)
+    const char *hostname_, bool numeric_)
 {
     //  Find the ':' that separates hostname name from service.
     const char *delimiter = strrchr (hostname_, ':');
@@ -327,6 +327,8 @@ int zmq::resolve_ip_hostname (sockaddr_storage *addr_, socklen_t *addr_len_,
 
     //  Avoid named services due to unclear socktype.
     req.ai_flags = AI_NUMERICSERV;
+    if (numeric_)
+        req.ai_flags |= AI_NUMERICHOST;
 
     //  Resolve host name. Some of the error info is lost in case of error,
     //  however, there's no way to report EAI errors via errno.
@@ -58,9 +58,11 @@ namespace zmq
         char const *interface_);
 
     //  This function resolves a string in <hostname>:<port-number> format.
-    //  Hostname can be either the name of the host or its IP address.
+    //  Hostname can be either the name of the host or its IP address. If
+    //  numeric_ is true, only IP addresses are accepted, so that the name
+    //  service is never queried.
     int resolve_ip_hostname (sockaddr_storage *addr_, socklen_t *addr_len_,
-        const char *hostname_);
+        const char *hostname_, bool numeric_ = false);
 
     // This function sets up address for UNIX domain transport.
     int resolve_local_path (sockaddr_storage *addr_, socklen_t *addr_len_,
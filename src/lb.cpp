@@ -110,7 +110,10 @@ int zmq::lb_t::send (msg_t *msg_, int flags_)
     //  If it's final part of the message we can fluch it downstream and
     //  continue round-robinning (load balance).
     if (!more) {
-        pipes [current]->flush ();
+        if (flags_ & send_noflush)
+            pipes [current]->defer_flush ();
+        else
+            pipes [current]->flush ();
         current = (current + 1) % active;
     }
 
@@ -18,22 +18,113 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "platform.hpp"
+#if defined ZMQ_HAVE_WINDOWS
+#include "windows.hpp"
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+#if defined ZMQ_HAVE_LINUX
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include <new>
+
 #include "mailbox.hpp"
+#include "clock.hpp"
+#include "config.hpp"
 #include "err.hpp"
 
-zmq::mailbox_t::mailbox_t ()
+//  Returns true if there's more than one CPU available. Spinning while
+//  the sender has no CPU to run on is just a waste of time.
+static bool multiprocessor ()
+{
+    static int cpus = 0;
+    if (!cpus) {
+#if defined ZMQ_HAVE_WINDOWS
+        SYSTEM_INFO info;
+        GetSystemInfo (&info);
+        cpus = (int) info.dwNumberOfProcessors;
+#elif defined _SC_NPROCESSORS_ONLN
+        long count = sysconf (_SC_NPROCESSORS_ONLN);
+        cpus = count > 0 ? (int) count : 1;
+#else
+        cpus = 2;
+#endif
+    }
+    return cpus > 1;
+}
+
+//  Lets the CPU know we are in a busy-wait loop.
+static inline void cpu_relax ()
+{
+#if (defined __i386__ || defined __x86_64__) && defined __GNUC__
+    __asm__ volatile ("pause" : : : "memory");
+#elif defined ZMQ_HAVE_WINDOWS
+    YieldProcessor ();
+#endif
+}
+
+#if defined ZMQ_HAVE_LINUX
+
+//  Blocks while *addr_ equals value_, but no longer than timeout_
+//  milliseconds. Negative timeout means infinite.
+static int futex_wait (volatile uint32_t *addr_, uint32_t value_,
+    int timeout_)
+{
+    timespec ts;
+    if (timeout_ >= 0) {
+        ts.tv_sec = timeout_ / 1000;
+        ts.tv_nsec = (timeout_ % 1000) * 1000000;
+    }
+    return syscall (SYS_futex, addr_, FUTEX_WAIT_PRIVATE, value_,
+        timeout_ >= 0 ? &ts : NULL, NULL, 0);
+}
+
+static void futex_wake (volatile uint32_t *addr_)
+{
+    syscall (SYS_futex, addr_, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+#endif
+
+zmq::mailbox_t::mailbox_t () :
+    freed (NULL),
+    freed_count (0),
+    active (false),
+    signalled (false),
+    spin_avg (0),
+    stalls (0)
 {
-    //  Get the pipe into passive state. That way, if the users starts by
-    //  polling on the associated file descriptor it will get woken up when
-    //  new command is posted.
-    bool ok = cpipe.read (NULL);
-    zmq_assert (!ok);
-    active = false;
+    //  The list starts with a dummy node. The mailbox starts in passive
+    //  state. That way, if the users starts by polling on the associated
+    //  file descriptor it will get woken up when new command is posted.
+    head = new (std::nothrow) node_t;
+    alloc_assert (head);
+    tail.set ((node_t*) ((size_t) head | passive_flag));
 }
 
 zmq::mailbox_t::~mailbox_t ()
 {
-    //  TODO: Retrieve and deallocate commands inside the cpipe.
+    //  TODO: Deallocate resources owned by the commands still in the list.
+    while (head) {
+        node_t *next = head->next.load ();
+        delete head;
+        head = next;
+    }
+
+    //  Deallocate the spare nodes.
+    node_t *lists [] = {freed, spare.xchg (NULL)};
+    for (int i = 0; i != 2; i++) {
+        while (lists [i]) {
+            node_t *next = lists [i]->next.load ();
+            delete lists [i];
+            lists [i] = next;
+        }
+    }
 }
 
 zmq::fd_t zmq::mailbox_t::get_fd ()
@@ -43,29 +134,61 @@ zmq::fd_t zmq::mailbox_t::get_fd ()
 
 void zmq::mailbox_t::send (const command_t &cmd_)
 {
-    sync.lock ();
-    cpipe.write (cmd_, false);
-    bool ok = cpipe.flush ();
-    sync.unlock ();
-    if (!ok)
-        signaler.send ();
+    node_t *node = alloc_node ();
+    node->cmd = cmd_;
+
+    //  Append the node to the list. Until the previous node is linked to
+    //  it, the receiver may see the list as momentarily inconsistent.
+    node_t *prev = tail.xchg (node);
+    bool passive = ((size_t) prev & passive_flag) != 0;
+    prev = (node_t*) ((size_t) prev & ~passive_flag);
+    prev->next.xchg (node);
+
+    //  If the receiver was passive, we are the first to send a command
+    //  since then, so it's our responsibility to wake it up.
+    //  If the receiver is waiting in-process, hand the wake-up over to it
+    //  directly, otherwise use the signaler.
+    if (passive) {
+        wakeups.add (1);
+        while (true) {
+            atomic_counter_t::integer_t state = waiting.get ();
+            if (state == waiting_none) {
+                signaler.send ();
+                break;
+            }
+            if (waiting.cas (state, waiting_woken) == state) {
+#if defined ZMQ_HAVE_LINUX
+                if (state == waiting_sleeping)
+                    futex_wake (waiting.address ());
+#endif
+                break;
+            }
+        }
+    }
 }
 
-int zmq::mailbox_t::recv (command_t *cmd_, int timeout_)
+int zmq::mailbox_t::recv (command_t *cmd_, int timeout_, int spin_)
 {
     //  Try to get the command straight away.
     if (active) {
-        bool ok = cpipe.read (cmd_);
+        bool ok = read (cmd_);
         if (ok)
             return 0;
 
         //  If there are no more commands available, switch into passive state.
         active = false;
-        signaler.recv ();
+        if (signalled)
+            signaler.recv ();
     }
 
     //  Wait for signal from the command sender.
-    int rc = signaler.wait (timeout_);
+    int rc;
+    if (spin_ && timeout_ != 0)
+        rc = wait (timeout_, spin_);
+    else {
+        signalled = true;
+        rc = signaler.wait (timeout_);
+    }
     if (rc != 0 && (errno == EAGAIN || errno == EINTR))
         return -1;
 
@@ -74,8 +197,193 @@ int zmq::mailbox_t::recv (command_t *cmd_, int timeout_)
 
     //  Get a command.
     errno_assert (rc == 0);
-    bool ok = cpipe.read (cmd_);
+    bool ok = read (cmd_);
     zmq_assert (ok);
     return 0;
 }
 
+uint32_t zmq::mailbox_t::get_wakeups ()
+{
+    return wakeups.get ();
+}
+
+uint32_t zmq::mailbox_t::get_stalls ()
+{
+    return stalls;
+}
+
+bool zmq::mailbox_t::read (command_t *cmd_)
+{
+    node_t *next = head->next.load ();
+    if (!next) {
+
+        //  If no sender has swapped the tail since the last read, the list
+        //  is empty. Switch into passive state, unless a sender managed
+        //  to swap the tail in the meantime.
+        node_t *passive = (node_t*) ((size_t) head | passive_flag);
+        if (tail.cas (head, passive) == head)
+            return false;
+
+        //  A sender has swapped the tail but hasn't linked its node yet.
+        //  It is a matter of few instructions, unless the sender was
+        //  preempted, so give way to other threads while waiting.
+        stalls++;
+        while (!(next = head->next.load ())) {
+#if defined ZMQ_HAVE_WINDOWS
+            Sleep (0);
+#else
+            sched_yield ();
+#endif
+        }
+    }
+
+    *cmd_ = next->cmd;
+    free_node (head);
+    head = next;
+    return true;
+}
+
+zmq::mailbox_t::node_t *zmq::mailbox_t::alloc_node ()
+{
+    //  Take all the spare nodes, use the first one and give the rest back.
+    //  If the receiver has passed new spare nodes in the meantime, there's
+    //  no place to return the rest to, so deallocate them. That happens
+    //  only when several senders compete for the spare nodes.
+    node_t *node = spare.xchg (NULL);
+    if (node) {
+        node_t *rest = node->next.load ();
+        if (rest && spare.cas (NULL, rest) != NULL) {
+            while (rest) {
+                node_t *next = rest->next.load ();
+                delete rest;
+                rest = next;
+            }
+        }
+        node->next.set (NULL);
+        return node;
+    }
+
+    node = new (std::nothrow) node_t;
+    alloc_assert (node);
+    return node;
+}
+
+void zmq::mailbox_t::free_node (node_t *node_)
+{
+    if (freed_count == command_node_cache) {
+        delete node_;
+        return;
+    }
+    node_->next.set (freed);
+    freed = node_;
+    freed_count++;
+
+    //  If the senders have used up the spare nodes, pass them the ones
+    //  collected so far.
+    if (!spare.load () && spare.cas (NULL, freed) == NULL) {
+        freed = NULL;
+        freed_count = 0;
+    }
+}
+
+int zmq::mailbox_t::wait (int timeout_, int spin_)
+{
+    //  Let the senders know we are waiting.
+    atomic_counter_t::integer_t state =
+        waiting.cas (waiting_none, waiting_spinning);
+    zmq_assert (state == waiting_none);
+
+    //  If a command was sent since we've switched into passive state, its
+    //  sender might have checked the state before we've set it and is going
+    //  to use the signaler. Find out which way the wake-up goes.
+    if (!((size_t) tail.load () & passive_flag)) {
+        state = waiting.cas (waiting_spinning, waiting_none);
+        if (state == waiting_spinning) {
+            signalled = true;
+            return signaler.wait (timeout_);
+        }
+        zmq_assert (state == waiting_woken);
+        waiting.set (waiting_none);
+        signalled = false;
+        return 0;
+    }
+
+    //  Spin for a while. The length of the spin adapts to how long it took
+    //  to get woken up recently, but it never exceeds the specified limit.
+    if (multiprocessor ()) {
+        int limit = spin_avg / 500 + (spin_ + 3) / 4;
+        if (limit > spin_)
+            limit = spin_;
+        if (timeout_ > 0 && (int64_t) timeout_ * 1000 < limit)
+            limit = timeout_ * 1000;
+        uint64_t start = clock_t::now_us ();
+        while (true) {
+            uint64_t elapsed = clock_t::now_us () - start;
+            if (waiting.get () == waiting_woken) {
+                spin_avg += (int) (((int64_t) elapsed * 1000 - spin_avg) / 8);
+                waiting.set (waiting_none);
+                signalled = false;
+                return 0;
+            }
+            if (elapsed >= (uint64_t) limit)
+                break;
+            cpu_relax ();
+        }
+        spin_avg -= spin_avg / 8;
+    }
+
+#if defined ZMQ_HAVE_LINUX
+
+    //  Go to sleep on the state word unless woken up in the meantime.
+    state = waiting.cas (waiting_spinning, waiting_sleeping);
+    if (state == waiting_woken) {
+        waiting.set (waiting_none);
+        signalled = false;
+        return 0;
+    }
+    zmq_assert (state == waiting_spinning);
+
+    uint64_t end = timeout_ > 0 ? clock_t::now_us () / 1000 + timeout_ : 0;
+    int timeout = timeout_;
+    int err = 0;
+    while (waiting.get () != waiting_woken) {
+        int rc = futex_wait (waiting.address (), waiting_sleeping, timeout);
+        if (rc == -1 && errno == EINTR) {
+            err = EINTR;
+            break;
+        }
+        if (timeout_ > 0) {
+            uint64_t now = clock_t::now_us () / 1000;
+            if (now >= end) {
+                err = EAGAIN;
+                break;
+            }
+            timeout = (int) (end - now);
+        }
+    }
+
+    //  Stop waiting, unless a sender has woken us up at the last moment.
+    if (err && waiting.cas (waiting_sleeping, waiting_none) !=
+          waiting_woken) {
+        errno = err;
+        return -1;
+    }
+    waiting.set (waiting_none);
+    signalled = false;
+    return 0;
+
+#else
+
+    //  Block on the signaler unless woken up in the meantime.
+    state = waiting.cas (waiting_spinning, waiting_none);
+    if (state == waiting_woken) {
+        waiting.set (waiting_none);
+        signalled = false;
+        return 0;
+    }
+    zmq_assert (state == waiting_spinning);
+    signalled = true;
+    return signaler.wait (timeout_);
+
+#endif
+}
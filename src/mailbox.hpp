@@ -26,10 +26,10 @@
 #include "platform.hpp"
 #include "signaler.hpp"
 #include "fd.hpp"
-#include "config.hpp"
+#include "stdint.hpp"
 #include "command.hpp"
-#include "ypipe.hpp"
-#include "mutex.hpp"
+#include "atomic_ptr.hpp"
+#include "atomic_counter.hpp"
 
 namespace zmq
 {
@@ -43,27 +43,94 @@ namespace zmq
 
         fd_t get_fd ();
         void send (const command_t &cmd_);
-        int recv (command_t *cmd_, int timeout_);
-        
+
+        //  If spin_ is non-zero, a blocking recv busy-waits for a command
+        //  for up to spin_ microseconds before asking the OS to block.
+        int recv (command_t *cmd_, int timeout_, int spin_ = 0);
+
+        //  Contention statistics. Number of commands that had to wake up
+        //  the receiver and number of times the receiver had to wait for
+        //  a sender to finish enqueueing a command.
+        uint32_t get_wakeups ();
+        uint32_t get_stalls ();
+
     private:
 
-        //  The pipe to store actual commands.
-        typedef ypipe_t <command_t, command_pipe_granularity> cpipe_t;
-        cpipe_t cpipe;
+        //  There's only one thread receiving from the mailbox, but there
+        //  is arbitrary number of threads sending. Commands are stored in
+        //  a linked list of nodes. Senders append nodes by swapping the
+        //  tail pointer, so sending never blocks. The receiver owns the
+        //  head of the list, which is always a node already read.
+        struct node_t
+        {
+            atomic_ptr_t <node_t> next;
+            command_t cmd;
+        };
+
+        //  Reads a command. If there's none, switches into passive state
+        //  and returns false.
+        bool read (command_t *cmd_);
+
+        //  Waits for a sender to wake the passive receiver up, spinning
+        //  first and blocking in-process afterwards where possible.
+        int wait (int timeout_, int spin_);
+
+        //  Gets a node for a new command, reusing a spare one if possible.
+        node_t *alloc_node ();
+
+        //  Keeps the node already read for reuse. Accessed by the receiver
+        //  only.
+        void free_node (node_t *node_);
+
+        //  The node read last. Accessed by the receiver only.
+        node_t *head;
+
+        //  The node appended last. The lowest bit of the pointer is set
+        //  when the receiver is in passive state, ie. the next sender has
+        //  to wake it up.
+        atomic_ptr_t <node_t> tail;
+        enum {passive_flag = 1};
+
+        //  Nodes already read, linked via their 'next' pointers, and their
+        //  count. Accessed by the receiver only.
+        node_t *freed;
+        int freed_count;
+
+        //  List of nodes passed from the receiver to the senders for reuse.
+        //  A sender takes the whole list so that no two senders can get
+        //  the same node.
+        atomic_ptr_t <node_t> spare;
 
         //  Signaler to pass signals from writer thread to reader thread.
         signaler_t signaler;
 
-        //  There's only one thread receiving from the mailbox, but there
-        //  is arbitrary number of threads sending. Given that ypipe requires
-        //  synchronised access on both of its endpoints, we have to synchronise
-        //  the sending side.
-        mutex_t sync;
-
-        //  True if the underlying pipe is active, ie. when we are allowed to
-        //  read commands from it.
+        //  True if the reader is in active state, ie. when we are allowed
+        //  to read commands from the list.
         bool active;
 
+        //  State of the receiver waiting in wait (). Senders waking up
+        //  a spinning or sleeping receiver do so by setting the state to
+        //  'woken' rather than by using the signaler.
+        atomic_counter_t waiting;
+        enum {
+            waiting_none = 0,
+            waiting_spinning = 1,
+            waiting_sleeping = 2,
+            waiting_woken = 3
+        };
+
+        //  True if the receiver was woken up using the signaler, ie. the
+        //  signal has to be consumed when switching into passive state.
+        bool signalled;
+
+        //  Moving average of successful spins, in microseconds. Used to
+        //  adapt the length of the spin to the actual wake-up latency.
+        int spin_avg;
+
+        //  Contention statistics.
+        atomic_counter_t wakeups;
+        uint32_t stalls;
+
         //  Disable copying of mailbox_t object.
         mailbox_t (const mailbox_t&);
         const mailbox_t &operator = (const mailbox_t&);
@@ -0,0 +1,92 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_MEMFD
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "memfd.hpp"
+#include "err.hpp"
+
+zmq::fd_t zmq::memfd_store (const void *data_, size_t size_)
+{
+    fd_t fd = memfd_create ("zmq-msg", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1)
+        return retired_fd;
+
+    //  The data are written rather than mapped as the file can't be sealed
+    //  for writing while there's a writable mapping.
+    const unsigned char *pos = (const unsigned char*) data_;
+    size_t left = size_;
+    while (left) {
+        ssize_t nbytes = write (fd, pos, left);
+        if (nbytes == -1 && errno == EINTR)
+            continue;
+        if (nbytes == -1) {
+            int rc = close (fd);
+            errno_assert (rc == 0);
+            return retired_fd;
+        }
+        pos += nbytes;
+        left -= nbytes;
+    }
+
+    int rc = fcntl (fd, F_ADD_SEALS,
+        F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    if (rc == -1) {
+        rc = close (fd);
+        errno_assert (rc == 0);
+        return retired_fd;
+    }
+
+    return fd;
+}
+
+void *zmq::memfd_map (fd_t fd_, size_t size_)
+{
+    //  The mapping would fault if the sender could shrink the file. Check
+    //  that it can't modify it either.
+    const int seals = F_SEAL_SHRINK | F_SEAL_WRITE;
+    struct stat info;
+    void *data = MAP_FAILED;
+    if (fstat (fd_, &info) == 0 && (size_t) info.st_size == size_ &&
+          (fcntl (fd_, F_GET_SEALS) & seals) == seals)
+        data = mmap (NULL, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+            fd_, 0);
+
+    //  The mapping stays valid once the file descriptor is closed.
+    int rc = close (fd_);
+    errno_assert (rc == 0);
+
+    return data == MAP_FAILED ? NULL : data;
+}
+
+void zmq::memfd_unmap (void *data_, void *hint_)
+{
+    int rc = munmap (data_, (size_t) hint_);
+    errno_assert (rc == 0);
+}
+
+#endif
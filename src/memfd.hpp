@@ -0,0 +1,57 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_MEMFD_HPP_INCLUDED__
+#define __ZMQ_MEMFD_HPP_INCLUDED__
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_MEMFD
+
+#include <stddef.h>
+
+#include "fd.hpp"
+
+namespace zmq
+{
+
+    //  Large messages sent over ipc can be passed to the peer as memory
+    //  files. The files are sealed, so that the sender can't modify them
+    //  once they were passed, and the receiver maps them privately, so that
+    //  the content doesn't have to be copied once again.
+
+    //  Creates a sealed memory file holding a copy of the data. Returns
+    //  retired_fd on failure.
+    fd_t memfd_store (const void *data_, size_t size_);
+
+    //  Maps the memory file received from the peer, provided it's sealed
+    //  and has the expected size. Closes the file descriptor. Returns NULL
+    //  on failure.
+    void *memfd_map (fd_t fd_, size_t size_);
+
+    //  Deallocation function of the messages mapping memory files. The
+    //  hint is the size of the mapping.
+    void memfd_unmap (void *data_, void *hint_);
+
+}
+
+#endif
+
+#endif
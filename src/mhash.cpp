@@ -0,0 +1,114 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "mhash.hpp"
+#include "pipe.hpp"
+#include "err.hpp"
+
+zmq::mhash_t::mhash_t () :
+    empty_hash (subscriptions_t::hash (NULL, 0))
+{
+}
+
+zmq::mhash_t::~mhash_t ()
+{
+}
+
+bool zmq::mhash_t::add (unsigned char *key_, size_t size_, pipe_t *pipe_)
+{
+    uint32_t hash = subscriptions_t::hash (key_, size_);
+    pipes_t *pipes = subscriptions.find (key_, size_, hash);
+    if (!pipes) {
+        pipes_t single (1, pipe_);
+        subscriptions.insert (blob_t (key_, size_), hash, single);
+        return true;
+    }
+
+    pipes_t::iterator it = std::lower_bound (pipes->begin (), pipes->end (),
+        pipe_);
+    if (it == pipes->end () || *it != pipe_)
+        pipes->insert (it, pipe_);
+    return false;
+}
+
+void zmq::mhash_t::rm (pipe_t *pipe_,
+    void (*func_) (unsigned char *data_, size_t size_, void *arg_),
+    void *arg_)
+{
+    //  The subscriptions left with no pipes are collected first as removing
+    //  them from the map moves the other entries.
+    std::vector <blob_t> unused;
+    for (size_t pos = 0; pos != subscriptions.capacity (); pos++) {
+        if (!subscriptions.used (pos))
+            continue;
+        pipes_t &pipes = subscriptions.value (pos);
+        pipes_t::iterator it = std::lower_bound (pipes.begin (), pipes.end (),
+            pipe_);
+        if (it == pipes.end () || *it != pipe_)
+            continue;
+        pipes.erase (it);
+        if (pipes.empty ())
+            unused.push_back (subscriptions.key (pos));
+    }
+
+    for (std::vector <blob_t>::size_type i = 0; i != unused.size (); i++) {
+        subscriptions.erase (unused [i], subscriptions_t::hash (unused [i]));
+        func_ ((unsigned char*) unused [i].data (), unused [i].size (), arg_);
+    }
+}
+
+bool zmq::mhash_t::rm (unsigned char *key_, size_t size_, pipe_t *pipe_)
+{
+    uint32_t hash = subscriptions_t::hash (key_, size_);
+    pipes_t *pipes = subscriptions.find (key_, size_, hash);
+    if (!pipes)
+        return false;
+
+    pipes_t::iterator it = std::lower_bound (pipes->begin (), pipes->end (),
+        pipe_);
+    if (it == pipes->end () || *it != pipe_)
+        return false;
+    pipes->erase (it);
+    if (!pipes->empty ())
+        return false;
+
+    subscriptions.erase (blob_t (key_, size_), hash);
+    return true;
+}
+
+void zmq::mhash_t::match (unsigned char *topic_, size_t size_,
+    void (*func_) (pipe_t *pipe_, void *arg_), void *arg_)
+{
+    pipes_t *pipes = subscriptions.find (topic_, size_,
+        subscriptions_t::hash (topic_, size_));
+    if (pipes)
+        for (pipes_t::size_type i = 0; i != pipes->size (); i++)
+            func_ ((*pipes) [i], arg_);
+
+    //  Signal the pipes subscribed to all the messages.
+    if (size_) {
+        pipes = subscriptions.find (topic_, 0, empty_hash);
+        if (pipes)
+            for (pipes_t::size_type i = 0; i != pipes->size (); i++)
+                func_ ((*pipes) [i], arg_);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_MHASH_HPP_INCLUDED__
+#define __ZMQ_MHASH_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <vector>
+
+#include "identity_map.hpp"
+
+namespace zmq
+{
+
+    //  Multi-hash. Set of subscriptions matched exactly rather than as
+    //  prefixes, each mapped to the set of pipes subscribed to it. Matching
+    //  a message is a single hash lookup regardless of the number of
+    //  subscriptions. The exception is the empty subscription, which
+    //  matches all messages.
+
+    class mhash_t
+    {
+    public:
+
+        mhash_t ();
+        ~mhash_t ();
+
+        //  Add key to the set. Returns true if it's a new subscription
+        //  rather than a duplicate.
+        bool add (unsigned char *key_, size_t size_, class pipe_t *pipe_);
+
+        //  Remove all subscriptions for a specific peer from the set.
+        //  If there are no subscriptions left on some topics, invoke the
+        //  supplied callback function.
+        void rm (class pipe_t *pipe_,
+            void (*func_) (unsigned char *data_, size_t size_, void *arg_),
+            void *arg_);
+
+        //  Remove specific subscription from the set. Return true is it was
+        //  actually removed rather than de-duplicated.
+        bool rm (unsigned char *key_, size_t size_, class pipe_t *pipe_);
+
+        //  Signal all the pipes subscribed to the topic.
+        void match (unsigned char *topic_, size_t size_,
+            void (*func_) (class pipe_t *pipe_, void *arg_), void *arg_);
+
+    private:
+
+        //  Sorted array of pipes subscribed to a topic.
+        typedef std::vector <class pipe_t*> pipes_t;
+
+        typedef identity_map_t <pipes_t> subscriptions_t;
+        subscriptions_t subscriptions;
+
+        //  Hash of the empty subscription.
+        uint32_t empty_hash;
+
+        mhash_t (const mhash_t&);
+        const mhash_t &operator = (const mhash_t&);
+    };
+
+}
+
+#endif
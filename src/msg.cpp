@@ -19,6 +19,7 @@
 */
 
 #include "msg.hpp"
+#include "msg_pool.hpp"
 #include "../include/zmq.h"
 
 #include <string.h>
@@ -48,7 +49,39 @@ int zmq::msg_t::init ()
     return 0;
 }
 
-int zmq::msg_t::init_size (size_t size_)
+zmq::msg_t::content_t *zmq::msg_t::alloc_content (size_t extra_,
+    bool pooled_)
+{
+    content_t *content = NULL;
+    if (pooled_)
+        content = (content_t*) msg_pool_alloc (sizeof (content_t) + extra_);
+    if (content)
+        content->pooled = true;
+    else {
+        content = (content_t*) malloc (sizeof (content_t) + extra_);
+        if (!content)
+            return NULL;
+        content->pooled = false;
+    }
+    return content;
+}
+
+void zmq::msg_t::free_content (content_t *content_)
+{
+    if (!content_->pooled) {
+        free (content_);
+        return;
+    }
+
+    //  The pool needs the size of the block. Data allocated along with the
+    //  content structure immediately follow it.
+    size_t size = sizeof (content_t);
+    if (content_->data == content_ + 1)
+        size += content_->size;
+    msg_pool_free (content_, size);
+}
+
+int zmq::msg_t::init_size (size_t size_, bool pooled_)
 {
     if (size_ <= max_vsm_size) {
         u.vsm.type = type_vsm;
@@ -58,8 +91,7 @@ int zmq::msg_t::init_size (size_t size_)
     else {
         u.lmsg.type = type_lmsg;
         u.lmsg.flags = 0;
-        u.lmsg.content =
-            (content_t*) malloc (sizeof (content_t) + size_);
+        u.lmsg.content = alloc_content (size_, pooled_);
         if (!u.lmsg.content) {
             errno = ENOMEM;
             return -1;
@@ -75,11 +107,11 @@ int zmq::msg_t::init_size (size_t size_)
 }
 
 int zmq::msg_t::init_data (void *data_, size_t size_, msg_free_fn *ffn_,
-    void *hint_)
+    void *hint_, bool pooled_)
 {
     u.lmsg.type = type_lmsg;
     u.lmsg.flags = 0;
-    u.lmsg.content = (content_t*) malloc (sizeof (content_t));
+    u.lmsg.content = alloc_content (0, pooled_);
     if (!u.lmsg.content) {
         errno = ENOMEM;
         return -1;
@@ -123,7 +155,7 @@ int zmq::msg_t::close ()
             if (u.lmsg.content->ffn)
                 u.lmsg.content->ffn (u.lmsg.content->data,
                     u.lmsg.content->hint);
-            free (u.lmsg.content);
+            free_content (u.lmsg.content);
         }
     }
 
@@ -54,9 +54,11 @@ namespace zmq
 
         bool check ();
         int init ();
-        int init_size (size_t size_);
+        //  If pooled_ is true, the content block is taken from the calling
+        //  thread's message pool (see msg_pool.hpp) instead of the heap.
+        int init_size (size_t size_, bool pooled_ = false);
         int init_data (void *data_, size_t size_, msg_free_fn *ffn_,
-            void *hint_);
+            void *hint_, bool pooled_ = false);
         int init_delimiter ();
         int close ();
         int move (msg_t &src_);
@@ -88,7 +90,8 @@ namespace zmq
         //  In the latter case, ffn member stores pointer to the function to be
         //  used to deallocate the data. If the buffer is actually shared (there
         //  are at least 2 references to it) refcount member contains number of
-        //  references.
+        //  references. If pooled is set, the structure itself was allocated
+        //  from the message pool rather than from the heap.
         struct content_t
         {
             void *data;
@@ -96,8 +99,14 @@ namespace zmq
             msg_free_fn *ffn;
             void *hint;
             zmq::atomic_counter_t refcnt;
+            bool pooled;
         };
 
+        //  Allocates/deallocates content_t structure with 'extra' bytes of
+        //  data appended.
+        static content_t *alloc_content (size_t extra_, bool pooled_);
+        static void free_content (content_t *content_);
+
         //  Different message types.
         enum type_t
         {
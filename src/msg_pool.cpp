@@ -0,0 +1,276 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "msg_pool.hpp"
+#include "platform.hpp"
+#include "atomic_counter.hpp"
+#include "config.hpp"
+#include "mutex.hpp"
+#include "err.hpp"
+
+#include <stdlib.h>
+
+#if !defined ZMQ_HAVE_WINDOWS
+#include <pthread.h>
+#endif
+
+//  Size classes go in steps of one and one and a half of a power of two,
+//  starting with the smallest block, i.e. 64, 96, 128, 192, 256 etc.
+//  max_classes is an upper bound on the number of classes needed to reach
+//  msg_pool_max_block.
+enum
+{
+    min_block = 64,
+    max_classes = 64
+};
+
+static int size_class (size_t size_)
+{
+    if (size_ <= min_block)
+        return 0;
+
+    //  Find the largest power of two that is still smaller than size_.
+    size_t base = min_block;
+    int index = 0;
+    while (base * 2 < size_) {
+        base *= 2;
+        index += 2;
+    }
+    return size_ <= base + base / 2 ? index + 1 : index + 2;
+}
+
+static size_t class_size (int class_)
+{
+    if (class_ == 0)
+        return min_block;
+    size_t base = (size_t) min_block << ((class_ - 1) / 2);
+    return class_ % 2 ? base + base / 2 : base * 2;
+}
+
+//  Number of blocks moved between a thread's cache and the depot in one go.
+static int batch_blocks (int class_)
+{
+    size_t blocks = zmq::msg_pool_batch_bytes / class_size (class_);
+    if (blocks < 4)
+        return 4;
+    if (blocks > 128)
+        return 128;
+    return (int) blocks;
+}
+
+//  Free blocks are chained through their first word. The first block of
+//  a batch stored in the depot uses its second word to link to the next
+//  batch.
+static inline void *&next_block (void *block_)
+{
+    return ((void**) block_) [0];
+}
+
+static inline void *&next_batch (void *batch_)
+{
+    return ((void**) batch_) [1];
+}
+
+//  Shared per-class storage of full batches.
+struct depot_t
+{
+    depot_t () :
+        batches (NULL),
+        count (0)
+    {
+    }
+
+    zmq::mutex_t sync;
+    void *batches;
+    int count;
+};
+
+static depot_t depots [max_classes];
+
+//  Number of contexts that have the pool enabled.
+static zmq::atomic_counter_t active_contexts;
+
+//  Pushes a batch of exactly batch_blocks (class_) blocks to the depot.
+//  If the depot is full, the blocks are returned to the heap instead.
+static void put_batch (int class_, void *batch_)
+{
+    depot_t &depot = depots [class_];
+    depot.sync.lock ();
+    if (depot.count < zmq::msg_pool_max_batches) {
+        next_batch (batch_) = depot.batches;
+        depot.batches = batch_;
+        depot.count++;
+        depot.sync.unlock ();
+        return;
+    }
+    depot.sync.unlock ();
+
+    while (batch_) {
+        void *next = next_block (batch_);
+        free (batch_);
+        batch_ = next;
+    }
+}
+
+//  Retrieves a batch from the depot. Returns NULL if there is none.
+static void *get_batch (int class_)
+{
+    depot_t &depot = depots [class_];
+    depot.sync.lock ();
+    void *batch = depot.batches;
+    if (batch) {
+        depot.batches = next_batch (batch);
+        depot.count--;
+    }
+    depot.sync.unlock ();
+    return batch;
+}
+
+#if !defined ZMQ_HAVE_WINDOWS
+
+//  Per-thread cache of free blocks.
+struct cache_t
+{
+    void *head [max_classes];
+    int count [max_classes];
+};
+
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+//  Invoked on thread exit. The cached blocks are handed back to the heap
+//  rather than to the depot as partial batches cannot be stored there.
+static void destroy_cache (void *arg_)
+{
+    cache_t *cache = (cache_t*) arg_;
+    for (int i = 0; i != max_classes; i++) {
+        void *block = cache->head [i];
+        while (block) {
+            void *next = next_block (block);
+            free (block);
+            block = next;
+        }
+    }
+    free (cache);
+}
+
+static void create_cache_key ()
+{
+    int rc = pthread_key_create (&cache_key, destroy_cache);
+    posix_assert (rc);
+}
+
+static cache_t *get_cache ()
+{
+    int rc = pthread_once (&cache_key_once, create_cache_key);
+    posix_assert (rc);
+    cache_t *cache = (cache_t*) pthread_getspecific (cache_key);
+    if (cache)
+        return cache;
+
+    cache = (cache_t*) calloc (1, sizeof (cache_t));
+    if (!cache)
+        return NULL;
+    rc = pthread_setspecific (cache_key, cache);
+    posix_assert (rc);
+    return cache;
+}
+
+#endif
+
+void *zmq::msg_pool_alloc (size_t size_)
+{
+#if defined ZMQ_HAVE_WINDOWS
+    //  Thread-local caches are not implemented on Windows yet.
+    return NULL;
+#else
+    if (size_ > zmq::msg_pool_max_block)
+        return NULL;
+
+    int cls = size_class (size_);
+    zmq_assert (cls < max_classes);
+    cache_t *cache = get_cache ();
+    if (!cache)
+        return NULL;
+
+    //  If the local cache is empty, try to get a batch of blocks returned by
+    //  other threads. If there are none, allocate a new block from the heap.
+    if (!cache->head [cls]) {
+        cache->head [cls] = get_batch (cls);
+        if (!cache->head [cls])
+            return malloc (class_size (cls));
+        cache->count [cls] = batch_blocks (cls);
+    }
+
+    void *block = cache->head [cls];
+    cache->head [cls] = next_block (block);
+    cache->count [cls]--;
+    return block;
+#endif
+}
+
+void zmq::msg_pool_free (void *block_, size_t size_)
+{
+#if defined ZMQ_HAVE_WINDOWS
+    zmq_assert (false);
+#else
+    int cls = size_class (size_);
+    zmq_assert (cls < max_classes);
+    cache_t *cache = get_cache ();
+    if (!cache) {
+        free (block_);
+        return;
+    }
+
+    next_block (block_) = cache->head [cls];
+    cache->head [cls] = block_;
+    cache->count [cls]++;
+
+    //  If the cache has grown over two batches, which happens when this
+    //  thread is releasing blocks allocated by a different thread, move
+    //  a batch worth of blocks to the depot.
+    int batch = batch_blocks (cls);
+    if (cache->count [cls] > 2 * batch) {
+        void *first = cache->head [cls];
+        void *last = first;
+        for (int i = 1; i != batch; i++)
+            last = next_block (last);
+        cache->head [cls] = next_block (last);
+        cache->count [cls] -= batch;
+        next_block (last) = NULL;
+        put_batch (cls, first);
+    }
+#endif
+}
+
+void zmq::msg_pool_acquire ()
+{
+    active_contexts.add (1);
+}
+
+void zmq::msg_pool_release ()
+{
+    active_contexts.sub (1);
+}
+
+bool zmq::msg_pool_active ()
+{
+    return active_contexts.get () != 0;
+}
@@ -0,0 +1,56 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_MSG_POOL_HPP_INCLUDED__
+#define __ZMQ_MSG_POOL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+namespace zmq
+{
+
+    //  Size-classed pool for message content blocks. Each thread keeps
+    //  a private cache of free blocks per size class so that allocation and
+    //  deallocation in the common case touch no shared state. When a thread
+    //  frees blocks allocated elsewhere (typically an I/O thread releasing
+    //  messages produced by an application thread) its cache grows and the
+    //  surplus is handed back to a shared depot in batches, where the
+    //  allocating thread picks it up again, one lock per batch.
+
+    //  Allocates a block of at least size_ bytes. Returns NULL if the size
+    //  is not served by the pool, in which case the caller is expected to
+    //  fall back to malloc.
+    void *msg_pool_alloc (size_t size_);
+
+    //  Returns a block obtained from msg_pool_alloc to the pool. size_
+    //  must be the same value that was passed to msg_pool_alloc.
+    void msg_pool_free (void *block_, size_t size_);
+
+    //  Contexts that enable the pool register themselves here. Allocations
+    //  that cannot be attributed to any context (zmq_msg_init_size and
+    //  zmq_msg_init_data) use the pool while at least one such context
+    //  exists.
+    void msg_pool_acquire ();
+    void msg_pool_release ();
+    bool msg_pool_active ();
+
+}
+
+#endif
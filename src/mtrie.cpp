@@ -19,6 +19,7 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <new>
 #include <algorithm>
@@ -32,218 +33,409 @@
 #include "pipe.hpp"
 #include "mtrie.hpp"
 
-zmq::mtrie_t::mtrie_t () :
-    min (0),
-    count (0)
+zmq::mtrie_t::mtrie_t ()
 {
+    root = new_node (NULL, 0);
 }
 
 zmq::mtrie_t::~mtrie_t ()
 {
-    if (count == 1)
-        delete next.node;
-    else if (count > 1) {
-        for (unsigned short i = 0; i != count; ++i)
-            if (next.table [i])
-                delete next.table [i];
-        free (next.table);
+    delete_node (root);
+}
+
+zmq::mtrie_t::node_t *zmq::mtrie_t::new_node (const unsigned char *prefix_,
+    size_t size_)
+{
+    node_t *node = (node_t*) malloc (sizeof (node_t) + size_);
+    alloc_assert (node);
+    node->pipes.pipes = NULL;
+    node->pipes_count = 0;
+    node->prefix_size = (uint32_t) size_;
+    node->children = NULL;
+    node->children_count = 0;
+    node->table = false;
+    if (size_)
+        memcpy (node->prefix (), prefix_, size_);
+    return node;
+}
+
+void zmq::mtrie_t::delete_node (node_t *node_)
+{
+    if (node_->table) {
+        for (int c = 0; c != 256; c++)
+            if (node_->children [c])
+                delete_node (node_->children [c]);
+    }
+    else {
+        for (unsigned short i = 0; i != node_->children_count; i++)
+            delete_node (node_->children [i]);
     }
+    free (node_->children);
+    if (node_->pipes_count > 1)
+        free (node_->pipes.pipes);
+    free (node_);
 }
 
-bool zmq::mtrie_t::add (unsigned char *prefix_, size_t size_, pipe_t *pipe_)
+bool zmq::mtrie_t::add_pipe (node_t *node_, pipe_t *pipe_)
 {
-    return add_helper (prefix_, size_, pipe_);
+    if (node_->pipes_count == 0) {
+        node_->pipes.pipe = pipe_;
+        node_->pipes_count = 1;
+        return true;
+    }
+
+    if (node_->pipes_count == 1) {
+        if (node_->pipes.pipe == pipe_)
+            return false;
+        pipe_t **pipes = (pipe_t**) malloc (2 * sizeof (pipe_t*));
+        alloc_assert (pipes);
+        pipes [0] = std::min (node_->pipes.pipe, pipe_);
+        pipes [1] = std::max (node_->pipes.pipe, pipe_);
+        node_->pipes.pipes = pipes;
+        node_->pipes_count = 2;
+        return false;
+    }
+
+    pipe_t **end = node_->pipes.pipes + node_->pipes_count;
+    pipe_t **it = std::lower_bound (node_->pipes.pipes, end, pipe_);
+    if (it != end && *it == pipe_)
+        return false;
+    size_t pos = it - node_->pipes.pipes;
+    node_->pipes.pipes = (pipe_t**) realloc (node_->pipes.pipes,
+        (node_->pipes_count + 1) * sizeof (pipe_t*));
+    alloc_assert (node_->pipes.pipes);
+    memmove (node_->pipes.pipes + pos + 1, node_->pipes.pipes + pos,
+        (node_->pipes_count - pos) * sizeof (pipe_t*));
+    node_->pipes.pipes [pos] = pipe_;
+    node_->pipes_count++;
+    return false;
 }
 
-bool zmq::mtrie_t::add_helper (unsigned char *prefix_, size_t size_,
-    pipe_t *pipe_)
+bool zmq::mtrie_t::rm_pipe (node_t *node_, pipe_t *pipe_)
 {
-    //  We are at the node corresponding to the prefix. We are done.
-    if (!size_) {
-        bool result = pipes.empty ();
-        pipes.insert (pipe_);
-        return result;
+    if (node_->pipes_count == 0)
+        return false;
+
+    if (node_->pipes_count == 1) {
+        if (node_->pipes.pipe != pipe_)
+            return false;
+        node_->pipes.pipe = NULL;
+        node_->pipes_count = 0;
+        return true;
+    }
+
+    pipe_t **end = node_->pipes.pipes + node_->pipes_count;
+    pipe_t **it = std::lower_bound (node_->pipes.pipes, end, pipe_);
+    if (it == end || *it != pipe_)
+        return false;
+    memmove (it, it + 1, (end - it - 1) * sizeof (pipe_t*));
+    node_->pipes_count--;
+
+    //  Switch back to storing the single pipe inline.
+    if (node_->pipes_count == 1) {
+        pipe_t *pipe = node_->pipes.pipes [0];
+        free (node_->pipes.pipes);
+        node_->pipes.pipe = pipe;
     }
+    return true;
+}
 
-    unsigned char c = *prefix_;
-    if (c < min || c >= min + count) {
+zmq::mtrie_t::node_t **zmq::mtrie_t::find_child (node_t *node_,
+    unsigned char c_)
+{
+    if (node_->table)
+        return node_->children [c_] ? &node_->children [c_] : NULL;
+
+    //  With no children there's no array to scan.
+    if (!node_->children_count)
+        return NULL;
+
+    unsigned char *keys =
+        (unsigned char*) (node_->children + node_->children_count);
+    unsigned char *key = (unsigned char*) memchr (keys, c_,
+        node_->children_count);
+    return key ? &node_->children [key - keys] : NULL;
+}
 
-        //  The character is out of range of currently handled
-        //  charcters. We have to extend the table.
-        if (!count) {
-            min = c;
-            count = 1;
-            next.node = NULL;
-        }
-        else if (count == 1) {
-            unsigned char oldc = min;
-            mtrie_t *oldp = next.node;
-            count = (min < c ? c - min : min - c) + 1;
-            next.table = (mtrie_t**)
-                malloc (sizeof (mtrie_t*) * count);
-            zmq_assert (next.table);
-            for (unsigned short i = 0; i != count; ++i)
-                next.table [i] = 0;
-            min = std::min (min, c);
-            next.table [oldc - min] = oldp;
-        }
-        else if (min < c) {
-
-            //  The new character is above the current character range.
-            unsigned short old_count = count;
-            count = c - min + 1;
-            next.table = (mtrie_t**) realloc ((void*) next.table,
-                sizeof (mtrie_t*) * count);
-            zmq_assert (next.table);
-            for (unsigned short i = old_count; i != count; i++)
-                next.table [i] = NULL;
-        }
-        else {
-
-            //  The new character is below the current character range.
-            unsigned short old_count = count;
-            count = (min + old_count) - c;
-            next.table = (mtrie_t**) realloc ((void*) next.table,
-                sizeof (mtrie_t*) * count);
-            zmq_assert (next.table);
-            memmove (next.table + min - c, next.table,
-                old_count * sizeof (mtrie_t*));
-            for (unsigned short i = 0; i != min - c; i++)
-                next.table [i] = NULL;
-            min = c;
-        }
+void zmq::mtrie_t::add_child (node_t *node_, node_t *child_)
+{
+    unsigned char c = child_->prefix () [0];
+
+    if (node_->table) {
+        zmq_assert (!node_->children [c]);
+        node_->children [c] = child_;
+        node_->children_count++;
+        return;
     }
 
-    //  If next node does not exist, create one.
-    if (count == 1) {
-        if (!next.node) {
-            next.node = new (std::nothrow) mtrie_t;
-            zmq_assert (next.node);
-        }
-        return next.node->add_helper (prefix_ + 1, size_ - 1, pipe_);
+    //  Too many children to keep them in the array. Switch to the table.
+    unsigned short count = node_->children_count;
+    if (count == max_array_children) {
+        node_t **table = (node_t**) malloc (256 * sizeof (node_t*));
+        alloc_assert (table);
+        memset (table, 0, 256 * sizeof (node_t*));
+        unsigned char *keys = (unsigned char*) (node_->children + count);
+        for (unsigned short i = 0; i != count; i++)
+            table [keys [i]] = node_->children [i];
+        table [c] = child_;
+        free (node_->children);
+        node_->children = table;
+        node_->children_count++;
+        node_->table = true;
+        return;
     }
-    else {
-        if (!next.table [c - min]) {
-            next.table [c - min] = new (std::nothrow) mtrie_t;
-            zmq_assert (next.table [c - min]);
+
+    //  Make space for the new child. The keys follow the child pointers
+    //  so they have to be moved as well.
+    node_->children = (node_t**) realloc (node_->children,
+        (count + 1) * (sizeof (node_t*) + 1));
+    alloc_assert (node_->children);
+    unsigned char *keys = (unsigned char*) (node_->children + count + 1);
+    memmove (keys, node_->children + count, count);
+
+    //  Keep the children sorted.
+    unsigned short pos = (unsigned short) (std::lower_bound (keys,
+        keys + count, c) - keys);
+    memmove (node_->children + pos + 1, node_->children + pos,
+        (count - pos) * sizeof (node_t*));
+    memmove (keys + pos + 1, keys + pos, count - pos);
+    node_->children [pos] = child_;
+    keys [pos] = c;
+    node_->children_count++;
+}
+
+void zmq::mtrie_t::rm_child (node_t *node_, unsigned char c_)
+{
+    if (node_->table) {
+        zmq_assert (node_->children [c_]);
+        node_->children [c_] = NULL;
+        node_->children_count--;
+        return;
+    }
+
+    unsigned short count = node_->children_count;
+    if (!count)
+        return;
+    unsigned char *keys = (unsigned char*) (node_->children + count);
+    unsigned char *key = (unsigned char*) memchr (keys, c_, count);
+    zmq_assert (key);
+    unsigned short pos = (unsigned short) (key - keys);
+    memmove (node_->children + pos, node_->children + pos + 1,
+        (count - pos - 1) * sizeof (node_t*));
+    memmove (keys + pos, keys + pos + 1, count - pos - 1);
+
+    //  Move the keys right after the remaining child pointers.
+    memmove (node_->children + count - 1, keys, count - 1);
+    node_->children_count--;
+    if (!node_->children_count) {
+        free (node_->children);
+        node_->children = NULL;
+    }
+}
+
+void zmq::mtrie_t::compact (node_t *node_)
+{
+    if (!node_->table || node_->children_count > max_array_children / 2)
+        return;
+
+    unsigned short count = node_->children_count;
+    node_t **children = NULL;
+    if (count) {
+        children = (node_t**) malloc (count * (sizeof (node_t*) + 1));
+        alloc_assert (children);
+        unsigned char *keys = (unsigned char*) (children + count);
+        unsigned short pos = 0;
+        for (int c = 0; c != 256; c++)
+            if (node_->children [c]) {
+                children [pos] = node_->children [c];
+                keys [pos] = (unsigned char) c;
+                pos++;
+            }
+    }
+    free (node_->children);
+    node_->children = children;
+    node_->table = false;
+}
+
+void zmq::mtrie_t::prune (node_t *parent_, node_t **slot_)
+{
+    node_t *node = *slot_;
+    if (node->pipes_count)
+        return;
+
+    //  Nobody is subscribed to the node or any longer prefix.
+    if (!node->children_count) {
+        rm_child (parent_, node->prefix () [0]);
+        delete_node (node);
+        return;
+    }
+
+    //  Node with a single child is merged with the child.
+    if (node->children_count == 1) {
+        node_t *child;
+        if (node->table) {
+            int c = 0;
+            while (!node->children [c])
+                c++;
+            child = node->children [c];
         }
-        return next.table [c - min]->add_helper (prefix_ + 1, size_ - 1, pipe_);
+        else
+            child = node->children [0];
+
+        size_t size = node->prefix_size + child->prefix_size;
+        child = (node_t*) realloc (child, sizeof (node_t) + size);
+        alloc_assert (child);
+        memmove (child->prefix () + node->prefix_size, child->prefix (),
+            child->prefix_size);
+        memcpy (child->prefix (), node->prefix (), node->prefix_size);
+        child->prefix_size = (uint32_t) size;
+        *slot_ = child;
+
+        free (node->children);
+        free (node);
     }
 }
 
+bool zmq::mtrie_t::add (unsigned char *prefix_, size_t size_, pipe_t *pipe_)
+{
+    node_t *node = root;
+    while (size_) {
+
+        //  If there's no node for the prefix yet, create one holding
+        //  the rest of the prefix.
+        node_t **slot = find_child (node, *prefix_);
+        if (!slot) {
+            node_t *child = new_node (prefix_, size_);
+            add_child (node, child);
+            return add_pipe (child, pipe_);
+        }
+
+        //  Find out how much of the child's prefix matches.
+        node_t *child = *slot;
+        size_t common = 1;
+        while (common != child->prefix_size && common != size_ &&
+              child->prefix () [common] == prefix_ [common])
+            common++;
+
+        //  If the prefix ends or differs in the middle of the child's prefix,
+        //  split the child in two.
+        if (common != child->prefix_size) {
+            node_t *split = new_node (child->prefix (), common);
+            child->prefix_size -= (uint32_t) common;
+            memmove (child->prefix (), child->prefix () + common,
+                child->prefix_size);
+            add_child (split, child);
+            *slot = split;
+            child = split;
+        }
+
+        node = child;
+        prefix_ += common;
+        size_ -= common;
+    }
+
+    return add_pipe (node, pipe_);
+}
 
 void zmq::mtrie_t::rm (pipe_t *pipe_,
     void (*func_) (unsigned char *data_, size_t size_, void *arg_),
     void *arg_)
 {
     unsigned char *buff = NULL;
-    rm_helper (pipe_, &buff, 0, 0, func_, arg_);
+    size_t maxbuffsize = 0;
+    rm_helper (root, pipe_, &buff, 0, &maxbuffsize, func_, arg_);
     free (buff);
 }
 
-void zmq::mtrie_t::rm_helper (pipe_t *pipe_, unsigned char **buff_,
-    size_t buffsize_, size_t maxbuffsize_,
+void zmq::mtrie_t::rm_helper (node_t *node_, pipe_t *pipe_,
+    unsigned char **buff_, size_t buffsize_, size_t *maxbuffsize_,
     void (*func_) (unsigned char *data_, size_t size_, void *arg_),
     void *arg_)
 {
     //  Remove the subscription from this node.
-    if (pipes.erase (pipe_) && pipes.empty ())
+    if (rm_pipe (node_, pipe_) && !node_->pipes_count)
         func_ (*buff_, buffsize_, arg_);
 
-    //  Adjust the buffer.
-    if (buffsize_ >= maxbuffsize_) {
-        maxbuffsize_ = buffsize_ + 256;
-        *buff_ = (unsigned char*) realloc (*buff_, maxbuffsize_);
-        alloc_assert (*buff_);
-    }
-
-    //  If there are no subnodes in the trie, return.
-    if (count == 0)
-        return;
+    //  Process the children. They are visited backwards so that removal of
+    //  a child doesn't move the children not visited yet.
+    int i = node_->table ? 256 : node_->children_count;
+    while (i-- != 0) {
+        node_t **slot = &node_->children [i];
+        if (!*slot)
+            continue;
+
+        //  Adjust the buffer and append the child's prefix.
+        node_t *child = *slot;
+        size_t size = buffsize_ + child->prefix_size;
+        if (size > *maxbuffsize_) {
+            *maxbuffsize_ = size + 256;
+            *buff_ = (unsigned char*) realloc (*buff_, *maxbuffsize_);
+            alloc_assert (*buff_);
+        }
+        memcpy (*buff_ + buffsize_, child->prefix (), child->prefix_size);
 
-    //  If there's one subnode (optimisation).
-    if (count == 1) {
-        (*buff_) [buffsize_] = min;
-        buffsize_++;
-        next.node->rm_helper (pipe_, buff_, buffsize_, maxbuffsize_,
-            func_, arg_);
-        return;
+        rm_helper (child, pipe_, buff_, size, maxbuffsize_, func_, arg_);
+        prune (node_, slot);
     }
-
-    //  If there are multiple subnodes.
-    for (unsigned char c = 0; c != count; c++) {
-        (*buff_) [buffsize_] = min + c;
-        if (next.table [c])
-            next.table [c]->rm_helper (pipe_, buff_, buffsize_ + 1,
-                maxbuffsize_, func_, arg_);
-    }  
+    compact (node_);
 }
 
 bool zmq::mtrie_t::rm (unsigned char *prefix_, size_t size_, pipe_t *pipe_)
 {
-    return rm_helper (prefix_, size_, pipe_);
+    return rm_helper (root, prefix_, size_, pipe_);
 }
 
-bool zmq::mtrie_t::rm_helper (unsigned char *prefix_, size_t size_,
-    pipe_t *pipe_)
+bool zmq::mtrie_t::rm_helper (node_t *node_, unsigned char *prefix_,
+    size_t size_, pipe_t *pipe_)
 {
-    if (!size_) {
-        pipes_t::size_type erased = pipes.erase (pipe_);
-        zmq_assert (erased == 1);
-        return pipes.empty ();
-    }
+    if (!size_)
+        return rm_pipe (node_, pipe_) && !node_->pipes_count;
 
-    unsigned char c = *prefix_;
-    if (!count || c < min || c >= min + count)
+    node_t **slot = find_child (node_, *prefix_);
+    if (!slot)
         return false;
-
-    mtrie_t *next_node =
-        count == 1 ? next.node : next.table [c - min];
-
-    if (!next_node)
+    node_t *child = *slot;
+    if (child->prefix_size > size_ ||
+          memcmp (child->prefix (), prefix_, child->prefix_size) != 0)
         return false;
 
-    return next_node->rm_helper (prefix_ + 1, size_ - 1, pipe_);
+    bool result = rm_helper (child, prefix_ + child->prefix_size,
+        size_ - child->prefix_size, pipe_);
+
+    //  If the subscription was removed, the node may not be needed any more.
+    if (result) {
+        prune (node_, slot);
+        compact (node_);
+    }
+    return result;
 }
 
 void zmq::mtrie_t::match (unsigned char *data_, size_t size_,
     void (*func_) (pipe_t *pipe_, void *arg_), void *arg_)
 {
-    mtrie_t *current = this;
+    node_t *current = root;
     while (true) {
 
         //  Signal the pipes attached to this node.
-		for (pipes_t::iterator it = current->pipes.begin ();
-			it != current->pipes.end (); ++it)
-			func_ (*it, arg_);
-
-		// If we are at the end of the message, there's nothing more to match.
-		if(!size_)
-			break;
-
-        //  If there are no subnodes in the trie, return.
-        if (current->count == 0)
+        if (current->pipes_count == 1)
+            func_ (current->pipes.pipe, arg_);
+        else
+            for (uint32_t i = 0; i != current->pipes_count; i++)
+                func_ (current->pipes.pipes [i], arg_);
+
+        //  If we are at the end of the message, there's nothing more to match.
+        if (!size_)
             break;
 
-        //  If there's one subnode (optimisation).
-		if (current->count == 1) {
-            if (data_ [0] != current->min)
-                break;
-            current = current->next.node;
-            data_++;
-            size_--;
-		    continue;
-		}
-
-		//  If there are multiple subnodes.
-        if (data_ [0] < current->min || data_ [0] >=
-              current->min + current->count)
+        //  Find the subnode and check that its whole prefix matches.
+        node_t **slot = find_child (current, data_ [0]);
+        if (!slot)
             break;
-        if (!current->next.table [data_ [0] - current->min])
+        current = *slot;
+        if (current->prefix_size > size_ ||
+              memcmp (current->prefix (), data_, current->prefix_size) != 0)
             break;
-        current = current->next.table [data_ [0] - current->min];
-        data_++;
-        size_--;
+        data_ += current->prefix_size;
+        size_ -= current->prefix_size;
     }
 }
-
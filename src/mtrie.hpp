@@ -22,7 +22,6 @@
 #define __ZMQ_MTRIE_HPP_INCLUDED__
 
 #include <stddef.h>
-#include <set>
 
 #include "stdint.hpp"
 
@@ -30,6 +29,13 @@ namespace zmq
 {
 
     //  Multi-trie. Each node in the trie is a set of pointers to pipes.
+    //
+    //  The trie is path-compressed: Chains of nodes with a single child and
+    //  no pipes are collapsed into a single node labelled by the whole
+    //  sequence of bytes. Nodes with few children keep them in a sorted
+    //  array, nodes with many children in a table indexed by the next byte.
+    //  The set of pipes is a sorted array, with the common case of a single
+    //  pipe stored inline. Nodes left without pipes are pruned on removal.
 
     class mtrie_t
     {
@@ -59,24 +65,71 @@ namespace zmq
 
     private:
 
-        bool add_helper (unsigned char *prefix_, size_t size_,
-            class pipe_t *pipe_);
-        void rm_helper (class pipe_t *pipe_, unsigned char **buff_,
-            size_t buffsize_, size_t maxbuffsize_,
+        //  Nodes with more children than this use a table of 256 entries.
+        //  The table is converted back to the array when the number of
+        //  children drops to half of the limit.
+        enum {max_array_children = 16};
+
+        struct node_t
+        {
+            //  Pipes subscribed to the key of this node. If there's a single
+            //  pipe, it's stored inline.
+            union {
+                class pipe_t *pipe;
+                class pipe_t **pipes;
+            } pipes;
+            uint32_t pipes_count;
+
+            //  Number of bytes leading from the parent node to this node.
+            //  The bytes themselves are stored right after the structure.
+            //  The first byte identifies the node within the parent.
+            uint32_t prefix_size;
+
+            //  If there are at most max_array_children children, the block
+            //  holds pointers to the children followed by their first bytes,
+            //  both sorted. Otherwise it's a table of 256 child pointers.
+            node_t **children;
+            unsigned short children_count;
+            bool table;
+
+            inline unsigned char *prefix ()
+            {
+                return (unsigned char*) (this + 1);
+            }
+        };
+
+        static node_t *new_node (const unsigned char *prefix_, size_t size_);
+        static void delete_node (node_t *node_);
+
+        //  Manipulation of the set of pipes. add_pipe returns true if
+        //  the set was empty, rm_pipe returns true if the pipe was found.
+        static bool add_pipe (node_t *node_, class pipe_t *pipe_);
+        static bool rm_pipe (node_t *node_, class pipe_t *pipe_);
+
+        //  Manipulation of the children. find_child returns the location
+        //  of the pointer to the child starting with byte c_, or NULL.
+        static node_t **find_child (node_t *node_, unsigned char c_);
+        static void add_child (node_t *node_, node_t *child_);
+        static void rm_child (node_t *node_, unsigned char c_);
+
+        //  Converts the table of children back to the array if there are
+        //  few of them left.
+        static void compact (node_t *node_);
+
+        //  Removes the child at location slot_ of the parent_ if it has
+        //  no pipes and no children or merges it with its only child if it
+        //  has no pipes and a single child.
+        static void prune (node_t *parent_, node_t **slot_);
+
+        static bool rm_helper (node_t *node_, unsigned char *prefix_,
+            size_t size_, class pipe_t *pipe_);
+        static void rm_helper (node_t *node_, class pipe_t *pipe_,
+            unsigned char **buff_, size_t buffsize_, size_t *maxbuffsize_,
             void (*func_) (unsigned char *data_, size_t size_, void *arg_),
             void *arg_);
-        bool rm_helper (unsigned char *prefix_, size_t size_,
-            class pipe_t *pipe_);
 
-        typedef std::set <class pipe_t*> pipes_t;
-        pipes_t pipes;
-
-        unsigned char min;
-        unsigned short count;
-        union {
-            class mtrie_t *node;
-            class mtrie_t **table;
-        } next;
+        //  The root node corresponds to the empty prefix.
+        node_t *root;
 
         mtrie_t (const mtrie_t&);
         const mtrie_t &operator = (const mtrie_t&);
@@ -85,4 +138,3 @@ namespace zmq
 }
 
 #endif
-
@@ -64,7 +64,8 @@ void zmq::object_t::process_command (command_t &cmd_)
         break;
 
     case command_t::activate_write:
-        process_activate_write (cmd_.args.activate_write.msgs_read);
+        process_activate_write (cmd_.args.activate_write.msgs_read,
+            cmd_.args.activate_write.bytes_read);
         break;
 
     case command_t::stop:
@@ -128,6 +129,10 @@ void zmq::object_t::process_command (command_t &cmd_)
         process_reaped ();
         break;
 
+    case command_t::resolved:
+        process_resolved (cmd_.args.resolved.error);
+        break;
+
     default:
         zmq_assert (false);
     }
@@ -170,6 +175,12 @@ zmq::io_thread_t *zmq::object_t::choose_io_thread (uint64_t affinity_)
     return ctx->choose_io_thread (affinity_);
 }
 
+void zmq::object_t::choose_io_threads (uint64_t affinity_,
+    std::vector <io_thread_t*> &io_threads_)
+{
+    ctx->choose_io_threads (affinity_, io_threads_);
+}
+
 void zmq::object_t::send_stop ()
 {
     //  'stop' command goes always from administrative thread to
@@ -282,7 +293,7 @@ void zmq::object_t::send_activate_read (pipe_t *destination_)
 }
 
 void zmq::object_t::send_activate_write (pipe_t *destination_,
-    uint64_t msgs_read_)
+    uint64_t msgs_read_, uint64_t bytes_read_)
 {
     command_t cmd;
 #if defined ZMQ_MAKE_VALGRIND_HAPPY
@@ -291,6 +302,7 @@ void zmq::object_t::send_activate_write (pipe_t *destination_,
     cmd.destination = destination_;
     cmd.type = command_t::activate_write;
     cmd.args.activate_write.msgs_read = msgs_read_;
+    cmd.args.activate_write.bytes_read = bytes_read_;
     send_command (cmd);
 }
 
@@ -429,7 +441,8 @@ void zmq::object_t::process_activate_read ()
     zmq_assert (false);
 }
 
-void zmq::object_t::process_activate_write (uint64_t msgs_read_)
+void zmq::object_t::process_activate_write (uint64_t msgs_read_,
+    uint64_t bytes_read_)
 {
     zmq_assert (false);
 }
@@ -474,6 +487,11 @@ void zmq::object_t::process_reaped ()
     zmq_assert (false);
 }
 
+void zmq::object_t::process_resolved (int error_)
+{
+    zmq_assert (false);
+}
+
 void zmq::object_t::process_seqnum ()
 {
     zmq_assert (false);
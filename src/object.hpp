@@ -21,6 +21,8 @@
 #ifndef __ZMQ_OBJECT_HPP_INCLUDED__
 #define __ZMQ_OBJECT_HPP_INCLUDED__
 
+#include <vector>
+
 #include "stdint.hpp"
 #include "blob.hpp"
 
@@ -56,6 +58,10 @@ namespace zmq
         //  Chooses least loaded I/O thread.
         class io_thread_t *choose_io_thread (uint64_t affinity_);
 
+        //  Chooses all the I/O threads eligible given the affinity.
+        void choose_io_threads (uint64_t affinity_,
+            std::vector <class io_thread_t*> &io_threads_);
+
         //  Derived object can use these functions to send commands
         //  to other objects.
         void send_stop ();
@@ -70,7 +76,7 @@ namespace zmq
              const blob_t &peer_identity_, bool inc_seqnum_ = true);
         void send_activate_read (class pipe_t *destination_);
         void send_activate_write (class pipe_t *destination_,
-             uint64_t msgs_read_);
+             uint64_t msgs_read_, uint64_t bytes_read_);
         void send_hiccup (class pipe_t *destination_, void *pipe_);
         void send_pipe_term (class pipe_t *destination_);
         void send_pipe_term_ack (class pipe_t *destination_);
@@ -92,7 +98,8 @@ namespace zmq
         virtual void process_bind (class pipe_t *pipe_,
             const blob_t &peer_identity_);
         virtual void process_activate_read ();
-        virtual void process_activate_write (uint64_t msgs_read_);
+        virtual void process_activate_write (uint64_t msgs_read_,
+            uint64_t bytes_read_);
         virtual void process_hiccup (void *pipe_);
         virtual void process_pipe_term ();
         virtual void process_pipe_term_ack ();
@@ -101,6 +108,7 @@ namespace zmq
         virtual void process_term_ack ();
         virtual void process_reap (class socket_base_t *socket_);
         virtual void process_reaped ();
+        virtual void process_resolved (int error_);
 
         //  Special handler called after a command that requires a seqnum
         //  was processed. The implementation should catch up with its counter
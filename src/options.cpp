@@ -26,6 +26,8 @@
 zmq::options_t::options_t () :
     sndhwm (1000),
     rcvhwm (1000),
+    sndhwm_bytes (0),
+    rcvhwm_bytes (0),
     affinity (0),
     rate (100),
     recovery_ivl (10000),
@@ -40,10 +42,20 @@ zmq::options_t::options_t () :
     maxmsgsize (-1),
     rcvtimeo (-1),
     sndtimeo (-1),
+    spin (0),
     immediate_connect (true),
     delay_on_close (true),
     delay_on_disconnect (true),
-    filter (false)
+    filter (false),
+    topic_length (0),
+    topic_delimiter (-1),
+    conflate (false),
+    last_value (false),
+    broadcast (false),
+    early_filter (false),
+    reuseport (false),
+    memfd_threshold (0),
+    msg_pool (false)
 {
 }
 
@@ -68,6 +80,22 @@ int zmq::options_t::setsockopt (int option_, const void *optval_,
         rcvhwm = *((int*) optval_);
         return 0;
 
+    case ZMQ_SNDHWM_BYTES:
+        if (optvallen_ != sizeof (int64_t) || *((int64_t*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        sndhwm_bytes = *((int64_t*) optval_);
+        return 0;
+
+    case ZMQ_RCVHWM_BYTES:
+        if (optvallen_ != sizeof (int64_t) || *((int64_t*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        rcvhwm_bytes = *((int64_t*) optval_);
+        return 0;
+
     case ZMQ_AFFINITY:
         if (optvallen_ != sizeof (uint64_t)) {
             errno = EINVAL;
@@ -193,6 +221,120 @@ int zmq::options_t::setsockopt (int option_, const void *optval_,
         sndtimeo = *((int*) optval_);
         return 0;
 
+    case ZMQ_SPIN:
+        if (optvallen_ != sizeof (int) || *((int*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        spin = *((int*) optval_);
+        return 0;
+
+    case ZMQ_TOPIC_LENGTH:
+        if (optvallen_ != sizeof (int) || *((int*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        //  The last value cache needs the topics to be defined.
+        if (last_value && *((int*) optval_) == 0 && topic_delimiter < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        topic_length = *((int*) optval_);
+        return 0;
+
+    case ZMQ_TOPIC_DELIMITER:
+        if (optvallen_ != sizeof (int) || *((int*) optval_) < -1 ||
+              *((int*) optval_) > 255) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        //  The last value cache needs the topics to be defined.
+        if (last_value && *((int*) optval_) < 0 && topic_length == 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        topic_delimiter = *((int*) optval_);
+        return 0;
+
+    case ZMQ_CONFLATE:
+        if (optvallen_ != sizeof (int) || (*((int*) optval_) != 0 &&
+              *((int*) optval_) != 1)) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (type != ZMQ_PUB && type != ZMQ_XPUB && type != ZMQ_PUSH &&
+              type != ZMQ_SUB && type != ZMQ_XSUB && type != ZMQ_PULL) {
+            errno = EINVAL;
+            return -1;
+        }
+        conflate = *((int*) optval_) ? true : false;
+        return 0;
+
+    case ZMQ_LAST_VALUE:
+        if (optvallen_ != sizeof (int) || (*((int*) optval_) != 0 &&
+              *((int*) optval_) != 1)) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (type != ZMQ_PUB && type != ZMQ_XPUB) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        //  Without the topics defined each distinct first message part
+        //  would be cached forever.
+        if (*((int*) optval_) && !exact_match ()) {
+            errno = EINVAL;
+            return -1;
+        }
+        last_value = *((int*) optval_) ? true : false;
+        return 0;
+
+    case ZMQ_BROADCAST:
+        if (optvallen_ != sizeof (int) || (*((int*) optval_) != 0 &&
+              *((int*) optval_) != 1)) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (type != ZMQ_PUB && type != ZMQ_XPUB) {
+            errno = EINVAL;
+            return -1;
+        }
+        broadcast = *((int*) optval_) ? true : false;
+        return 0;
+
+    case ZMQ_EARLY_FILTER:
+        if (optvallen_ != sizeof (int) || (*((int*) optval_) != 0 &&
+              *((int*) optval_) != 1)) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (type != ZMQ_SUB) {
+            errno = EINVAL;
+            return -1;
+        }
+        early_filter = *((int*) optval_) ? true : false;
+        return 0;
+
+    case ZMQ_REUSEPORT:
+        if (optvallen_ != sizeof (int) || (*((int*) optval_) != 0 &&
+              *((int*) optval_) != 1)) {
+            errno = EINVAL;
+            return -1;
+        }
+        reuseport = *((int*) optval_) ? true : false;
+        return 0;
+
+    case ZMQ_MEMFD_THRESHOLD:
+        if (optvallen_ != sizeof (int64_t) || *((int64_t*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        memfd_threshold = *((int64_t*) optval_);
+        return 0;
+
     }
 
     errno = EINVAL;
@@ -221,6 +363,24 @@ int zmq::options_t::getsockopt (int option_, void *optval_, size_t *optvallen_)
         *optvallen_ = sizeof (int);
         return 0;
 
+    case ZMQ_SNDHWM_BYTES:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = sndhwm_bytes;
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
+    case ZMQ_RCVHWM_BYTES:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = rcvhwm_bytes;
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
     case ZMQ_AFFINITY:
         if (*optvallen_ < sizeof (uint64_t)) {
             errno = EINVAL;
@@ -356,8 +516,120 @@ int zmq::options_t::getsockopt (int option_, void *optval_, size_t *optvallen_)
         *optvallen_ = sizeof (int);
         return 0;
 
+    case ZMQ_SPIN:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = spin;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_TOPIC_LENGTH:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = topic_length;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_TOPIC_DELIMITER:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = topic_delimiter;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_CONFLATE:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = conflate ? 1 : 0;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_LAST_VALUE:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = last_value ? 1 : 0;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_BROADCAST:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = broadcast ? 1 : 0;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_EARLY_FILTER:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = early_filter ? 1 : 0;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_REUSEPORT:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = reuseport ? 1 : 0;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_MEMFD_THRESHOLD:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = memfd_threshold;
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
     }
 
     errno = EINVAL;
     return -1;
 }
+
+bool zmq::options_t::conflate_out () const
+{
+    return conflate &&
+        (type == ZMQ_PUB || type == ZMQ_XPUB || type == ZMQ_PUSH);
+}
+
+bool zmq::options_t::conflate_in () const
+{
+    return conflate &&
+        (type == ZMQ_SUB || type == ZMQ_XSUB || type == ZMQ_PULL);
+}
+
+bool zmq::options_t::broadcast_out () const
+{
+    return broadcast && !conflate && !last_value;
+}
+
+size_t zmq::options_t::topic_size (const unsigned char *data_,
+    size_t size_) const
+{
+    //  Messages shorter than the topic are matched as a whole. They can
+    //  match only subscriptions of the same (wrong) size.
+    if (topic_length > 0)
+        return size_ < (size_t) topic_length ? size_ : topic_length;
+
+    //  If there's no delimiter, the whole message is the topic.
+    const unsigned char *end = (const unsigned char*) memchr (data_,
+        topic_delimiter, size_);
+    return end ? end - data_ : size_;
+}
@@ -39,6 +39,10 @@ namespace zmq
         int sndhwm;
         int rcvhwm;
 
+        //  High-water marks for message pipes in bytes. 0 means no limit.
+        int64_t sndhwm_bytes;
+        int64_t rcvhwm_bytes;
+
         uint64_t affinity;
         blob_t identity;
 
@@ -79,6 +83,10 @@ namespace zmq
         int rcvtimeo;
         int sndtimeo;
 
+        //  Maximum time blocking send/recv operations busy-wait before
+        //  blocking, in microseconds. 0 means no busy-waiting.
+        int spin;
+
         //  If true, when connecting, pipes are created immediately without
         //  waiting for the connection to be established. That way the socket
         //  is not aware of the peer's identity, however, it is able to send
@@ -95,6 +103,65 @@ namespace zmq
 
         //  If 1, (X)SUB socket should filter the messages. If 0, it should not.
         bool filter;
+
+        //  If positive, (X)PUB and (X)SUB sockets match the subscriptions
+        //  exactly against the first topic_length bytes of the message
+        //  rather than as prefixes. Default 0 (prefix matching).
+        int topic_length;
+
+        //  If non-negative, subscriptions are matched exactly against the
+        //  part of the message preceding the first occurrence of this byte.
+        //  Ignored if topic_length is set. Default -1 (prefix matching).
+        int topic_delimiter;
+
+        //  If true, pipes hold only the last message of each topic. Applies
+        //  to outbound messages of (X)PUB and PUSH sockets and to inbound
+        //  messages of (X)SUB and PULL sockets.
+        bool conflate;
+
+        //  Return true if the messages sent or received by the socket
+        //  respectively are conflated.
+        bool conflate_out () const;
+        bool conflate_in () const;
+
+        //  Returns true if messages are passed to inproc subscribers via
+        //  the shared ring. Conflation and last value cache take precedence.
+        bool broadcast_out () const;
+
+        //  If true, (X)PUB socket keeps the last message published on each
+        //  topic and sends the matching ones to new subscribers.
+        bool last_value;
+
+        //  If true, (X)PUB socket passes messages to inproc SUB sockets via
+        //  a single ring shared by all of them.
+        bool broadcast;
+
+        //  If true, SUB socket connected via TCP, IPC or PGM drops the
+        //  messages matching no subscription in the I/O thread, before they
+        //  are passed to the socket.
+        bool early_filter;
+
+        //  If true, binding to a TCP endpoint creates a listener in each
+        //  I/O thread, all of them sharing the port using SO_REUSEPORT.
+        bool reuseport;
+
+        //  Messages of at least this size sent over ipc are passed as
+        //  memfds rather than through the socket. Zero means never.
+        int64_t memfd_threshold;
+
+        //  Returns true if the subscriptions are matched exactly.
+        inline bool exact_match () const
+        {
+            return topic_length > 0 || topic_delimiter >= 0;
+        }
+
+        //  Returns the size of the topic the message starts with when
+        //  the subscriptions are matched exactly.
+        size_t topic_size (const unsigned char *data_, size_t size_) const;
+
+        //  If true, message content is allocated from the message pool.
+        //  Inherited from the context (ZMQ_MSG_POOL context option).
+        bool msg_pool;
     };
 
 }
@@ -66,8 +66,12 @@ int zmq::pair_t::xsend (msg_t *msg_, int flags_)
         return -1;
     }
 
-    if (!(flags_ & ZMQ_SNDMORE))
-        pipe->flush ();
+    if (!(flags_ & ZMQ_SNDMORE)) {
+        if (flags_ & send_noflush)
+            pipe->defer_flush ();
+        else
+            pipe->flush ();
+    }
 
     //  Detach the original message from the data buffer.
     int rc = msg_->init ();
@@ -86,7 +86,7 @@ void zmq::pgm_receiver_t::unplug ()
     pending_bytes = 0;
 
     if (has_rx_timer) {
-        cancel_timer (rx_timer_id);
+        cancel_timer (rx_timer);
         has_rx_timer = false;
     }
 
@@ -144,7 +144,7 @@ void zmq::pgm_receiver_t::in_event ()
     zmq_assert (pending_bytes == 0);
 
     if (has_rx_timer) {
-        cancel_timer (rx_timer_id);
+        cancel_timer (rx_timer);
         has_rx_timer = false;
     }
 
@@ -163,7 +163,7 @@ void zmq::pgm_receiver_t::in_event ()
         if (received == 0) {
             if (errno == ENOMEM || errno == EBUSY) {
                 const long timeout = pgm_socket.get_rx_timeout ();
-                add_timer (timeout, rx_timer_id);
+                rx_timer = add_timer (timeout, rx_timer_id);
                 has_rx_timer = true;
             }
             break;
@@ -218,9 +218,10 @@ void zmq::pgm_receiver_t::in_event ()
 
             //  Create and connect decoder for the peer.
             it->second.decoder = new (std::nothrow) decoder_t (0,
-                options.maxmsgsize);
+                options.maxmsgsize, options.msg_pool);
             alloc_assert (it->second.decoder);
             it->second.decoder->set_sink (sink);
+            it->second.decoder->set_filter (sink->get_filter ());
         }
 
         mru_decoder = it->second.decoder;
@@ -237,7 +238,7 @@ void zmq::pgm_receiver_t::in_event ()
 
             //  Reset outstanding timer.
             if (has_rx_timer) {
-                cancel_timer (rx_timer_id);
+                cancel_timer (rx_timer);
                 has_rx_timer = false;
             }
 
@@ -73,6 +73,7 @@ namespace zmq
 
         //  RX timer is running.
         bool has_rx_timer;
+        timer_handle_t rx_timer;
 
         //  If joined is true we are already getting messages from the peer.
         //  It it's false, we are getting data but still we haven't seen
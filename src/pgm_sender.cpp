@@ -103,12 +103,12 @@ void zmq::pgm_sender_t::plug (io_thread_t *io_thread_, i_engine_sink *sink_)
 void zmq::pgm_sender_t::unplug ()
 {
     if (has_rx_timer) {
-        cancel_timer (rx_timer_id);
+        cancel_timer (rx_timer);
         has_rx_timer = false;
     }
 
     if (has_tx_timer) {
-        cancel_timer (tx_timer_id);
+        cancel_timer (tx_timer);
         has_tx_timer = false;
     }
 
@@ -147,7 +147,7 @@ zmq::pgm_sender_t::~pgm_sender_t ()
 void zmq::pgm_sender_t::in_event ()
 {
     if (has_rx_timer) {
-        cancel_timer (rx_timer_id);
+        cancel_timer (rx_timer);
         has_rx_timer = false;
     }
 
@@ -155,7 +155,7 @@ void zmq::pgm_sender_t::in_event ()
     pgm_socket.process_upstream ();
     if (errno == ENOMEM || errno == EBUSY) {
         const long timeout = pgm_socket.get_rx_timeout ();
-        add_timer (timeout, rx_timer_id);
+        rx_timer = add_timer (timeout, rx_timer_id);
         has_rx_timer = true;
     }
 }
@@ -186,7 +186,7 @@ void zmq::pgm_sender_t::out_event ()
     }
 
     if (has_tx_timer) {
-        cancel_timer (tx_timer_id);
+        cancel_timer (tx_timer);
         has_tx_timer = false;
     }
 
@@ -201,7 +201,7 @@ void zmq::pgm_sender_t::out_event ()
 
         if (errno == ENOMEM) {
             const long timeout = pgm_socket.get_tx_timeout ();
-            add_timer (timeout, tx_timer_id);
+            tx_timer = add_timer (timeout, tx_timer_id);
             has_tx_timer = true;
         } else
             zmq_assert (errno == EBUSY);
@@ -69,6 +69,8 @@ namespace zmq
         //  Timers are running.
         bool has_tx_timer;
         bool has_rx_timer;
+        timer_handle_t tx_timer;
+        timer_handle_t rx_timer;
 
         //  Message encoder.
         encoder_t encoder;
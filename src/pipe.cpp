@@ -22,44 +22,99 @@
 #include <stddef.h>
 
 #include "pipe.hpp"
+#include "conflate_pipe.hpp"
+#include "ring.hpp"
+#include "options.hpp"
 #include "err.hpp"
 
 int zmq::pipepair (class object_t *parents_ [2], class pipe_t* pipes_ [2],
-    int hwms_ [2], bool delays_ [2])
+    int hwms_ [2], int64_t hwms_bytes_ [2], const options_t *conflates_ [2],
+    ring_t *rings_ [2], bool delays_ [2])
 {
     //   Creates two pipe objects. These objects are connected by two ypipes,
-    //   each to pass messages in one direction.
+    //   each to pass messages in one direction. The messages conflated or
+    //   passed via a ring use conflate_pipe_t or ring_pipe_t instead.
+    pipe_t::ypipe_msg_t *ypipes [2] = {NULL, NULL};
+    pipe_t::upipe_t *upipes [2] = {NULL, NULL};
+    int hwms [2];
+    int64_t hwms_bytes [2];
+    for (int i = 0; i != 2; i++) {
+        if (rings_ [i])
+            upipes [i] = rings_ [i]->create_pipe (hwms_ [i]);
+        else if (conflates_ [i])
+            upipes [i] = new (std::nothrow) conflate_pipe_t (
+                conflates_ [i]->topic_length, conflates_ [i]->topic_delimiter);
+        else {
+            ypipes [i] = new (std::nothrow) pipe_t::ypipe_msg_t ();
+            alloc_assert (ypipes [i]);
+        }
+        if (upipes [i])
+            alloc_assert (upipes [i]);
 
-    pipe_t::upipe_t *upipe1 = new (std::nothrow) pipe_t::upipe_t ();
-    alloc_assert (upipe1);
-    pipe_t::upipe_t *upipe2 = new (std::nothrow) pipe_t::upipe_t ();
-    alloc_assert (upipe2);
+        //  The watermarks don't apply to the messages conflated or passed
+        //  via the ring.
+        hwms [i] = upipes [i] ? 0 : hwms_ [i];
+        hwms_bytes [i] = upipes [i] ? 0 : hwms_bytes_ [i];
+    }
 
-    pipes_ [0] = new (std::nothrow) pipe_t (parents_ [0], upipe1, upipe2,
-        hwms_ [1], hwms_ [0], delays_ [0]);
+    //  Pipe 1 writes the messages read by pipe 0 and vice versa.
+    pipes_ [0] = new (std::nothrow) pipe_t (parents_ [0], ypipes [1],
+        ypipes [0], upipes [1], upipes [0], hwms [1], hwms [0],
+        hwms_bytes [1], hwms_bytes [0], delays_ [0]);
     alloc_assert (pipes_ [0]);
-    pipes_ [1] = new (std::nothrow) pipe_t (parents_ [1], upipe2, upipe1,
-        hwms_ [0], hwms_ [1], delays_ [1]);
+    pipes_ [1] = new (std::nothrow) pipe_t (parents_ [1], ypipes [0],
+        ypipes [1], upipes [0], upipes [1], hwms [0], hwms [1],
+        hwms_bytes [0], hwms_bytes [1], delays_ [1]);
     alloc_assert (pipes_ [1]);
 
     pipes_ [0]->set_peer (pipes_ [1]);
     pipes_ [1]->set_peer (pipes_ [0]);
 
+    pipes_ [0]->conflate = conflates_ [1] != NULL;
+    pipes_ [1]->conflate = conflates_ [0] != NULL;
+
+    //  The writer is used to wake up the reader of the ring.
+    if (rings_ [0]) {
+        ((ring_pipe_t*) upipes [0])->set_writer (pipes_ [0]);
+        pipes_ [0]->shared = true;
+    }
+    if (rings_ [1]) {
+        ((ring_pipe_t*) upipes [1])->set_writer (pipes_ [1]);
+        pipes_ [1]->shared = true;
+    }
+
     return 0;
 }
 
-zmq::pipe_t::pipe_t (object_t *parent_, upipe_t *inpipe_, upipe_t *outpipe_,
-      int inhwm_, int outhwm_, bool delay_) :
+zmq::pipe_t::pipe_t (object_t *parent_, ypipe_msg_t *inpipe_,
+      ypipe_msg_t *outpipe_, upipe_t *inupipe_, upipe_t *outupipe_,
+      int inhwm_, int outhwm_, int64_t inhwm_bytes_, int64_t outhwm_bytes_,
+      bool delay_) :
     object_t (parent_),
     inpipe (inpipe_),
     outpipe (outpipe_),
+    inupipe (inupipe_),
+    outupipe (outupipe_),
+    prefetched (NULL),
+    prefetched_pos (0),
+    prefetched_count (0),
+    conflate (false),
+    shared (false),
     in_active (true),
     out_active (true),
+    deferred (false),
     hwm (outhwm_),
     lwm (compute_lwm (inhwm_)),
     msgs_read (0),
     msgs_written (0),
     peers_msgs_read (0),
+    hwm_bytes (outhwm_bytes_),
+    lwm_bytes ((inhwm_bytes_ + 1) / 2),
+    bytes_read (0),
+    bytes_written (0),
+    partial_bytes (0),
+    peers_bytes_read (0),
+    bytes_notified (0),
     peer (NULL),
     sink (NULL),
     state (active),
@@ -70,6 +125,7 @@ zmq::pipe_t::pipe_t (object_t *parent_, upipe_t *inpipe_, upipe_t *outpipe_,
 
 zmq::pipe_t::~pipe_t ()
 {
+    delete [] prefetched;
 }
 
 void zmq::pipe_t::set_peer (pipe_t *peer_)
@@ -86,33 +142,36 @@ void zmq::pipe_t::set_event_sink (i_pipe_events *sink_)
     sink = sink_;
 }
 
-void zmq::pipe_t::set_pipe_id (uint32_t id_)
+void zmq::pipe_t::set_pipe_id (uint64_t id_)
 {
     pipe_id = id_;
 }
 
-uint32_t zmq::pipe_t::get_pipe_id ()
+uint64_t zmq::pipe_t::get_pipe_id ()
 {
     return pipe_id;
 }
 
+bool zmq::pipe_t::is_shared ()
+{
+    return shared;
+}
+
 bool zmq::pipe_t::check_read ()
 {
     if (unlikely (!in_active || (state != active && state != pending)))
         return false;
 
     //  Check if there's an item in the pipe.
-    if (!inpipe->check_read ()) {
+    if (!prefetch ()) {
         in_active = false;
         return false;
     }
 
     //  If the next item in the pipe is message delimiter,
     //  initiate termination process.
-    if (inpipe->probe (is_delimiter)) {
-        msg_t msg;
-        bool ok = inpipe->read (&msg);
-        zmq_assert (ok);
+    if (prefetched [prefetched_pos].is_delimiter ()) {
+        prefetched_pos++;
         delimit ();
         return false;
     }
@@ -125,10 +184,11 @@ bool zmq::pipe_t::read (msg_t *msg_)
     if (unlikely (!in_active || (state != active && state != pending)))
         return false;
 
-    if (!inpipe->read (msg_)) {
+    if (!prefetch ()) {
         in_active = false;
         return false;
     }
+    *msg_ = prefetched [prefetched_pos++];
 
     //  If delimiter was read, start termination process of the pipe.
     if (msg_->is_delimiter ()) {
@@ -138,9 +198,15 @@ bool zmq::pipe_t::read (msg_t *msg_)
 
     if (!(msg_->flags () & (msg_t::more | msg_t::label)))
         msgs_read++;
-
-    if (lwm > 0 && msgs_read % lwm == 0)
-        send_activate_write (peer, msgs_read);
+    bytes_read += msg_->size ();
+
+    //  Let the writer know when it can write more. In terms of bytes, it is
+    //  done each time half of the writer's limit is read.
+    if ((lwm > 0 && msgs_read % lwm == 0) || (lwm_bytes > 0 &&
+          bytes_read - bytes_notified >= (uint64_t) lwm_bytes)) {
+        send_activate_write (peer, msgs_read, bytes_read);
+        bytes_notified = bytes_read;
+    }
 
     return true;
 }
@@ -152,6 +218,14 @@ bool zmq::pipe_t::check_write (msg_t *msg_)
 
     bool full = hwm > 0 && msgs_written - peers_msgs_read == uint64_t (hwm);
 
+    //  The byte limit is soft: New message is accepted unless the amount
+    //  of data already queued has reached the limit. Given that the reader
+    //  reports its progress each time it reads half of the limit, large
+    //  messages can't get stuck this way.
+    if (hwm_bytes > 0 &&
+          bytes_written - peers_bytes_read >= uint64_t (hwm_bytes))
+        full = true;
+
     if (unlikely (full)) {
         out_active = false;
         return false;
@@ -166,9 +240,13 @@ bool zmq::pipe_t::write (msg_t *msg_)
         return false;
 
     bool more = msg_->flags () & (msg_t::more | msg_t::label) ? true : false;
-    outpipe->write (*msg_, more);
-    if (!more)
+    partial_bytes += msg_->size ();
+    out_write (*msg_, more);
+    if (!more) {
         msgs_written++;
+        bytes_written += partial_bytes;
+        partial_bytes = 0;
+    }
 
     return true;
 }
@@ -177,13 +255,14 @@ void zmq::pipe_t::rollback ()
 {
     //  Remove incomplete message from the outbound pipe.
     msg_t msg;
-    if (outpipe) {
-		while (outpipe->unwrite (&msg)) {
+    if (has_outpipe ()) {
+		while (out_unwrite (&msg)) {
 		    zmq_assert (msg.flags () & (msg_t::more | msg_t::label));
 		    int rc = msg.close ();
 		    errno_assert (rc == 0);
 		}
     }
+    partial_bytes = 0;
 }
 
 void zmq::pipe_t::flush ()
@@ -196,10 +275,24 @@ void zmq::pipe_t::flush ()
     if (state == terminating)
         return;
 
-    if (outpipe && !outpipe->flush ())
+    if (has_outpipe () && !out_flush ())
         send_activate_read (peer);
 }
 
+void zmq::pipe_t::defer_flush ()
+{
+    if (!deferred) {
+        deferred = true;
+        sink->flush_deferred (this);
+    }
+}
+
+void zmq::pipe_t::flush_deferred ()
+{
+    deferred = false;
+    flush ();
+}
+
 void zmq::pipe_t::process_activate_read ()
 {
     if (!in_active && (state == active || state == pending)) {
@@ -208,10 +301,12 @@ void zmq::pipe_t::process_activate_read ()
     }
 }
 
-void zmq::pipe_t::process_activate_write (uint64_t msgs_read_)
+void zmq::pipe_t::process_activate_write (uint64_t msgs_read_,
+    uint64_t bytes_read_)
 {
     //  Remember the peers's message sequence number.
     peers_msgs_read = msgs_read_;
+    peers_bytes_read = bytes_read_;
 
     if (!out_active && state == active) {
         out_active = true;
@@ -223,18 +318,31 @@ void zmq::pipe_t::process_hiccup (void *pipe_)
 {
     //  Destroy old outpipe. Note that the read end of the pipe was already
     //  migrated to this thread.
-    zmq_assert (outpipe);
-    outpipe->flush ();
+    zmq_assert (has_outpipe ());
     msg_t msg;
-    while (outpipe->read (&msg)) {
-       int rc = msg.close ();
-       errno_assert (rc == 0);
+    if (outupipe) {
+        outupipe->flush ();
+        while (outupipe->read (&msg)) {
+           int rc = msg.close ();
+           errno_assert (rc == 0);
+        }
+        delete outupipe;
+    }
+    else {
+        outpipe->flush ();
+        while (outpipe->read (&msg)) {
+           int rc = msg.close ();
+           errno_assert (rc == 0);
+        }
+        delete outpipe;
     }
-    delete outpipe;
 
-    //  Plug in the new outpipe.
+    //  Plug in the new outpipe. It's of the same kind as the old one.
     zmq_assert (pipe_);
-    outpipe = (upipe_t*) pipe_;
+    if (outupipe)
+        outupipe = (upipe_t*) pipe_;
+    else
+        outpipe = (ypipe_msg_t*) pipe_;
     out_active = true;
 
     //  If appropriate, notify the user about the hiccup.
@@ -252,7 +360,7 @@ void zmq::pipe_t::process_pipe_term ()
     if (state == active) {
         if (!delay) {
             state = terminating;
-            outpipe = NULL;
+            drop_outpipe ();
             send_pipe_term_ack (peer);
             return;
         }
@@ -266,7 +374,7 @@ void zmq::pipe_t::process_pipe_term ()
     //  term command as well, so we can move straight to terminating state.
     if (state == delimited) {
         state = terminating;
-        outpipe = NULL;
+        drop_outpipe ();
         send_pipe_term_ack (peer);
         return;
     }
@@ -276,7 +384,7 @@ void zmq::pipe_t::process_pipe_term ()
     //  own ack.
     if (state == terminated) {
         state = double_terminated;
-        outpipe = NULL;
+        drop_outpipe ();
         send_pipe_term_ack (peer);
         return;
     }
@@ -298,7 +406,7 @@ void zmq::pipe_t::process_pipe_term_ack ()
     if (state == terminating) ;
     else if (state == double_terminated);
     else if (state == terminated) {
-        outpipe = NULL;
+        drop_outpipe ();
         send_pipe_term_ack (peer);
     }
     else
@@ -309,12 +417,8 @@ void zmq::pipe_t::process_pipe_term_ack ()
     //  First, delete all the unread messages in the pipe. We have to do it by
     //  hand because msg_t doesn't have automatic destructor. Then deallocate
     //  the ypipe itself.
-    msg_t msg;
-    while (inpipe->read (&msg)) {
-       int rc = msg.close ();
-       errno_assert (rc == 0);
-    }
-    delete inpipe;
+    drop_prefetched ();
+    destroy_inpipe ();
 
     //  Deallocate the pipe object
     delete this;
@@ -344,7 +448,7 @@ void zmq::pipe_t::terminate (bool delay_)
     //  There are still pending messages available, but the user calls
     //  'terminate'. We can act as if all the pending messages were read.
     else if (state == pending && !delay) {
-            outpipe = NULL;
+            drop_outpipe ();
             send_pipe_term_ack (peer);
             state = terminating;
     }
@@ -368,7 +472,7 @@ void zmq::pipe_t::terminate (bool delay_)
     //  Stop outbound flow of messages.
     out_active = false;
 
-    if (outpipe) {
+    if (has_outpipe ()) {
 
 		//  Rollback any unfinished outbound messages.
 		rollback ();
@@ -377,16 +481,11 @@ void zmq::pipe_t::terminate (bool delay_)
 		//  checked thus the delimiter can be written even though the pipe is full.
 		msg_t msg;
 		msg.init_delimiter ();
-		outpipe->write (msg, false);
+		out_write (msg, false);
 		flush ();
     }
 }
 
-bool zmq::pipe_t::is_delimiter (msg_t &msg_)
-{
-    return msg_.is_delimiter ();
-}
-
 int zmq::pipe_t::compute_lwm (int hwm_)
 {
     //  Compute the low water mark. Following point should be taken
@@ -423,7 +522,7 @@ void zmq::pipe_t::delimit ()
     }
 
     if (state == pending) {
-        outpipe = NULL;
+        drop_outpipe ();
         send_pipe_term_ack (peer);
         state = terminating;
         return;
@@ -433,22 +532,108 @@ void zmq::pipe_t::delimit ()
     zmq_assert (false);
 }
 
+bool zmq::pipe_t::prefetch ()
+{
+    if (prefetched_pos != prefetched_count)
+        return true;
+    if (unlikely (!prefetched)) {
+        prefetched = new (std::nothrow) msg_t [message_pipe_prefetch];
+        alloc_assert (prefetched);
+    }
+    prefetched_pos = 0;
+    prefetched_count = in_read_batch (prefetched, message_pipe_prefetch);
+    return prefetched_count != 0;
+}
+
+void zmq::pipe_t::drop_prefetched ()
+{
+    while (prefetched_pos != prefetched_count) {
+        int rc = prefetched [prefetched_pos++].close ();
+        errno_assert (rc == 0);
+    }
+}
+
 void zmq::pipe_t::hiccup ()
 {
     //  If termination is already under way do nothing.
     if (state != active)
         return;
 
-    //  We'll drop the pointer to the inpipe. From now on, the peer is
-    //  responsible for deallocating it.
-    inpipe = NULL;
+    //  The messages already taken from the old inpipe are dropped as well.
+    drop_prefetched ();
 
-    //  Create new inpipe.
-    inpipe = new (std::nothrow) pipe_t::upipe_t ();
-    alloc_assert (inpipe);
+    //  Create new inpipe. We'll drop the pointer to the old one. From now on,
+    //  the peer is responsible for deallocating it.
+    //  The ring is shared with other pipes, thus it's never replaced.
+    zmq_assert (conflate || !inupipe);
+    if (conflate) {
+        inupipe = ((conflate_pipe_t*) inupipe)->create ();
+        send_hiccup (peer, (void*) inupipe);
+    }
+    else {
+        inpipe = new (std::nothrow) ypipe_msg_t ();
+        alloc_assert (inpipe);
+        send_hiccup (peer, (void*) inpipe);
+    }
     in_active = true;
+}
 
-    //  Notify the peer about the hiccup.
-    send_hiccup (peer, (void*) inpipe);
+void zmq::pipe_t::out_write (const msg_t &msg_, bool incomplete_)
+{
+    if (outupipe)
+        outupipe->write (msg_, incomplete_);
+    else
+        outpipe->write (msg_, incomplete_);
+}
+
+bool zmq::pipe_t::out_unwrite (msg_t *msg_)
+{
+    if (outupipe)
+        return outupipe->unwrite (msg_);
+    return outpipe->unwrite (msg_);
+}
+
+bool zmq::pipe_t::out_flush ()
+{
+    if (outupipe)
+        return outupipe->flush ();
+    return outpipe->flush ();
+}
+
+int zmq::pipe_t::in_read_batch (msg_t *msgs_, int count_)
+{
+    if (inupipe)
+        return inupipe->read_batch (msgs_, count_);
+    return inpipe->read_batch (msgs_, count_);
+}
+
+bool zmq::pipe_t::has_outpipe ()
+{
+    return outpipe || outupipe;
+}
+
+void zmq::pipe_t::drop_outpipe ()
+{
+    outpipe = NULL;
+    outupipe = NULL;
+}
+
+void zmq::pipe_t::destroy_inpipe ()
+{
+    msg_t msg;
+    if (inupipe) {
+        while (inupipe->read (&msg)) {
+           int rc = msg.close ();
+           errno_assert (rc == 0);
+        }
+        delete inupipe;
+    }
+    else {
+        while (inpipe->read (&msg)) {
+           int rc = msg.close ();
+           errno_assert (rc == 0);
+        }
+        delete inpipe;
+    }
 }
 
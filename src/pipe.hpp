@@ -23,6 +23,7 @@
 
 #include "msg.hpp"
 #include "ypipe.hpp"
+#include "ypipe_base.hpp"
 #include "config.hpp"
 #include "object.hpp"
 #include "stdint.hpp"
@@ -34,11 +35,21 @@ namespace zmq
     //  Create a pipepair for bi-directional transfer of messages.
     //  First HWM is for messages passed from first pipe to the second pipe.
     //  Second HWM is for messages passed from second pipe to the first pipe.
+    //  Byte HWMs are the same limits expressed in bytes of message data,
+    //  zero meaning no limit.
+    //  If conflate option is non-NULL, messages passed in the respective
+    //  direction are conflated, with the topics defined by the options.
+    //  HWMs don't apply to the conflated messages.
+    //  If ring is non-NULL, messages passed in the respective direction are
+    //  not written to the pipe, instead they are read from the ring shared
+    //  with other pipes. HWM of the ring applies to such messages.
     //  Delay specifies how the pipe behaves when the peer terminates. If true
     //  pipe receives all the pending messages before terminating, otherwise it
     //  terminates straight away.
     int pipepair (class object_t *parents_ [2], class pipe_t* pipes_ [2],
-        int hwms_ [2], bool delays_ [2]);
+        int hwms_ [2], int64_t hwms_bytes_ [2],
+        const struct options_t *conflates_ [2], class ring_t *rings_ [2],
+        bool delays_ [2]);
 
     struct i_pipe_events
     {
@@ -48,8 +59,18 @@ namespace zmq
         virtual void write_activated (class pipe_t *pipe_) = 0;
         virtual void hiccuped (class pipe_t *pipe_) = 0;
         virtual void terminated (class pipe_t *pipe_) = 0;
+
+        //  Messages were written to the pipe, but the pipe was not flushed.
+        //  Triggered only once till the pipe is flushed via flush_deferred.
+        virtual void flush_deferred (class pipe_t *pipe_) = 0;
     };
 
+    //  Send flag used internally when sending a batch of messages. Messages
+    //  sent with the flag are written to the pipes, but the pipes are not
+    //  flushed. The socket flushes the pipes written to once the batch is
+    //  written.
+    enum {send_noflush = 0x100};
+
     //  Note that pipe can be stored in three different arrays.
     //  The array of inbound pipes (1), the array of outbound pipes (2) and
     //  the generic array of pipes to deallocate (3).
@@ -62,7 +83,9 @@ namespace zmq
     {
         //  This allows pipepair to create pipe objects.
         friend int pipepair (class object_t *parents_ [2],
-            class pipe_t* pipes_ [2], int hwms_ [2], bool delays_ [2]);
+            class pipe_t* pipes_ [2], int hwms_ [2], int64_t hwms_bytes_ [2],
+            const struct options_t *conflates_ [2], class ring_t *rings_ [2],
+            bool delays_ [2]);
 
     public:
 
@@ -70,8 +93,12 @@ namespace zmq
         void set_event_sink (i_pipe_events *sink_);
 
         //  Pipe endpoint can store an opaque ID to be used by its clients.
-        void set_pipe_id (uint32_t id_);
-        uint32_t get_pipe_id ();
+        void set_pipe_id (uint64_t id_);
+        uint64_t get_pipe_id ();
+
+        //  Returns true if the outbound messages are not written to the pipe,
+        //  but to the ring shared with other pipes.
+        bool is_shared ();
 
         //  Returns true if there is at least one message to read in the pipe.
         bool check_read ();
@@ -93,6 +120,13 @@ namespace zmq
         //  Flush the messages downsteam.
         void flush ();
 
+        //  Leaves the messages written so far unflushed. The sink is asked
+        //  to flush them later on using flush_deferred.
+        void defer_flush ();
+
+        //  Flushes the pipe whose flush was deferred.
+        void flush_deferred ();
+
         //  Temporaraily disconnects the inbound message stream and drops
         //  all the messages on the fly. Causes 'hiccuped' event to be generated
         //  in the peer.
@@ -106,12 +140,16 @@ namespace zmq
 
     private:
 
-        //  Type of the underlying lock-free pipe.
-        typedef ypipe_t <msg_t, message_pipe_granularity> upipe_t;
+        //  Types of the underlying pipe. It's lock-free ypipe_t unless the
+        //  messages are conflated (conflate_pipe_t) or read from a shared
+        //  ring (ring_pipe_t). The latter two are accessed via upipe_t.
+        typedef ypipe_t <msg_t, message_pipe_granularity> ypipe_msg_t;
+        typedef ypipe_base_t <msg_t> upipe_t;
 
         //  Command handlers.
         void process_activate_read ();
-        void process_activate_write (uint64_t msgs_read_);
+        void process_activate_write (uint64_t msgs_read_,
+            uint64_t bytes_read_);
         void process_hiccup (void *pipe_);
         void process_pipe_term ();
         void process_pipe_term_ack ();
@@ -119,10 +157,38 @@ namespace zmq
         //  Handler for delimiter read from the pipe.
         void delimit ();
 
+        //  Makes sure there's a message in the prefetch buffer, taking the
+        //  next batch from the inbound pipe if needed. Returns false if there
+        //  are no messages available.
+        bool prefetch ();
+
+        //  Deallocates the prefetched messages that were not read.
+        void drop_prefetched ();
+
+        //  Access to the underlying pipes. The ypipe_t is called directly,
+        //  the virtual calls are made only if upipe_t is used instead.
+        void out_write (const msg_t &msg_, bool incomplete_);
+        bool out_unwrite (msg_t *msg_);
+        bool out_flush ();
+        int in_read_batch (msg_t *msgs_, int count_);
+
+        //  Returns true if the outbound pipe still exists.
+        bool has_outpipe ();
+
+        //  Drops the pointer to the outbound pipe. The peer is responsible
+        //  for deallocating it.
+        void drop_outpipe ();
+
+        //  Deallocates the inbound pipe including the messages in it.
+        void destroy_inpipe ();
+
         //  Constructor is private. Pipe can only be created using
-        //  pipepair function.
-        pipe_t (object_t *parent_, upipe_t *inpipe_, upipe_t *outpipe_,
-            int inhwm_, int outhwm_, bool delay_);
+        //  pipepair function. Either the ypipe_t or the upipe_t is
+        //  supplied for each direction.
+        pipe_t (object_t *parent_, ypipe_msg_t *inpipe_,
+            ypipe_msg_t *outpipe_, upipe_t *inupipe_, upipe_t *outupipe_,
+            int inhwm_, int outhwm_, int64_t inhwm_bytes_,
+            int64_t outhwm_bytes_, bool delay_);
 
         //  Pipepair uses this function to let us know about
         //  the peer pipe object.
@@ -131,14 +197,35 @@ namespace zmq
         //  Destructor is private. Pipe objects destroy themselves.
         ~pipe_t ();
 
-        //  Underlying pipes for both directions.
-        upipe_t *inpipe;
-        upipe_t *outpipe;
+        //  Underlying pipes for both directions. If the upipe_t is non-NULL
+        //  it's used instead of the ypipe_t, which is NULL in that case.
+        ypipe_msg_t *inpipe;
+        ypipe_msg_t *outpipe;
+        upipe_t *inupipe;
+        upipe_t *outupipe;
+
+        //  Messages taken from the inbound pipe, but not yet read by the
+        //  user. Reading them in batches means that the state shared with
+        //  the writer is accessed once per batch instead of once per message.
+        //  The buffer is allocated on the first read so that the pipes that
+        //  are never read from don't pay for it.
+        msg_t *prefetched;
+        int prefetched_pos;
+        int prefetched_count;
+
+        //  True if the messages in the inbound pipe are conflated.
+        bool conflate;
+
+        //  True if the outbound messages are passed via a shared ring.
+        bool shared;
 
         //  Can the pipe be read from / written to?
         bool in_active;
         bool out_active;
 
+        //  True if the flush was deferred and the sink was notified about it.
+        bool deferred;
+
         //  High watermark for the outbound pipe.
         int hwm;
 
@@ -153,6 +240,20 @@ namespace zmq
         //  can be higher at the moment.
         uint64_t peers_msgs_read;
 
+        //  Same as above, measured in bytes of message data. Bytes written
+        //  are accounted for once the whole message is written, the size
+        //  of the parts written so far is stored in partial_bytes. The byte
+        //  watermarks are zero if there's no byte limit.
+        int64_t hwm_bytes;
+        int64_t lwm_bytes;
+        uint64_t bytes_read;
+        uint64_t bytes_written;
+        uint64_t partial_bytes;
+        uint64_t peers_bytes_read;
+
+        //  Value of bytes_read when the peer was last notified about it.
+        uint64_t bytes_notified;
+
         //  The pipe object on the other side of the pipepair.
         pipe_t *peer;
 
@@ -183,10 +284,7 @@ namespace zmq
         bool delay;
 
         //  Opaque ID. To be used by the clients, not the pipe itself.
-        uint32_t pipe_id;
-
-        //  Returns true if the message is delimiter; false otherwise.
-        static bool is_delimiter (msg_t &msg_);
+        uint64_t pipe_id;
 
         //  Computes appropriate low watermark from the given high watermark.
         static int compute_lwm (int hwm_);
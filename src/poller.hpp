@@ -36,12 +36,14 @@ namespace zmq
     typedef poll_t poller_t;
 #elif defined ZMQ_FORCE_EPOLL
     typedef epoll_t poller_t;
+#define ZMQ_USE_EPOLL
 #elif defined ZMQ_FORCE_DEVPOLL
     typedef devpoll_t poller_t;
 #elif defined ZMQ_FORCE_KQUEUE
     typedef kqueue_t poller_t;
 #elif defined ZMQ_HAVE_LINUX
     typedef epoll_t poller_t;
+#define ZMQ_USE_EPOLL
 #elif defined ZMQ_HAVE_WINDOWS
     typedef select_t poller_t;
 #elif defined ZMQ_HAVE_FREEBSD
@@ -22,8 +22,46 @@
 #include "i_poll_events.hpp"
 #include "err.hpp"
 
-zmq::poller_base_t::poller_base_t ()
+//  Returns the position of the lowest bit set. The argument must be
+//  non-zero.
+static inline int lowest_bit (uint64_t word_)
 {
+#if defined __GNUC__
+    return __builtin_ctzll (word_);
+#else
+    int pos = 0;
+    while (!(word_ & 1)) {
+        word_ >>= 1;
+        pos++;
+    }
+    return pos;
+#endif
+}
+
+//  Returns the position of the first bit set in the range [from_, to_) of
+//  the bitmap or -1 if there is none.
+static int find_bit (const uint64_t *bitmap_, int from_, int to_)
+{
+    while (from_ < to_) {
+        uint64_t word = bitmap_ [from_ / 64] >> (from_ % 64);
+        if (word) {
+            int pos = from_ + lowest_bit (word);
+            return pos < to_ ? pos : -1;
+        }
+        from_ = (from_ / 64 + 1) * 64;
+    }
+    return -1;
+}
+
+zmq::poller_base_t::poller_base_t () :
+    unused (no_timer),
+    active (0)
+{
+    for (int i = 0; i != slot_count; i++)
+        slots [i] = no_timer;
+    for (int i = 0; i != slot_count / 64; i++)
+        occupied [i] = 0;
+    current = clock.now_ms ();
 }
 
 zmq::poller_base_t::~poller_base_t ()
@@ -45,55 +83,211 @@ void zmq::poller_base_t::adjust_load (int amount_)
         load.sub (-amount_);
 }
 
-void zmq::poller_base_t::add_timer (int timeout_, i_poll_events *sink_, int id_)
+zmq::poller_base_t::timer_handle_t zmq::poller_base_t::add_timer (
+    int timeout_, i_poll_events *sink_, int id_)
 {
-    uint64_t expiration = clock.now_ms () + timeout_;
-    timer_info_t info = {sink_, id_};
-    timers.insert (timers_t::value_type (expiration, info));
+    uint64_t now = clock.now_ms ();
+
+    //  If there are no timers, the wheel can be moved forward in time
+    //  without processing the elapsed period.
+    if (!active && current < now)
+        current = now;
+
+    //  Get an unused entry.
+    uint32_t index = unused;
+    if (index != no_timer)
+        unused = timers [index].next;
+    else {
+        index = (uint32_t) timers.size ();
+        zmq_assert (index != no_timer);
+        timer_info_t info;
+        info.generation = 0;
+        timers.push_back (info);
+    }
+
+    timer_info_t &info = timers [index];
+    info.expiration = now + timeout_;
+    info.sink = sink_;
+    info.id = id_;
+    link (index);
+    active++;
+
+    return ((timer_handle_t) info.generation << 32) | index;
+}
+
+void zmq::poller_base_t::cancel_timer (timer_handle_t handle_)
+{
+    uint32_t index = (uint32_t) handle_;
+    zmq_assert (index < timers.size ());
+    timer_info_t &info = timers [index];
+    zmq_assert (info.generation == (uint32_t) (handle_ >> 32));
+    zmq_assert (info.slot != no_timer);
+
+    //  Release the entry.
+    unlink (index);
+    info.slot = no_timer;
+    info.generation++;
+    info.next = unused;
+    unused = index;
+    active--;
 }
 
-void zmq::poller_base_t::cancel_timer (i_poll_events *sink_, int id_)
+void zmq::poller_base_t::link (uint32_t index_)
 {
-    //  Complexity of this operation is O(n). We assume it is rarely used.
-    for (timers_t::iterator it = timers.begin (); it != timers.end (); ++it)
-        if (it->second.sink == sink_ && it->second.id == id_) {
-            timers.erase (it);
-            return;
+    timer_info_t &info = timers [index_];
+
+    //  Timers that are already due are executed at the next millisecond
+    //  processed. Timers due within one revolution of the root level are
+    //  placed in the root level directly. Otherwise choose the lowest level
+    //  able to accomodate the timer.
+    uint32_t slot;
+    if (info.expiration < current)
+        slot = (uint32_t) (current & (root_slots - 1));
+    else if (info.expiration - current < root_slots)
+        slot = (uint32_t) (info.expiration & (root_slots - 1));
+    else {
+        uint64_t delta = info.expiration - current;
+        int level = 1;
+        int shift = root_bits;
+        while (level != levels - 1 &&
+              delta >= ((uint64_t) 1 << (shift + level_bits))) {
+            level++;
+            shift += level_bits;
         }
+        slot = root_slots + (level - 1) * level_slots +
+            (uint32_t) ((info.expiration >> shift) & (level_slots - 1));
+    }
 
-    //  Timer not found.
-    zmq_assert (false);
+    info.slot = slot;
+    info.prev = no_timer;
+    info.next = slots [slot];
+    if (info.next != no_timer)
+        timers [info.next].prev = index_;
+    slots [slot] = index_;
+    occupied [slot / 64] |= (uint64_t) 1 << (slot % 64);
+}
+
+void zmq::poller_base_t::unlink (uint32_t index_)
+{
+    timer_info_t &info = timers [index_];
+    if (info.prev != no_timer)
+        timers [info.prev].next = info.next;
+    else
+        slots [info.slot] = info.next;
+    if (info.next != no_timer)
+        timers [info.next].prev = info.prev;
+    if (slots [info.slot] == no_timer)
+        occupied [info.slot / 64] &= ~((uint64_t) 1 << (info.slot % 64));
+}
+
+void zmq::poller_base_t::cascade (uint32_t slot_)
+{
+    //  Detach the list first as the timers may end up in the same slot
+    //  once again.
+    uint32_t index = slots [slot_];
+    slots [slot_] = no_timer;
+    occupied [slot_ / 64] &= ~((uint64_t) 1 << (slot_ % 64));
+
+    while (index != no_timer) {
+        uint32_t next = timers [index].next;
+        link (index);
+        index = next;
+    }
+}
+
+uint64_t zmq::poller_base_t::next_expiration ()
+{
+    //  The root level holds the exact expiration times.
+    uint32_t pos = (uint32_t) (current & (root_slots - 1));
+    int found = find_bit (occupied, pos, root_slots);
+    if (found == -1) {
+        found = find_bit (occupied, 0, pos);
+        if (found != -1)
+            found += root_slots;
+    }
+    uint64_t result = found == -1 ? (uint64_t) -1 :
+        current - pos + found;
+
+    //  In the upper levels the best we know is when the slot will be
+    //  redistributed. That happens no later than any of the timers in it
+    //  expire.
+    int shift = root_bits;
+    for (int level = 1; level != levels; level++, shift += level_bits) {
+        uint32_t slot = root_slots + (level - 1) * level_slots;
+        uint64_t word = occupied [slot / 64];
+        if (!word)
+            continue;
+
+        //  The first redistribution of the level not yet done and the slot
+        //  it applies to.
+        uint64_t first = ((current + ((uint64_t) 1 << shift) - 1) >> shift);
+        int start = (int) (first & (level_slots - 1));
+        uint64_t rotated = start ? (word >> start) | (word << (64 - start)) :
+            word;
+        uint64_t time = (first + lowest_bit (rotated)) << shift;
+        if (time < result)
+            result = time;
+    }
+
+    return result;
 }
 
 uint64_t zmq::poller_base_t::execute_timers ()
 {
     //  Fast track.
-    if (timers.empty ())
+    if (!active)
         return 0;
 
     //  Get the current time.
-    uint64_t current = clock.now_ms ();
-
-    //   Execute the timers that are already due.
-    timers_t::iterator it = timers.begin ();
-    while (it != timers.end ()) {
-
-        //  If we have to wait to execute the item, same will be true about
-        //  all the following items (multimap is sorted). Thus we can stop
-        //  checking the subsequent timers and return the time to wait for
-        //  the next timer (at least 1ms).
-        if (it->first > current)
-            return it->first - current;
-
-        //  Trigger the timer.
-        it->second.sink->timer_event (it->second.id);
-
-        //  Remove it from the list of active timers.
-        timers_t::iterator o = it;
-        ++it;
-        timers.erase (o);
+    uint64_t now = clock.now_ms ();
+
+    //  Process the elapsed milliseconds.
+    while (current <= now) {
+
+        uint32_t pos = (uint32_t) (current & (root_slots - 1));
+
+        //  When the root level starts a new revolution, redistribute timers
+        //  from the upper levels. When a level itself starts a new
+        //  revolution, the next upper level is redistributed as well.
+        if (!pos) {
+            int shift = root_bits;
+            for (int level = 1; level != levels; level++) {
+                uint32_t index = (uint32_t) ((current >> shift) &
+                    (level_slots - 1));
+                cascade (root_slots + (level - 1) * level_slots + index);
+                if (index)
+                    break;
+                shift += level_bits;
+            }
+        }
+
+        //  Execute the timers. The timer entry is released before the
+        //  sink is invoked as the sink may add new timers.
+        while (slots [pos] != no_timer) {
+            uint32_t index = slots [pos];
+            unlink (index);
+            timer_info_t &info = timers [index];
+            i_poll_events *sink = info.sink;
+            int id = info.id;
+            info.slot = no_timer;
+            info.generation++;
+            info.next = unused;
+            unused = index;
+            active--;
+            sink->timer_event (id);
+        }
+
+        //  Skip to the next non-empty slot, but not beyond the end of the
+        //  revolution as upper levels have to be redistributed there.
+        int found = find_bit (occupied, pos + 1, root_slots);
+        uint64_t next = found == -1 ? current - pos + root_slots :
+            current - pos + found;
+        current = next < now + 1 ? next : now + 1;
     }
 
     //  There are no more timers.
-    return 0;
+    if (!active)
+        return 0;
+
+    return next_expiration () - now;
 }
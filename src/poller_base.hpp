@@ -21,9 +21,10 @@
 #ifndef __ZMQ_POLLER_BASE_HPP_INCLUDED__
 #define __ZMQ_POLLER_BASE_HPP_INCLUDED__
 
-#include <map>
+#include <vector>
 
 #include "clock.hpp"
+#include "stdint.hpp"
 #include "atomic_counter.hpp"
 
 namespace zmq
@@ -33,6 +34,9 @@ namespace zmq
     {
     public:
 
+        //  Handle identifying a running timer.
+        typedef uint64_t timer_handle_t;
+
         poller_base_t ();
         virtual ~poller_base_t ();
 
@@ -42,11 +46,13 @@ namespace zmq
 
         //  Add a timeout to expire in timeout_ milliseconds. After the
         //  expiration timer_event on sink_ object will be called with
-        //  argument set to id_.
-        void add_timer (int timeout_, struct i_poll_events *sink_, int id_);
+        //  argument set to id_. Returned handle can be used to cancel
+        //  the timer.
+        timer_handle_t add_timer (int timeout_, struct i_poll_events *sink_,
+            int id_);
 
-        //  Cancel the timer created by sink_ object with ID equal to id_.
-        void cancel_timer (struct i_poll_events *sink_, int id_);
+        //  Cancel the timer. The timer must not have expired yet.
+        void cancel_timer (timer_handle_t handle_);
 
     protected:
 
@@ -59,17 +65,74 @@ namespace zmq
 
     private:
 
+        //  Timers are kept in a hierarchical timing wheel. The root level
+        //  has a slot for each millisecond. A slot in each of the upper
+        //  levels spans a whole revolution of the level below it. When
+        //  the root level completes a revolution, timers from the next slot
+        //  of the upper level are redistributed to the lower levels.
+        //  Adding and cancelling a timer is thus O(1).
+        enum {
+            root_bits = 8,
+            level_bits = 6,
+            levels = 5,
+            root_slots = 1 << root_bits,
+            level_slots = 1 << level_bits,
+            slot_count = root_slots + (levels - 1) * level_slots
+        };
+
+        //  Marks the end of a list of timers.
+        enum {no_timer = 0xffffffff};
+
+        //  Inserts the timer to the slot corresponding to its expiration.
+        void link (uint32_t index_);
+
+        //  Removes the timer from its slot.
+        void unlink (uint32_t index_);
+
+        //  Redistributes timers from the specified slot to lower levels.
+        void cascade (uint32_t slot_);
+
+        //  Returns the earliest time a timer can expire at.
+        uint64_t next_expiration ();
+
         //  Clock instance private to this I/O thread.
         clock_t clock;
 
-        //  List of active timers.
+        //  Timers are stored in a single array so that no allocation is
+        //  needed per timer. Unused entries form a list so that they can
+        //  be reused.
         struct timer_info_t
         {
+            uint64_t expiration;
             struct i_poll_events *sink;
             int id;
+
+            //  Incremented each time the entry is released so that
+            //  stale handles can be detected.
+            uint32_t generation;
+
+            //  The slot the timer is in, or no_timer if the entry is unused.
+            uint32_t slot;
+
+            //  Neighbours in the slot or in the list of unused entries.
+            uint32_t prev;
+            uint32_t next;
         };
-        typedef std::multimap <uint64_t, timer_info_t> timers_t;
+        typedef std::vector <timer_info_t> timers_t;
         timers_t timers;
+        uint32_t unused;
+
+        //  Heads of the timer lists, one for each slot of each level,
+        //  and a bitmap of non-empty slots.
+        uint32_t slots [slot_count];
+        uint64_t occupied [slot_count / 64];
+
+        //  The next millisecond to process. All the timers that expired
+        //  before this point in time were already executed.
+        uint64_t current;
+
+        //  Number of running timers.
+        uint32_t active;
 
         //  Load of the poller. Currently the number of file descriptors
         //  registered.
@@ -0,0 +1,249 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "resolver.hpp"
+#include "command.hpp"
+#include "object.hpp"
+#include "config.hpp"
+#include "ctx.hpp"
+#include "err.hpp"
+
+zmq::resolver_t::resolver_t (ctx_t *ctx_) :
+    ctx (ctx_),
+    ttl (resolve_ttl),
+    started (false),
+    sleeping (false),
+    stopping (false)
+{
+}
+
+zmq::resolver_t::~resolver_t ()
+{
+    stop ();
+}
+
+void zmq::resolver_t::set_ttl (int ttl_)
+{
+    sync.lock ();
+    ttl = ttl_;
+    sync.unlock ();
+}
+
+int zmq::resolver_t::get_ttl ()
+{
+    sync.lock ();
+    int result = ttl;
+    sync.unlock ();
+    return result;
+}
+
+int zmq::resolver_t::resolve (const char *hostname_, sockaddr_storage *addr_,
+    socklen_t *addr_len_)
+{
+    //  IP addresses need no lookup.
+    int rc = resolve_ip_hostname (addr_, addr_len_, hostname_, true);
+    if (rc == 0)
+        return 0;
+
+    std::string hostname (hostname_);
+    sync.lock ();
+    bool found = lookup (hostname, addr_, addr_len_);
+    sync.unlock ();
+    if (found)
+        return 0;
+
+    rc = resolve_ip_hostname (addr_, addr_len_, hostname_);
+    if (rc != 0)
+        return -1;
+
+    sync.lock ();
+    store (hostname, *addr_, *addr_len_);
+    sync.unlock ();
+    return 0;
+}
+
+int zmq::resolver_t::resolve (const char *hostname_, sockaddr_storage *addr_,
+    socklen_t *addr_len_, object_t *sink_)
+{
+    //  IP addresses need no lookup.
+    int rc = resolve_ip_hostname (addr_, addr_len_, hostname_, true);
+    if (rc == 0)
+        return 0;
+
+    std::string hostname (hostname_);
+    sync.lock ();
+    if (lookup (hostname, addr_, addr_len_)) {
+        sync.unlock ();
+        return 0;
+    }
+
+    //  If the same host name is being looked up already, there's no need
+    //  to request a new lookup.
+    bool pending = false;
+    for (waiters_t::size_type i = 0; i != waiters.size (); i++)
+        if (waiters [i].hostname == hostname) {
+            pending = true;
+            break;
+        }
+
+    waiter_t waiter = {hostname, sink_, addr_, addr_len_};
+    waiters.push_back (waiter);
+
+    if (!pending) {
+        requests.push_back (hostname);
+        if (!started) {
+            started = true;
+            worker.start (worker_routine, this);
+        }
+        else if (sleeping) {
+            sleeping = false;
+            signaler.send ();
+        }
+    }
+    sync.unlock ();
+
+    errno = EAGAIN;
+    return -1;
+}
+
+bool zmq::resolver_t::cancel (object_t *sink_)
+{
+    sync.lock ();
+    for (waiters_t::size_type i = 0; i != waiters.size (); i++)
+        if (waiters [i].sink == sink_) {
+            waiters [i] = waiters.back ();
+            waiters.pop_back ();
+            sync.unlock ();
+            return true;
+        }
+    sync.unlock ();
+    return false;
+}
+
+void zmq::resolver_t::stop ()
+{
+    sync.lock ();
+    if (!started) {
+        sync.unlock ();
+        return;
+    }
+    stopping = true;
+    if (sleeping) {
+        sleeping = false;
+        signaler.send ();
+    }
+    sync.unlock ();
+
+    worker.stop ();
+    started = false;
+}
+
+void zmq::resolver_t::worker_routine (void *arg_)
+{
+    ((resolver_t*) arg_)->loop ();
+}
+
+void zmq::resolver_t::loop ()
+{
+    sync.lock ();
+    while (!stopping) {
+
+        //  Wait for the next request.
+        if (requests.empty ()) {
+            sleeping = true;
+            sync.unlock ();
+            int rc = signaler.wait (-1);
+            if (rc == 0)
+                signaler.recv ();
+            else
+                errno_assert (errno == EINTR);
+            sync.lock ();
+            continue;
+        }
+        std::string hostname = requests.front ();
+        requests.pop_front ();
+
+        //  Look the host name up. The lock is not held meanwhile so that
+        //  the cached addresses can be used.
+        sync.unlock ();
+        sockaddr_storage addr;
+        socklen_t addr_len = 0;
+        int rc = resolve_ip_hostname (&addr, &addr_len, hostname.c_str ());
+        int err = rc == 0 ? 0 : errno;
+        sync.lock ();
+
+        if (!err)
+            store (hostname, addr, addr_len);
+        complete (hostname, err, addr, addr_len);
+    }
+    sync.unlock ();
+}
+
+bool zmq::resolver_t::lookup (const std::string &hostname_,
+    sockaddr_storage *addr_, socklen_t *addr_len_)
+{
+    cache_t::iterator it = cache.find (hostname_);
+    if (it == cache.end ())
+        return false;
+    if (it->second.expiry <= clock.now_ms ()) {
+        cache.erase (it);
+        return false;
+    }
+    memcpy (addr_, &it->second.addr, it->second.addr_len);
+    *addr_len_ = it->second.addr_len;
+    return true;
+}
+
+void zmq::resolver_t::store (const std::string &hostname_,
+    const sockaddr_storage &addr_, socklen_t addr_len_)
+{
+    if (ttl <= 0)
+        return;
+    entry_t &entry = cache [hostname_];
+    memcpy (&entry.addr, &addr_, addr_len_);
+    entry.addr_len = addr_len_;
+    entry.expiry = clock.now_ms () + ttl;
+}
+
+void zmq::resolver_t::complete (const std::string &hostname_, int error_,
+    const sockaddr_storage &addr_, socklen_t addr_len_)
+{
+    waiters_t::size_type i = 0;
+    while (i != waiters.size ()) {
+        waiter_t &waiter = waiters [i];
+        if (waiter.hostname != hostname_) {
+            i++;
+            continue;
+        }
+        if (!error_) {
+            memcpy (waiter.addr, &addr_, addr_len_);
+            *waiter.addr_len = addr_len_;
+        }
+        command_t cmd;
+        cmd.destination = waiter.sink;
+        cmd.type = command_t::resolved;
+        cmd.args.resolved.error = error_;
+        ctx->send_command (waiter.sink->get_tid (), cmd);
+        waiters [i] = waiters.back ();
+        waiters.pop_back ();
+    }
+}
@@ -0,0 +1,155 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_RESOLVER_HPP_INCLUDED__
+#define __ZMQ_RESOLVER_HPP_INCLUDED__
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <string>
+
+#include "ip.hpp"
+#include "clock.hpp"
+#include "mutex.hpp"
+#include "signaler.hpp"
+#include "thread.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Resolves addresses in <hostname>:<port-number> format on behalf of
+    //  the context's I/O threads. Host names are looked up in a dedicated
+    //  thread, so that a slow name service never blocks the I/O threads.
+    //  Resolved addresses are cached for a configurable time. IP addresses
+    //  are resolved immediately and not cached.
+
+    class resolver_t
+    {
+    public:
+
+        resolver_t (class ctx_t *ctx_);
+        ~resolver_t ();
+
+        //  Time in milliseconds the resolved addresses are cached for.
+        void set_ttl (int ttl_);
+        int get_ttl ();
+
+        //  Resolves the address, blocking till the lookup is done. The
+        //  result is stored in the cache.
+        int resolve (const char *hostname_, sockaddr_storage *addr_,
+            socklen_t *addr_len_);
+
+        //  Resolves the address without blocking. If the address is not
+        //  known yet, returns -1 and sets errno to EAGAIN. Once the lookup
+        //  is done, the address is stored to addr_ and addr_len_ and
+        //  'resolved' command is sent to sink_.
+        int resolve (const char *hostname_, sockaddr_storage *addr_,
+            socklen_t *addr_len_, class object_t *sink_);
+
+        //  Cancels the lookup requested by sink_. Returns false if there is
+        //  no such lookup, i.e. the 'resolved' command was already sent.
+        bool cancel (class object_t *sink_);
+
+        //  Shuts the resolver thread down. Waits for the lookup being
+        //  processed at the moment, if any.
+        void stop ();
+
+    private:
+
+        //  Main routine of the resolver thread.
+        static void worker_routine (void *arg_);
+        void loop ();
+
+        //  Looks the address up in the cache. Returns false if it's not
+        //  there or the entry has expired.
+        bool lookup (const std::string &hostname_, sockaddr_storage *addr_,
+            socklen_t *addr_len_);
+
+        //  Stores the resolved address in the cache.
+        void store (const std::string &hostname_,
+            const sockaddr_storage &addr_, socklen_t addr_len_);
+
+        //  Passes the result of the lookup to all the objects waiting for it.
+        void complete (const std::string &hostname_, int error_,
+            const sockaddr_storage &addr_, socklen_t addr_len_);
+
+        //  Context to send the 'resolved' commands via.
+        class ctx_t *ctx;
+
+        //  Cached addresses and the time they expire.
+        struct entry_t
+        {
+            sockaddr_storage addr;
+            socklen_t addr_len;
+            uint64_t expiry;
+        };
+        typedef std::map <std::string, entry_t> cache_t;
+        cache_t cache;
+
+        //  Objects waiting for the lookups to be done.
+        struct waiter_t
+        {
+            std::string hostname;
+            class object_t *sink;
+            sockaddr_storage *addr;
+            socklen_t *addr_len;
+        };
+        typedef std::vector <waiter_t> waiters_t;
+        waiters_t waiters;
+
+        //  Host names to be looked up by the resolver thread.
+        std::deque <std::string> requests;
+
+        //  Time the addresses are cached for.
+        int ttl;
+
+        //  Clock used to expire the cache entries.
+        clock_t clock;
+
+        //  True if the resolver thread was launched. It is launched once
+        //  the first lookup is requested.
+        bool started;
+
+        //  True if the resolver thread is waiting for the requests and has
+        //  to be woken up via the signaler.
+        bool sleeping;
+
+        //  True if the resolver thread was asked to terminate.
+        bool stopping;
+
+        //  Synchronisation of the above between the resolver thread and
+        //  the threads requesting the lookups.
+        mutex_t sync;
+
+        //  Used to wake the resolver thread up.
+        signaler_t signaler;
+
+        //  The resolver thread.
+        thread_t worker;
+
+        resolver_t (const resolver_t&);
+        const resolver_t &operator = (const resolver_t&);
+    };
+
+}
+
+#endif
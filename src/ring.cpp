@@ -0,0 +1,341 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+#include <algorithm>
+
+#include "ring.hpp"
+#include "pipe.hpp"
+#include "config.hpp"
+#include "err.hpp"
+
+zmq::ring_t::ring_t () :
+    slots (NULL),
+    mask (0),
+    head (0),
+    published (0),
+    dropping (false),
+    readers (0),
+    sleepers (0),
+    refs (1)
+{
+}
+
+zmq::ring_t::~ring_t ()
+{
+    zmq_assert (readers == 0 && pipes.empty ());
+
+    //  All the published messages were passed to the readers. Deallocate
+    //  the parts of the unfinished message, if any.
+    for (uint32_t pos = published.get (); pos != head; pos++) {
+        int rc = slots [pos & mask].msg.close ();
+        errno_assert (rc == 0);
+    }
+    delete [] slots;
+}
+
+zmq::ring_pipe_t *zmq::ring_t::create_pipe (int size_)
+{
+    sync.lock ();
+
+    if (!slots) {
+        uint32_t count = 1;
+        while (count < (uint32_t) (size_ > 0 ? size_ : default_ring_size))
+            count <<= 1;
+        slots = new (std::nothrow) slot_t [count];
+        alloc_assert (slots);
+        mask = count - 1;
+    }
+
+    //  The pipe gets the messages published from now on.
+    ring_pipe_t *pipe = new (std::nothrow) ring_pipe_t (this,
+        published.get ());
+    alloc_assert (pipe);
+    pipes.push_back (pipe);
+    readers++;
+
+    sync.unlock ();
+
+    refs.add (1);
+    return pipe;
+}
+
+void zmq::ring_t::write (msg_t *msg_)
+{
+    bool more = msg_->flags () & (msg_t::more | msg_t::label) ? true : false;
+
+    sync.lock ();
+
+    //  The message can be written if there's someone to read it, the slot
+    //  was already read by all the readers and the message being written
+    //  doesn't fill the whole ring.
+    if (!dropping && readers > 0 && head - published.get () <= mask &&
+          slots [head & mask].refs.load () == 0) {
+        slots [head & mask].msg = *msg_;
+        head++;
+
+        //  Publish the whole message. Each reader gets a reference to each
+        //  of the parts.
+        if (!more) {
+            for (uint32_t pos = published.get (); pos != head; pos++) {
+                slot_t &slot = slots [pos & mask];
+                if (readers > 1)
+                    slot.msg.add_refs (readers - 1);
+                slot.refs.set (readers);
+            }
+            published.cas (published.get (), head);
+        }
+        sync.unlock ();
+        return;
+    }
+
+    //  Drop the message including the parts written so far.
+    while (head != published.get ()) {
+        head--;
+        int rc = slots [head & mask].msg.close ();
+        errno_assert (rc == 0);
+    }
+    dropping = more;
+
+    sync.unlock ();
+
+    int rc = msg_->close ();
+    errno_assert (rc == 0);
+}
+
+void zmq::ring_t::flush ()
+{
+    //  Fast path. Nobody is waiting for messages.
+    if (!sleepers.get ())
+        return;
+
+    sleep_sync.lock ();
+    for (pipes_t::size_type i = 0; i != sleeping.size (); i++) {
+        sleeping [i]->listed = false;
+        sleeping [i]->writer->flush ();
+    }
+    sleeping.clear ();
+    sleepers.set (0);
+    sleep_sync.unlock ();
+}
+
+void zmq::ring_t::terminated (pipe_t *writer_)
+{
+    sync.lock ();
+    sleep_sync.lock ();
+    for (pipes_t::size_type i = 0; i != pipes.size (); i++)
+        if (pipes [i]->writer == writer_) {
+            pipes [i]->writer = NULL;
+            if (pipes [i]->listed) {
+                sleeping.erase (std::find (sleeping.begin (), sleeping.end (),
+                    pipes [i]));
+                sleepers.set ((atomic_counter_t::integer_t) sleeping.size ());
+                pipes [i]->listed = false;
+            }
+        }
+    sleep_sync.unlock ();
+    sync.unlock ();
+}
+
+void zmq::ring_t::release ()
+{
+    if (!refs.sub (1))
+        delete this;
+}
+
+void zmq::ring_t::sleep (ring_pipe_t *pipe_)
+{
+    //  The pipe can be woken up only while the writer exists.
+    sleep_sync.lock ();
+    if (pipe_->writer && !pipe_->listed) {
+        sleeping.push_back (pipe_);
+        pipe_->listed = true;
+        sleepers.add (1);
+    }
+    pipe_->asleep.set (1);
+    sleep_sync.unlock ();
+}
+
+void zmq::ring_t::detach (ring_pipe_t *pipe_)
+{
+    sync.lock ();
+    uint32_t end = pipe_->end;
+    if (pipe_->attached) {
+        end = published.get ();
+        pipe_->attached = false;
+        readers--;
+    }
+    pipes.erase (std::find (pipes.begin (), pipes.end (), pipe_));
+    sync.unlock ();
+
+    unlist (pipe_);
+
+    //  Release the messages the pipe haven't read. The slots can't be
+    //  reused till we are done.
+    for (uint32_t pos = pipe_->cursor; pos != end; pos++) {
+        slot_t &slot = slots [pos & mask];
+        msg_t msg = slot.msg;
+        int rc = msg.close ();
+        errno_assert (rc == 0);
+        slot.refs.sub (1);
+    }
+}
+
+void zmq::ring_t::terminate (ring_pipe_t *pipe_)
+{
+    //  The messages published from now on are not passed to the pipe.
+    sync.lock ();
+    zmq_assert (pipe_->attached);
+    pipe_->end = published.get ();
+    pipe_->attached = false;
+    readers--;
+    sync.unlock ();
+
+    unlist (pipe_);
+
+    //  Let the reader know. The end position has to be set beforehand.
+    pipe_->terminated.cas (0, 1);
+}
+
+void zmq::ring_t::unlist (ring_pipe_t *pipe_)
+{
+    sleep_sync.lock ();
+    if (pipe_->listed) {
+        sleeping.erase (std::find (sleeping.begin (), sleeping.end (), pipe_));
+        sleepers.set ((atomic_counter_t::integer_t) sleeping.size ());
+        pipe_->listed = false;
+    }
+    sleep_sync.unlock ();
+}
+
+zmq::ring_pipe_t::ring_pipe_t (ring_t *ring_, uint32_t cursor_) :
+    ring (ring_),
+    writer (NULL),
+    cursor (cursor_),
+    available (cursor_),
+    terminated (0),
+    end (0),
+    delimited (false),
+    attached (true),
+    asleep (0),
+    listed (false)
+{
+}
+
+zmq::ring_pipe_t::~ring_pipe_t ()
+{
+    ring->detach (this);
+    ring->release ();
+}
+
+void zmq::ring_pipe_t::set_writer (pipe_t *writer_)
+{
+    writer = writer_;
+}
+
+void zmq::ring_pipe_t::write (const msg_t &value_, bool incomplete_)
+{
+    //  Only the delimiter is written to the pipe directly.
+    msg_t msg = value_;
+    zmq_assert (msg.is_delimiter () && !incomplete_);
+    ring->terminate (this);
+}
+
+bool zmq::ring_pipe_t::unwrite (msg_t *value_)
+{
+    return false;
+}
+
+bool zmq::ring_pipe_t::flush ()
+{
+    //  Returns false if the reader has to be woken up.
+    return asleep.cas (1, 0) != 1;
+}
+
+bool zmq::ring_pipe_t::check_read ()
+{
+    if (cursor != available)
+        return true;
+    if (delimited)
+        return false;
+
+    //  Check for newly published messages. Note that the published position
+    //  has to be retrieved before checking for termination. Otherwise the
+    //  messages published after the termination may be read. The positions
+    //  are loaded with acquire semantics so that the slots they cover are
+    //  read only after the writer has filled them in.
+    uint32_t pos = ring->published.load ();
+    if (terminated.load ()) {
+        available = end;
+        return true;
+    }
+    available = pos;
+    if (cursor != available)
+        return true;
+
+    //  There are no messages. Ask to be woken up and check once more in
+    //  case the messages were published in the meantime.
+    ring->sleep (this);
+    pos = ring->published.load ();
+    if (terminated.load ()) {
+        available = end;
+        return true;
+    }
+    available = pos;
+    return cursor != available;
+}
+
+bool zmq::ring_pipe_t::read (msg_t *value_)
+{
+    if (!check_read ())
+        return false;
+
+    //  All the messages up to the termination point were read.
+    if (cursor == available) {
+        value_->init_delimiter ();
+        delimited = true;
+        return true;
+    }
+
+    //  Take the reference to the message. The slot can be reused once
+    //  all the readers are done with it.
+    ring_t::slot_t &slot = ring->slots [cursor & ring->mask];
+    *value_ = slot.msg;
+    slot.refs.sub (1);
+    cursor++;
+    return true;
+}
+
+int zmq::ring_pipe_t::read_batch (msg_t *values_, int count_)
+{
+    if (!count_ || !read (&values_ [0]))
+        return 0;
+
+    //  Take the rest of the messages known to be available. Checking for
+    //  more would make the reader ask to be woken up while it still has
+    //  messages to process.
+    int nread = 1;
+    while (nread != count_ && cursor != available) {
+        bool ok = read (&values_ [nread]);
+        zmq_assert (ok);
+        nread++;
+    }
+    return nread;
+}
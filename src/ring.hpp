@@ -0,0 +1,202 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_RING_HPP_INCLUDED__
+#define __ZMQ_RING_HPP_INCLUDED__
+
+#include <vector>
+
+#include "ypipe_base.hpp"
+#include "atomic_counter.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+#include "msg.hpp"
+
+namespace zmq
+{
+
+    //  Ring of messages written by a single publisher and read by multiple
+    //  subscribers. Each message is written to the ring once, no matter how
+    //  many subscribers there are, and each subscriber reads it using its
+    //  own cursor. Message slot can be reused once all the subscribers have
+    //  read the message. If the slowest subscriber is a whole ring behind,
+    //  new messages are dropped.
+    //
+    //  The subscribers access the ring via ring_pipe_t objects, which can
+    //  be used in place of ypipe_t as inbound pipes of the subscribers.
+
+    class ring_t
+    {
+    public:
+
+        ring_t ();
+
+        //  Creates a pipe reading the messages written to the ring from now
+        //  on. If this is the first pipe created, the ring is allocated
+        //  to hold size_ messages.
+        class ring_pipe_t *create_pipe (int size_);
+
+        //  Writes the message part to the ring. The ring takes ownership
+        //  of the message. The message becomes visible to the readers once
+        //  all its parts are written.
+        void write (msg_t *msg_);
+
+        //  Wakes up the readers that are waiting for messages.
+        void flush ();
+
+        //  Forgets about all the pipes the writer_ pipe is the writer of.
+        //  Called before writer_ is deallocated.
+        void terminated (class pipe_t *writer_);
+
+        //  Drops a reference to the ring. The ring deallocates itself when
+        //  there are no more references.
+        void release ();
+
+    private:
+
+        friend class ring_pipe_t;
+
+        ~ring_t ();
+
+        //  Reader side of the pipe waits for new messages.
+        void sleep (ring_pipe_t *pipe_);
+
+        //  Removes the pipe from the ring. Messages that were passed to
+        //  the pipe, but not read by it are released.
+        void detach (ring_pipe_t *pipe_);
+
+        //  Writer side of the pipe stops sending messages to it. The reader
+        //  gets the messages written so far and the delimiter after them.
+        void terminate (ring_pipe_t *pipe_);
+
+        //  Removes the pipe from the list of pipes waiting for messages.
+        void unlist (ring_pipe_t *pipe_);
+
+        struct slot_t
+        {
+            msg_t msg;
+
+            //  Number of readers that have not read the message yet. Slot
+            //  can be reused when it drops to zero.
+            atomic_counter_t refs;
+        };
+
+        //  Array of message slots. Number of slots is a power of two so that
+        //  positions in the ring can be used as free running sequence
+        //  numbers.
+        slot_t *slots;
+        uint32_t mask;
+
+        //  Position where the next message part will be written. Used
+        //  exclusively by the writer thread.
+        uint32_t head;
+
+        //  Position up to which the messages are visible to the readers.
+        atomic_counter_t published;
+
+        //  True if the rest of the current message is dropped as there
+        //  was no space in the ring.
+        bool dropping;
+
+        //  Number of pipes reading from the ring and the list of all the
+        //  pipes, including those already terminated by the writer.
+        int readers;
+        typedef std::vector <ring_pipe_t*> pipes_t;
+        pipes_t pipes;
+
+        //  Synchronisation of slots, readers, pipes and publishing
+        //  of messages.
+        mutex_t sync;
+
+        //  Pipes waiting for new messages and the number of them.
+        pipes_t sleeping;
+        atomic_counter_t sleepers;
+        mutex_t sleep_sync;
+
+        //  Number of references to the ring (publisher and pipes).
+        atomic_counter_t refs;
+
+        ring_t (const ring_t&);
+        const ring_t &operator = (const ring_t&);
+    };
+
+    //  Pipe reading messages from a ring_t. The only message that can be
+    //  written to it is the delimiter.
+
+    class ring_pipe_t : public ypipe_base_t <msg_t>
+    {
+    public:
+
+        ~ring_pipe_t ();
+
+        //  Sets the pipe the messages are written through. The writer
+        //  is flushed to wake up the reader.
+        void set_writer (class pipe_t *writer_);
+
+        //  Implementation of ypipe_base_t.
+        void write (const msg_t &value_, bool incomplete_);
+        bool unwrite (msg_t *value_);
+        bool flush ();
+        bool check_read ();
+        bool read (msg_t *value_);
+        int read_batch (msg_t *values_, int count_);
+
+    private:
+
+        friend class ring_t;
+
+        ring_pipe_t (ring_t *ring_, uint32_t cursor_);
+
+        ring_t *ring;
+
+        //  Pipe the messages are written through. Access is synchronised
+        //  by the ring's sleep_sync.
+        class pipe_t *writer;
+
+        //  Position of the next message to read and the position up to
+        //  which messages are known to be available. Used exclusively by
+        //  the reader thread.
+        uint32_t cursor;
+        uint32_t available;
+
+        //  Set by the writer when the pipe is terminated. The reader gets
+        //  the messages up to the end position and the delimiter after
+        //  them.
+        atomic_counter_t terminated;
+        uint32_t end;
+
+        //  True if the delimiter was already read.
+        bool delimited;
+
+        //  True if the pipe counts among the ring's readers.
+        bool attached;
+
+        //  True if the reader is waiting to be woken up by flush. Listed
+        //  is true if the pipe is in the ring's list of sleeping pipes.
+        atomic_counter_t asleep;
+        bool listed;
+
+        ring_pipe_t (const ring_pipe_t&);
+        const ring_pipe_t &operator = (const ring_pipe_t&);
+    };
+
+}
+
+#endif
@@ -49,68 +49,56 @@ void zmq::router_t::xattach_pipe (pipe_t *pipe_, const blob_t &peer_identity_)
 
     //  Add the pipe to the map out outbound pipes.
     //  TODO: What if new connection has same peer identity as the old one?
+    uint32_t hash = outpipes_t::hash (peer_identity_);
     outpipe_t outpipe = {pipe_, true};
-    bool ok = outpipes.insert (outpipes_t::value_type (
-        peer_identity_, outpipe)).second;
+    bool ok = outpipes.insert (peer_identity_, hash, outpipe);
     zmq_assert (ok);
 
     //  Add the pipe to the list of inbound pipes.
-    inpipe_t inpipe = {pipe_, peer_identity_, true};
+    inpipe_t inpipe = {pipe_, peer_identity_, hash, true};
     inpipes.push_back (inpipe);
 }
 
-void zmq::router_t::xterminated (pipe_t *pipe_)
+zmq::router_t::inpipes_t::iterator zmq::router_t::find_inpipe (pipe_t *pipe_)
 {
     for (inpipes_t::iterator it = inpipes.begin (); it != inpipes.end ();
-          ++it) {
-        if (it->pipe == pipe_) {
-            if ((inpipes_t::size_type) (it - inpipes.begin ()) < current_in)
-                current_in--;
-            inpipes.erase (it);
-            if (current_in >= inpipes.size ())
-                current_in = 0;
-            goto clean_outpipes;
-        }
-    }
+          ++it)
+        if (it->pipe == pipe_)
+            return it;
     zmq_assert (false);
+    return inpipes.end ();
+}
 
-clean_outpipes:
-    for (outpipes_t::iterator it = outpipes.begin ();
-          it != outpipes.end (); ++it) {
-        if (it->second.pipe == pipe_) {
-            outpipes.erase (it);
-            if (pipe_ == current_out)
-                current_out = NULL;
-            return;
-        }
-    }
-    zmq_assert (false);
+void zmq::router_t::xterminated (pipe_t *pipe_)
+{
+    inpipes_t::iterator it = find_inpipe (pipe_);
+
+    bool ok = outpipes.erase (it->identity, it->hash);
+    zmq_assert (ok);
+    if (pipe_ == current_out)
+        current_out = NULL;
+
+    if ((inpipes_t::size_type) (it - inpipes.begin ()) < current_in)
+        current_in--;
+    inpipes.erase (it);
+    if (current_in >= inpipes.size ())
+        current_in = 0;
 }
 
 void zmq::router_t::xread_activated (pipe_t *pipe_)
 {
-    for (inpipes_t::iterator it = inpipes.begin (); it != inpipes.end ();
-          ++it) {
-        if (it->pipe == pipe_) {
-            zmq_assert (!it->active);
-            it->active = true;
-            return;
-        }
-    }
-    zmq_assert (false);
+    inpipes_t::iterator it = find_inpipe (pipe_);
+    zmq_assert (!it->active);
+    it->active = true;
 }
 
 void zmq::router_t::xwrite_activated (pipe_t *pipe_)
 {
-    for (outpipes_t::iterator it = outpipes.begin ();
-          it != outpipes.end (); ++it) {
-        if (it->second.pipe == pipe_) {
-            zmq_assert (!it->second.active);
-            it->second.active = true;
-            return;
-        }
-    }
-    zmq_assert (false);
+    inpipes_t::iterator it = find_inpipe (pipe_);
+    outpipe_t *outpipe = outpipes.find (it->identity, it->hash);
+    zmq_assert (outpipe);
+    zmq_assert (!outpipe->active);
+    outpipe->active = true;
 }
 
 int zmq::router_t::xsend (msg_t *msg_, int flags_)
@@ -129,16 +117,17 @@ int zmq::router_t::xsend (msg_t *msg_, int flags_)
 
             //  Find the pipe associated with the identity stored in the prefix.
             //  If there's no such pipe just silently ignore the message.
-            blob_t identity ((unsigned char*) msg_->data (), msg_->size ());
-            outpipes_t::iterator it = outpipes.find (identity);
+            unsigned char *identity = (unsigned char*) msg_->data ();
+            outpipe_t *outpipe = outpipes.find (identity, msg_->size (),
+                outpipes_t::hash (identity, msg_->size ()));
 
-            if (it != outpipes.end ()) {
-                current_out = it->second.pipe;
+            if (outpipe) {
+                current_out = outpipe->pipe;
                 msg_t empty;
                 int rc = empty.init ();
                 errno_assert (rc == 0);
                 if (!current_out->check_write (&empty)) {
-                    it->second.active = false;
+                    outpipe->active = false;
                     more_out = false;
                     current_out = NULL;
                     rc = empty.close ();
@@ -167,7 +156,10 @@ int zmq::router_t::xsend (msg_t *msg_, int flags_)
         if (unlikely (!ok))
             current_out = NULL;
         else if (!more_out) {
-            current_out->flush ();
+            if (flags_ & send_noflush)
+                current_out->defer_flush ();
+            else
+                current_out->flush ();
             current_out = NULL;
         }
     }
@@ -21,10 +21,10 @@
 #ifndef __ZMQ_ROUTER_HPP_INCLUDED__
 #define __ZMQ_ROUTER_HPP_INCLUDED__
 
-#include <map>
 #include <vector>
 
 #include "socket_base.hpp"
+#include "identity_map.hpp"
 #include "blob.hpp"
 #include "msg.hpp"
 
@@ -61,13 +61,18 @@ namespace zmq
         {
             class pipe_t *pipe;
             blob_t identity;
+            uint32_t hash;
             bool active;
         };
 
-        //  Inbound pipes with the names of corresponging peers.
+        //  Inbound pipes with the names of corresponging peers. The hash
+        //  of the name is computed once when the pipe is attached.
         typedef std::vector <inpipe_t> inpipes_t;
         inpipes_t inpipes;
 
+        //  Returns the inbound pipe record of the pipe.
+        inpipes_t::iterator find_inpipe (class pipe_t *pipe_);
+
         //  The pipe we are currently reading from.
         inpipes_t::size_type current_in;
 
@@ -87,7 +92,7 @@ namespace zmq
         };
 
         //  Outbound pipes indexed by the peer names.
-        typedef std::map <blob_t, outpipe_t> outpipes_t;
+        typedef identity_map_t <outpipe_t> outpipes_t;
         outpipes_t outpipes;
 
         //  The pipe we are currently writing to.
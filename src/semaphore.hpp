@@ -26,7 +26,7 @@
 
 #if defined ZMQ_HAVE_WINDOWS
 #include "windows.hpp"
-#elif defined ZMQ_HAVE_OPENVMS
+#elif defined ZMQ_HAVE_LINUX || defined ZMQ_HAVE_OSX || defined ZMQ_HAVE_OPENVMS
 #include <pthread.h>
 #else
 #include <semaphore.h>
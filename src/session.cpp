@@ -18,9 +18,12 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <new>
+
 #include "session.hpp"
 #include "socket_base.hpp"
 #include "i_engine.hpp"
+#include "filter.hpp"
 #include "err.hpp"
 #include "pipe.hpp"
 #include "likely.hpp"
@@ -30,6 +33,7 @@ zmq::session_t::session_t (class io_thread_t *io_thread_,
     own_t (io_thread_, options_),
     io_object_t (io_thread_),
     pipe (NULL),
+    filter (NULL),
     incomplete_in (false),
     pending (false),
     engine (NULL),
@@ -37,6 +41,10 @@ zmq::session_t::session_t (class io_thread_t *io_thread_,
     io_thread (io_thread_),
     has_linger_timer (false)
 {
+    if (options.type == ZMQ_SUB && options.early_filter) {
+        filter = new (std::nothrow) filter_t (options);
+        alloc_assert (filter);
+    }
 }
 
 zmq::session_t::~session_t ()
@@ -45,13 +53,15 @@ zmq::session_t::~session_t ()
 
     //  If there's still a pending linger timer, remove it.
     if (has_linger_timer) {
-        cancel_timer (linger_timer_id);
+        cancel_timer (linger_timer);
         has_linger_timer = false;
     }
 
     //  Close the engine.
     if (engine)
         engine->terminate ();
+
+    delete filter;
 }
 
 void zmq::session_t::attach_pipe (pipe_t *pipe_)
@@ -73,6 +83,17 @@ bool zmq::session_t::read (msg_t *msg_)
 
     incomplete_in =
         msg_->flags () & (msg_t::more | msg_t::label) ? true : false;
+
+    //  Keep the copy of the subscriptions up to date. SUB socket sends
+    //  only well-formed single-part subscriptions.
+    if (filter) {
+        unsigned char *data = (unsigned char*) msg_->data ();
+        if (*data == 1)
+            filter->add (data + 1, msg_->size () - 1);
+        else
+            filter->rm (data + 1, msg_->size () - 1);
+    }
+
     return true;
 }
 
@@ -93,6 +114,11 @@ void zmq::session_t::flush ()
         pipe->flush ();
 }
 
+zmq::filter_t *zmq::session_t::get_filter ()
+{
+    return filter;
+}
+
 void zmq::session_t::clean_pipes ()
 {
     if (pipe) {
@@ -155,6 +181,12 @@ void zmq::session_t::hiccuped (pipe_t *pipe_)
     zmq_assert (false);
 }
 
+void zmq::session_t::flush_deferred (pipe_t *pipe_)
+{
+    //  Session always flushes the messages it writes straight away.
+    zmq_assert (false);
+}
+
 void zmq::session_t::process_plug ()
 {
 }
@@ -181,8 +213,14 @@ void zmq::session_t::process_attach (i_engine *engine_,
         object_t *parents [2] = {this, socket};
         pipe_t *pipes [2] = {NULL, NULL};
         int hwms [2] = {options.rcvhwm, options.sndhwm};
+        int64_t hwms_bytes [2] = {options.rcvhwm_bytes, options.sndhwm_bytes};
+        const options_t *conflates [2] = {
+            options.conflate_in () ? &options : NULL,
+            options.conflate_out () ? &options : NULL};
+        ring_t *rings [2] = {NULL, NULL};
         bool delays [2] = {options.delay_on_close, options.delay_on_disconnect};
-        int rc = pipepair (parents, pipes, hwms, delays);
+        int rc = pipepair (parents, pipes, hwms, hwms_bytes, conflates,
+            rings, delays);
         errno_assert (rc == 0);
 
         //  Plug the local end of the pipe.
@@ -237,7 +275,7 @@ void zmq::session_t::process_term (int linger_)
     //  the timer.
     if (linger_ > 0) {
         zmq_assert (!has_linger_timer);
-        add_timer (linger_, linger_timer_id);
+        linger_timer = add_timer (linger_, linger_timer_id);
         has_linger_timer = true;
     }
 
@@ -305,6 +343,10 @@ void zmq::session_t::detached ()
     //  the socket object to resend all the subscriptions.
     if (pipe && (options.type == ZMQ_SUB || options.type == ZMQ_XSUB))
         pipe->hiccup ();  
+
+    //  The subscriptions will be passed through the session once again.
+    if (filter)
+        filter->clear ();
 }
 
 
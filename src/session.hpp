@@ -49,12 +49,14 @@ namespace zmq
         bool write (msg_t *msg_);
         void flush ();
         void detach ();
+        class filter_t *get_filter ();
 
         //  i_pipe_events interface implementation.
         void read_activated (class pipe_t *pipe_);
         void write_activated (class pipe_t *pipe_);
         void hiccuped (class pipe_t *pipe_);
         void terminated (class pipe_t *pipe_);
+        void flush_deferred (class pipe_t *pipe_);
 
     protected:
 
@@ -100,6 +102,12 @@ namespace zmq
         //  Pipe connecting the session to its socket.
         class pipe_t *pipe;
 
+        //  Copy of the subscriptions of the SUB socket the session belongs
+        //  to, used to drop the messages in the I/O thread. It's updated as
+        //  the subscriptions pass through the session on their way upstream.
+        //  NULL unless ZMQ_EARLY_FILTER option is set.
+        class filter_t *filter;
+
         //  This flag is true if the remainder of the message being processed
         //  is still in the in pipe.
         bool incomplete_in;
@@ -123,6 +131,7 @@ namespace zmq
 
         //  True is linger timer is running.
         bool has_linger_timer;
+        timer_handle_t linger_timer;
 
         session_t (const session_t&);
         const session_t &operator = (const session_t&);
@@ -0,0 +1,412 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_MEMFD && defined ZMQ_HAVE_EVENTFD
+
+#include <new>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "shm_engine.hpp"
+#include "shm_ring.hpp"
+#include "io_thread.hpp"
+#include "filter.hpp"
+#include "likely.hpp"
+#include "stdint.hpp"
+#include "err.hpp"
+
+//  Sent along with the file descriptors of the segment.
+static const uint32_t shm_handshake_magic = 0x5a4d5148;
+
+zmq::shm_engine_t::shm_engine_t (fd_t fd_, const options_t &options_,
+      bool connect_) :
+    s (fd_),
+    segment (NULL),
+    out_ring (NULL),
+    in_ring (NULL),
+    side (connect_ ? 0 : 1),
+    in_pending (false),
+    input_stopped (false),
+    filter (NULL),
+    in_more (false),
+    dropping (false),
+    out_pending (false),
+    sink (NULL),
+    ephemeral_sink (NULL),
+    options (options_),
+    plugged (false)
+{
+    int rc = in_msg.init ();
+    errno_assert (rc == 0);
+    rc = out_msg.init ();
+    errno_assert (rc == 0);
+}
+
+zmq::shm_engine_t::~shm_engine_t ()
+{
+    zmq_assert (!plugged);
+
+    int rc = in_msg.close ();
+    errno_assert (rc == 0);
+    rc = out_msg.close ();
+    errno_assert (rc == 0);
+
+    //  Messages received via slots may keep the segment mapped for a while.
+    if (segment) {
+        delete out_ring;
+        delete in_ring;
+        segment->release ();
+    }
+
+    rc = close (s);
+    errno_assert (rc == 0);
+}
+
+void zmq::shm_engine_t::plug (io_thread_t *io_thread_, i_engine_sink *sink_)
+{
+    zmq_assert (!plugged);
+    plugged = true;
+    ephemeral_sink = NULL;
+
+    //  Connect to session/init object.
+    zmq_assert (!sink);
+    zmq_assert (sink_);
+    sink = sink_;
+    filter = sink->get_filter ();
+    input_stopped = false;
+
+    //  Connect to I/O threads poller object. The socket is polled for the
+    //  segment sent by the peer and for disconnection.
+    io_object_t::plug (io_thread_);
+    handle = add_fd (s);
+    set_pollin (handle);
+
+    //  The connecting side passes the segment to the peer straight away.
+    if (segment) {
+        wake_handle = add_fd (segment->get_wake_fd (side));
+        set_pollin (wake_handle);
+    }
+    else if (side == 0 && !send_segment ()) {
+        error ();
+        return;
+    }
+
+    //  Flush all the messages that may have been already received.
+    in_event ();
+}
+
+void zmq::shm_engine_t::unplug ()
+{
+    zmq_assert (plugged);
+    plugged = false;
+
+    //  Cancel all fd subscriptions.
+    rm_fd (handle);
+    if (segment)
+        rm_fd (wake_handle);
+
+    //  Disconnect from I/O threads poller object.
+    io_object_t::unplug ();
+
+    //  Disconnect from init/session object.
+    filter = NULL;
+    ephemeral_sink = sink;
+    sink = NULL;
+}
+
+void zmq::shm_engine_t::terminate ()
+{
+    unplug ();
+    delete this;
+}
+
+void zmq::shm_engine_t::in_event ()
+{
+    //  The accepting side waits for the peer to pass it the segment.
+    if (!segment) {
+        bool failed = false;
+        if (!recv_segment (&failed)) {
+            if (failed)
+                error ();
+            return;
+        }
+    }
+
+    //  Reset the eventfd.
+    uint64_t count;
+    ssize_t nbytes = read (segment->get_wake_fd (side), &count,
+        sizeof (count));
+    errno_assert (nbytes == sizeof (count) || errno == EAGAIN);
+
+    //  No more data are expected on the socket. If it's readable, the peer
+    //  has either disconnected or violated the protocol.
+    unsigned char buf;
+    nbytes = recv (s, &buf, sizeof (buf), MSG_DONTWAIT);
+    bool disconnection = nbytes != -1 ||
+        (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+
+    if (!process ())
+        return;
+
+    if (sink && disconnection)
+        error ();
+}
+
+void zmq::shm_engine_t::activate_out ()
+{
+    if (segment)
+        process ();
+}
+
+void zmq::shm_engine_t::activate_in ()
+{
+    input_stopped = false;
+    if (segment)
+        process ();
+}
+
+bool zmq::shm_engine_t::send_segment ()
+{
+    shm_segment_t *new_segment = shm_segment_t::create ();
+    if (!new_segment)
+        return false;
+
+    //  Pass the shared memory and the eventfds to the peer.
+    fd_t fds [3] = {new_segment->get_fd (), new_segment->get_wake_fd (0),
+        new_segment->get_wake_fd (1)};
+    uint32_t magic = shm_handshake_magic;
+    iovec iov = {&magic, sizeof (magic)};
+    union {
+        cmsghdr align;
+        unsigned char buf [CMSG_SPACE (sizeof (fds))];
+    } control;
+    memset (&control, 0, sizeof (control));
+    msghdr msg;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+    cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (fds));
+    memcpy (CMSG_DATA (cmsg), fds, sizeof (fds));
+
+    ssize_t nbytes = sendmsg (s, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (nbytes != sizeof (magic)) {
+        new_segment->release ();
+        return false;
+    }
+
+    //  The peer has its own descriptor of the memory now.
+    new_segment->close_fd ();
+    open_rings (new_segment);
+    return true;
+}
+
+bool zmq::shm_engine_t::recv_segment (bool *error_)
+{
+    uint32_t magic;
+    iovec iov = {&magic, sizeof (magic)};
+    union {
+        cmsghdr align;
+        unsigned char buf [CMSG_SPACE (3 * sizeof (fd_t))];
+    } control;
+    msghdr msg;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+
+    ssize_t nbytes = recvmsg (s, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+          errno == EINTR))
+        return false;
+
+    //  Collect the file descriptors passed.
+    fd_t fds [3];
+    int nfds = 0;
+    if (nbytes != -1) {
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR (&msg); cmsg;
+              cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET ||
+                  cmsg->cmsg_type != SCM_RIGHTS)
+                continue;
+            int count = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (fd_t);
+            for (int i = 0; i != count; i++) {
+                fd_t fd;
+                memcpy (&fd, CMSG_DATA (cmsg) + i * sizeof (fd_t),
+                    sizeof (fd_t));
+                if (nfds < 3)
+                    fds [nfds++] = fd;
+                else {
+                    int rc = close (fd);
+                    errno_assert (rc == 0);
+                }
+            }
+        }
+    }
+
+    //  Drop the connection if the peer doesn't speak the protocol.
+    if (nbytes != sizeof (magic) || magic != shm_handshake_magic ||
+          nfds != 3 || (msg.msg_flags & MSG_CTRUNC)) {
+        for (int i = 0; i != nfds; i++) {
+            int rc = close (fds [i]);
+            errno_assert (rc == 0);
+        }
+        *error_ = true;
+        return false;
+    }
+
+    shm_segment_t *new_segment = shm_segment_t::attach (fds [0], fds + 1);
+    if (!new_segment) {
+        *error_ = true;
+        return false;
+    }
+    open_rings (new_segment);
+    return true;
+}
+
+void zmq::shm_engine_t::open_rings (shm_segment_t *segment_)
+{
+    segment = segment_;
+    out_ring = new (std::nothrow) shm_ring_t (segment, side);
+    alloc_assert (out_ring);
+    in_ring = new (std::nothrow) shm_ring_t (segment, 1 - side);
+    alloc_assert (in_ring);
+
+    wake_handle = add_fd (segment->get_wake_fd (side));
+    set_pollin (wake_handle);
+}
+
+bool zmq::shm_engine_t::process ()
+{
+    if (!process_in ()) {
+        error ();
+        return false;
+    }
+    process_out ();
+
+    //  Flush all the messages passed to the sink. If the sink has unplugged
+    //  the engine, flush transient sink.
+    if (unlikely (!plugged)) {
+        zmq_assert (ephemeral_sink);
+        ephemeral_sink->flush ();
+    } else {
+        sink->flush ();
+    }
+    return true;
+}
+
+bool zmq::shm_engine_t::process_in ()
+{
+    while (plugged && !input_stopped) {
+
+        if (!in_pending) {
+            int rc = in_ring->read (&in_msg, options.msg_pool,
+                options.maxmsgsize);
+            if (rc != 0) {
+
+                //  The peer has violated the protocol or the message can't
+                //  be allocated. Either way, the connection is unusable.
+                if (errno != EAGAIN)
+                    return false;
+                break;
+            }
+
+            //  The remaining parts of the message share the fate of the
+            //  first one.
+            bool first = !in_more;
+            in_more = in_msg.flags () & (msg_t::more | msg_t::label) ?
+                true : false;
+            if (first)
+                dropping = filter && !filter->match (
+                    (unsigned char*) in_msg.data (), in_msg.size ());
+            if (dropping) {
+                int rc = in_msg.close ();
+                errno_assert (rc == 0);
+                rc = in_msg.init ();
+                errno_assert (rc == 0);
+                continue;
+            }
+            in_pending = true;
+        }
+
+        //  Wait for activate_in if the sink can't accept more messages.
+        if (!sink->write (&in_msg)) {
+            input_stopped = true;
+            break;
+        }
+        in_pending = false;
+        int rc = in_msg.close ();
+        errno_assert (rc == 0);
+        rc = in_msg.init ();
+        errno_assert (rc == 0);
+    }
+
+    if (in_ring->flush_read ())
+        wake_peer ();
+    return true;
+}
+
+void zmq::shm_engine_t::process_out ()
+{
+    while (true) {
+        if (!out_pending) {
+            if (!plugged || !sink->read (&out_msg))
+                break;
+            out_pending = true;
+        }
+
+        //  If the ring is full, the peer wakes us up once it's not.
+        if (!out_ring->write (&out_msg))
+            break;
+        out_pending = false;
+    }
+
+    //  A large message may have been written partially. Flush the chunks
+    //  anyway so that the peer can free the space for the rest of it.
+    if (out_ring->flush_write ())
+        wake_peer ();
+}
+
+void zmq::shm_engine_t::wake_peer ()
+{
+    uint64_t one = 1;
+    ssize_t nbytes = write (segment->get_wake_fd (1 - side), &one,
+        sizeof (one));
+    errno_assert (nbytes == sizeof (one));
+}
+
+void zmq::shm_engine_t::error ()
+{
+    zmq_assert (sink);
+    sink->detach ();
+    unplug ();
+    delete this;
+}
+
+#endif
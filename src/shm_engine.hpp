@@ -0,0 +1,136 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SHM_ENGINE_HPP_INCLUDED__
+#define __ZMQ_SHM_ENGINE_HPP_INCLUDED__
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_MEMFD && defined ZMQ_HAVE_EVENTFD
+
+#include "i_engine.hpp"
+#include "io_object.hpp"
+#include "options.hpp"
+#include "msg.hpp"
+#include "fd.hpp"
+
+namespace zmq
+{
+
+    //  Engine of the shm transport. The peers pass the messages to each
+    //  other via rings in a shared memory segment and use eventfds to wake
+    //  each other up. The unix domain socket the connection was established
+    //  with is used to pass the segment to the accepting peer and, after
+    //  that, only to detect the disconnection of the peer.
+
+    class shm_engine_t : public io_object_t, public i_engine
+    {
+    public:
+
+        //  connect_ is true on the connecting side of the connection, i.e.
+        //  on the side that creates the segment.
+        shm_engine_t (fd_t fd_, const options_t &options_, bool connect_);
+        ~shm_engine_t ();
+
+        //  i_engine interface implementation.
+        void plug (class io_thread_t *io_thread_, struct i_engine_sink *sink_);
+        void unplug ();
+        void terminate ();
+        void activate_in ();
+        void activate_out ();
+
+        //  i_poll_events interface implementation.
+        void in_event ();
+
+    private:
+
+        //  Creates the segment and passes it to the peer.
+        bool send_segment ();
+
+        //  Receives the segment from the peer. Returns false if it haven't
+        //  arrived yet or on error, in which case error is set to true.
+        bool recv_segment (bool *error_);
+
+        //  Starts using the segment.
+        void open_rings (class shm_segment_t *segment_);
+
+        //  Passes the messages between the rings and the sink and flushes
+        //  the sink afterwards. Returns false if the inbound ring can't be
+        //  read any more. In such case the engine was already destroyed.
+        bool process ();
+        bool process_in ();
+        void process_out ();
+
+        //  Wakes the peer up.
+        void wake_peer ();
+
+        //  Function to handle disconnections.
+        void error ();
+
+        //  Unix domain socket connected to the peer.
+        fd_t s;
+        handle_t handle;
+
+        //  The shared memory and the rings this side writes to and reads
+        //  from. NULL until the segment is set up.
+        class shm_segment_t *segment;
+        class shm_ring_t *out_ring;
+        class shm_ring_t *in_ring;
+        handle_t wake_handle;
+
+        //  Index of this side, 0 for the connecting side, 1 for the
+        //  accepting one.
+        int side;
+
+        //  Message read from the ring that the sink haven't accepted yet.
+        msg_t in_msg;
+        bool in_pending;
+
+        //  True if the sink haven't accepted a message and haven't asked
+        //  for more yet.
+        bool input_stopped;
+
+        //  Early filtering of the messages received.
+        class filter_t *filter;
+        bool in_more;
+        bool dropping;
+
+        //  Message read from the sink that doesn't fit into the ring yet.
+        msg_t out_msg;
+        bool out_pending;
+
+        i_engine_sink *sink;
+
+        //  Detached transient sink.
+        i_engine_sink *ephemeral_sink;
+
+        options_t options;
+
+        bool plugged;
+
+        shm_engine_t (const shm_engine_t&);
+        const shm_engine_t &operator = (const shm_engine_t&);
+    };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,581 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_MEMFD && defined ZMQ_HAVE_EVENTFD
+
+#include <new>
+#include <algorithm>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+
+#include "shm_ring.hpp"
+#include "err.hpp"
+
+namespace zmq
+{
+    //  Header at the beginning of the segment. The peers check that they
+    //  agree on the layout of the segment.
+    struct shm_header_t
+    {
+        uint32_t magic;
+        uint32_t ring_size;
+        uint32_t slot_count;
+        uint32_t slot_size;
+        unsigned char pad [48];
+        shm_ctl_t ctls [2];
+    };
+
+    enum
+    {
+        shm_magic = 0x5a4d5153,
+        shm_header_size = 4096,
+        shm_rings_offset = shm_header_size,
+        shm_slots_offset = shm_rings_offset + 2 * shm_ring_size,
+        shm_segment_size = shm_slots_offset +
+            2 * shm_slot_count * shm_slot_size
+    };
+
+    //  The peer must not be able to resize the memory while it's mapped.
+    static const int shm_seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+}
+
+zmq::shm_segment_t *zmq::shm_segment_t::create ()
+{
+    //  Create the memory.
+    fd_t fd = memfd_create ("zmq-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1)
+        return NULL;
+    int rc = ftruncate (fd, shm_segment_size);
+    if (rc == 0)
+        rc = fcntl (fd, F_ADD_SEALS, shm_seals);
+    void *data = MAP_FAILED;
+    if (rc == 0)
+        data = mmap (NULL, shm_segment_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        int err = errno;
+        rc = close (fd);
+        errno_assert (rc == 0);
+        errno = err;
+        return NULL;
+    }
+
+    //  Create the eventfds.
+    fd_t wake_fds [2];
+    wake_fds [0] = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    wake_fds [1] = wake_fds [0] == -1 ? -1 :
+        eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fds [1] == -1) {
+        int err = errno;
+        if (wake_fds [0] != -1) {
+            rc = close (wake_fds [0]);
+            errno_assert (rc == 0);
+        }
+        rc = munmap (data, shm_segment_size);
+        errno_assert (rc == 0);
+        rc = close (fd);
+        errno_assert (rc == 0);
+        errno = err;
+        return NULL;
+    }
+
+    //  The memory is zero-filled, so only the header has to be filled in.
+    shm_header_t *header = (shm_header_t*) data;
+    header->magic = shm_magic;
+    header->ring_size = shm_ring_size;
+    header->slot_count = shm_slot_count;
+    header->slot_size = shm_slot_size;
+
+    shm_segment_t *segment = new (std::nothrow) shm_segment_t (fd,
+        (unsigned char*) data, wake_fds);
+    alloc_assert (segment);
+    return segment;
+}
+
+zmq::shm_segment_t *zmq::shm_segment_t::attach (fd_t fd_, fd_t wake_fds_ [2])
+{
+    //  Check that the memory has the expected size and can't be resized.
+    struct stat info;
+    int rc = fstat (fd_, &info);
+    if (rc == 0 && (info.st_size != shm_segment_size ||
+          fcntl (fd_, F_GET_SEALS) != shm_seals)) {
+        errno = EPROTO;
+        rc = -1;
+    }
+
+    void *data = MAP_FAILED;
+    if (rc == 0)
+        data = mmap (NULL, shm_segment_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd_, 0);
+
+    //  Check the layout of the segment.
+    if (data != MAP_FAILED) {
+        shm_header_t *header = (shm_header_t*) data;
+        if (header->magic != shm_magic ||
+              header->ring_size != shm_ring_size ||
+              header->slot_count != shm_slot_count ||
+              header->slot_size != shm_slot_size) {
+            rc = munmap (data, shm_segment_size);
+            errno_assert (rc == 0);
+            data = MAP_FAILED;
+            errno = EPROTO;
+        }
+    }
+
+    if (data == MAP_FAILED) {
+        int err = errno;
+        rc = close (fd_);
+        errno_assert (rc == 0);
+        rc = close (wake_fds_ [0]);
+        errno_assert (rc == 0);
+        rc = close (wake_fds_ [1]);
+        errno_assert (rc == 0);
+        errno = err;
+        return NULL;
+    }
+
+    shm_segment_t *segment = new (std::nothrow) shm_segment_t (fd_,
+        (unsigned char*) data, wake_fds_);
+    alloc_assert (segment);
+    return segment;
+}
+
+zmq::shm_segment_t::shm_segment_t (fd_t fd_, unsigned char *data_,
+      fd_t wake_fds_ [2]) :
+    fd (fd_),
+    data (data_),
+    refs (1)
+{
+    wake_fds [0] = wake_fds_ [0];
+    wake_fds [1] = wake_fds_ [1];
+    for (int i = 0; i != 2; i++)
+        for (int j = 0; j != shm_slot_count; j++) {
+            slot_refs [i][j].segment = this;
+            slot_refs [i][j].state = &ctl (i)->slots [j];
+        }
+}
+
+zmq::shm_segment_t::~shm_segment_t ()
+{
+    close_fd ();
+    int rc = close (wake_fds [0]);
+    errno_assert (rc == 0);
+    rc = close (wake_fds [1]);
+    errno_assert (rc == 0);
+    rc = munmap (data, shm_segment_size);
+    errno_assert (rc == 0);
+}
+
+zmq::fd_t zmq::shm_segment_t::get_fd ()
+{
+    return fd;
+}
+
+void zmq::shm_segment_t::close_fd ()
+{
+    if (fd != retired_fd) {
+        int rc = close (fd);
+        errno_assert (rc == 0);
+        fd = retired_fd;
+    }
+}
+
+zmq::fd_t zmq::shm_segment_t::get_wake_fd (int index_)
+{
+    return wake_fds [index_];
+}
+
+void zmq::shm_segment_t::add_ref ()
+{
+    refs.add (1);
+}
+
+void zmq::shm_segment_t::release ()
+{
+    if (!refs.sub (1))
+        delete this;
+}
+
+zmq::shm_ctl_t *zmq::shm_segment_t::ctl (int index_)
+{
+    return &((shm_header_t*) data)->ctls [index_];
+}
+
+unsigned char *zmq::shm_segment_t::ring (int index_)
+{
+    return data + shm_rings_offset + index_ * shm_ring_size;
+}
+
+unsigned char *zmq::shm_segment_t::slot (int index_, int slot_)
+{
+    return data + shm_slots_offset +
+        (index_ * shm_slot_count + slot_) * shm_slot_size;
+}
+
+void zmq::shm_segment_t::free_slot (void *data_, void *hint_)
+{
+    //  Hand the slot back to the producer.
+    slot_ref_t *ref = (slot_ref_t*) hint_;
+    __atomic_store_n (ref->state, 0, __ATOMIC_RELEASE);
+    ref->segment->release ();
+}
+
+zmq::shm_ring_t::shm_ring_t (shm_segment_t *segment_, int index_) :
+    segment (segment_),
+    index (index_),
+    ctl (segment_->ctl (index_)),
+    data (segment_->ring (index_)),
+    tail (__atomic_load_n (&ctl->tail, __ATOMIC_ACQUIRE)),
+    head (__atomic_load_n (&ctl->head, __ATOMIC_ACQUIRE)),
+    flushed_tail (tail),
+    flushed_head (head),
+    written (0),
+    next_slot (0),
+    assembled (0)
+{
+    int rc = assembled_msg.init ();
+    errno_assert (rc == 0);
+}
+
+zmq::shm_ring_t::~shm_ring_t ()
+{
+    int rc = assembled_msg.close ();
+    errno_assert (rc == 0);
+}
+
+uint32_t zmq::shm_ring_t::record_size (size_t size_)
+{
+    return (uint32_t) (sizeof (record_t) + ((size_ + 7) & ~(size_t) 7));
+}
+
+bool zmq::shm_ring_t::write (msg_t *msg_)
+{
+    size_t size = msg_->size ();
+    unsigned char flags = msg_->flags () & (msg_t::more | msg_t::label);
+
+    //  Small messages are copied to the ring.
+    if (size < shm_slot_min) {
+        if (!reserve (size))
+            return false;
+        put (record_inline, flags, 0, msg_->data (), size);
+        int rc = msg_->close ();
+        errno_assert (rc == 0);
+        rc = msg_->init ();
+        errno_assert (rc == 0);
+        return true;
+    }
+
+    //  Large ones are copied to a slot if there's a free one.
+    if (!written && size <= shm_slot_size) {
+        int slot = find_slot ();
+        if (slot != -1) {
+            if (!reserve (0))
+                return false;
+            memcpy (segment->slot (index, slot), msg_->data (), size);
+            __atomic_store_n (&ctl->slots [slot], 1, __ATOMIC_RELAXED);
+            put (record_slot, flags, (uint16_t) slot, NULL, size);
+            next_slot = (slot + 1) % shm_slot_count;
+            int rc = msg_->close ();
+            errno_assert (rc == 0);
+            rc = msg_->init ();
+            errno_assert (rc == 0);
+            return true;
+        }
+    }
+
+    //  Otherwise the message is passed in chunks. The chunks are small
+    //  enough for the ring to never be blocked by a record that can't fit.
+    const size_t max_chunk = shm_ring_size / 4 - 2 * sizeof (record_t);
+    while (written < size) {
+        unsigned char *pos = (unsigned char*) msg_->data () + written;
+        size_t chunk = std::min (size - written, max_chunk);
+        if (!written) {
+            if (!reserve (sizeof (uint64_t) + chunk))
+                return false;
+            unsigned char *payload = data +
+                ((tail + sizeof (record_t)) & (shm_ring_size - 1));
+            uint64_t total = size;
+            memcpy (payload, &total, sizeof (total));
+            memcpy (payload + sizeof (total), pos, chunk);
+            put (record_first, flags, 0, NULL, sizeof (total) + chunk);
+        }
+        else {
+            if (!reserve (chunk))
+                return false;
+            put (record_chunk, flags, 0, pos, chunk);
+        }
+        written += chunk;
+    }
+
+    written = 0;
+    int rc = msg_->close ();
+    errno_assert (rc == 0);
+    rc = msg_->init ();
+    errno_assert (rc == 0);
+    return true;
+}
+
+bool zmq::shm_ring_t::flush_write ()
+{
+    if (tail == flushed_tail)
+        return false;
+    flushed_tail = tail;
+    __atomic_store_n (&ctl->tail, tail, __ATOMIC_RELEASE);
+
+    //  Wake up the consumer if it's waiting for messages.
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+    return __atomic_load_n (&ctl->consumer_waiting, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n (&ctl->consumer_waiting, 0, __ATOMIC_ACQ_REL);
+}
+
+int zmq::shm_ring_t::read (msg_t *msg_, bool pooled_, int64_t maxmsgsize_)
+{
+    while (true) {
+
+        //  If there are no more records, tell the producer to wake us up
+        //  once there are. The tail has to be checked once again after
+        //  that as it may have moved in the meantime.
+        if (head == tail) {
+            tail = __atomic_load_n (&ctl->tail, __ATOMIC_ACQUIRE);
+            if (head == tail) {
+                __atomic_store_n (&ctl->consumer_waiting, 1, __ATOMIC_RELAXED);
+                __atomic_thread_fence (__ATOMIC_SEQ_CST);
+                tail = __atomic_load_n (&ctl->tail, __ATOMIC_ACQUIRE);
+                if (head == tail) {
+                    errno = EAGAIN;
+                    return -1;
+                }
+                __atomic_store_n (&ctl->consumer_waiting, 0, __ATOMIC_RELAXED);
+            }
+        }
+
+        //  The ring is written by the peer, so the records are checked
+        //  before they are used. Each record must have been written
+        //  completely and it must not cross the end of the ring.
+        uint32_t available = tail - head;
+        uint32_t contiguous = shm_ring_size - (head & (shm_ring_size - 1));
+        if (available > shm_ring_size || available < sizeof (record_t)) {
+            errno = EPROTO;
+            return -1;
+        }
+
+        //  The header is copied as the record may be overwritten by the
+        //  producer as soon as it's released.
+        record_t record = *(record_t*) (data + (head & (shm_ring_size - 1)));
+        unsigned char *payload = data + (head & (shm_ring_size - 1)) +
+            sizeof (record_t);
+        uint32_t size = record.size;
+        unsigned char flags = record.flags & (msg_t::more | msg_t::label);
+        bool done = true;
+
+        if (record.type == record_skip) {
+            if (contiguous > available) {
+                errno = EPROTO;
+                return -1;
+            }
+            head += contiguous;
+            continue;
+        }
+        if (record.type != record_slot && (size >= shm_ring_size ||
+              record_size (size) > contiguous ||
+              record_size (size) > available)) {
+            errno = EPROTO;
+            return -1;
+        }
+
+        switch (record.type) {
+
+        case record_inline:
+            {
+                if (size >= shm_slot_min ||
+                      (maxmsgsize_ >= 0 && (int64_t) size > maxmsgsize_)) {
+                    errno = EPROTO;
+                    return -1;
+                }
+                int rc = msg_->init_size (size, pooled_);
+                if (rc != 0) {
+                    errno_assert (errno == ENOMEM);
+                    rc = msg_->init ();
+                    errno_assert (rc == 0);
+                    errno = ENOMEM;
+                    return -1;
+                }
+                memcpy (msg_->data (), payload, size);
+                msg_->set_flags (flags);
+                break;
+            }
+
+        case record_slot:
+            {
+                if (record.slot >= shm_slot_count || size > shm_slot_size ||
+                      (maxmsgsize_ >= 0 && (int64_t) size > maxmsgsize_)) {
+                    errno = EPROTO;
+                    return -1;
+                }
+                segment->add_ref ();
+                int rc = msg_->init_data (segment->slot (index, record.slot),
+                    size, shm_segment_t::free_slot,
+                    &segment->slot_refs [index][record.slot]);
+                errno_assert (rc == 0);
+                msg_->set_flags (flags);
+                break;
+            }
+
+        case record_first:
+            {
+                uint64_t total;
+                if (size < sizeof (total) || assembled) {
+                    errno = EPROTO;
+                    return -1;
+                }
+                memcpy (&total, payload, sizeof (total));
+                size -= sizeof (total);
+                if (size > total || (uint64_t) (size_t) total != total ||
+                      (maxmsgsize_ >= 0 && total > (uint64_t) maxmsgsize_)) {
+                    errno = EPROTO;
+                    return -1;
+                }
+                int rc = assembled_msg.close ();
+                errno_assert (rc == 0);
+                rc = assembled_msg.init_size ((size_t) total, pooled_);
+                if (rc != 0) {
+                    errno_assert (errno == ENOMEM);
+                    rc = assembled_msg.init ();
+                    errno_assert (rc == 0);
+                    errno = ENOMEM;
+                    return -1;
+                }
+                memcpy (assembled_msg.data (), payload + sizeof (total), size);
+                assembled = size;
+                done = assembled == total;
+                break;
+            }
+
+        case record_chunk:
+            {
+                if (!assembled || size > assembled_msg.size () - assembled) {
+                    errno = EPROTO;
+                    return -1;
+                }
+                memcpy ((unsigned char*) assembled_msg.data () + assembled,
+                    payload, size);
+                assembled += size;
+                done = assembled == assembled_msg.size ();
+                break;
+            }
+
+        default:
+            errno = EPROTO;
+            return -1;
+        }
+
+        //  Release the space occupied by the record.
+        head += record_size (record.type == record_slot ? 0 : record.size);
+        __atomic_store_n (&ctl->head, head, __ATOMIC_RELEASE);
+
+        if (!done)
+            continue;
+
+        //  The message was assembled from chunks.
+        if (assembled) {
+            int rc = msg_->move (assembled_msg);
+            errno_assert (rc == 0);
+            msg_->set_flags (flags);
+            assembled = 0;
+        }
+        return 0;
+    }
+}
+
+bool zmq::shm_ring_t::flush_read ()
+{
+    if (head == flushed_head)
+        return false;
+    flushed_head = head;
+
+    //  Wake up the producer if it's waiting for space.
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+    return __atomic_load_n (&ctl->producer_waiting, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n (&ctl->producer_waiting, 0, __ATOMIC_ACQ_REL);
+}
+
+bool zmq::shm_ring_t::reserve (size_t size_)
+{
+    uint32_t size = record_size (size_);
+    uint32_t contiguous = shm_ring_size - (tail & (shm_ring_size - 1));
+    uint32_t needed = size <= contiguous ? size : contiguous + size;
+
+    //  Check whether there's enough space. If not, tell the consumer to
+    //  wake us up once there is. The head has to be checked once again
+    //  after that as it may have moved in the meantime.
+    if (shm_ring_size - (tail - head) < needed) {
+        head = __atomic_load_n (&ctl->head, __ATOMIC_ACQUIRE);
+        if (shm_ring_size - (tail - head) < needed) {
+            __atomic_store_n (&ctl->producer_waiting, 1, __ATOMIC_RELAXED);
+            __atomic_thread_fence (__ATOMIC_SEQ_CST);
+            head = __atomic_load_n (&ctl->head, __ATOMIC_ACQUIRE);
+            if (shm_ring_size - (tail - head) < needed)
+                return false;
+            __atomic_store_n (&ctl->producer_waiting, 0, __ATOMIC_RELAXED);
+        }
+    }
+
+    //  Records are never split. If the record doesn't fit before the end
+    //  of the ring, skip to the beginning.
+    if (size > contiguous) {
+        record_t *record = (record_t*) (data + (tail & (shm_ring_size - 1)));
+        record->size = contiguous - sizeof (record_t);
+        record->type = record_skip;
+        tail += contiguous;
+    }
+
+    return true;
+}
+
+void zmq::shm_ring_t::put (unsigned char type_, unsigned char flags_,
+    uint16_t slot_, const void *data_, size_t size_)
+{
+    record_t *record = (record_t*) (data + (tail & (shm_ring_size - 1)));
+    record->size = (uint32_t) size_;
+    record->type = type_;
+    record->flags = flags_;
+    record->slot = slot_;
+    if (data_)
+        memcpy (record + 1, data_, size_);
+    tail += record_size (type_ == record_slot ? 0 : size_);
+}
+
+int zmq::shm_ring_t::find_slot ()
+{
+    for (int i = 0; i != shm_slot_count; i++) {
+        int slot = (next_slot + i) % shm_slot_count;
+        if (!__atomic_load_n (&ctl->slots [slot], __ATOMIC_ACQUIRE))
+            return slot;
+    }
+    return -1;
+}
+
+#endif
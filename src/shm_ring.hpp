@@ -0,0 +1,243 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SHM_RING_HPP_INCLUDED__
+#define __ZMQ_SHM_RING_HPP_INCLUDED__
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_MEMFD && defined ZMQ_HAVE_EVENTFD
+
+#include <stddef.h>
+
+#include "atomic_counter.hpp"
+#include "config.hpp"
+#include "stdint.hpp"
+#include "fd.hpp"
+#include "msg.hpp"
+
+namespace zmq
+{
+
+    //  Control block of a ring as laid out in the shared memory. The
+    //  cursors are free-running byte counters. Each side announces that
+    //  it's going to sleep via the waiting flags, so that the other side
+    //  knows it has to wake it up. The fields written by the producer and
+    //  by the consumer are kept in separate cache lines.
+
+    struct shm_ctl_t
+    {
+        uint32_t tail;
+        uint32_t producer_waiting;
+        unsigned char pad1 [56];
+        uint32_t head;
+        uint32_t consumer_waiting;
+        unsigned char pad2 [56];
+
+        //  Non-zero if the corresponding slot holds a message the consumer
+        //  haven't deallocated yet.
+        uint32_t slots [shm_slot_count];
+    };
+
+    //  Shared memory segment used by the shm transport. The segment is
+    //  created by the connecting peer and passed to the accepting one along
+    //  with two eventfds the peers use to wake each other up. It holds two
+    //  rings, one per direction, each accompanied by a set of slots for
+    //  large messages.
+    //
+    //  The segment is reference counted. Besides the engine, each message
+    //  received via a slot holds a reference, so that the memory stays
+    //  mapped till the message is deallocated.
+
+    class shm_segment_t
+    {
+    public:
+
+        //  Creates a new segment. Returns NULL and sets errno on failure.
+        static shm_segment_t *create ();
+
+        //  Maps the segment received from the peer. Takes ownership of the
+        //  file descriptors. Returns NULL and sets errno on failure.
+        static shm_segment_t *attach (fd_t fd_, fd_t wake_fds_ [2]);
+
+        //  The file descriptor of the shared memory. Once it was passed to
+        //  the peer, it can be closed; the memory stays mapped.
+        fd_t get_fd ();
+        void close_fd ();
+
+        //  The eventfds used to wake up the connecting (0) and the
+        //  accepting (1) peer.
+        fd_t get_wake_fd (int index_);
+
+        void add_ref ();
+        void release ();
+
+    private:
+
+        friend class shm_ring_t;
+
+        shm_segment_t (fd_t fd_, unsigned char *data_, fd_t wake_fds_ [2]);
+        ~shm_segment_t ();
+
+        //  Returns the control block, the data and the slots of the ring.
+        shm_ctl_t *ctl (int index_);
+        unsigned char *ring (int index_);
+        unsigned char *slot (int index_, int slot_);
+
+        //  Deallocation function of the messages received via slots.
+        static void free_slot (void *data_, void *hint_);
+
+        //  Hints passed to free_slot, one per slot.
+        struct slot_ref_t
+        {
+            shm_segment_t *segment;
+            uint32_t *state;
+        };
+        slot_ref_t slot_refs [2][shm_slot_count];
+
+        fd_t fd;
+        unsigned char *data;
+        fd_t wake_fds [2];
+
+        atomic_counter_t refs;
+
+        shm_segment_t (const shm_segment_t&);
+        const shm_segment_t &operator = (const shm_segment_t&);
+    };
+
+    //  Single-producer single-consumer ring of messages in a shared memory
+    //  segment. Each peer creates one object for the ring it writes to and
+    //  one for the ring it reads from. Ring 0 passes messages from the
+    //  connecting peer to the accepting one, ring 1 the other way round.
+    //
+    //  Messages smaller than shm_slot_min are copied into the ring. Larger
+    //  messages are copied into a free slot and the receiver uses them in
+    //  place. Messages too large for a slot, or written while all the slots
+    //  are in use, are passed through the ring in chunks.
+
+    class shm_ring_t
+    {
+    public:
+
+        shm_ring_t (shm_segment_t *segment_, int index_);
+        ~shm_ring_t ();
+
+        //  Producer side. Writes the message to the ring and leaves msg_
+        //  empty. Returns false if there's not enough space in the ring. In
+        //  such case the consumer wakes the producer up once it has freed
+        //  some and the write has to be retried with the same message.
+        bool write (msg_t *msg_);
+
+        //  Makes the messages written so far available to the consumer.
+        //  Returns true if the consumer has to be woken up.
+        bool flush_write ();
+
+        //  Consumer side. Reads the next message from the ring. Returns -1
+        //  and sets errno to EAGAIN if there's none. In such case the
+        //  producer wakes the consumer up once it has written one. EPROTO
+        //  means the producer has violated the protocol or sent a message
+        //  larger than maxmsgsize_, ENOMEM that the message could not be
+        //  allocated. In both cases the ring can't be read any more.
+        int read (msg_t *msg_, bool pooled_, int64_t maxmsgsize_);
+
+        //  Finishes a batch of reads, including the chunks of a message
+        //  that was not read completely yet. Returns true if the producer
+        //  has to be woken up.
+        bool flush_read ();
+
+    private:
+
+        //  Record header preceding each record in the ring. Records are
+        //  aligned to 8 bytes.
+        struct record_t
+        {
+            uint32_t size;
+            unsigned char type;
+            unsigned char flags;
+            uint16_t slot;
+        };
+
+        enum
+        {
+            //  Message copied into the ring.
+            record_inline = 1,
+
+            //  Message stored in a slot. The record has no payload, its size
+            //  is the size of the message.
+            record_slot = 2,
+
+            //  The first chunk of a message. The payload starts with the
+            //  64-bit size of the whole message.
+            record_first = 3,
+
+            //  Subsequent chunk of a message.
+            record_chunk = 4,
+
+            //  Padding up to the end of the ring.
+            record_skip = 5
+        };
+
+        static uint32_t record_size (size_t size_);
+
+        //  Makes sure there's a contiguous space for a record of the given
+        //  payload size at the tail of the ring.
+        bool reserve (size_t size_);
+
+        //  Appends the record with the payload copied from data_ to the ring.
+        void put (unsigned char type_, unsigned char flags_, uint16_t slot_,
+            const void *data_, size_t size_);
+
+        //  Returns a free slot or -1 if there's none.
+        int find_slot ();
+
+        shm_segment_t *segment;
+        int index;
+        shm_ctl_t *ctl;
+        unsigned char *data;
+
+        //  Producer cursor and the last known consumer cursor, if this is
+        //  the producer side. The other way round for the consumer side.
+        uint32_t tail;
+        uint32_t head;
+
+        //  Cursors as of the last flush. If the cursor haven't moved since,
+        //  there's no need to check whether the other side is waiting.
+        uint32_t flushed_tail;
+        uint32_t flushed_head;
+
+        //  Producer side: number of bytes of the message being written in
+        //  chunks that were already written. Next slot to try.
+        size_t written;
+        int next_slot;
+
+        //  Consumer side: message being assembled from chunks and the
+        //  number of bytes assembled so far.
+        msg_t assembled_msg;
+        size_t assembled;
+
+        shm_ring_t (const shm_ring_t&);
+        const shm_ring_t &operator = (const shm_ring_t&);
+    };
+
+}
+
+#endif
+
+#endif
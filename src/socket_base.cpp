@@ -47,6 +47,7 @@
 #include "likely.hpp"
 #include "uuid.hpp"
 #include "msg.hpp"
+#include "socket_poller.hpp"
 
 #include "pair.hpp"
 #include "pub.hpp"
@@ -128,8 +129,10 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_, uint32_t tid_) :
     last_tsc (0),
     ticks (0),
     rcvlabel (false),
-    rcvmore (false)
+    rcvmore (false),
+    unflushed (false)
 {
+    options.msg_pool = parent_->get (ZMQ_MSG_POOL) == 1;
 }
 
 zmq::socket_base_t::~socket_base_t ()
@@ -183,7 +186,8 @@ int zmq::socket_base_t::check_protocol (const std::string &protocol_)
 {
     //  First check out whether the protcol is something we are aware of.
     if (protocol_ != "inproc" && protocol_ != "ipc" && protocol_ != "tcp" &&
-          protocol_ != "pgm" && protocol_ != "epgm" && protocol_ != "sys") {
+          protocol_ != "pgm" && protocol_ != "epgm" && protocol_ != "sys" &&
+          protocol_ != "shm") {
         errno = EPROTONOSUPPORT;
         return -1;
     }
@@ -206,6 +210,14 @@ int zmq::socket_base_t::check_protocol (const std::string &protocol_)
     }
 #endif
 
+    //  SHM transport requires memfd and eventfd.
+#if !defined ZMQ_HAVE_MEMFD || !defined ZMQ_HAVE_EVENTFD
+    if (protocol_ == "shm") {
+        errno = EPROTONOSUPPORT;
+        return -1;
+    }
+#endif
+
     //  Check whether socket type and transport protocol match.
     //  Specifically, multicast protocols can't be combined with
     //  bi-directional messaging patterns (socket types).
@@ -244,6 +256,8 @@ void zmq::socket_base_t::attach_pipe (pipe_t *pipe_,
         register_term_acks (1);
         pipe_->terminate (false);
     }
+
+    notify_socket_pollers ();
 }
 
 int zmq::socket_base_t::setsockopt (int option_, const void *optval_,
@@ -254,6 +268,15 @@ int zmq::socket_base_t::setsockopt (int option_, const void *optval_,
         return -1;
     }
 
+    //  The subscriptions are stored according to the topic options, so
+    //  the options can't be changed once there are any subscriptions or
+    //  peers that could have sent them.
+    if ((option_ == ZMQ_TOPIC_LENGTH || option_ == ZMQ_TOPIC_DELIMITER) &&
+          (!pipes.empty () || xhas_subscriptions ())) {
+        errno = EINVAL;
+        return -1;
+    }
+
     //  First, check whether specific socket type overloads the option.
     int rc = xsetsockopt (option_, optval_, optvallen_);
     if (rc == 0 || errno != EINVAL)
@@ -307,6 +330,14 @@ int zmq::socket_base_t::getsockopt (int option_, void *optval_,
             errno = EINVAL;
             return -1;
         }
+
+        //  The socket is being polled, possibly waiting for the replies to
+        //  the messages sent without flushing. Pass them to the peers.
+        if (unflushed) {
+            flush_pipes ();
+            unflushed = false;
+        }
+
         int rc = process_commands (0, false);
         if (rc != 0 && (errno == EINTR || errno == ETERM))
             return -1;
@@ -346,25 +377,48 @@ int zmq::socket_base_t::bind (const char *addr_)
         return register_endpoint (addr_, endpoint);
     }
 
-    if (protocol == "tcp" || protocol == "ipc") {
-
-        //  Choose I/O thread to run the listerner in.
-        io_thread_t *io_thread = choose_io_thread (options.affinity);
-        if (!io_thread) {
+    if (protocol == "tcp" || protocol == "ipc" || protocol == "shm") {
+
+        //  Choose I/O threads to run the listerners in. If the port can be
+        //  shared, there's one listener per I/O thread, otherwise a single
+        //  listener is used.
+        bool sharded = protocol == "tcp" && options.reuseport &&
+            tcp_listener_t::can_share_port ();
+        std::vector <io_thread_t*> io_threads;
+        if (sharded)
+            choose_io_threads (options.affinity, io_threads);
+        else {
+            io_thread_t *io_thread = choose_io_thread (options.affinity);
+            if (io_thread)
+                io_threads.push_back (io_thread);
+        }
+        if (io_threads.empty ()) {
             errno = EMTHREAD;
             return -1;
         }
 
-        //  Create and run the listener.
-        zmq_listener_t *listener = new (std::nothrow) zmq_listener_t (
-            io_thread, this, options);
-        alloc_assert (listener);
-        int rc = listener->set_address (protocol.c_str(), address.c_str ());
-        if (rc != 0) {
-            delete listener;
-            return -1;
+        //  Create the listeners.
+        std::vector <zmq_listener_t*> listeners;
+        for (size_t i = 0; i != io_threads.size (); i++) {
+            zmq_listener_t *listener = new (std::nothrow) zmq_listener_t (
+                io_threads [i], this, options, sharded);
+            alloc_assert (listener);
+            int rc = listener->set_address (protocol.c_str(),
+                address.c_str ());
+            if (rc != 0) {
+                int err = errno;
+                delete listener;
+                for (size_t j = 0; j != listeners.size (); j++)
+                    delete listeners [j];
+                errno = err;
+                return -1;
+            }
+            listeners.push_back (listener);
         }
-        launch_child (listener);
+
+        //  Run the listeners.
+        for (size_t i = 0; i != listeners.size (); i++)
+            launch_child (listeners [i]);
 
         return 0;
     }
@@ -399,14 +453,16 @@ int zmq::socket_base_t::connect (const char *addr_)
     if (rc != 0)
         return -1;
 
-    //  Parsed address for validation
+    //  Parsed address for validation. Resolved TCP address is cached by
+    //  the context, so that the connecter can use it straight away.
     sockaddr_storage addr;
     socklen_t addr_len;
 
     if (protocol == "tcp")
-        rc = resolve_ip_hostname (&addr, &addr_len, address.c_str ());
+        rc = get_ctx ()->get_resolver ()->resolve (address.c_str (), &addr,
+            &addr_len);
     else
-    if (protocol == "ipc")
+    if (protocol == "ipc" || protocol == "shm")
         rc = resolve_local_path (&addr, &addr_len, address.c_str ());
     if (rc != 0)
         return -1;
@@ -434,13 +490,47 @@ int zmq::socket_base_t::connect (const char *addr_)
             rcvhwm = 0;
         else
             rcvhwm = options.rcvhwm + peer.options.sndhwm;
+        int64_t sndhwm_bytes;
+        int64_t rcvhwm_bytes;
+        if (options.sndhwm_bytes == 0 || peer.options.rcvhwm_bytes == 0)
+            sndhwm_bytes = 0;
+        else
+            sndhwm_bytes = options.sndhwm_bytes + peer.options.rcvhwm_bytes;
+        if (options.rcvhwm_bytes == 0 || peer.options.sndhwm_bytes == 0)
+            rcvhwm_bytes = 0;
+        else
+            rcvhwm_bytes = options.rcvhwm_bytes + peer.options.sndhwm_bytes;
 
         //  Create a bi-directional pipe to connect the peers.
         object_t *parents [2] = {this, peer.socket};
         pipe_t *pipes [2] = {NULL, NULL};
         int hwms [2] = {sndhwm, rcvhwm};
+        int64_t hwms_bytes [2] = {sndhwm_bytes, rcvhwm_bytes};
+
+        //  Messages are conflated if either side asks for it.
+        const options_t *conflates [2] = {
+            options.conflate_out () ? &options :
+                peer.options.conflate_in () ? &peer.options : NULL,
+            peer.options.conflate_out () ? &peer.options :
+                options.conflate_in () ? &options : NULL};
+
+        //  Messages from a publisher to inproc subscribers can be passed via
+        //  a single ring shared by all the subscribers. Subscribers filter
+        //  the messages themselves in such case.
+        ring_t *rings [2] = {
+            options.broadcast_out () && peer.options.type == ZMQ_SUB &&
+                !conflates [0] ? get_ring () : NULL,
+            peer.options.broadcast_out () && options.type == ZMQ_SUB &&
+                !conflates [1] ? peer.socket->get_ring () : NULL};
+
+        //  The size of the ring is given by the publisher's HWM.
+        if (rings [0])
+            hwms [0] = options.sndhwm;
+        if (rings [1])
+            hwms [1] = peer.options.sndhwm;
         bool delays [2] = {options.delay_on_disconnect, options.delay_on_close};
-        int rc = pipepair (parents, pipes, hwms, delays);
+        int rc = pipepair (parents, pipes, hwms, hwms_bytes, conflates,
+            rings, delays);
         errno_assert (rc == 0);
 
         //  Attach local end of the pipe to this socket object.
@@ -475,8 +565,14 @@ int zmq::socket_base_t::connect (const char *addr_)
         object_t *parents [2] = {this, session};
         pipe_t *pipes [2] = {NULL, NULL};
         int hwms [2] = {options.sndhwm, options.rcvhwm};
+        int64_t hwms_bytes [2] = {options.sndhwm_bytes, options.rcvhwm_bytes};
+        const options_t *conflates [2] = {
+            options.conflate_out () ? &options : NULL,
+            options.conflate_in () ? &options : NULL};
+        ring_t *rings [2] = {NULL, NULL};
         bool delays [2] = {options.delay_on_disconnect, options.delay_on_close};
-        int rc = pipepair (parents, pipes, hwms, delays);
+        int rc = pipepair (parents, pipes, hwms, hwms_bytes, conflates,
+            rings, delays);
         errno_assert (rc == 0);
 
         //  Attach local end of the pipe to the socket object.
@@ -517,13 +613,28 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
     if (flags_ & ZMQ_SNDMORE)
         msg_->set_flags (msg_t::more);
 
+    //  Messages sent with ZMQ_NOFLUSH are written to the pipes, but the peers
+    //  are not notified about them till the pipes are flushed.
+    if (flags_ & ZMQ_NOFLUSH)
+        flags_ = (flags_ & ~ZMQ_NOFLUSH) | send_noflush;
+
     //  Try to send the message.
     rc = xsend (msg_, flags_);
-    if (rc == 0)
+    if (rc == 0) {
+        if (flags_ & send_noflush)
+            set_unflushed ();
         return 0;
+    }
     if (unlikely (errno != EAGAIN))
         return -1;
 
+    //  The pipes may be full of messages the peers don't know about yet.
+    //  Let them know so that they can make room for the message.
+    if (unflushed) {
+        flush_pipes ();
+        unflushed = false;
+    }
+
     //  In case of non-blocking send we'll simply propagate
     //  the error - including EAGAIN - up the stack.
     if (flags_ & ZMQ_DONTWAIT || options.sndtimeo == 0)
@@ -542,8 +653,11 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
         if (unlikely (process_commands (timeout, false) != 0))
             return -1;
         rc = xsend (msg_, flags_);
-        if (rc == 0)
+        if (rc == 0) {
+            if (flags_ & send_noflush)
+                set_unflushed ();
             break;
+        }
         if (unlikely (errno != EAGAIN))
             return -1;
         if (timeout > 0) {
@@ -592,12 +706,7 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
 
     //  If we have the message, return immediately.
     if (rc == 0) {
-        rcvlabel = msg_->flags () & msg_t::label;
-        rcvmore = msg_->flags () & msg_t::more || rcvlabel;
-        if (rcvlabel)
-            msg_->reset_flags (msg_t::label);
-        if (rcvmore)
-            msg_->reset_flags (msg_t::more);
+        extract_flags (msg_);
         return 0;
     }
 
@@ -613,15 +722,17 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
         rc = xrecv (msg_, flags_);
         if (rc < 0)
             return rc;
-        rcvlabel = msg_->flags () & msg_t::label;
-        rcvmore = msg_->flags () & msg_t::more || rcvlabel;
-        if (rcvlabel)
-            msg_->reset_flags (msg_t::label);
-        if (rcvmore)
-            msg_->reset_flags (msg_t::more);
+        extract_flags (msg_);
         return 0;
     }
 
+    //  The reply may depend on the messages sent without flushing. Flush
+    //  them before waiting for it.
+    if (unflushed) {
+        flush_pipes ();
+        unflushed = false;
+    }
+
     //  Compute the time when the timeout should occur.
     //  If the timeout is infite, don't care.
     clock_t clock ;
@@ -650,17 +761,136 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
             }
         }
     }
-    rcvlabel = msg_->flags () & msg_t::label;
-    rcvmore = msg_->flags () & msg_t::more || rcvlabel;
-    if (rcvlabel)
-        msg_->reset_flags (msg_t::label);
-    if (rcvmore)
-        msg_->reset_flags (msg_t::more);
+    extract_flags (msg_);
     return 0;
 }
 
+int zmq::socket_base_t::send_batch (msg_t *msgs_, int count_, int flags_)
+{
+    //  Check whether the library haven't been shut down yet.
+    if (unlikely (ctx_terminated)) {
+        errno = ETERM;
+        return -1;
+    }
+
+    if (unlikely (count_ <= 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  Check whether messages passed to the function are valid.
+    for (int i = 0; i != count_; i++) {
+        if (unlikely (!msgs_ [i].check ())) {
+            errno = EFAULT;
+            return -1;
+        }
+    }
+
+    //  Process pending commands, if any. Commands are processed once for
+    //  the whole batch.
+    int rc = process_commands (0, true);
+    if (unlikely (rc != 0))
+        return -1;
+
+    //  The flags imposed on the message apply to the last one only.
+    if (flags_ & ZMQ_SNDLABEL)
+        msgs_ [count_ - 1].set_flags (msg_t::label);
+    if (flags_ & ZMQ_SNDMORE)
+        msgs_ [count_ - 1].set_flags (msg_t::more);
+
+    //  With ZMQ_NOFLUSH the pipes are left unflushed even once the batch
+    //  is written.
+    bool noflush = flags_ & ZMQ_NOFLUSH ? true : false;
+    flags_ &= ~ZMQ_NOFLUSH;
+
+    int sent = 0;
+    while (true) {
+
+        //  Write as many messages as possible without flushing the pipes,
+        //  then flush them all at once. That way the peers are woken up at
+        //  most once per batch.
+        for (; sent != count_; sent++) {
+            int flags = sent == count_ - 1 ? flags_ :
+                flags_ & ~(ZMQ_SNDMORE | ZMQ_SNDLABEL);
+            rc = xsend (&msgs_ [sent], flags | send_noflush);
+            if (rc != 0)
+                break;
+        }
+        if (!noflush) {
+            flush_pipes ();
+            unflushed = false;
+        }
+        else if (sent != 0)
+            set_unflushed ();
+
+        //  If at least part of the batch was sent, report it. The error,
+        //  if any, will be reported by the subsequent call.
+        if (sent != 0)
+            return sent;
+        if (unlikely (errno != EAGAIN))
+            return -1;
+
+        //  Nothing was sent. Send the first message the standard way, which
+        //  blocks if required, and carry on with the rest.
+        rc = send (&msgs_ [0], (count_ == 1 ? flags_ :
+            flags_ & ~(ZMQ_SNDMORE | ZMQ_SNDLABEL)) |
+            (noflush ? ZMQ_NOFLUSH : 0));
+        if (rc != 0)
+            return -1;
+        sent = 1;
+    }
+}
+
+int zmq::socket_base_t::recv_batch (msg_t *msgs_, int count_, int flags_)
+{
+    if (unlikely (count_ <= 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  Check whether messages passed to the function are valid.
+    for (int i = 1; i < count_; i++) {
+        if (unlikely (!msgs_ [i].check ())) {
+            errno = EFAULT;
+            return -1;
+        }
+    }
+
+    //  Wait for the first message the standard way. It checks for the rest
+    //  of the error conditions as well.
+    int rc = recv (&msgs_ [0], flags_);
+    if (unlikely (rc != 0))
+        return -1;
+
+    //  Get the messages that are immediately available. Stop at the part
+    //  followed by more parts of the same message, so that ZMQ_RCVMORE
+    //  applies to the last message received.
+    int received = 1;
+    while (received != count_ && !rcvmore) {
+        rc = xrecv (&msgs_ [received], flags_ | ZMQ_DONTWAIT);
+        if (rc != 0)
+            break;
+        extract_flags (&msgs_ [received]);
+        received++;
+        ticks++;
+    }
+
+    //  Commands are processed once per batch at most.
+    if (ticks >= inbound_poll_rate) {
+        if (unlikely (process_commands (0, false) != 0))
+            return -1;
+        ticks = 0;
+    }
+
+    return received;
+}
+
 int zmq::socket_base_t::close ()
 {
+    //  Persistent pollers must not refer to the socket any more.
+    while (!socket_pollers.empty ())
+        socket_pollers.back ().first->remove (this);
+
     //  Transfer the ownership of the socket from this application thread
     //  to the reaper thread which will take care of the rest of shutdown
     //  process.
@@ -669,6 +899,11 @@ int zmq::socket_base_t::close ()
     return 0;
 }
 
+bool zmq::socket_base_t::pooled ()
+{
+    return options.msg_pool;
+}
+
 bool zmq::socket_base_t::has_in ()
 {
     return xhas_in ();
@@ -679,34 +914,65 @@ bool zmq::socket_base_t::has_out ()
     return xhas_out ();
 }
 
+void zmq::socket_base_t::add_socket_poller (socket_poller_t *poller_,
+    int index_)
+{
+    socket_pollers.push_back (std::make_pair (poller_, index_));
+}
+
+void zmq::socket_base_t::rm_socket_poller (socket_poller_t *poller_)
+{
+    for (socket_pollers_t::iterator it = socket_pollers.begin ();
+          it != socket_pollers.end (); ++it)
+        if (it->first == poller_) {
+            socket_pollers.erase (it);
+            return;
+        }
+}
+
+int zmq::socket_base_t::socket_poller_index (socket_poller_t *poller_)
+{
+    for (socket_pollers_t::size_type i = 0; i != socket_pollers.size (); i++)
+        if (socket_pollers [i].first == poller_)
+            return socket_pollers [i].second;
+    return -1;
+}
+
+void zmq::socket_base_t::notify_socket_pollers ()
+{
+    for (socket_pollers_t::size_type i = 0; i != socket_pollers.size (); i++)
+        socket_pollers [i].first->changed (socket_pollers [i].second);
+}
+
 bool zmq::socket_base_t::register_session (const blob_t &name_,
     session_t *session_)
 {
+    uint32_t hash = sessions_t::hash (name_);
     sessions_sync.lock ();
-    bool registered = sessions.insert (
-        sessions_t::value_type (name_, session_)).second;
+    bool registered = sessions.insert (name_, hash, session_);
     sessions_sync.unlock ();
     return registered;
 }
 
 void zmq::socket_base_t::unregister_session (const blob_t &name_)
 {
+    uint32_t hash = sessions_t::hash (name_);
     sessions_sync.lock ();
-    sessions_t::iterator it = sessions.find (name_);
-    zmq_assert (it != sessions.end ());
-    sessions.erase (it);
+    bool erased = sessions.erase (name_, hash);
+    zmq_assert (erased);
     sessions_sync.unlock ();
 }
 
 zmq::session_t *zmq::socket_base_t::find_session (const blob_t &name_)
 {
+    uint32_t hash = sessions_t::hash (name_);
     sessions_sync.lock ();
-    sessions_t::iterator it = sessions.find (name_);
-    if (it == sessions.end ()) {
+    session_t **entry = sessions.find (name_, hash);
+    if (!entry) {
         sessions_sync.unlock ();
         return NULL;
     }
-    session_t *session = it->second;
+    session_t *session = *entry;
 
     //  Prepare the session for subsequent attach command.
     //  Note the connect sessions have NULL pointers registered here.
@@ -737,7 +1003,7 @@ int zmq::socket_base_t::process_commands (int timeout_, bool throttle_)
     if (timeout_ != 0) {
 
         //  If we are asked to wait, simply ask mailbox to wait.
-        rc = mailbox.recv (&cmd, timeout_);
+        rc = mailbox.recv (&cmd, timeout_, options.spin);
     }
     else {
 
@@ -786,6 +1052,48 @@ int zmq::socket_base_t::process_commands (int timeout_, bool throttle_)
     return 0;
 }
 
+void zmq::socket_base_t::extract_flags (msg_t *msg_)
+{
+    rcvlabel = msg_->flags () & msg_t::label;
+    rcvmore = msg_->flags () & msg_t::more || rcvlabel;
+    if (rcvlabel)
+        msg_->reset_flags (msg_t::label);
+    if (rcvmore)
+        msg_->reset_flags (msg_t::more);
+}
+
+int zmq::socket_base_t::flush ()
+{
+    //  Check whether the library haven't been shut down yet.
+    if (unlikely (ctx_terminated)) {
+        errno = ETERM;
+        return -1;
+    }
+
+    flush_pipes ();
+    unflushed = false;
+    return 0;
+}
+
+void zmq::socket_base_t::set_unflushed ()
+{
+    //  The persistent pollers retrieve ZMQ_EVENTS only for the sockets that
+    //  may have become ready. Let them check the socket so that polling it
+    //  flushes the messages.
+    if (!unflushed) {
+        unflushed = true;
+        notify_socket_pollers ();
+    }
+}
+
+void zmq::socket_base_t::flush_pipes ()
+{
+    for (deferred_t::size_type i = 0; i != deferred.size (); i++)
+        deferred [i]->flush_deferred ();
+    deferred.clear ();
+    xflush ();
+}
+
 void zmq::socket_base_t::process_stop ()
 {
     //  Here, someone have called zmq_term while the socket was still alive.
@@ -826,6 +1134,11 @@ void zmq::socket_base_t::process_destroy ()
     destroyed = true;
 }
 
+zmq::ring_t *zmq::socket_base_t::get_ring ()
+{
+    return NULL;
+}
+
 int zmq::socket_base_t::xsetsockopt (int option_, const void *optval_,
     size_t optvallen_)
 {
@@ -849,6 +1162,11 @@ bool zmq::socket_base_t::xhas_in ()
     return false;
 }
 
+bool zmq::socket_base_t::xhas_subscriptions ()
+{
+    return false;
+}
+
 int zmq::socket_base_t::xrecv (msg_t *msg_, int flags_)
 {
     errno = ENOTSUP;
@@ -869,6 +1187,10 @@ void zmq::socket_base_t::xhiccuped (pipe_t *pipe_)
     zmq_assert (false);
 }
 
+void zmq::socket_base_t::xflush ()
+{
+}
+
 void zmq::socket_base_t::in_event ()
 {
     //  This function is invoked only once the socket is running in the context
@@ -911,11 +1233,13 @@ void zmq::socket_base_t::check_destroy ()
 void zmq::socket_base_t::read_activated (pipe_t *pipe_)
 {
     xread_activated (pipe_);
+    notify_socket_pollers ();
 }
 
 void zmq::socket_base_t::write_activated (pipe_t *pipe_)
 {
     xwrite_activated (pipe_);
+    notify_socket_pollers ();
 }
 
 void zmq::socket_base_t::hiccuped (pipe_t *pipe_)
@@ -928,6 +1252,14 @@ void zmq::socket_base_t::terminated (pipe_t *pipe_)
     //  Notify the specific socket type about the pipe termination.
     xterminated (pipe_);
 
+    //  The pipe may be waiting to be flushed.
+    if (!deferred.empty ()) {
+        deferred_t::iterator it = std::find (deferred.begin (),
+            deferred.end (), pipe_);
+        if (it != deferred.end ())
+            deferred.erase (it);
+    }
+
     //  Remove the pipe from the list of attached pipes and confirm its
     //  termination if we are already shutting down.
     pipes.erase (pipe_);
@@ -935,3 +1267,8 @@ void zmq::socket_base_t::terminated (pipe_t *pipe_)
         unregister_term_ack ();
 }
 
+void zmq::socket_base_t::flush_deferred (pipe_t *pipe_)
+{
+    deferred.push_back (pipe_);
+}
+
@@ -21,7 +21,6 @@
 #ifndef __ZMQ_SOCKET_BASE_HPP_INCLUDED__
 #define __ZMQ_SOCKET_BASE_HPP_INCLUDED__
 
-#include <map>
 #include <vector>
 
 #include "own.hpp"
@@ -34,6 +33,7 @@
 #include "mailbox.hpp"
 #include "stdint.hpp"
 #include "blob.hpp"
+#include "identity_map.hpp"
 #include "pipe.hpp"
 #include "own.hpp"
 
@@ -71,13 +71,36 @@ namespace zmq
         int connect (const char *addr_);
         int send (class msg_t *msg_, int flags_);
         int recv (class msg_t *msg_, int flags_);
+        int send_batch (class msg_t *msgs_, int count_, int flags_);
+        int recv_batch (class msg_t *msgs_, int count_, int flags_);
+        int flush ();
         int close ();
 
+        //  Returns true if messages created on behalf of this socket should
+        //  be allocated from the message pool.
+        bool pooled ();
+
         //  These functions are used by the polling mechanism to determine
         //  which events are to be reported from this socket.
         bool has_in ();
         bool has_out ();
 
+        //  Persistent pollers use these functions to register with the socket
+        //  so that they are notified when the state of the socket may have
+        //  changed. index_ identifies the socket within the poller.
+        void add_socket_poller (class socket_poller_t *poller_, int index_);
+        void rm_socket_poller (class socket_poller_t *poller_);
+
+        //  Returns index of the socket within the poller or -1 if the socket
+        //  is not registered with the poller.
+        int socket_poller_index (class socket_poller_t *poller_);
+
+        //  Returns the ring used to pass messages to inproc subscribers or
+        //  NULL if the socket type doesn't send messages that way. The ring
+        //  doesn't change over the lifetime of the socket, so the function
+        //  can be called from a different thread.
+        virtual class ring_t *get_ring ();
+
         //  Registry of named sessions.
         bool register_session (const blob_t &name_, class session_t *session_);
         void unregister_session (const blob_t &name_);
@@ -98,6 +121,7 @@ namespace zmq
         void write_activated (pipe_t *pipe_);
         void hiccuped (pipe_t *pipe_);
         void terminated (pipe_t *pipe_);
+        void flush_deferred (pipe_t *pipe_);
 
     protected:
 
@@ -115,6 +139,11 @@ namespace zmq
         virtual int xsetsockopt (int option_, const void *optval_,
             size_t optvallen_);
 
+        //  Returns true if the socket has subscriptions of its own, i.e.
+        //  ones that are not tied to any of the pipes. The default
+        //  implementation assumes there are none.
+        virtual bool xhas_subscriptions ();
+
         //  The default implementation assumes that send is not supported.
         virtual bool xhas_out ();
         virtual int xsend (class msg_t *msg_, int flags_);
@@ -129,6 +158,10 @@ namespace zmq
         virtual void xhiccuped (pipe_t *pipe_);
         virtual void xterminated (pipe_t *pipe_) = 0;
 
+        //  Flushes the messages sent with send_noflush flag that were not
+        //  written to a pipe. The default implementation does nothing.
+        virtual void xflush ();
+
         //  Delay actual destruction of the socket.
         void process_destroy ();
 
@@ -166,6 +199,21 @@ namespace zmq
         //  in a predefined time period.
         int process_commands (int timeout_, bool throttle_);
 
+        //  Moves the LABEL and MORE flags of the received message to the
+        //  socket, so that they can be retrieved using getsockopt.
+        void extract_flags (class msg_t *msg_);
+
+        //  Flushes the messages written to the pipes without flushing them
+        //  downstream.
+        void flush_pipes ();
+
+        //  Remembers that there are messages to flush.
+        void set_unflushed ();
+
+        //  Notifies the persistent pollers the socket is registered with
+        //  that the socket may have become ready.
+        void notify_socket_pollers ();
+
         //  Handlers for incoming commands.
         void process_stop ();
         void process_bind (class pipe_t *pipe_, const blob_t &peer_identity_);
@@ -183,6 +231,11 @@ namespace zmq
         poller_t *poller;
         poller_t::handle_t handle;
 
+        //  Persistent pollers the socket is registered with.
+        typedef std::vector <std::pair <class socket_poller_t*, int> >
+            socket_pollers_t;
+        socket_pollers_t socket_pollers;
+
         //  Timestamp of when commands were processed the last time.
         uint64_t last_tsc;
 
@@ -195,11 +248,19 @@ namespace zmq
         //  True if the last message received had MORE flag set.
         bool rcvmore;
 
+        //  True if messages were sent with ZMQ_NOFLUSH flag since the pipes
+        //  were last flushed.
+        bool unflushed;
+
+        //  Pipes written to without being flushed.
+        typedef std::vector <pipe_t*> deferred_t;
+        deferred_t deferred;
+
         //  Lists of existing sessions. This list is never referenced from
         //  within the socket, instead it is used by objects owned by
         //  the socket. As those objects can live in different threads,
         //  the access is synchronised by mutex.
-        typedef std::map <blob_t, session_t*> sessions_t;
+        typedef identity_map_t <session_t*> sessions_t;
         sessions_t sessions;
         mutex_t sessions_sync;
 
@@ -0,0 +1,429 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "socket_poller.hpp"
+
+#if defined ZMQ_USE_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+#include "socket_base.hpp"
+#include "config.hpp"
+#include "clock.hpp"
+#include "err.hpp"
+
+zmq::socket_poller_t::socket_poller_t () :
+    tag (0xcafebabe)
+{
+#if defined ZMQ_USE_EPOLL
+    epoll_fd = epoll_create (1);
+    errno_assert (epoll_fd != -1);
+#else
+    rebuild = false;
+#endif
+}
+
+zmq::socket_poller_t::~socket_poller_t ()
+{
+    //  Let the sockets know they are not polled by this poller any more.
+    for (items_t::size_type i = 0; i != items.size (); i++)
+        if (items [i].used && items [i].socket)
+            items [i].socket->rm_socket_poller (this);
+
+#if defined ZMQ_USE_EPOLL
+    int rc = close (epoll_fd);
+    errno_assert (rc == 0);
+#endif
+
+    //  Remove the tag, so that the object is considered dead.
+    tag = 0xdeadbeef;
+}
+
+bool zmq::socket_poller_t::check_tag ()
+{
+    return tag == 0xcafebabe;
+}
+
+int zmq::socket_poller_t::add (socket_base_t *socket_, void *user_data_,
+    short events_)
+{
+    if (socket_->socket_poller_index (this) != -1) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  The socket is polled on using its mailbox file descriptor.
+    fd_t fd;
+    size_t fd_size = sizeof (fd_t);
+    int rc = socket_->getsockopt (ZMQ_FD, &fd, &fd_size);
+    if (rc != 0)
+        return -1;
+
+    int index = alloc_item ();
+    item_t &item = items [index];
+    item.socket = socket_;
+    item.fd = fd;
+    item.user_data = user_data_;
+    item.events = events_;
+    socket_->add_socket_poller (this, index);
+
+#if defined ZMQ_USE_EPOLL
+    register_item (index, EPOLL_CTL_ADD);
+
+    //  Messages may be already waiting in the socket.
+    set_pending (index);
+#else
+    rebuild = true;
+#endif
+    return 0;
+}
+
+int zmq::socket_poller_t::modify (socket_base_t *socket_, short events_)
+{
+    int index = socket_->socket_poller_index (this);
+    if (index == -1) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    items [index].events = events_;
+#if defined ZMQ_USE_EPOLL
+    set_pending (index);
+#else
+    rebuild = true;
+#endif
+    return 0;
+}
+
+int zmq::socket_poller_t::remove (socket_base_t *socket_)
+{
+    int index = socket_->socket_poller_index (this);
+    if (index == -1) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    socket_->rm_socket_poller (this);
+#if defined ZMQ_USE_EPOLL
+    register_item (index, EPOLL_CTL_DEL);
+#endif
+    free_item (index);
+    return 0;
+}
+
+int zmq::socket_poller_t::add_fd (fd_t fd_, void *user_data_, short events_)
+{
+    if (fds.find (fd_) != fds.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int index = alloc_item ();
+    item_t &item = items [index];
+    item.socket = NULL;
+    item.fd = fd_;
+    item.user_data = user_data_;
+    item.events = events_;
+    fds.insert (fds_t::value_type (fd_, index));
+
+#if defined ZMQ_USE_EPOLL
+    register_item (index, EPOLL_CTL_ADD);
+#else
+    rebuild = true;
+#endif
+    return 0;
+}
+
+int zmq::socket_poller_t::modify_fd (fd_t fd_, short events_)
+{
+    fds_t::iterator it = fds.find (fd_);
+    if (it == fds.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    items [it->second].events = events_;
+#if defined ZMQ_USE_EPOLL
+    register_item (it->second, EPOLL_CTL_MOD);
+#else
+    rebuild = true;
+#endif
+    return 0;
+}
+
+int zmq::socket_poller_t::remove_fd (fd_t fd_)
+{
+    fds_t::iterator it = fds.find (fd_);
+    if (it == fds.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+#if defined ZMQ_USE_EPOLL
+    register_item (it->second, EPOLL_CTL_DEL);
+#endif
+    free_item (it->second);
+    fds.erase (it);
+    return 0;
+}
+
+void zmq::socket_poller_t::changed (int index_)
+{
+#if defined ZMQ_USE_EPOLL
+    if (items [index_].events)
+        set_pending (index_);
+#endif
+}
+
+int zmq::socket_poller_t::alloc_item ()
+{
+    if (!unused.empty ()) {
+        int index = unused.back ();
+        unused.pop_back ();
+        items [index].used = true;
+        return index;
+    }
+
+    item_t item;
+    item.pending = false;
+    item.used = true;
+    items.push_back (item);
+    return (int) items.size () - 1;
+}
+
+void zmq::socket_poller_t::free_item (int index_)
+{
+    //  The entry may still be in the list of pending items. The pending
+    //  flag is left as is so that the entry is not added to the list twice
+    //  if it gets reused.
+    items [index_].used = false;
+    unused.push_back (index_);
+#if !defined ZMQ_USE_EPOLL
+    rebuild = true;
+#endif
+}
+
+#if defined ZMQ_USE_EPOLL
+
+int zmq::socket_poller_t::wait (zmq_poller_event_t *events_, int n_events_,
+    long timeout_)
+{
+    if (!events_) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (n_events_ <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    zmq::clock_t clock;
+    uint64_t end = timeout_ > 0 ? clock.now_ms () + timeout_ : 0;
+
+    while (true) {
+
+        //  Don't block if there are sockets to check.
+        int timeout;
+        if (!pending.empty () || timeout_ == 0)
+            timeout = 0;
+        else if (timeout_ < 0)
+            timeout = -1;
+        else {
+            uint64_t now = clock.now_ms ();
+            timeout = now < end ? (int) (end - now) : 0;
+        }
+
+        epoll_event ev_buf [max_io_events];
+        int n = epoll_wait (epoll_fd, &ev_buf [0], max_io_events, timeout);
+        if (n == -1 && errno == EINTR)
+            return -1;
+        errno_assert (n != -1);
+
+        //  Signaled sockets have to be checked for the actual events, raw
+        //  file descriptors can be reported straight away. If there's no
+        //  space left, they'll be reported by the next wait as epoll is
+        //  level-triggered.
+        int nevents = 0;
+        for (int i = 0; i != n; i++) {
+            int index = (int) ev_buf [i].data.u32;
+            item_t &item = items [index];
+            if (!item.used)
+                continue;
+            if (item.socket) {
+                set_pending (index);
+                continue;
+            }
+            if (nevents == n_events_)
+                continue;
+            zmq_poller_event_t &event = events_ [nevents++];
+            event.socket = NULL;
+            event.fd = item.fd;
+            event.user_data = item.user_data;
+            event.events = 0;
+            if (ev_buf [i].events & EPOLLIN)
+                event.events |= ZMQ_POLLIN;
+            if (ev_buf [i].events & EPOLLOUT)
+                event.events |= ZMQ_POLLOUT;
+            if (ev_buf [i].events & ~(EPOLLIN | EPOLLOUT))
+                event.events |= ZMQ_POLLERR;
+        }
+
+        nevents = check_pending (events_, n_events_, nevents);
+        if (nevents != 0 || timeout_ == 0)
+            return nevents;
+
+        //  Find out whether timeout have expired.
+        if (timeout_ > 0 && pending.empty () && clock.now_ms () >= end)
+            return 0;
+    }
+}
+
+int zmq::socket_poller_t::check_pending (zmq_poller_event_t *events_,
+    int n_events_, int nevents_)
+{
+    //  Checking the sockets may add new items to the list of pending items,
+    //  so the list is swapped out first.
+    checking.clear ();
+    checking.swap (pending);
+
+    for (std::vector <int>::size_type i = 0; i != checking.size (); i++) {
+        int index = checking [i];
+        item_t &item = items [index];
+        item.pending = false;
+        if (!item.used)
+            continue;
+
+        //  No space left. Leave the item for the next wait.
+        if (nevents_ == n_events_) {
+            set_pending (index);
+            continue;
+        }
+
+        int zmq_events;
+        size_t zmq_events_size = sizeof (int);
+        int rc = item.socket->getsockopt (ZMQ_EVENTS, &zmq_events,
+            &zmq_events_size);
+        if (rc != 0) {
+
+            //  Put back the items that were not checked yet.
+            for (; i != checking.size (); i++) {
+                items [checking [i]].pending = false;
+                set_pending (checking [i]);
+            }
+            return -1;
+        }
+
+        //  Sockets reported ready are checked again during the next wait
+        //  as the application may not consume all the messages.
+        short revents = item.events & zmq_events;
+        if (revents) {
+            zmq_poller_event_t &event = events_ [nevents_++];
+            event.socket = item.socket;
+            event.fd = retired_fd;
+            event.user_data = item.user_data;
+            event.events = revents;
+            set_pending (index);
+        }
+    }
+
+    return nevents_;
+}
+
+void zmq::socket_poller_t::set_pending (int index_)
+{
+    if (!items [index_].pending) {
+        items [index_].pending = true;
+        pending.push_back (index_);
+    }
+}
+
+void zmq::socket_poller_t::register_item (int index_, int op_)
+{
+    item_t &item = items [index_];
+
+    //  0MQ sockets are polled for their mailbox file descriptor becoming
+    //  readable. For raw file descriptors the events are simply converted.
+    epoll_event ev;
+    ev.data.u32 = (uint32_t) index_;
+    ev.events = 0;
+    if (item.socket)
+        ev.events = EPOLLIN;
+    else {
+        if (item.events & ZMQ_POLLIN)
+            ev.events |= EPOLLIN;
+        if (item.events & ZMQ_POLLOUT)
+            ev.events |= EPOLLOUT;
+    }
+
+    int rc = epoll_ctl (epoll_fd, op_, item.fd, &ev);
+    errno_assert (rc != -1);
+}
+
+#else
+
+int zmq::socket_poller_t::wait (zmq_poller_event_t *events_, int n_events_,
+    long timeout_)
+{
+    if (!events_) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (n_events_ <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  Rebuild the poll set if the set of items have changed.
+    if (rebuild) {
+        pollitems.clear ();
+        pollindices.clear ();
+        for (items_t::size_type i = 0; i != items.size (); i++) {
+            if (!items [i].used)
+                continue;
+            zmq_pollitem_t pollitem = {items [i].socket, items [i].fd,
+                items [i].events, 0};
+            pollitems.push_back (pollitem);
+            pollindices.push_back ((int) i);
+        }
+        rebuild = false;
+    }
+
+    int rc = zmq_poll (pollitems.empty () ? NULL : &pollitems [0],
+        (int) pollitems.size (), timeout_);
+    if (rc <= 0)
+        return rc;
+
+    int nevents = 0;
+    for (std::vector <zmq_pollitem_t>::size_type i = 0;
+          i != pollitems.size () && nevents != n_events_; i++) {
+        if (!pollitems [i].revents)
+            continue;
+        item_t &item = items [pollindices [i]];
+        zmq_poller_event_t &event = events_ [nevents++];
+        event.socket = item.socket;
+        event.fd = item.socket ? retired_fd : item.fd;
+        event.user_data = item.user_data;
+        event.events = pollitems [i].revents;
+    }
+    return nevents;
+}
+
+#endif
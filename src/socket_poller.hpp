@@ -0,0 +1,146 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SOCKET_POLLER_HPP_INCLUDED__
+#define __ZMQ_SOCKET_POLLER_HPP_INCLUDED__
+
+#include <map>
+#include <vector>
+
+#include "../include/zmq.h"
+
+#include "poller.hpp"
+#include "fd.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Persistent set of 0MQ sockets and file descriptors to poll on.
+    //  Unlike zmq_poll, the set is not rebuilt with each wait.
+    //
+    //  With epoll, only the sockets that may have changed their state are
+    //  examined on each wait. Those are the sockets whose file descriptor
+    //  was signaled, the sockets notified by their pipes (see
+    //  socket_base_t::notify_socket_pollers) and the sockets reported in
+    //  the previous wait as the application may not have consumed all the
+    //  events. Thus, the cost of the wait is proportional to the number of
+    //  ready items rather than to the size of the set. Elsewhere, the set
+    //  is polled using zmq_poll.
+
+    class socket_poller_t
+    {
+    public:
+
+        socket_poller_t ();
+        ~socket_poller_t ();
+
+        //  Returns false if object is not a poller.
+        bool check_tag ();
+
+        int add (class socket_base_t *socket_, void *user_data_,
+            short events_);
+        int modify (class socket_base_t *socket_, short events_);
+        int remove (class socket_base_t *socket_);
+
+        int add_fd (fd_t fd_, void *user_data_, short events_);
+        int modify_fd (fd_t fd_, short events_);
+        int remove_fd (fd_t fd_);
+
+        //  Fills in at most n_events_ ready items and returns their number.
+        //  If there are none, waits for timeout_ milliseconds, -1 meaning
+        //  infinity. Returns 0 if the timeout have expired.
+        int wait (zmq_poller_event_t *events_, int n_events_, long timeout_);
+
+        //  Called by the socket stored at index_ when its state may have
+        //  changed.
+        void changed (int index_);
+
+    private:
+
+        struct item_t
+        {
+            socket_base_t *socket;
+            fd_t fd;
+            void *user_data;
+            short events;
+
+            //  True if the item is in the list of items to check.
+            bool pending;
+
+            //  True if the entry is used, false if it's in the free list.
+            bool used;
+        };
+
+        //  Returns index of an unused entry.
+        int alloc_item ();
+
+        //  Releases the entry.
+        void free_item (int index_);
+
+        //  Used to check whether the object is a poller.
+        uint32_t tag;
+
+        //  Polled items. The entries don't move so that the index can
+        //  be used as a handle.
+        typedef std::vector <item_t> items_t;
+        items_t items;
+
+        //  Indices of the unused entries.
+        std::vector <int> unused;
+
+        //  File descriptors of the raw file descriptor items.
+        typedef std::map <fd_t, int> fds_t;
+        fds_t fds;
+
+#if defined ZMQ_USE_EPOLL
+        //  Items to check during the next wait and the items being checked
+        //  at the moment.
+        std::vector <int> pending;
+        std::vector <int> checking;
+
+        //  Checks the pending items and stores the events ready into events_
+        //  starting at position nevents_. Returns the new number of events
+        //  or -1 in case of error.
+        int check_pending (zmq_poller_event_t *events_, int n_events_,
+            int nevents_);
+
+        //  Appends the item to the list of items to check.
+        void set_pending (int index_);
+
+        //  Registers, modifies or unregisters the item with epoll.
+        void register_item (int index_, int op_);
+
+        fd_t epoll_fd;
+#else
+        //  The whole set of items passed to zmq_poll. It's rebuilt only
+        //  when the set of items changes.
+        std::vector <zmq_pollitem_t> pollitems;
+        std::vector <int> pollindices;
+        bool rebuild;
+#endif
+
+        socket_poller_t (const socket_poller_t&);
+        const socket_poller_t &operator = (const socket_poller_t&);
+    };
+
+}
+
+#endif
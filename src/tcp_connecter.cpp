@@ -44,13 +44,17 @@ zmq::tcp_connecter_t::~tcp_connecter_t ()
 
 int zmq::tcp_connecter_t::set_address (const char *protocol_, const char *addr_)
 {
-    if (strcmp (protocol_, "tcp") == 0)
-        return resolve_ip_hostname (&addr, &addr_len, addr_);
-
     errno = EPROTONOSUPPORT;
     return -1;    
 }
 
+void zmq::tcp_connecter_t::set_address (const sockaddr_storage &addr_,
+    socklen_t addr_len_)
+{
+    memcpy (&addr, &addr_, addr_len_);
+    addr_len = addr_len_;
+}
+
 int zmq::tcp_connecter_t::open ()
 {
     zmq_assert (s == retired_fd);
@@ -158,15 +162,20 @@ zmq::tcp_connecter_t::~tcp_connecter_t ()
 
 int zmq::tcp_connecter_t::set_address (const char *protocol_, const char *addr_)
 {
-    if (strcmp (protocol_, "tcp") == 0)
-        return resolve_ip_hostname (&addr, &addr_len, addr_);
-    else if (strcmp (protocol_, "ipc") == 0)
+    if (strcmp (protocol_, "ipc") == 0)
         return resolve_local_path (&addr, &addr_len, addr_);
 
     errno = EPROTONOSUPPORT;
     return -1;
 }
 
+void zmq::tcp_connecter_t::set_address (const sockaddr_storage &addr_,
+    socklen_t addr_len_)
+{
+    memcpy (&addr, &addr_, addr_len_);
+    addr_len = addr_len_;
+}
+
 int zmq::tcp_connecter_t::open ()
 {
     zmq_assert (s == retired_fd);
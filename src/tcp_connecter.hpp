@@ -43,8 +43,10 @@ namespace zmq
         tcp_connecter_t ();
         ~tcp_connecter_t ();
 
-        //  Set address to connect to.
+        //  Set address to connect to. TCP addresses are resolved by the
+        //  caller, see resolver_t, and passed in as sockaddr.
         int set_address (const char *protocol, const char *addr_);
+        void set_address (const sockaddr_storage &addr_, socklen_t addr_len_);
 
         //  Open TCP connecting socket. Address is in
         //  <hostname>:<port-number> format. Returns -1 in case of error,
@@ -42,8 +42,13 @@ zmq::tcp_listener_t::~tcp_listener_t ()
         close ();
 }
 
+bool zmq::tcp_listener_t::can_share_port ()
+{
+    return false;
+}
+
 int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_,
-    int backlog_)
+    int backlog_, bool reuseport_)
 {
     //  IPC protocol is not supported on Windows platform.
     if (strcmp (protocol_, "tcp") != 0 ) {
@@ -163,8 +168,17 @@ zmq::tcp_listener_t::~tcp_listener_t ()
         close ();
 }
 
+bool zmq::tcp_listener_t::can_share_port ()
+{
+#if defined ZMQ_HAVE_LINUX && defined SO_REUSEPORT
+    return true;
+#else
+    return false;
+#endif
+}
+
 int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_,
-    int backlog_)
+    int backlog_, bool reuseport_)
 {
     if (strcmp (protocol_, "tcp") == 0 ) {
 
@@ -183,6 +197,21 @@ int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_,
         rc = setsockopt (s, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof (int));
         errno_assert (rc == 0);
 
+        //  Allow sharing the port with other listening sockets.
+        if (reuseport_) {
+            zmq_assert (can_share_port ());
+#if defined ZMQ_HAVE_LINUX && defined SO_REUSEPORT
+            rc = setsockopt (s, SOL_SOCKET, SO_REUSEPORT, &flag, sizeof (int));
+            if (rc != 0) {
+                int err = errno;
+                if (close () != 0)
+                    return -1;
+                errno = err;
+                return -1;
+            }
+#endif
+        }
+
         //  Set the non-blocking flag.
 #ifdef ZMQ_HAVE_OPENVMS
     	flag = 1;
@@ -303,8 +332,13 @@ zmq::fd_t zmq::tcp_listener_t::accept ()
 {
     zmq_assert (s != retired_fd);
 
-    //  Accept one incoming connection.
+    //  Accept one incoming connection. On Linux, the new socket is made
+    //  non-blocking by the same system call.
+#if defined ZMQ_HAVE_LINUX && defined SOCK_NONBLOCK
+    fd_t sock = ::accept4 (s, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
     fd_t sock = ::accept (s, NULL, NULL);
+#endif
 
 #if (defined ZMQ_HAVE_LINUX || defined ZMQ_HAVE_FREEBSD || \
      defined ZMQ_HAVE_OPENBSD || defined ZMQ_HAVE_OSX || \
@@ -332,17 +366,20 @@ zmq::fd_t zmq::tcp_listener_t::accept ()
 
     errno_assert (sock != -1); 
 
-    // Set to non-blocking mode.
+    // Set to non-blocking mode unless accept4 did so already.
+    int rc;
+#if !(defined ZMQ_HAVE_LINUX && defined SOCK_NONBLOCK)
 #ifdef ZMQ_HAVE_OPENVMS
     int flags = 1;
-    int rc = ioctl (sock, FIONBIO, &flags);
+    rc = ioctl (sock, FIONBIO, &flags);
     errno_assert (rc != -1);
 #else
     int flags = fcntl (s, F_GETFL, 0);
     if (flags == -1)
         flags = 0;
-    int rc = fcntl (sock, F_SETFL, flags | O_NONBLOCK);
+    rc = fcntl (sock, F_SETFL, flags | O_NONBLOCK);
     errno_assert (rc != -1);
+#endif
 #endif
 
     struct sockaddr *sa = (struct sockaddr*) &addr;
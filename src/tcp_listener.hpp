@@ -36,9 +36,14 @@ namespace zmq
         tcp_listener_t ();
         ~tcp_listener_t ();
 
-        //  Start listening on the interface.
+        //  Returns true if several listening sockets can share the same TCP
+        //  port, with the OS distributing the connections among them.
+        static bool can_share_port ();
+
+        //  Start listening on the interface. If reuseport_ is true, the TCP
+        //  port can be shared with other listening sockets.
         int set_address (const char *protocol_, const char *addr_,
-            int backlog_);
+            int backlog_, bool reuseport_);
 
         //  Close the listening socket.
         int close ();
@@ -131,6 +131,7 @@ int zmq::tcp_socket_t::read (void *data_, size_t size_)
 #include <netinet/in.h>
 #include <netdb.h>
 #include <fcntl.h>
+#include <string.h>
 
 zmq::tcp_socket_t::tcp_socket_t () :
     s (retired_fd)
@@ -200,6 +201,25 @@ int zmq::tcp_socket_t::write (const void *data_, size_t size_)
     return (size_t) nbytes;
 }
 
+int zmq::tcp_socket_t::writev (const iovec *iov_, int count_)
+{
+    ssize_t nbytes = ::writev (s, iov_, count_);
+
+    //  Several errors are OK. When speculative write is being done we may not
+    //  be able to write a single byte to the socket. Also, SIGSTOP issued
+    //  by a debugging tool can result in EINTR error.
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+          errno == EINTR))
+        return 0;
+
+    //  Signalise peer failure.
+    if (nbytes == -1 && (errno == ECONNRESET || errno == EPIPE))
+        return -1;
+
+    errno_assert (nbytes != -1);
+    return (size_t) nbytes;
+}
+
 int zmq::tcp_socket_t::read (void *data_, size_t size_)
 {
     ssize_t nbytes = recv (s, data_, size_, 0);
@@ -225,5 +245,117 @@ int zmq::tcp_socket_t::read (void *data_, size_t size_)
     return (size_t) nbytes;
 }
 
+int zmq::tcp_socket_t::readv (const iovec *iov_, int count_)
+{
+    ssize_t nbytes = ::readv (s, iov_, count_);
+
+    //  Several errors are OK. When speculative read is being done we may not
+    //  be able to read a single byte to the socket. Also, SIGSTOP issued
+    //  by a debugging tool can result in EINTR error.
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+          errno == EINTR))
+        return 0;
+
+    //  Signalise peer failure.
+    if (nbytes == -1 && (errno == ECONNRESET || errno == ECONNREFUSED ||
+          errno == ETIMEDOUT || errno == EHOSTUNREACH))
+        return -1;
+
+    errno_assert (nbytes != -1);
+
+    //  Orderly shutdown by the peer.
+    if (nbytes == 0)
+        return -1;
+
+    return (size_t) nbytes;
+}
+
+int zmq::tcp_socket_t::writev (const iovec *iov_, int count_, fd_t fd_)
+{
+    union {
+        cmsghdr align;
+        unsigned char buf [CMSG_SPACE (sizeof (fd_t))];
+    } control;
+    memset (&control, 0, sizeof (control));
+    msghdr msg;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = (iovec*) iov_;
+    msg.msg_iovlen = count_;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+    cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (fd_t));
+    memcpy (CMSG_DATA (cmsg), &fd_, sizeof (fd_t));
+
+    ssize_t nbytes = sendmsg (s, &msg, 0);
+
+    //  Same error handling as with writev.
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+          errno == EINTR))
+        return 0;
+    if (nbytes == -1 && (errno == ECONNRESET || errno == EPIPE))
+        return -1;
+
+    errno_assert (nbytes != -1);
+    return (size_t) nbytes;
+}
+
+int zmq::tcp_socket_t::readv (const iovec *iov_, int count_, fd_t *fd_)
+{
+    union {
+        cmsghdr align;
+        unsigned char buf [CMSG_SPACE (sizeof (fd_t))];
+    } control;
+    msghdr msg;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = (iovec*) iov_;
+    msg.msg_iovlen = count_;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+
+#if defined MSG_CMSG_CLOEXEC
+    ssize_t nbytes = recvmsg (s, &msg, MSG_CMSG_CLOEXEC);
+#else
+    ssize_t nbytes = recvmsg (s, &msg, 0);
+#endif
+
+    *fd_ = retired_fd;
+
+    //  Same error handling as with readv.
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+          errno == EINTR))
+        return 0;
+    if (nbytes == -1 && (errno == ECONNRESET || errno == ECONNREFUSED ||
+          errno == ETIMEDOUT || errno == EHOSTUNREACH))
+        return -1;
+
+    errno_assert (nbytes != -1);
+
+    //  Orderly shutdown by the peer.
+    if (nbytes == 0)
+        return -1;
+
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR (&msg); cmsg;
+          cmsg = CMSG_NXTHDR (&msg, cmsg))
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+              cmsg->cmsg_len == CMSG_LEN (sizeof (fd_t)))
+            memcpy (fd_, CMSG_DATA (cmsg), sizeof (fd_t));
+
+    //  The peer is expected to pass a single descriptor at a time. If it
+    //  passed more, the surplus ones were discarded.
+    if (msg.msg_flags & MSG_CTRUNC) {
+        if (*fd_ != retired_fd) {
+            int rc = ::close (*fd_);
+            errno_assert (rc == 0);
+            *fd_ = retired_fd;
+        }
+        return -1;
+    }
+
+    return (size_t) nbytes;
+}
+
 #endif
 
@@ -25,6 +25,11 @@
 
 #include "fd.hpp"
 #include "stdint.hpp"
+#include "platform.hpp"
+
+#if !defined ZMQ_HAVE_WINDOWS
+#include <sys/uio.h>
+#endif
 
 namespace zmq
 {
@@ -53,12 +58,34 @@ namespace zmq
         //  of error or orderly shutdown by the other peer -1 is returned.
         int write (const void *data_, size_t size_);
 
+#if !defined ZMQ_HAVE_WINDOWS
+        //  Gathering version of write. Semantics of the return value are
+        //  the same as with write.
+        int writev (const iovec *iov_, int count_);
+
+        //  Same as above, except that the file descriptor is passed to the
+        //  peer along with the data. It is passed only if at least one byte
+        //  was written. Applicable to unix domain sockets only.
+        int writev (const iovec *iov_, int count_, fd_t fd_);
+#endif
+
         //  Reads data from the socket (up to 'size' bytes). Returns the number
         //  of bytes actually read (even zero is to be considered to be
         //  a success). In case of error or orderly shutdown by the other
         //  peer -1 is returned.
         int read (void *data_, size_t size_);
 
+#if !defined ZMQ_HAVE_WINDOWS
+        //  Scattering version of read. Semantics of the return value are
+        //  the same as with read.
+        int readv (const iovec *iov_, int count_);
+
+        //  Same as above, except that a file descriptor passed by the peer
+        //  along with the data is stored in *fd_. If there's none, *fd_ is
+        //  set to retired_fd. Applicable to unix domain sockets only.
+        int readv (const iovec *iov_, int count_, fd_t *fd_);
+#endif
+
     private:
 
         //  Underlying socket.
@@ -19,6 +19,7 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <new>
 #include <algorithm>
@@ -31,128 +32,297 @@
 #include "err.hpp"
 #include "trie.hpp"
 
-zmq::trie_t::trie_t () :
-    refcnt (0),
-    min (0),
-    count (0)
+zmq::trie_t::trie_t ()
 {
+    root = new_node (NULL, 0);
 }
 
 zmq::trie_t::~trie_t ()
 {
-    if (count == 1)
-        delete next.node;
-    else if (count > 1) {
-        for (unsigned short i = 0; i != count; ++i)
-            if (next.table [i])
-                delete next.table [i];
-        free (next.table);
+    delete_node (root);
+}
+
+void zmq::trie_t::clear ()
+{
+    delete_node (root);
+    root = new_node (NULL, 0);
+}
+
+zmq::trie_t::node_t *zmq::trie_t::new_node (const unsigned char *prefix_,
+    size_t size_)
+{
+    node_t *node = (node_t*) malloc (sizeof (node_t) + size_);
+    alloc_assert (node);
+    node->refcnt = 0;
+    node->prefix_size = (uint32_t) size_;
+    node->children = NULL;
+    node->children_count = 0;
+    node->table = false;
+    if (size_)
+        memcpy (node->prefix (), prefix_, size_);
+    return node;
+}
+
+void zmq::trie_t::delete_node (node_t *node_)
+{
+    if (node_->table) {
+        for (int c = 0; c != 256; c++)
+            if (node_->children [c])
+                delete_node (node_->children [c]);
+    }
+    else {
+        for (unsigned short i = 0; i != node_->children_count; i++)
+            delete_node (node_->children [i]);
     }
+    free (node_->children);
+    free (node_);
 }
 
-bool zmq::trie_t::add (unsigned char *prefix_, size_t size_)
+zmq::trie_t::node_t **zmq::trie_t::find_child (node_t *node_,
+    unsigned char c_)
 {
-    //  We are at the node corresponding to the prefix. We are done.
-    if (!size_) {
-        ++refcnt;
-        return refcnt == 1;
+    if (node_->table)
+        return node_->children [c_] ? &node_->children [c_] : NULL;
+
+    //  With no children there's no array to scan.
+    if (!node_->children_count)
+        return NULL;
+
+    //  The first bytes of the children are contiguous so that they can be
+    //  scanned by the (vectorised) memchr.
+    unsigned char *keys =
+        (unsigned char*) (node_->children + node_->children_count);
+    unsigned char *key = (unsigned char*) memchr (keys, c_,
+        node_->children_count);
+    return key ? &node_->children [key - keys] : NULL;
+}
+
+void zmq::trie_t::add_child (node_t *node_, node_t *child_)
+{
+    unsigned char c = child_->prefix () [0];
+
+    if (node_->table) {
+        zmq_assert (!node_->children [c]);
+        node_->children [c] = child_;
+        node_->children_count++;
+        return;
     }
 
-    unsigned char c = *prefix_;
-    if (c < min || c >= min + count) {
+    //  Too many children to keep them in the array. Switch to the table.
+    unsigned short count = node_->children_count;
+    if (count == max_array_children) {
+        node_t **table = (node_t**) malloc (256 * sizeof (node_t*));
+        alloc_assert (table);
+        memset (table, 0, 256 * sizeof (node_t*));
+        unsigned char *keys = (unsigned char*) (node_->children + count);
+        for (unsigned short i = 0; i != count; i++)
+            table [keys [i]] = node_->children [i];
+        table [c] = child_;
+        free (node_->children);
+        node_->children = table;
+        node_->children_count++;
+        node_->table = true;
+        return;
+    }
 
-        //  The character is out of range of currently handled
-        //  charcters. We have to extend the table.
-        if (!count) {
-            min = c;
-            count = 1;
-            next.node = NULL;
-        }
-        else if (count == 1) {
-            unsigned char oldc = min;
-            trie_t *oldp = next.node;
-            count = (min < c ? c - min : min - c) + 1;
-            next.table = (trie_t**)
-                malloc (sizeof (trie_t*) * count);
-            zmq_assert (next.table);
-            for (unsigned short i = 0; i != count; ++i)
-                next.table [i] = 0;
-            min = std::min (min, c);
-            next.table [oldc - min] = oldp;
-        }
-        else if (min < c) {
-
-            //  The new character is above the current character range.
-            unsigned short old_count = count;
-            count = c - min + 1;
-            next.table = (trie_t**) realloc ((void*) next.table,
-                sizeof (trie_t*) * count);
-            zmq_assert (next.table);
-            for (unsigned short i = old_count; i != count; i++)
-                next.table [i] = NULL;
-        }
-        else {
-
-            //  The new character is below the current character range.
-            unsigned short old_count = count;
-            count = (min + old_count) - c;
-            next.table = (trie_t**) realloc ((void*) next.table,
-                sizeof (trie_t*) * count);
-            zmq_assert (next.table);
-            memmove (next.table + min - c, next.table,
-                old_count * sizeof (trie_t*));
-            for (unsigned short i = 0; i != min - c; i++)
-                next.table [i] = NULL;
-            min = c;
+    //  Make space for the new child. The keys follow the child pointers
+    //  so they have to be moved as well.
+    node_->children = (node_t**) realloc (node_->children,
+        (count + 1) * (sizeof (node_t*) + 1));
+    alloc_assert (node_->children);
+    unsigned char *keys = (unsigned char*) (node_->children + count + 1);
+    memmove (keys, node_->children + count, count);
+
+    //  Keep the children sorted.
+    unsigned short pos = (unsigned short) (std::lower_bound (keys,
+        keys + count, c) - keys);
+    memmove (node_->children + pos + 1, node_->children + pos,
+        (count - pos) * sizeof (node_t*));
+    memmove (keys + pos + 1, keys + pos, count - pos);
+    node_->children [pos] = child_;
+    keys [pos] = c;
+    node_->children_count++;
+}
+
+void zmq::trie_t::rm_child (node_t *node_, unsigned char c_)
+{
+    if (node_->table) {
+        zmq_assert (node_->children [c_]);
+        node_->children [c_] = NULL;
+        node_->children_count--;
+
+        //  Convert the table back to the array if there are few children.
+        unsigned short count = node_->children_count;
+        if (count > max_array_children / 2)
+            return;
+        node_t **children = NULL;
+        if (count) {
+            children = (node_t**) malloc (count * (sizeof (node_t*) + 1));
+            alloc_assert (children);
+            unsigned char *keys = (unsigned char*) (children + count);
+            unsigned short pos = 0;
+            for (int c = 0; c != 256; c++)
+                if (node_->children [c]) {
+                    children [pos] = node_->children [c];
+                    keys [pos] = (unsigned char) c;
+                    pos++;
+                }
         }
+        free (node_->children);
+        node_->children = children;
+        node_->table = false;
+        return;
     }
 
-    //  If next node does not exist, create one.
-    if (count == 1) {
-        if (!next.node) {
-            next.node = new (std::nothrow) trie_t;
-            zmq_assert (next.node);
-        }
-        return next.node->add (prefix_ + 1, size_ - 1);
+    unsigned short count = node_->children_count;
+    if (!count)
+        return;
+    unsigned char *keys = (unsigned char*) (node_->children + count);
+    unsigned char *key = (unsigned char*) memchr (keys, c_, count);
+    zmq_assert (key);
+    unsigned short pos = (unsigned short) (key - keys);
+    memmove (node_->children + pos, node_->children + pos + 1,
+        (count - pos - 1) * sizeof (node_t*));
+    memmove (keys + pos, keys + pos + 1, count - pos - 1);
+
+    //  Move the keys right after the remaining child pointers.
+    memmove (node_->children + count - 1, keys, count - 1);
+    node_->children_count--;
+    if (!node_->children_count) {
+        free (node_->children);
+        node_->children = NULL;
     }
-    else {
-        if (!next.table [c - min]) {
-            next.table [c - min] = new (std::nothrow) trie_t;
-            zmq_assert (next.table [c - min]);
+}
+
+void zmq::trie_t::prune (node_t *parent_, node_t **slot_)
+{
+    node_t *node = *slot_;
+    if (node->refcnt)
+        return;
+
+    //  Nobody is subscribed to the node or any longer prefix.
+    if (!node->children_count) {
+        rm_child (parent_, node->prefix () [0]);
+        delete_node (node);
+        return;
+    }
+
+    //  Node with a single child is merged with the child.
+    if (node->children_count == 1) {
+        node_t *child;
+        if (node->table) {
+            int c = 0;
+            while (!node->children [c])
+                c++;
+            child = node->children [c];
         }
-        return next.table [c - min]->add (prefix_ + 1, size_ - 1);
+        else
+            child = node->children [0];
+
+        size_t size = node->prefix_size + child->prefix_size;
+        child = (node_t*) realloc (child, sizeof (node_t) + size);
+        alloc_assert (child);
+        memmove (child->prefix () + node->prefix_size, child->prefix (),
+            child->prefix_size);
+        memcpy (child->prefix (), node->prefix (), node->prefix_size);
+        child->prefix_size = (uint32_t) size;
+        *slot_ = child;
+
+        free (node->children);
+        free (node);
     }
 }
 
-bool zmq::trie_t::rm (unsigned char *prefix_, size_t size_)
+bool zmq::trie_t::add (unsigned char *prefix_, size_t size_)
 {
-     //  TODO: Shouldn't an error be reported if the key does not exist?
+    node_t *node = root;
+    while (size_) {
+
+        //  If there's no node for the prefix yet, create one holding
+        //  the rest of the prefix.
+        node_t **slot = find_child (node, *prefix_);
+        if (!slot) {
+            node_t *child = new_node (prefix_, size_);
+            add_child (node, child);
+            child->refcnt = 1;
+            return true;
+        }
 
-     if (!size_) {
-         if (!refcnt)
-             return false;
-         refcnt--;
-         return refcnt == 0;
-     }
+        //  Find out how much of the child's prefix matches.
+        node_t *child = *slot;
+        size_t common = 1;
+        while (common != child->prefix_size && common != size_ &&
+              child->prefix () [common] == prefix_ [common])
+            common++;
+
+        //  If the prefix ends or differs in the middle of the child's prefix,
+        //  split the child in two.
+        if (common != child->prefix_size) {
+            node_t *split = new_node (child->prefix (), common);
+            child->prefix_size -= (uint32_t) common;
+            memmove (child->prefix (), child->prefix () + common,
+                child->prefix_size);
+            add_child (split, child);
+            *slot = split;
+            child = split;
+        }
 
-     unsigned char c = *prefix_;
-     if (!count || c < min || c >= min + count)
-         return false;
+        node = child;
+        prefix_ += common;
+        size_ -= common;
+    }
 
-     trie_t *next_node =
-         count == 1 ? next.node : next.table [c - min];
+    ++node->refcnt;
+    return node->refcnt == 1;
+}
 
-     if (!next_node)
-         return false;
+bool zmq::trie_t::rm (unsigned char *prefix_, size_t size_)
+{
+    //  Find the node, remembering the locations the node and its parent
+    //  are stored in, so that they can be pruned once the last subscription
+    //  is removed.
+    node_t *grandparent = NULL;
+    node_t **parent_slot = NULL;
+    node_t *parent = NULL;
+    node_t **slot = NULL;
+    node_t *node = root;
+    while (size_) {
+        node_t **next = find_child (node, *prefix_);
+        if (!next)
+            return false;
+        node_t *child = *next;
+        if (child->prefix_size > size_ ||
+              memcmp (child->prefix (), prefix_, child->prefix_size) != 0)
+            return false;
+        grandparent = parent;
+        parent_slot = slot;
+        parent = node;
+        slot = next;
+        node = child;
+        prefix_ += child->prefix_size;
+        size_ -= child->prefix_size;
+    }
 
-     return next_node->rm (prefix_ + 1, size_ - 1);
+    if (!node->refcnt)
+        return false;
+    node->refcnt--;
+    if (node->refcnt)
+        return false;
+
+    //  If the node is removed, the parent may be left with a single child.
+    if (parent) {
+        prune (parent, slot);
+        if (grandparent)
+            prune (grandparent, parent_slot);
+    }
+    return true;
 }
 
 bool zmq::trie_t::check (unsigned char *data_, size_t size_)
 {
     //  This function is on critical path. It deliberately doesn't use
     //  recursion to get a bit better performance.
-    trie_t *current = this;
+    node_t *current = root;
     while (true) {
 
         //  We've found a corresponding subscription!
@@ -163,22 +333,19 @@ bool zmq::trie_t::check (unsigned char *data_, size_t size_)
         if (!size_)
             return false;
 
-        //  If there's no corresponding slot for the first character
-        //  of the prefix, the message does not match.
-        unsigned char c = *data_;
-        if (c < current->min || c >= current->min + current->count)
+        //  If there's no corresponding child for the first character
+        //  of the data, the message does not match.
+        node_t **slot = find_child (current, *data_);
+        if (!slot)
             return false;
 
-        //  Move to the next character.
-        if (current->count == 1)
-            current = current->next.node;
-        else {
-            current = current->next.table [c - current->min];
-            if (!current)
-                return false;
-        }
-        data_++;
-        size_--;
+        //  Compare the rest of the child's prefix in one go.
+        current = *slot;
+        if (current->prefix_size > size_ ||
+              memcmp (current->prefix (), data_, current->prefix_size) != 0)
+            return false;
+        data_ += current->prefix_size;
+        size_ -= current->prefix_size;
     }
 }
 
@@ -186,43 +353,56 @@ void zmq::trie_t::apply (void (*func_) (unsigned char *data_, size_t size_,
     void *arg_), void *arg_)
 {
     unsigned char *buff = NULL;
-    apply_helper (&buff, 0, 0, func_, arg_);
+    size_t maxbuffsize = 0;
+    apply_helper (root, &buff, 0, &maxbuffsize, func_, arg_);
     free (buff);
 }
 
-void zmq::trie_t::apply_helper (
-    unsigned char **buff_, size_t buffsize_, size_t maxbuffsize_,
+void zmq::trie_t::apply_helper (node_t *node_,
+    unsigned char **buff_, size_t buffsize_, size_t *maxbuffsize_,
     void (*func_) (unsigned char *data_, size_t size_, void *arg_), void *arg_)
 {
     //  If this node is a subscription, apply the function.
-    if (refcnt)
+    if (node_->refcnt)
         func_ (*buff_, buffsize_, arg_);
 
-    //  Adjust the buffer.
-    if (buffsize_ >= maxbuffsize_) {
-        maxbuffsize_ = buffsize_ + 256;
-        *buff_ = (unsigned char*) realloc (*buff_, maxbuffsize_);
-        zmq_assert (*buff_);
-    }
-
-    //  If there are no subnodes in the trie, return.
-    if (count == 0)
-        return;
+    int count = node_->table ? 256 : node_->children_count;
+    for (int i = 0; i != count; i++) {
+        node_t *child = node_->children [i];
+        if (!child)
+            continue;
+
+        //  Adjust the buffer and append the child's prefix.
+        size_t size = buffsize_ + child->prefix_size;
+        if (size > *maxbuffsize_) {
+            *maxbuffsize_ = size + 256;
+            *buff_ = (unsigned char*) realloc (*buff_, *maxbuffsize_);
+            alloc_assert (*buff_);
+        }
+        memcpy (*buff_ + buffsize_, child->prefix (), child->prefix_size);
 
-    //  If there's one subnode (optimisation).
-    if (count == 1) {
-        (*buff_) [buffsize_] = min;
-        buffsize_++;
-        next.node->apply_helper (buff_, buffsize_, maxbuffsize_, func_, arg_);
-        return;
+        apply_helper (child, buff_, size, maxbuffsize_, func_, arg_);
     }
+}
 
-    //  If there are multiple subnodes.
-    for (unsigned char c = 0; c != count; c++) {
-        (*buff_) [buffsize_] = min + c;
-        if (next.table [c])
-            next.table [c]->apply_helper (buff_, buffsize_ + 1, maxbuffsize_,
-                func_, arg_);
-    }   
+size_t zmq::trie_t::get_memory ()
+{
+    return get_memory_helper (root);
 }
 
+size_t zmq::trie_t::get_memory_helper (node_t *node_)
+{
+    size_t result = sizeof (node_t) + node_->prefix_size;
+    if (node_->table) {
+        result += 256 * sizeof (node_t*);
+        for (int c = 0; c != 256; c++)
+            if (node_->children [c])
+                result += get_memory_helper (node_->children [c]);
+    }
+    else {
+        result += node_->children_count * (sizeof (node_t*) + 1);
+        for (unsigned short i = 0; i != node_->children_count; i++)
+            result += get_memory_helper (node_->children [i]);
+    }
+    return result;
+}
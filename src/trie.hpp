@@ -28,6 +28,12 @@
 namespace zmq
 {
 
+    //  Trie of subscriptions. It's path-compressed: Chains of nodes with
+    //  a single child and no subscription are collapsed into a single node
+    //  labelled by the whole sequence of bytes, which is then compared in
+    //  one go. Nodes with few children keep them in a sorted array, nodes
+    //  with many children in a table indexed by the next byte.
+
     class trie_t
     {
     public:
@@ -43,6 +49,9 @@ namespace zmq
         //  removed from the trie.
         bool rm (unsigned char *prefix_, size_t size_);
 
+        //  Remove all the keys from the trie.
+        void clear ();
+
         //  Check whether particular key is in the trie.
         bool check (unsigned char *data_, size_t size_);
 
@@ -50,20 +59,64 @@ namespace zmq
         void apply (void (*func_) (unsigned char *data_, size_t size_,
             void *arg_), void *arg_);
 
+        //  Returns number of bytes allocated by the trie.
+        size_t get_memory ();
+
     private:
 
-        void apply_helper (
-            unsigned char **buff_, size_t buffsize_, size_t maxbuffsize_,
+        //  Nodes with more children than this use a table of 256 entries.
+        //  The table is converted back to the array when the number of
+        //  children drops to half of the limit.
+        enum {max_array_children = 16};
+
+        struct node_t
+        {
+            //  Number of times the key of this node was subscribed to.
+            uint32_t refcnt;
+
+            //  Number of bytes leading from the parent node to this node.
+            //  The bytes themselves are stored right after the structure.
+            //  The first byte identifies the node within the parent.
+            uint32_t prefix_size;
+
+            //  If there are at most max_array_children children, the block
+            //  holds pointers to the children followed by their first bytes,
+            //  both sorted. Otherwise it's a table of 256 child pointers.
+            node_t **children;
+            unsigned short children_count;
+            bool table;
+
+            inline unsigned char *prefix ()
+            {
+                return (unsigned char*) (this + 1);
+            }
+        };
+
+        static node_t *new_node (const unsigned char *prefix_, size_t size_);
+        static void delete_node (node_t *node_);
+
+        //  Manipulation of the children. find_child returns the location
+        //  of the pointer to the child starting with byte c_, or NULL.
+        static node_t **find_child (node_t *node_, unsigned char c_);
+        static void add_child (node_t *node_, node_t *child_);
+        static void rm_child (node_t *node_, unsigned char c_);
+
+        //  Removes the child at location slot_ of the parent_ if it has
+        //  no subscription and no children or merges it with its only
+        //  child if it has no subscription and a single child. Converts
+        //  the table of children of the parent_ back to the array if there
+        //  are few of them left.
+        static void prune (node_t *parent_, node_t **slot_);
+
+        static void apply_helper (node_t *node_,
+            unsigned char **buff_, size_t buffsize_, size_t *maxbuffsize_,
             void (*func_) (unsigned char *data_, size_t size_, void *arg_),
             void *arg_);
 
-        uint32_t refcnt;
-        unsigned char min;
-        unsigned short count;
-        union {
-            class trie_t *node;
-            class trie_t **table;
-        } next;
+        static size_t get_memory_helper (node_t *node_);
+
+        //  The root node corresponds to the empty prefix.
+        node_t *root;
 
         trie_t (const trie_t&);
         const trie_t &operator = (const trie_t&);
@@ -72,4 +125,3 @@ namespace zmq
 }
 
 #endif
-
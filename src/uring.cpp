@@ -0,0 +1,170 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_IO_URING
+
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "uring.hpp"
+#include "err.hpp"
+
+zmq::uring_t::uring_t () :
+    fd (retired_fd),
+    ring (MAP_FAILED),
+    ring_size (0),
+    sqes ((io_uring_sqe*) MAP_FAILED),
+    sqes_size (0),
+    sqe_tail (0)
+{
+}
+
+zmq::uring_t::~uring_t ()
+{
+    close ();
+}
+
+int zmq::uring_t::init (unsigned sq_entries_, unsigned cq_entries_)
+{
+    zmq_assert (fd == retired_fd);
+
+    io_uring_params params;
+    memset (&params, 0, sizeof (params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = cq_entries_;
+    int rc = syscall (__NR_io_uring_setup, sq_entries_, &params);
+    if (rc == -1)
+        return -1;
+    fd = rc;
+
+    //  Waiting with timeout requires the extended argument to
+    //  io_uring_enter. We also rely on both rings sharing a single mapping.
+    if (!(params.features & IORING_FEAT_EXT_ARG) ||
+          !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        close ();
+        errno = ENOSYS;
+        return -1;
+    }
+
+    //  Map the rings and the array of submission entries.
+    ring_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+    size_t cq_size = params.cq_off.cqes +
+        params.cq_entries * sizeof (io_uring_cqe);
+    if (cq_size > ring_size)
+        ring_size = cq_size;
+    ring = mmap (NULL, ring_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    errno_assert (ring != MAP_FAILED);
+    sqes_size = params.sq_entries * sizeof (io_uring_sqe);
+    sqes = (io_uring_sqe*) mmap (NULL, sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    errno_assert (sqes != MAP_FAILED);
+
+    unsigned char *base = (unsigned char*) ring;
+    sq_head = (unsigned*) (base + params.sq_off.head);
+    sq_tail = (unsigned*) (base + params.sq_off.tail);
+    sq_mask = *(unsigned*) (base + params.sq_off.ring_mask);
+    sq_entries = params.sq_entries;
+    cq_head = (unsigned*) (base + params.cq_off.head);
+    cq_tail = (unsigned*) (base + params.cq_off.tail);
+    cq_mask = *(unsigned*) (base + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe*) (base + params.cq_off.cqes);
+
+    //  The submission entries are always used in order, so the indirection
+    //  array can be filled in once and for all.
+    unsigned *array = (unsigned*) (base + params.sq_off.array);
+    for (unsigned i = 0; i != sq_entries; i++)
+        array [i] = i;
+    sqe_tail = *sq_tail;
+
+    return 0;
+}
+
+io_uring_sqe *zmq::uring_t::get_sqe ()
+{
+    unsigned head = __atomic_load_n (sq_head, __ATOMIC_ACQUIRE);
+    if (sqe_tail - head >= sq_entries)
+        return NULL;
+    io_uring_sqe *sqe = &sqes [sqe_tail & sq_mask];
+    sqe_tail++;
+    memset (sqe, 0, sizeof (io_uring_sqe));
+    return sqe;
+}
+
+int zmq::uring_t::enter (int timeout_)
+{
+    //  Publish the prepared entries to the kernel. Entries the kernel
+    //  hasn't consumed during the previous call are submitted anew.
+    __atomic_store_n (sq_tail, sqe_tail, __ATOMIC_RELEASE);
+    unsigned to_submit = sqe_tail - __atomic_load_n (sq_head, __ATOMIC_ACQUIRE);
+
+    io_uring_getevents_arg arg;
+    memset (&arg, 0, sizeof (arg));
+    __kernel_timespec ts;
+    if (timeout_ >= 0) {
+        ts.tv_sec = timeout_ / 1000;
+        ts.tv_nsec = (timeout_ % 1000) * 1000000;
+        arg.ts = (__u64) (unsigned long) &ts;
+    }
+
+    int rc = syscall (__NR_io_uring_enter, fd, to_submit, 1,
+        IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof (arg));
+    if (rc == -1 && (errno == EINTR || errno == ETIME || errno == EBUSY ||
+          errno == EAGAIN))
+        return -1;
+    errno_assert (rc != -1);
+    return 0;
+}
+
+io_uring_cqe *zmq::uring_t::peek_cqe ()
+{
+    unsigned head = *cq_head;
+    if (head == __atomic_load_n (cq_tail, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &cqes [head & cq_mask];
+}
+
+void zmq::uring_t::cqe_seen ()
+{
+    __atomic_store_n (cq_head, *cq_head + 1, __ATOMIC_RELEASE);
+}
+
+void zmq::uring_t::close ()
+{
+    if (sqes != MAP_FAILED) {
+        munmap (sqes, sqes_size);
+        sqes = (io_uring_sqe*) MAP_FAILED;
+    }
+    if (ring != MAP_FAILED) {
+        munmap (ring, ring_size);
+        ring = MAP_FAILED;
+    }
+    if (fd != retired_fd) {
+        ::close (fd);
+        fd = retired_fd;
+    }
+}
+
+#endif
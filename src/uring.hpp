@@ -0,0 +1,111 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_URING_HPP_INCLUDED__
+#define __ZMQ_URING_HPP_INCLUDED__
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_IO_URING
+
+#include <stddef.h>
+#include <linux/io_uring.h>
+
+#include "fd.hpp"
+
+namespace zmq
+{
+
+    //  Minimal wrapper over the Linux io_uring interface. It maps the
+    //  submission and completion rings into the process and provides the
+    //  primitives needed by the I/O thread: getting a free submission
+    //  entry, submitting the prepared entries while waiting for completions
+    //  and walking the completion ring.
+
+    class uring_t
+    {
+    public:
+
+        uring_t ();
+        ~uring_t ();
+
+        //  Sets up the ring. Returns -1 and sets errno if io_uring is not
+        //  supported by the kernel or is not permitted to the process.
+        int init (unsigned sq_entries_, unsigned cq_entries_);
+
+        //  Returns a zeroed submission entry or NULL if the submission
+        //  ring is full.
+        io_uring_sqe *get_sqe ();
+
+        //  Submits all the prepared entries and waits till at least one
+        //  completion is available or timeout_ (in milliseconds, -1 meaning
+        //  infinite) expires. Returns -1 and sets errno if the wait was
+        //  interrupted, timed out or the completion ring overflowed. In any
+        //  case the completions available should be processed afterwards.
+        int enter (int timeout_);
+
+        //  Returns the oldest completion not yet processed or NULL if there
+        //  is none.
+        io_uring_cqe *peek_cqe ();
+
+        //  Marks the completion returned by peek_cqe as processed.
+        void cqe_seen ();
+
+        //  Tears the ring down. Requests still in flight are discarded by
+        //  the kernel.
+        void close ();
+
+    private:
+
+        //  The ring file descriptor.
+        fd_t fd;
+
+        //  Shared memory areas with the kernel.
+        void *ring;
+        size_t ring_size;
+        io_uring_sqe *sqes;
+        size_t sqes_size;
+
+        //  Submission ring.
+        unsigned *sq_head;
+        unsigned *sq_tail;
+        unsigned sq_mask;
+        unsigned sq_entries;
+
+        //  Index of the first submission entry not handed out yet. Entries
+        //  between *sq_tail and this index are prepared, but not yet
+        //  published to the kernel.
+        unsigned sqe_tail;
+
+        //  Completion ring.
+        unsigned *cq_head;
+        unsigned *cq_tail;
+        unsigned cq_mask;
+        io_uring_cqe *cqes;
+
+        uring_t (const uring_t&);
+        const uring_t &operator = (const uring_t&);
+    };
+
+}
+
+#endif
+
+#endif
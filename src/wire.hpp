@@ -26,6 +26,10 @@
 namespace zmq
 {
 
+    //  Flag in the header of a message part passed as a memory file rather
+    //  than inline. The body of such message part is its 64-bit size.
+    enum {wire_memfd = 2};
+
     //  Helper functions to convert different integer types to/from network
     //  byte order.
 
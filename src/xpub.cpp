@@ -18,28 +18,51 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <new>
 #include <string.h>
 
 #include "xpub.hpp"
 #include "pipe.hpp"
+#include "ring.hpp"
 #include "err.hpp"
 #include "msg.hpp"
 
 zmq::xpub_t::xpub_t (class ctx_t *parent_, uint32_t tid_) :
     socket_base_t (parent_, tid_),
+    shared_pipes (0),
     more (false)
 {
     options.type = ZMQ_XPUB;
+
+    //  The ring is created upfront as the subscribers can ask for it from
+    //  their own threads. The memory for messages is allocated only when
+    //  the first subscriber connects.
+    ring = new (std::nothrow) ring_t ();
+    alloc_assert (ring);
 }
 
 zmq::xpub_t::~xpub_t ()
 {
+    for (last_values_t::iterator it = last_values.begin ();
+          it != last_values.end (); ++it)
+        for (parts_t::size_type i = 0; i != it->second.size (); i++) {
+            int rc = it->second [i].close ();
+            errno_assert (rc == 0);
+        }
+    for (parts_t::size_type i = 0; i != last_value.size (); i++) {
+        int rc = last_value [i].close ();
+        errno_assert (rc == 0);
+    }
+    ring->release ();
 }
 
 void zmq::xpub_t::xattach_pipe (pipe_t *pipe_, const blob_t &peer_identity_)
 {
     zmq_assert (pipe_);
-    dist.attach (pipe_);
+    if (pipe_->is_shared ())
+        shared_pipes++;
+    else
+        dist.attach (pipe_);
 
     //  The pipe is active when attached. Let's read the subscriptions from
     //  it, if any.
@@ -64,11 +87,27 @@ void zmq::xpub_t::xread_activated (pipe_t *pipe_)
         size_t size = sub.size ();
         zmq_assert (size > 0 && (*data == 0 || *data == 1));
         bool unique;
-		if (*data == 0)
+        if (options.exact_match ()) {
+            if (*data == 0)
+                unique = exact_subscriptions.rm (data + 1, size - 1, pipe_);
+            else
+                unique = exact_subscriptions.add (data + 1, size - 1, pipe_);
+        }
+		else if (*data == 0)
 		    unique = subscriptions.rm (data + 1, size - 1, pipe_);
 		else
 		    unique = subscriptions.add (data + 1, size - 1, pipe_);
 
+        //  Pass the cached messages to the new subscriber. Don't interleave
+        //  them with the parts of the message being sent.
+        if (*data == 1 && options.last_value && !pipe_->is_shared ()) {
+            blob_t prefix (data + 1, size - 1);
+            if (more)
+                pending_last_values.push_back (std::make_pair (pipe_, prefix));
+            else
+                send_last_values (pipe_, prefix);
+        }
+
         //  If the subscription is not a duplicate store it so that it can be
         //  passed to used on next recv call.
         if (unique && options.type != ZMQ_PUB)
@@ -88,14 +127,42 @@ void zmq::xpub_t::xterminated (pipe_t *pipe_)
     //  is interested in anymore, send corresponding unsubscriptions
     //  upstream.
     subscriptions.rm (pipe_, send_unsubscription, this);
+    exact_subscriptions.rm (pipe_, send_unsubscription, this);
+
+    //  Forget about the cached messages to be sent to the pipe.
+    pending_last_values_t::iterator it = pending_last_values.begin ();
+    while (it != pending_last_values.end ())
+        if (it->first == pipe_)
+            it = pending_last_values.erase (it);
+        else
+            ++it;
+
+    if (pipe_->is_shared ()) {
+        ring->terminated (pipe_);
+        shared_pipes--;
+    }
+    else
+        dist.terminated (pipe_);
+}
 
-    dist.terminated (pipe_);
+void zmq::xpub_t::xflush ()
+{
+    //  Wake up the subscribers of the shared ring. Nothing happens if none
+    //  of them is waiting for messages.
+    if (shared_pipes)
+        ring->flush ();
+}
+
+zmq::ring_t *zmq::xpub_t::get_ring ()
+{
+    return ring;
 }
 
 void zmq::xpub_t::mark_as_matching (pipe_t *pipe_, void *arg_)
 {
     xpub_t *self = (xpub_t*) arg_;
-    self->dist.match (pipe_);
+    if (!pipe_->is_shared ())
+        self->dist.match (pipe_);
 }
 
 int zmq::xpub_t::xsend (msg_t *msg_, int flags_)
@@ -104,9 +171,31 @@ int zmq::xpub_t::xsend (msg_t *msg_, int flags_)
         msg_->flags () & (msg_t::more | msg_t::label) ? true : false;
 
     //  For the first part of multi-part message, find the matching pipes.
-    if (!more)
-        subscriptions.match ((unsigned char*) msg_->data (), msg_->size (),
-            mark_as_matching, this);
+    if (!more) {
+        unsigned char *data = (unsigned char*) msg_->data ();
+        size_t size = msg_->size ();
+        if (options.exact_match ())
+            exact_subscriptions.match (data, options.topic_size (data, size),
+                mark_as_matching, this);
+        else
+            subscriptions.match (data, size, mark_as_matching, this);
+    }
+
+    if (options.last_value)
+        cache_last_value (msg_);
+
+    //  Pass the message to the subscribers reading from the shared ring.
+    //  The message is written to the ring once for all of them.
+    if (shared_pipes) {
+        msg_t copy;
+        int rc = copy.init ();
+        errno_assert (rc == 0);
+        rc = copy.copy (*msg_);
+        errno_assert (rc == 0);
+        ring->write (&copy);
+        if (!msg_more && !(flags_ & send_noflush))
+            ring->flush ();
+    }
 
     //  Send the message to all the pipes that were marked as matching
     //  in the previous step.
@@ -121,6 +210,15 @@ int zmq::xpub_t::xsend (msg_t *msg_, int flags_)
 
     more = msg_more;
 
+    //  Serve the subscriptions that arrived while the message was being sent.
+    if (!more) {
+        while (!pending_last_values.empty ()) {
+            send_last_values (pending_last_values.front ().first,
+                pending_last_values.front ().second);
+            pending_last_values.pop_front ();
+        }
+    }
+
     return 0;
 }
 
@@ -169,3 +267,68 @@ void zmq::xpub_t::send_unsubscription (unsigned char *data_, size_t size_,
     }
 }
 
+void zmq::xpub_t::cache_last_value (msg_t *msg_)
+{
+    //  Keep a copy of the message part. The data are shared, not copied.
+    msg_t copy;
+    int rc = copy.init ();
+    errno_assert (rc == 0);
+    rc = copy.copy (*msg_);
+    errno_assert (rc == 0);
+    last_value.push_back (copy);
+    if (msg_->flags () & (msg_t::more | msg_t::label))
+        return;
+
+    //  The whole message is available. The topic is the initial part of
+    //  the first message part as defined by the options.
+    msg_t &first = last_value.front ();
+    unsigned char *data = (unsigned char*) first.data ();
+    size_t size = options.topic_size (data, first.size ());
+
+    //  Replace the previous message on the topic.
+    parts_t &parts = last_values [blob_t (data, size)];
+    for (parts_t::size_type i = 0; i != parts.size (); i++) {
+        rc = parts [i].close ();
+        errno_assert (rc == 0);
+    }
+    parts.swap (last_value);
+    last_value.clear ();
+}
+
+void zmq::xpub_t::send_last_values (pipe_t *pipe_, const blob_t &prefix_)
+{
+    //  The cached topics matching the subscription. With exact matching
+    //  it's only the topic itself, unless the subscription is empty.
+    last_values_t::iterator it = options.exact_match () && !prefix_.empty () ?
+        last_values.find (prefix_) : last_values.lower_bound (prefix_);
+
+    for (; it != last_values.end (); ++it) {
+        if (it->first.compare (0, prefix_.size (), prefix_) != 0)
+            break;
+
+        //  Write the message. If the pipe is full, drop the rest of the
+        //  cached messages the same way as the published ones are dropped
+        //  and let the distributor know the pipe is passive till it's
+        //  activated again.
+        parts_t &parts = it->second;
+        for (parts_t::size_type i = 0; i != parts.size (); i++) {
+            msg_t copy;
+            int rc = copy.init ();
+            errno_assert (rc == 0);
+            rc = copy.copy (parts [i]);
+            errno_assert (rc == 0);
+            if (!pipe_->write (&copy)) {
+                rc = copy.close ();
+                errno_assert (rc == 0);
+                pipe_->rollback ();
+                pipe_->flush ();
+                dist.deactivated (pipe_);
+                return;
+            }
+        }
+
+        if (options.exact_match () && !prefix_.empty ())
+            break;
+    }
+    pipe_->flush ();
+}
@@ -22,9 +22,12 @@
 #define __ZMQ_XPUB_HPP_INCLUDED__
 
 #include <deque>
+#include <map>
+#include <vector>
 
 #include "socket_base.hpp"
 #include "mtrie.hpp"
+#include "mhash.hpp"
 #include "array.hpp"
 #include "blob.hpp"
 #include "dist.hpp"
@@ -49,6 +52,8 @@ namespace zmq
         void xread_activated (class pipe_t *pipe_);
         void xwrite_activated (class pipe_t *pipe_);
         void xterminated (class pipe_t *pipe_);
+        void xflush ();
+        class ring_t *get_ring ();
 
     private:
 
@@ -60,12 +65,27 @@ namespace zmq
         //  Function to be applied to each matching pipes.
         static void mark_as_matching (class pipe_t *pipe_, void *arg_);
 
+        //  Stores the message part in the last value cache.
+        void cache_last_value (class msg_t *msg_);
+
+        //  Sends the cached messages matching the subscription to the pipe.
+        void send_last_values (class pipe_t *pipe_, const blob_t &prefix_);
+
         //  List of all subscriptions mapped to corresponding pipes.
         mtrie_t subscriptions;
 
+        //  The same for subscriptions matched exactly, used when
+        //  ZMQ_TOPIC_LENGTH or ZMQ_TOPIC_DELIMITER option is set.
+        mhash_t exact_subscriptions;
+
         //  Distributor of messages holding the list of outbound pipes.
         dist_t dist;
 
+        //  Ring shared by the inproc subscribers and the number of pipes
+        //  reading from it. Such pipes are not handled by the distributor.
+        class ring_t *ring;
+        int shared_pipes;
+
         //  True if we are in the middle of sending a multi-part message.
         bool more;
 
@@ -74,6 +94,22 @@ namespace zmq
         typedef std::deque <blob_t> pending_t;
         pending_t pending;
 
+        //  Last value cache, used if ZMQ_LAST_VALUE option is set. Maps
+        //  topics to the last message published on them. The parts of
+        //  the message are copies sharing the data with the sent message.
+        typedef std::vector <msg_t> parts_t;
+        typedef std::map <blob_t, parts_t> last_values_t;
+        last_values_t last_values;
+
+        //  Parts of the message being sent.
+        parts_t last_value;
+
+        //  Subscriptions that arrived in the middle of a multi-part message.
+        //  Cached messages are sent to them once the message is complete.
+        typedef std::deque <std::pair <class pipe_t*, blob_t> >
+            pending_last_values_t;
+        pending_last_values_t pending_last_values;
+
         xpub_t (const xpub_t&);
         const xpub_t &operator = (const xpub_t&);
     };
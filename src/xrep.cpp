@@ -29,6 +29,7 @@ zmq::xrep_t::xrep_t (class ctx_t *parent_, uint32_t tid_) :
     socket_base_t (parent_, tid_),
     prefetched (false),
     more_in (false),
+    outpipes_count (0),
     current_out (NULL),
     more_out (false)
 {
@@ -41,12 +42,12 @@ zmq::xrep_t::xrep_t (class ctx_t *parent_, uint32_t tid_) :
     prefetched_msg.init ();
 
     //  Start the peer ID sequence from a random point.
-    generate_random (&next_peer_id, sizeof (next_peer_id));
+    generate_random (&initial_generation, sizeof (initial_generation));
 }
 
 zmq::xrep_t::~xrep_t ()
 {
-    zmq_assert (outpipes.empty ());
+    zmq_assert (outpipes_count == 0);
     prefetched_msg.close ();
 }
 
@@ -54,49 +55,61 @@ void zmq::xrep_t::xattach_pipe (pipe_t *pipe_, const blob_t &peer_identity_)
 {
     zmq_assert (pipe_);
 
-    //  Generate a new peer ID. Take care to avoid duplicates.
-    outpipes_t::iterator it = outpipes.lower_bound (next_peer_id);
-    if (!outpipes.empty ()) {
-        while (true) {
-            if (it == outpipes.end ())
-                it = outpipes.begin ();
-            if (it->first != next_peer_id)
-                break;
-            ++next_peer_id;
-            ++it;
+    //  Get an unused slot for the pipe. If there's none and the slot index
+    //  can't grow any more, refuse the peer.
+    uint32_t slot;
+    if (!unused.empty ()) {
+        slot = unused.front ();
+        unused.pop_front ();
+    }
+    else {
+        if (unlikely ((uint64_t) outpipes.size () > (uint32_t) -1)) {
+            pipe_->terminate (false);
+            return;
         }
+        slot = (uint32_t) outpipes.size ();
+        outpipe_t outpipe = {NULL, false, initial_generation};
+        outpipes.push_back (outpipe);
     }
-
-    //  Add the pipe to the map out outbound pipes.
-    outpipe_t outpipe = {pipe_, true};
-    bool ok = outpipes.insert (outpipes_t::value_type (
-        next_peer_id, outpipe)).second;
-    zmq_assert (ok);
+    outpipe_t &outpipe = outpipes [slot];
+    outpipe.pipe = pipe_;
+    outpipe.active = true;
+    outpipes_count++;
 
     //  Add the pipe to the list of inbound pipes.
-    pipe_->set_pipe_id (next_peer_id);
+    pipe_->set_pipe_id (((uint64_t) outpipe.generation << 32) | slot);
     fq.attach (pipe_);
+}
 
-    //  Advance next peer ID so that if new connection is dropped shortly after
-    //  its creation we don't accidentally get two subsequent peers with
-    //  the same ID.
-    ++next_peer_id;
+zmq::xrep_t::outpipe_t *zmq::xrep_t::find_outpipe (uint64_t peer_id_)
+{
+    uint32_t slot = (uint32_t) peer_id_;
+    if (slot >= outpipes.size ())
+        return NULL;
+    outpipe_t &outpipe = outpipes [slot];
+    if (!outpipe.pipe || outpipe.generation != (uint32_t) (peer_id_ >> 32))
+        return NULL;
+    return &outpipe;
 }
 
 void zmq::xrep_t::xterminated (pipe_t *pipe_)
 {
+    //  The pipe may have been refused when attached.
+    outpipe_t *outpipe = find_outpipe (pipe_->get_pipe_id ());
+    if (!outpipe || outpipe->pipe != pipe_)
+        return;
+
     fq.terminated (pipe_);
 
-    for (outpipes_t::iterator it = outpipes.begin ();
-          it != outpipes.end (); ++it) {
-        if (it->second.pipe == pipe_) {
-            outpipes.erase (it);
-            if (pipe_ == current_out)
-                current_out = NULL;
-            return;
-        }
-    }
-    zmq_assert (false);
+    //  Release the slot. New generation makes the old peer ID invalid.
+    outpipe->pipe = NULL;
+    outpipe->active = false;
+    outpipe->generation++;
+    unused.push_back ((uint32_t) pipe_->get_pipe_id ());
+    outpipes_count--;
+
+    if (pipe_ == current_out)
+        current_out = NULL;
 }
 
 void zmq::xrep_t::xread_activated (pipe_t *pipe_)
@@ -106,15 +119,10 @@ void zmq::xrep_t::xread_activated (pipe_t *pipe_)
 
 void zmq::xrep_t::xwrite_activated (pipe_t *pipe_)
 {
-    for (outpipes_t::iterator it = outpipes.begin ();
-          it != outpipes.end (); ++it) {
-        if (it->second.pipe == pipe_) {
-            zmq_assert (!it->second.active);
-            it->second.active = true;
-            return;
-        }
-    }
-    zmq_assert (false);
+    outpipe_t *outpipe = find_outpipe (pipe_->get_pipe_id ());
+    zmq_assert (outpipe && outpipe->pipe == pipe_);
+    zmq_assert (!outpipe->active);
+    outpipe->active = true;
 }
 
 int zmq::xrep_t::xsend (msg_t *msg_, int flags_)
@@ -133,17 +141,17 @@ int zmq::xrep_t::xsend (msg_t *msg_, int flags_)
 
             //  Find the pipe associated with the peer ID stored in the prefix.
             //  If there's no such pipe just silently ignore the message.
-            if (msg_->size () == 4) {
-                uint32_t peer_id = get_uint32 ((unsigned char*) msg_->data ());
-                outpipes_t::iterator it = outpipes.find (peer_id);
+            if (msg_->size () == peer_id_size) {
+                uint64_t peer_id = get_uint64 ((unsigned char*) msg_->data ());
+                outpipe_t *outpipe = find_outpipe (peer_id);
 
-                if (it != outpipes.end ()) {
-                    current_out = it->second.pipe;
+                if (outpipe) {
+                    current_out = outpipe->pipe;
                     msg_t empty;
                     int rc = empty.init ();
                     errno_assert (rc == 0);
                     if (!current_out->check_write (&empty)) {
-                        it->second.active = false;
+                        outpipe->active = false;
                         more_out = false;
                         current_out = NULL;
                     }
@@ -169,7 +177,10 @@ int zmq::xrep_t::xsend (msg_t *msg_, int flags_)
         if (unlikely (!ok))
             current_out = NULL;
         else if (!more_out) {
-            current_out->flush ();
+            if (flags_ & send_noflush)
+                current_out->defer_flush ();
+            else
+                current_out->flush ();
             current_out = NULL;
         }
     }
@@ -215,9 +226,9 @@ int zmq::xrep_t::xrecv (msg_t *msg_, int flags_)
     prefetched = true;
     rc = msg_->close ();
     errno_assert (rc == 0);
-    rc = msg_->init_size (4);
+    rc = msg_->init_size (peer_id_size);
     errno_assert (rc == 0);
-    put_uint32 ((unsigned char*) msg_->data (), pipe->get_pipe_id ());
+    put_uint64 ((unsigned char*) msg_->data (), pipe->get_pipe_id ());
     msg_->set_flags (msg_t::label);
     return 0;
 }
@@ -21,7 +21,8 @@
 #ifndef __ZMQ_XREP_HPP_INCLUDED__
 #define __ZMQ_XREP_HPP_INCLUDED__
 
-#include <map>
+#include <deque>
+#include <vector>
 
 #include "socket_base.hpp"
 #include "stdint.hpp"
@@ -70,25 +71,44 @@ namespace zmq
         //  If true, more incoming message parts are expected.
         bool more_in;
 
+        //  Peer ID is a 64-bit number consisting of the index of the slot
+        //  holding the pipe (low 32 bits) and the generation of the slot
+        //  (high 32 bits). Generation is incremented each time the slot is
+        //  released so that the ID of a terminated pipe doesn't refer to
+        //  a new pipe using the same slot.
+        enum {peer_id_size = 8};
+
         struct outpipe_t
         {
             class pipe_t *pipe;
             bool active;
+            uint32_t generation;
         };
 
-        //  Outbound pipes indexed by the peer IDs.
-        typedef std::map <uint32_t, outpipe_t> outpipes_t;
+        //  Returns the slot the peer ID refers to or NULL if the peer
+        //  doesn't exist.
+        outpipe_t *find_outpipe (uint64_t peer_id_);
+
+        //  Outbound pipes indexed by the slot part of the peer IDs.
+        typedef std::vector <outpipe_t> outpipes_t;
         outpipes_t outpipes;
 
+        //  Indices of unused slots. The slots are reused in FIFO order
+        //  so that generations of a slot wrap around as late as possible.
+        std::deque <uint32_t> unused;
+
+        //  Number of used slots.
+        uint32_t outpipes_count;
+
         //  The pipe we are currently writing to.
         class pipe_t *current_out;
 
         //  If true, more outgoing message parts are expected.
         bool more_out;
 
-        //  Peer ID are generated. It's a simple increment and wrap-over
-        //  algorithm. This value is the next ID to use (if not used already).
-        uint32_t next_peer_id;
+        //  Generation new slots start with. It's chosen randomly so that
+        //  peer IDs differ between the instances of the socket.
+        uint32_t initial_generation;
 
         xrep_t (const xrep_t&);
         const xrep_t &operator = (const xrep_t&);
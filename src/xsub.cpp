@@ -25,6 +25,7 @@
 
 zmq::xsub_t::xsub_t (class ctx_t *parent_, uint32_t tid_) :
     socket_base_t (parent_, tid_),
+    subscriptions (options),
     has_message (false),
     more (false)
 {
@@ -46,8 +47,7 @@ void zmq::xsub_t::xattach_pipe (pipe_t *pipe_, const blob_t &peer_identity_)
     dist.attach (pipe_);
 
     //  Send all the cached subscriptions to the new upstream peer.
-    subscriptions.apply (send_subscription, pipe_);
-    pipe_->flush ();
+    send_subscriptions (pipe_);
 }
 
 void zmq::xsub_t::xread_activated (pipe_t *pipe_)
@@ -69,8 +69,7 @@ void zmq::xsub_t::xterminated (pipe_t *pipe_)
 void zmq::xsub_t::xhiccuped (pipe_t *pipe_)
 {
     //  Send all the cached subscriptions to the hiccuped pipe.
-    subscriptions.apply (send_subscription, pipe_);
-    pipe_->flush ();
+    send_subscriptions (pipe_);
 }
 
 int zmq::xsub_t::xsend (msg_t *msg_, int flags_)
@@ -190,9 +189,21 @@ bool zmq::xsub_t::xhas_in ()
     }
 }
 
+bool zmq::xsub_t::xhas_subscriptions ()
+{
+    return !subscriptions.empty ();
+}
+
 bool zmq::xsub_t::match (msg_t *msg_)
 {
-    return subscriptions.check ((unsigned char*) msg_->data (), msg_->size ());
+    return subscriptions.match ((unsigned char*) msg_->data (),
+        msg_->size ());
+}
+
+void zmq::xsub_t::send_subscriptions (pipe_t *pipe_)
+{
+    subscriptions.apply (send_subscription, pipe_);
+    pipe_->flush ();
 }
 
 void zmq::xsub_t::send_subscription (unsigned char *data_, size_t size_,
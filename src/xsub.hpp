@@ -24,7 +24,7 @@
 #include "socket_base.hpp"
 #include "dist.hpp"
 #include "fq.hpp"
-#include "trie.hpp"
+#include "filter.hpp"
 #include "msg.hpp"
 
 namespace zmq
@@ -46,6 +46,7 @@ namespace zmq
         bool xhas_out ();
         int xrecv (class msg_t *msg_, int flags_);
         bool xhas_in ();
+        bool xhas_subscriptions ();
         void xread_activated (class pipe_t *pipe_);
         void xwrite_activated (class pipe_t *pipe_);
         void xhiccuped (pipe_t *pipe_);
@@ -67,8 +68,11 @@ namespace zmq
         //  Object for distributing the subscriptions upstream.
         dist_t dist;
 
+        //  Sends all the subscriptions to the pipe.
+        void send_subscriptions (class pipe_t *pipe_);
+
         //  The repository of subscriptions.
-        trie_t subscriptions;
+        filter_t subscriptions;
 
         //  If true, 'message' contains a matching message to return on the
         //  next recv call.
@@ -163,6 +163,23 @@ namespace zmq
             return true;
         }
 
+        //  Reads up to count_ items from the pipe into the array. All the
+        //  items prefetched by a single check_read are returned at once, so
+        //  the reader touches the shared pointer at most once per batch
+        //  rather than once per item. Returns the number of items read.
+        inline int read_batch (T *values_, int count_)
+        {
+            if (!check_read ())
+                return 0;
+
+            int nread = 0;
+            while (nread != count_ && &queue.front () != r) {
+                values_ [nread++] = queue.front ();
+                queue.pop ();
+            }
+            return nread;
+        }
+
         //  Applies the function fn to the first elemenent in the pipe
         //  and returns the value returned by the fn.
         //  The pipe mustn't be empty or the function crashes.
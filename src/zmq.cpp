@@ -38,6 +38,7 @@
 #include <new>
 
 #include "socket_base.hpp"
+#include "socket_poller.hpp"
 #include "stdint.hpp"
 #include "config.hpp"
 #include "likely.hpp"
@@ -45,6 +46,7 @@
 #include "ctx.hpp"
 #include "err.hpp"
 #include "msg.hpp"
+#include "msg_pool.hpp"
 #include "fd.hpp"
 
 #if !defined ZMQ_HAVE_WINDOWS
@@ -150,6 +152,24 @@ int zmq_term (void *ctx_)
     return rc;
 }
 
+int zmq_ctx_set (void *ctx_, int option_, int optval_)
+{
+    if (!ctx_ || !((zmq::ctx_t*) ctx_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::ctx_t*) ctx_)->set (option_, optval_);
+}
+
+int zmq_ctx_get (void *ctx_, int option_)
+{
+    if (!ctx_ || !((zmq::ctx_t*) ctx_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::ctx_t*) ctx_)->get (option_);
+}
+
 void *zmq_socket (void *ctx_, int type_)
 {
     if (!ctx_ || !((zmq::ctx_t*) ctx_)->check_tag ()) {
@@ -210,8 +230,13 @@ int zmq_connect (void *s_, const char *addr_)
 
 int zmq_send (void *s_, const void *buf_, size_t len_, int flags_)
 {
+    if (!s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = ENOTSOCK;
+        return -1;
+    }
     zmq_msg_t msg;
-    int rc = zmq_msg_init_size (&msg, len_);
+    int rc = ((zmq::msg_t*) &msg)->init_size (len_,
+        ((zmq::socket_base_t*) s_)->pooled ());
     if (rc != 0)
         return -1;
     memcpy (zmq_msg_data (&msg), buf_, len_);
@@ -281,6 +306,35 @@ int zmq_recvmsg (void *s_, zmq_msg_t *msg_, int flags_)
     return (int) zmq_msg_size (msg_);
 }
 
+int zmq_sendmmsg (void *s_, zmq_msg_t *msgs_, int count_, int flags_)
+{
+    if (!s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = ENOTSOCK;
+        return -1;
+    }
+    return (((zmq::socket_base_t*) s_)->send_batch ((zmq::msg_t*) msgs_,
+        count_, flags_));
+}
+
+int zmq_recvmmsg (void *s_, zmq_msg_t *msgs_, int count_, int flags_)
+{
+    if (!s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = ENOTSOCK;
+        return -1;
+    }
+    return (((zmq::socket_base_t*) s_)->recv_batch ((zmq::msg_t*) msgs_,
+        count_, flags_));
+}
+
+int zmq_flush (void *s_)
+{
+    if (!s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = ENOTSOCK;
+        return -1;
+    }
+    return (((zmq::socket_base_t*) s_)->flush ());
+}
+
 int zmq_msg_init (zmq_msg_t *msg_)
 {
     return ((zmq::msg_t*) msg_)->init ();
@@ -288,13 +342,14 @@ int zmq_msg_init (zmq_msg_t *msg_)
 
 int zmq_msg_init_size (zmq_msg_t *msg_, size_t size_)
 {
-    return ((zmq::msg_t*) msg_)->init_size (size_);
+    return ((zmq::msg_t*) msg_)->init_size (size_, zmq::msg_pool_active ());
 }
 
 int zmq_msg_init_data (zmq_msg_t *msg_, void *data_, size_t size_,
     zmq_free_fn *ffn_, void *hint_)
 {
-    return ((zmq::msg_t*) msg_)->init_data (data_, size_, ffn_, hint_);
+    return ((zmq::msg_t*) msg_)->init_data (data_, size_, ffn_, hint_,
+        zmq::msg_pool_active ());
 }
 
 int zmq_msg_close (zmq_msg_t *msg_)
@@ -694,6 +749,96 @@ int zmq_poll (zmq_pollitem_t *items_, int nitems_, long timeout_)
 #undef ZMQ_POLL_BASED_ON_POLL
 #endif
 
+void *zmq_poller_new ()
+{
+    zmq::socket_poller_t *poller = new (std::nothrow) zmq::socket_poller_t;
+    alloc_assert (poller);
+    return (void*) poller;
+}
+
+int zmq_poller_destroy (void *poller_)
+{
+    if (!poller_ || !((zmq::socket_poller_t*) poller_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    delete (zmq::socket_poller_t*) poller_;
+    return 0;
+}
+
+int zmq_poller_add (void *poller_, void *s_, void *user_data_, short events_)
+{
+    if (!poller_ || !((zmq::socket_poller_t*) poller_)->check_tag () ||
+          !s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::socket_poller_t*) poller_)->add ((zmq::socket_base_t*) s_,
+        user_data_, events_);
+}
+
+int zmq_poller_modify (void *poller_, void *s_, short events_)
+{
+    if (!poller_ || !((zmq::socket_poller_t*) poller_)->check_tag () ||
+          !s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::socket_poller_t*) poller_)->modify (
+        (zmq::socket_base_t*) s_, events_);
+}
+
+int zmq_poller_remove (void *poller_, void *s_)
+{
+    if (!poller_ || !((zmq::socket_poller_t*) poller_)->check_tag () ||
+          !s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::socket_poller_t*) poller_)->remove (
+        (zmq::socket_base_t*) s_);
+}
+
+int zmq_poller_add_fd (void *poller_, zmq_fd_t fd_, void *user_data_,
+    short events_)
+{
+    if (!poller_ || !((zmq::socket_poller_t*) poller_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::socket_poller_t*) poller_)->add_fd (fd_, user_data_,
+        events_);
+}
+
+int zmq_poller_modify_fd (void *poller_, zmq_fd_t fd_, short events_)
+{
+    if (!poller_ || !((zmq::socket_poller_t*) poller_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::socket_poller_t*) poller_)->modify_fd (fd_, events_);
+}
+
+int zmq_poller_remove_fd (void *poller_, zmq_fd_t fd_)
+{
+    if (!poller_ || !((zmq::socket_poller_t*) poller_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::socket_poller_t*) poller_)->remove_fd (fd_);
+}
+
+int zmq_poller_wait (void *poller_, zmq_poller_event_t *events_,
+    int n_events_, long timeout_)
+{
+    if (!poller_ || !((zmq::socket_poller_t*) poller_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::socket_poller_t*) poller_)->wait (events_, n_events_,
+        timeout_);
+}
+
 int zmq_errno ()
 {
     return errno;
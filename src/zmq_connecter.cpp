@@ -32,6 +32,8 @@
 #include "zmq_engine.hpp"
 #include "zmq_init.hpp"
 #include "io_thread.hpp"
+#include "resolver.hpp"
+#include "ctx.hpp"
 #include "err.hpp"
 
 zmq::zmq_connecter_t::zmq_connecter_t (class io_thread_t *io_thread_,
@@ -42,16 +44,25 @@ zmq::zmq_connecter_t::zmq_connecter_t (class io_thread_t *io_thread_,
     handle_valid (false),
     wait (wait_),
     session (session_),
-    current_reconnect_ivl(options.reconnect_ivl)
+    current_reconnect_ivl(options.reconnect_ivl),
+    protocol (protocol_),
+    address (address_),
+    resolving (false),
+    addr_len (0)
 {
-    int rc = tcp_connecter.set_address (protocol_, address_);
-    zmq_assert (rc == 0); //TODO: take care ENOMEM, EINVAL
+    //  TCP addresses are resolved anew before each connection attempt.
+    //  SHM connections are established via unix domain sockets.
+    if (protocol != "tcp") {
+        int rc = tcp_connecter.set_address (
+            protocol == "shm" ? "ipc" : protocol_, address_);
+        zmq_assert (rc == 0); //TODO: take care ENOMEM, EINVAL
+    }
 }
 
 zmq::zmq_connecter_t::~zmq_connecter_t ()
 {
     if (wait)
-        cancel_timer (reconnect_timer_id);
+        cancel_timer (reconnect_timer);
     if (handle_valid)
         rm_fd (handle);
 }
@@ -64,6 +75,36 @@ void zmq::zmq_connecter_t::process_plug ()
         start_connecting ();
 }
 
+void zmq::zmq_connecter_t::process_term (int linger_)
+{
+    //  If the resolver has already sent us the address, we have to wait
+    //  for it before shutting down.
+    if (resolving && !get_ctx ()->get_resolver ()->cancel (this))
+        register_term_acks (1);
+
+    own_t::process_term (linger_);
+}
+
+void zmq::zmq_connecter_t::process_resolved (int error_)
+{
+    resolving = false;
+
+    if (is_terminating ()) {
+        unregister_term_ack ();
+        return;
+    }
+
+    //  Handle the error condition by attempt to reconnect.
+    if (error_) {
+        wait = true;
+        add_reconnect_timer ();
+        return;
+    }
+
+    tcp_connecter.set_address (addr, addr_len);
+    open_connection ();
+}
+
 void zmq::zmq_connecter_t::in_event ()
 {
     //  We are not polling for incomming data, so we are actually called
@@ -93,7 +134,7 @@ void zmq::zmq_connecter_t::out_event ()
 
     //  Create an init object. 
     zmq_init_t *init = new (std::nothrow) zmq_init_t (io_thread, NULL,
-        session, fd, options);
+        session, fd, options, protocol);
     alloc_assert (init);
     launch_sibling (init);
 
@@ -109,6 +150,28 @@ void zmq::zmq_connecter_t::timer_event (int id_)
 }
 
 void zmq::zmq_connecter_t::start_connecting ()
+{
+    //  Resolve the TCP address without blocking the I/O thread. If it's
+    //  not known yet, the resolver will let us know once it is.
+    if (protocol == "tcp") {
+        int rc = get_ctx ()->get_resolver ()->resolve (address.c_str (),
+            &addr, &addr_len, this);
+        if (rc != 0 && errno == EAGAIN) {
+            resolving = true;
+            return;
+        }
+        if (rc != 0) {
+            wait = true;
+            add_reconnect_timer ();
+            return;
+        }
+        tcp_connecter.set_address (addr, addr_len);
+    }
+
+    open_connection ();
+}
+
+void zmq::zmq_connecter_t::open_connection ()
 {
     //  Open the connecting socket.
     int rc = tcp_connecter.open ();
@@ -136,7 +199,7 @@ void zmq::zmq_connecter_t::start_connecting ()
 
 void zmq::zmq_connecter_t::add_reconnect_timer()
 {
-    add_timer (get_new_reconnect_ivl(), reconnect_timer_id);
+    reconnect_timer = add_timer (get_new_reconnect_ivl(), reconnect_timer_id);
 }
 
 int zmq::zmq_connecter_t::get_new_reconnect_ivl ()
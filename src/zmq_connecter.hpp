@@ -21,6 +21,8 @@
 #ifndef __ZMQ_ZMQ_CONNECTER_HPP_INCLUDED__
 #define __ZMQ_ZMQ_CONNECTER_HPP_INCLUDED__
 
+#include <string>
+
 #include "own.hpp"
 #include "io_object.hpp"
 #include "tcp_connecter.hpp"
@@ -45,8 +47,13 @@ namespace zmq
         //  ID of the timer used to delay the reconnection.
         enum {reconnect_timer_id = 1};
 
+        //  Handle of the reconnection timer, valid while waiting.
+        timer_handle_t reconnect_timer;
+
         //  Handlers for incoming commands.
         void process_plug ();
+        void process_term (int linger_);
+        void process_resolved (int error_);
 
         //  Handlers for I/O events.
         void in_event ();
@@ -54,8 +61,13 @@ namespace zmq
         void timer_event (int id_);
 
         //  Internal function to start the actual connection establishment.
+        //  TCP address is resolved first.
         void start_connecting ();
 
+        //  Internal function to open the connecting socket once the address
+        //  is known.
+        void open_connection ();
+
         //  Internal function to add a reconnect timer
         void add_reconnect_timer();
 
@@ -83,6 +95,18 @@ namespace zmq
         //  Current reconnect ivl, updated for backoff strategy
         int current_reconnect_ivl;
 
+        //  Address to connect to.
+        std::string protocol;
+        std::string address;
+
+        //  If true, connecter is waiting for the resolver to look the
+        //  address up.
+        bool resolving;
+
+        //  Resolved TCP address, filled in by the resolver.
+        sockaddr_storage addr;
+        socklen_t addr_len;
+
         zmq_connecter_t (const zmq_connecter_t&);
         const zmq_connecter_t &operator = (const zmq_connecter_t&);
     };
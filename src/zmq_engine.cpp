@@ -25,6 +25,11 @@
 
 #include <string.h>
 #include <new>
+#include <algorithm>
+
+#if !defined ZMQ_HAVE_WINDOWS
+#include <unistd.h>
+#endif
 
 #include "zmq_engine.hpp"
 #include "zmq_connecter.hpp"
@@ -32,13 +37,20 @@
 #include "config.hpp"
 #include "err.hpp"
 
-zmq::zmq_engine_t::zmq_engine_t (fd_t fd_, const options_t &options_) :
+zmq::zmq_engine_t::zmq_engine_t (fd_t fd_, const options_t &options_,
+      bool ipc_) :
     inpos (NULL),
     insize (0),
-    decoder (in_batch_size, options_.maxmsgsize),
+    decoder (in_batch_size, options_.maxmsgsize, options_.msg_pool),
     outpos (NULL),
     outsize (0),
     encoder (out_batch_size),
+#if !defined ZMQ_HAVE_WINDOWS
+    outiovcnt (0),
+    outiovpos (0),
+    outfd (retired_fd),
+    pass_fds (false),
+#endif
     sink (NULL),
     ephemeral_sink (NULL),
     options (options_),
@@ -47,11 +59,27 @@ zmq::zmq_engine_t::zmq_engine_t (fd_t fd_, const options_t &options_) :
     //  Initialise the underlying socket.
     int rc = tcp_socket.open (fd_, options.sndbuf, options.rcvbuf);
     zmq_assert (rc == 0);
+
+#if defined ZMQ_HAVE_MEMFD
+    //  Memory files are accepted on all the ipc connections, however, they
+    //  are sent only if asked to.
+    if (ipc_) {
+        pass_fds = true;
+        encoder.set_memfd_threshold ((size_t) options.memfd_threshold);
+    }
+#endif
 }
 
 zmq::zmq_engine_t::~zmq_engine_t ()
 {
     zmq_assert (!plugged);
+
+#if !defined ZMQ_HAVE_WINDOWS
+    if (outfd != retired_fd) {
+        int rc = close (outfd);
+        errno_assert (rc == 0);
+    }
+#endif
 }
 
 void zmq::zmq_engine_t::plug (io_thread_t *io_thread_, i_engine_sink *sink_)
@@ -65,6 +93,7 @@ void zmq::zmq_engine_t::plug (io_thread_t *io_thread_, i_engine_sink *sink_)
     zmq_assert (sink_);
     encoder.set_sink (sink_);
     decoder.set_sink (sink_);
+    decoder.set_filter (sink_->get_filter ());
     sink = sink_;
 
     //  Connect to I/O threads poller object.
@@ -91,6 +120,7 @@ void zmq::zmq_engine_t::unplug ()
     //  Disconnect from init/session object.
     encoder.set_sink (NULL);
     decoder.set_sink (NULL);
+    decoder.set_filter (NULL);
     ephemeral_sink = sink;
     sink = NULL;
 }
@@ -108,6 +138,7 @@ void zmq::zmq_engine_t::in_event ()
     //  If there's no data to process in the buffer...
     if (!insize) {
 
+#if defined ZMQ_HAVE_WINDOWS
         //  Retrieve the buffer and read as much data as possible.
         //  Note that buffer can be arbitrarily large. However, we assume
         //  the underlying TCP layer has fixed buffer size and thus the
@@ -120,6 +151,46 @@ void zmq::zmq_engine_t::in_event ()
             insize = 0;
             disconnection = true;
         }
+#else
+        //  Same as above, except that if a large message body is being
+        //  received, the rest of it is read directly into the message and
+        //  only the data following it land in the decoder's buffer.
+        iovec iov [2];
+        int count = 2;
+        decoder.get_iovec (iov, &count);
+        int nbytes;
+        if (pass_fds) {
+            fd_t fd;
+            nbytes = tcp_socket.readv (iov, count, &fd);
+            if (fd != retired_fd)
+                decoder.push_fd (fd);
+        }
+        else
+            nbytes = count == 1 ?
+                tcp_socket.read (iov [0].iov_base, iov [0].iov_len) :
+                tcp_socket.readv (iov, count);
+
+        //  Check whether the peer has closed the connection.
+        if (nbytes == -1)
+            disconnection = true;
+        else if (count == 1) {
+            inpos = (unsigned char*) iov [0].iov_base;
+            insize = nbytes;
+        }
+        else {
+
+            //  Pass the body part to the decoder straight away. The rest is
+            //  processed the standard way below.
+            size_t body = std::min ((size_t) nbytes, iov [0].iov_len);
+            if (body && decoder.process_buffer (
+                  (unsigned char*) iov [0].iov_base, body) == (size_t) -1)
+                disconnection = true;
+            else {
+                inpos = (unsigned char*) iov [1].iov_base;
+                insize = nbytes - body;
+            }
+        }
+#endif
     }
 
     //  Push the data to the decoder.
@@ -163,8 +234,17 @@ void zmq::zmq_engine_t::out_event ()
     //  If write buffer is empty, try to read new data from the encoder.
     if (!outsize) {
 
+#if defined ZMQ_HAVE_WINDOWS
         outpos = NULL;
         encoder.get_data (&outpos, &outsize);
+#else
+        //  Message bodies are not copied to the batch but referenced from
+        //  the messages themselves. The encoder keeps the messages alive
+        //  until the whole batch is written.
+        outiovcnt = out_batch_max_iov;
+        outiovpos = 0;
+        encoder.get_iovec (outiov, &outiovcnt, &outsize, &outfd);
+#endif
 
         //  If IO handler has unplugged engine, flush transient IO handler.
         if (unlikely (!plugged)) {
@@ -185,7 +265,26 @@ void zmq::zmq_engine_t::out_event ()
     //  arbitratily large. However, we assume that underlying TCP layer has
     //  limited transmission buffer and thus the actual number of bytes
     //  written should be reasonably modest.
+#if defined ZMQ_HAVE_WINDOWS
     int nbytes = tcp_socket.write (outpos, outsize);
+#else
+    int nbytes;
+    if (outfd == retired_fd)
+        nbytes = tcp_socket.writev (outiov + outiovpos,
+            outiovcnt - outiovpos);
+    else {
+
+        //  Once any data were written, the memory file is on its way to
+        //  the peer.
+        nbytes = tcp_socket.writev (outiov + outiovpos,
+            outiovcnt - outiovpos, outfd);
+        if (nbytes > 0) {
+            int rc = close (outfd);
+            errno_assert (rc == 0);
+            outfd = retired_fd;
+        }
+    }
+#endif
 
     //  Handle problems with the connection.
     if (nbytes == -1) {
@@ -193,7 +292,23 @@ void zmq::zmq_engine_t::out_event ()
         return;
     }
 
+#if defined ZMQ_HAVE_WINDOWS
     outpos += nbytes;
+#else
+    //  Skip the chunks that were written completely and adjust the one
+    //  that was written partially.
+    size_t written = nbytes;
+    while (written) {
+        iovec &iov = outiov [outiovpos];
+        if (written < iov.iov_len) {
+            iov.iov_base = (unsigned char*) iov.iov_base + written;
+            iov.iov_len -= written;
+            break;
+        }
+        written -= iov.iov_len;
+        outiovpos++;
+    }
+#endif
     outsize -= nbytes;
 }
 
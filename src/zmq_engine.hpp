@@ -31,6 +31,7 @@
 #include "encoder.hpp"
 #include "decoder.hpp"
 #include "options.hpp"
+#include "config.hpp"
 
 namespace zmq
 {
@@ -39,7 +40,9 @@ namespace zmq
     {
     public:
 
-        zmq_engine_t (fd_t fd_, const options_t &options_);
+        //  If ipc_ is true, the connection is a unix domain socket and the
+        //  large messages can be passed as memory files.
+        zmq_engine_t (fd_t fd_, const options_t &options_, bool ipc_);
         ~zmq_engine_t ();
 
         //  i_engine interface implementation.
@@ -69,6 +72,21 @@ namespace zmq
         size_t outsize;
         encoder_t encoder;
 
+#if !defined ZMQ_HAVE_WINDOWS
+        //  Batch of data being sent. Entries preceding outiovpos were
+        //  already written. outsize is the number of bytes still to write.
+        iovec outiov [out_batch_max_iov];
+        int outiovcnt;
+        int outiovpos;
+
+        //  Memory file to pass along with the batch, if any. It's closed
+        //  once the first byte of the batch is written.
+        fd_t outfd;
+
+        //  If true, file descriptors are passed over the connection.
+        bool pass_fds;
+#endif
+
         i_engine_sink *sink;
 
         //  Detached transient sink.
@@ -25,6 +25,7 @@
 #include "named_session.hpp"
 #include "socket_base.hpp"
 #include "zmq_engine.hpp"
+#include "shm_engine.hpp"
 #include "io_thread.hpp"
 #include "session.hpp"
 #include "uuid.hpp"
@@ -34,7 +35,7 @@
 
 zmq::zmq_init_t::zmq_init_t (io_thread_t *io_thread_,
       socket_base_t *socket_, session_t *session_, fd_t fd_,
-      const options_t &options_) :
+      const options_t &options_, const std::string &protocol_) :
     own_t (io_thread_, options_),
     ephemeral_engine (NULL),
     received (false),
@@ -42,8 +43,16 @@ zmq::zmq_init_t::zmq_init_t (io_thread_t *io_thread_,
     session (session_),
     io_thread (io_thread_)
 {
-    //  Create the engine object for this connection.
-    engine = new (std::nothrow) zmq_engine_t (fd_, options);
+    //  Create the engine object for this connection. On the shm transport
+    //  the connecting side is the one with the session.
+#if defined ZMQ_HAVE_MEMFD && defined ZMQ_HAVE_EVENTFD
+    if (protocol_ == "shm")
+        engine = new (std::nothrow) shm_engine_t (fd_, options,
+            session != NULL);
+    else
+#endif
+        engine = new (std::nothrow) zmq_engine_t (fd_, options,
+            protocol_ == "ipc");
     alloc_assert (engine);
 
     //  Generate an unique identity.
@@ -144,6 +153,12 @@ void zmq::zmq_init_t::detach ()
     terminate ();
 }
 
+zmq::filter_t *zmq::zmq_init_t::get_filter ()
+{
+    //  The identity of the peer must not be filtered out.
+    return NULL;
+}
+
 void zmq::zmq_init_t::process_plug ()
 {
     zmq_assert (engine);
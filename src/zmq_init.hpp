@@ -22,6 +22,7 @@
 #define __ZMQ_ZMQ_INIT_HPP_INCLUDED__
 
 #include <vector>
+#include <string>
 
 #include "i_engine.hpp"
 #include "stdint.hpp"
@@ -42,7 +43,8 @@ namespace zmq
     public:
 
         zmq_init_t (class io_thread_t *io_thread_, class socket_base_t *socket_,
-            class session_t *session_, fd_t fd_, const options_t &options_);
+            class session_t *session_, fd_t fd_, const options_t &options_,
+            const std::string &protocol_);
         ~zmq_init_t ();
 
     private:
@@ -55,6 +57,7 @@ namespace zmq
         bool write (class msg_t *msg_);
         void flush ();
         void detach ();
+        class filter_t *get_filter ();
 
         //  Handlers for incoming commands.
         void process_plug ();
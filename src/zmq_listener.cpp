@@ -26,10 +26,11 @@
 #include "err.hpp"
 
 zmq::zmq_listener_t::zmq_listener_t (io_thread_t *io_thread_,
-      socket_base_t *socket_, const options_t &options_) :
+      socket_base_t *socket_, const options_t &options_, bool sharded_) :
     own_t (io_thread_, options_),
     io_object_t (io_thread_),
-    socket (socket_)
+    socket (socket_),
+    io_thread (sharded_ ? io_thread_ : NULL)
 {
 }
 
@@ -39,7 +40,10 @@ zmq::zmq_listener_t::~zmq_listener_t ()
 
 int zmq::zmq_listener_t::set_address (const char *protocol_, const char *addr_)
 {
-     return tcp_listener.set_address (protocol_, addr_, options.backlog);
+     //  SHM connections are established via unix domain sockets.
+     protocol = protocol_;
+     return tcp_listener.set_address (protocol == "shm" ? "ipc" : protocol_,
+         addr_, options.backlog, io_thread != NULL);
 }
 
 void zmq::zmq_listener_t::process_plug ()
@@ -57,22 +61,23 @@ void zmq::zmq_listener_t::process_term (int linger_)
 
 void zmq::zmq_listener_t::in_event ()
 {
-    fd_t fd = tcp_listener.accept ();
-
-    //  If connection was reset by the peer in the meantime, just ignore it.
+    //  Accept all the pending connections. If connection was reset by the
+    //  peer in the meantime, just ignore it and wait for the next event.
     //  TODO: Handle specific errors like ENFILE/EMFILE etc.
-    if (fd == retired_fd)
-        return;
-
-    //  Choose I/O thread to run connecter in. Given that we are already
-    //  running in an I/O thread, there must be at least one available.
-    io_thread_t *io_thread = choose_io_thread (options.affinity);
-    zmq_assert (io_thread);
-
-    //  Create and launch an init object. 
-    zmq_init_t *init = new (std::nothrow) zmq_init_t (io_thread, socket,
-        NULL, fd, options);
-    alloc_assert (init);
-    launch_child (init);
+    fd_t fd;
+    while ((fd = tcp_listener.accept ()) != retired_fd) {
+
+        //  Choose I/O thread to run connecter in. Given that we are already
+        //  running in an I/O thread, there must be at least one available.
+        io_thread_t *thread = io_thread ? io_thread :
+            choose_io_thread (options.affinity);
+        zmq_assert (thread);
+
+        //  Create and launch an init object. 
+        zmq_init_t *init = new (std::nothrow) zmq_init_t (thread, socket,
+            NULL, fd, options, protocol);
+        alloc_assert (init);
+        launch_child (init);
+    }
 }
 
@@ -21,6 +21,8 @@
 #ifndef __ZMQ_ZMQ_LISTENER_HPP_INCLUDED__
 #define __ZMQ_ZMQ_LISTENER_HPP_INCLUDED__
 
+#include <string>
+
 #include "own.hpp"
 #include "io_object.hpp"
 #include "tcp_listener.hpp"
@@ -33,8 +35,12 @@ namespace zmq
     {
     public:
 
+        //  If sharded_ is true, the listener is one of several listening on
+        //  the same port, each in a different I/O thread, and the accepted
+        //  connections are handled in the listener's own I/O thread.
         zmq_listener_t (class io_thread_t *io_thread_,
-            class socket_base_t *socket_, const options_t &options_);
+            class socket_base_t *socket_, const options_t &options_,
+            bool sharded_);
         ~zmq_listener_t ();
 
         //  Set address to listen on.
@@ -55,9 +61,16 @@ namespace zmq
         //  Handle corresponding to the listening socket.
         handle_t handle;
 
+        //  Transport the listener accepts connections for.
+        std::string protocol;
+
         //  Socket the listerner belongs to.
         class socket_base_t *socket;
 
+        //  I/O thread to run the accepted connections in. If NULL, the
+        //  least busy one is chosen for each connection.
+        class io_thread_t *io_thread;
+
         zmq_listener_t (const zmq_listener_t&);
         const zmq_listener_t &operator = (const zmq_listener_t&);
     };
@@ -0,0 +1,147 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+
+static void send_str (void *s_, const char *str_, int flags_)
+{
+    int rc = zmq_send (s_, str_, strlen (str_), flags_);
+    assert (rc == (int) strlen (str_));
+}
+
+static void recv_str (void *s_, const char *str_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), 0);
+    assert (rc == (int) strlen (str_));
+    assert (memcmp (buff, str_, rc) == 0);
+}
+
+static void recv_none (void *s_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+}
+
+//  Connects a subscriber and waits till the publisher gets the subscription.
+static void *subscribe (void *ctx_, void *pub_, const char *topic_)
+{
+    void *sub = zmq_socket (ctx_, ZMQ_SUB);
+    assert (sub);
+    int rc = zmq_connect (sub, "inproc://a");
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, topic_, strlen (topic_));
+    assert (rc == 0);
+    char buff [32];
+    rc = zmq_recv (pub_, buff, sizeof (buff), 0);
+    assert (rc == (int) strlen (topic_) + 1);
+    assert (buff [0] == 1 && memcmp (buff + 1, topic_, rc - 1) == 0);
+    return sub;
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (0);
+    assert (ctx);
+
+    //  Publisher passing messages to the subscribers via ring of four
+    //  messages.
+    void *pub = zmq_socket (ctx, ZMQ_XPUB);
+    assert (pub);
+    int broadcast = 1;
+    int rc = zmq_setsockopt (pub, ZMQ_BROADCAST, &broadcast, sizeof (int));
+    assert (rc == 0);
+    int hwm = 4;
+    rc = zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_bind (pub, "inproc://a");
+    assert (rc == 0);
+
+    void *sub1 = subscribe (ctx, pub, "A");
+    void *sub2 = subscribe (ctx, pub, "B");
+    void *sub3 = subscribe (ctx, pub, "");
+
+    //  Subscribers filter the messages themselves.
+    send_str (pub, "A1", 0);
+    send_str (pub, "B1", 0);
+    send_str (pub, "C", ZMQ_SNDMORE);
+    send_str (pub, "body", 0);
+    recv_str (sub1, "A1");
+    recv_none (sub1);
+    recv_str (sub2, "B1");
+    recv_none (sub2);
+    recv_str (sub3, "A1");
+    recv_str (sub3, "B1");
+    recv_str (sub3, "C");
+    recv_str (sub3, "body");
+    recv_none (sub3);
+
+    //  Once the ring is full, messages are dropped.
+    send_str (pub, "A2", 0);
+    send_str (pub, "A3", 0);
+    send_str (pub, "A4", 0);
+    send_str (pub, "A5", 0);
+    send_str (pub, "A6", 0);
+    recv_str (sub1, "A2");
+    recv_str (sub1, "A3");
+    recv_str (sub1, "A4");
+    recv_str (sub1, "A5");
+    recv_none (sub1);
+    recv_none (sub2);
+    recv_str (sub3, "A2");
+    recv_str (sub3, "A3");
+    recv_str (sub3, "A4");
+    recv_str (sub3, "A5");
+    recv_none (sub3);
+
+    //  The remaining subscribers are not affected when one of them leaves.
+    rc = zmq_close (sub1);
+    assert (rc == 0);
+    send_str (pub, "B2", 0);
+    recv_str (sub2, "B2");
+    recv_str (sub3, "B2");
+
+    //  Subscribers get the messages sent before the publisher is closed.
+    send_str (pub, "B3", 0);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+    recv_str (sub2, "B3");
+    recv_str (sub3, "B3");
+    recv_none (sub3);
+
+    //  Only publishers can use the ring.
+    broadcast = 1;
+    rc = zmq_setsockopt (sub2, ZMQ_BROADCAST, &broadcast, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+
+    rc = zmq_close (sub2);
+    assert (rc == 0);
+    rc = zmq_close (sub3);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
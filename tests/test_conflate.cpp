@@ -0,0 +1,138 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+
+static void send_str (void *s_, const char *str_, int flags_)
+{
+    int rc = zmq_send (s_, str_, strlen (str_), flags_);
+    assert (rc == (int) strlen (str_));
+}
+
+static void recv_str (void *s_, const char *str_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), ZMQ_DONTWAIT);
+    assert (rc == (int) strlen (str_));
+    assert (memcmp (buff, str_, rc) == 0);
+}
+
+static void recv_none (void *s_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (0);
+    assert (ctx);
+
+    //  Publisher keeping the last message of each topic. The topic is
+    //  the first byte of the message.
+    void *pub = zmq_socket (ctx, ZMQ_XPUB);
+    assert (pub);
+    int conflate = 1;
+    int rc = zmq_setsockopt (pub, ZMQ_CONFLATE, &conflate, sizeof (int));
+    assert (rc == 0);
+    int length = 1;
+    rc = zmq_setsockopt (pub, ZMQ_TOPIC_LENGTH, &length, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_bind (pub, "inproc://a");
+    assert (rc == 0);
+
+    void *sub = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_connect (sub, "inproc://a");
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    char buff [32];
+    rc = zmq_recv (pub, buff, sizeof (buff), 0);
+    assert (rc == 1);
+
+    //  The subscriber gets the last value of each topic, the topics being
+    //  ordered by the arrival of their first unread message.
+    for (int i = 0; i != 100; i++) {
+        char msg [16];
+        sprintf (msg, "A%d", i);
+        send_str (pub, msg, 0);
+        sprintf (msg, "B%d", i);
+        send_str (pub, msg, 0);
+    }
+    recv_str (sub, "A99");
+    recv_str (sub, "B99");
+    recv_none (sub);
+
+    //  Once the message is read, new message with the same topic is queued.
+    send_str (pub, "B100", 0);
+    send_str (pub, "A100", 0);
+    recv_str (sub, "B100");
+    recv_str (sub, "A100");
+    recv_none (sub);
+
+    //  Receiver keeping the last message only. Multi-part messages are
+    //  conflated as a whole.
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_setsockopt (pull, ZMQ_CONFLATE, &conflate, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_bind (pull, "inproc://b");
+    assert (rc == 0);
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    rc = zmq_connect (push, "inproc://b");
+    assert (rc == 0);
+
+    send_str (push, "1", ZMQ_SNDMORE);
+    send_str (push, "2", 0);
+    send_str (push, "3", ZMQ_SNDMORE);
+    send_str (push, "4", 0);
+    recv_str (pull, "3");
+    recv_str (pull, "4");
+    recv_none (pull);
+
+    //  Conflation doesn't make sense for other socket types.
+    void *req = zmq_socket (ctx, ZMQ_REQ);
+    assert (req);
+    rc = zmq_setsockopt (req, ZMQ_CONFLATE, &conflate, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+
+    rc = zmq_close (pub);
+    assert (rc == 0);
+    rc = zmq_close (sub);
+    assert (rc == 0);
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+    rc = zmq_close (req);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
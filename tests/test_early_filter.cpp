@@ -0,0 +1,125 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+
+static void send_str (void *s_, const char *str_, int flags_)
+{
+    int rc = zmq_send (s_, str_, strlen (str_), flags_);
+    assert (rc == (int) strlen (str_));
+}
+
+static void recv_str (void *s_, const char *str_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), 0);
+    assert (rc == (int) strlen (str_));
+    assert (memcmp (buff, str_, rc) == 0);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  The option applies to SUB sockets only.
+    void *pub = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub);
+    int early = 1;
+    int rc = zmq_setsockopt (pub, ZMQ_EARLY_FILTER, &early, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+
+    void *sub = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_setsockopt (sub, ZMQ_EARLY_FILTER, &early, sizeof (int));
+    assert (rc == 0);
+    early = 0;
+    size_t size = sizeof (int);
+    rc = zmq_getsockopt (sub, ZMQ_EARLY_FILTER, &early, &size);
+    assert (rc == 0 && early == 1);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "A", 1);
+    assert (rc == 0);
+
+    //  Use a peer that doesn't filter the messages it sends. Wait for
+    //  the subscription to make sure the filter is in place.
+    void *peer = zmq_socket (ctx, ZMQ_DEALER);
+    assert (peer);
+    rc = zmq_bind (peer, "tcp://127.0.0.1:5574");
+    assert (rc == 0);
+    rc = zmq_connect (sub, "tcp://127.0.0.1:5574");
+    assert (rc == 0);
+    recv_str (peer, "\1A");
+
+    //  Non-matching messages are dropped including all their parts,
+    //  large ones as well.
+    char large [10000];
+    memset (large, 'B', sizeof (large));
+    send_str (peer, "B1", 0);
+    send_str (peer, "B2", ZMQ_SNDMORE);
+    send_str (peer, "A2", 0);
+    rc = zmq_send (peer, large, sizeof (large), ZMQ_SNDMORE);
+    assert (rc == sizeof (large));
+    send_str (peer, "A3", 0);
+    send_str (peer, "A4", ZMQ_SNDMORE);
+    send_str (peer, "B4", 0);
+    large [0] = 'A';
+    rc = zmq_send (peer, large, sizeof (large), 0);
+    assert (rc == sizeof (large));
+    send_str (peer, "A5", 0);
+
+    recv_str (sub, "A4");
+    int more;
+    size = sizeof (int);
+    rc = zmq_getsockopt (sub, ZMQ_RCVMORE, &more, &size);
+    assert (rc == 0 && more);
+    recv_str (sub, "B4");
+    char buff [sizeof (large)];
+    rc = zmq_recv (sub, buff, sizeof (buff), 0);
+    assert (rc == sizeof (large) && memcmp (buff, large, rc) == 0);
+    recv_str (sub, "A5");
+
+    //  Changes of the subscriptions apply to the filter as well.
+    rc = zmq_setsockopt (sub, ZMQ_UNSUBSCRIBE, "A", 1);
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "CC", 2);
+    assert (rc == 0);
+    rc = zmq_recv (peer, buff, sizeof (buff), 0);
+    assert (rc == 2 && buff [0] == 0 && buff [1] == 'A');
+    recv_str (peer, "\1CC");
+    send_str (peer, "A6", 0);
+    send_str (peer, "C6", 0);
+    send_str (peer, "CC6", 0);
+    recv_str (sub, "CC6");
+
+    rc = zmq_close (peer);
+    assert (rc == 0);
+    rc = zmq_close (sub);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,109 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+
+#include "testutil.hpp"
+#include "../src/stdint.hpp"
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  Create pair of sockets, each with byte high watermark of 1000 and
+    //  message high watermark high enough not to interfere. Thus the total
+    //  buffer space should be 2000 bytes.
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int hwm = 1000;
+    int rc = zmq_setsockopt (sb, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    int64_t hwm_bytes = 1000;
+    rc = zmq_setsockopt (sb, ZMQ_RCVHWM_BYTES, &hwm_bytes, sizeof (hwm_bytes));
+    assert (rc == 0);
+    rc = zmq_bind (sb, "inproc://a");
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM_BYTES, &hwm_bytes, sizeof (hwm_bytes));
+    assert (rc == 0);
+    rc = zmq_connect (sc, "inproc://a");
+    assert (rc == 0);
+
+    //  Check the option can be retrieved and rejects negative values.
+    int64_t value;
+    size_t size = sizeof (value);
+    rc = zmq_getsockopt (sc, ZMQ_SNDHWM_BYTES, &value, &size);
+    assert (rc == 0 && size == sizeof (value) && value == 1000);
+    value = -1;
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM_BYTES, &value, sizeof (value));
+    assert (rc == -1 && errno == EINVAL);
+
+    //  Try to send 30 messages of 100 bytes. Only 20 should succeed.
+    char buf [100];
+    memset (buf, 0, sizeof (buf));
+    for (int i = 0; i < 30; i++)
+    {
+        int rc = zmq_send (sc, buf, sizeof (buf), ZMQ_DONTWAIT);
+        if (i < 20)
+            assert (rc == 100);
+        else
+            assert (rc < 0 && errno == EAGAIN);
+    }
+
+    //  There should be now 20 messages pending, consume them.
+    for (int i = 0; i != 20; i++) {
+        rc = zmq_recv (sb, buf, sizeof (buf), 0);
+        assert (rc == 100);
+    }
+
+    //  Now it should be possible to send one more.
+    rc = zmq_send (sc, buf, sizeof (buf), 0);
+    assert (rc == 100);
+
+    //  The limit is soft, message larger than the limit gets through.
+    char large [5000];
+    memset (large, 0, sizeof (large));
+    rc = zmq_send (sc, large, sizeof (large), ZMQ_DONTWAIT);
+    assert (rc == 5000);
+    rc = zmq_send (sc, buf, sizeof (buf), ZMQ_DONTWAIT);
+    assert (rc < 0 && errno == EAGAIN);
+
+    //  Consume the remaining messages.
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == 100);
+    rc = zmq_recv (sb, large, sizeof (large), 0);
+    assert (rc == 5000);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
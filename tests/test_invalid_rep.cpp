@@ -46,26 +46,26 @@ int main (int argc, char *argv [])
     assert (rc == 1);
 
     //  Receive the request.
-    char addr [4];
+    char addr [8];
     char seqn [4];
     char body [1];
     rc = zmq_recv (xrep_socket, addr, sizeof (addr), 0);
-    assert (rc == 4);
+    assert (rc == 8);
     rc = zmq_recv (xrep_socket, seqn, sizeof (seqn), 0);
     assert (rc == 4);
     rc = zmq_recv (xrep_socket, body, sizeof (body), 0);
     assert (rc == 1);
 
     //  Send invalid reply (addr not label).
-    rc = zmq_send (xrep_socket, addr, 4, 0);
-    assert (rc == 4);
+    rc = zmq_send (xrep_socket, addr, 8, 0);
+    assert (rc == 8);
 
     rc = zmq_recv (req_socket, body, sizeof (body), ZMQ_DONTWAIT);
     assert (rc == -1);
 
     //  Send invalid reply (ID not label).
-    rc = zmq_send (xrep_socket, addr, 4, ZMQ_SNDLABEL);
-    assert (rc == 4);
+    rc = zmq_send (xrep_socket, addr, 8, ZMQ_SNDLABEL);
+    assert (rc == 8);
     rc = zmq_send (xrep_socket, seqn, 4, 0);             // right ID, not label!
     assert (rc == 4);
 
@@ -75,8 +75,8 @@ int main (int argc, char *argv [])
     // Send invalid reply (bad ID labels, followed by good label, invalid data),
     // ensuring that we always discard entire message (and not leak), if ID
     // is found to be invalid.
-    rc = zmq_send (xrep_socket, addr, 4, ZMQ_SNDLABEL);  // right address
-    assert (rc == 4);
+    rc = zmq_send (xrep_socket, addr, 8, ZMQ_SNDLABEL);  // right address
+    assert (rc == 8);
     rc = zmq_send (xrep_socket, seqn, 3, ZMQ_SNDLABEL);  // wrong ID size
     assert (rc == 3);
     rc = zmq_send (xrep_socket, seqn, 3, ZMQ_SNDLABEL);  // ''
@@ -98,10 +98,10 @@ int main (int argc, char *argv [])
     assert (rc == -1);
 
     // Send invalid reply (bad ID label, followed by good label, invalid data).
-    rc = zmq_send (xrep_socket, addr, 4, ZMQ_SNDLABEL);  // right address
-    assert (rc == 4);
-    rc = zmq_send (xrep_socket, addr, 4, ZMQ_SNDLABEL);  // wrong ID value
-    assert (rc == 4);
+    rc = zmq_send (xrep_socket, addr, 8, ZMQ_SNDLABEL);  // right address
+    assert (rc == 8);
+    rc = zmq_send (xrep_socket, addr, 8, ZMQ_SNDLABEL);  // wrong ID value
+    assert (rc == 8);
     rc = zmq_send (xrep_socket, seqn, 4, ZMQ_SNDLABEL);  // right ID!
     assert (rc == 4);
     rc = zmq_send (xrep_socket, seqn, 4, ZMQ_SNDLABEL);  // ''
@@ -113,12 +113,12 @@ int main (int argc, char *argv [])
     assert (rc == -1);
 
     // Send invalid reply (not label, followed by good label, invalid data).
-    rc = zmq_send (xrep_socket, addr, 4, ZMQ_SNDLABEL);  // right address
-    assert (rc == 4);
+    rc = zmq_send (xrep_socket, addr, 8, ZMQ_SNDLABEL);  // right address
+    assert (rc == 8);
     rc = zmq_send (xrep_socket, seqn, 4, ZMQ_SNDMORE);   // right ID, but not a label
     assert (rc == 4);
-    rc = zmq_send (xrep_socket, addr, 4, ZMQ_SNDLABEL);  // right address
-    assert (rc == 4);
+    rc = zmq_send (xrep_socket, addr, 8, ZMQ_SNDLABEL);  // right address
+    assert (rc == 8);
     rc = zmq_send (xrep_socket, seqn, 4, ZMQ_SNDLABEL);  // right ID!
     assert (rc == 4);
     rc = zmq_send (xrep_socket, "x", 1, 0);              // but bad data
@@ -129,8 +129,8 @@ int main (int argc, char *argv [])
 
 
     // Send valid reply.
-    rc = zmq_send (xrep_socket, addr, 4, ZMQ_SNDLABEL);
-    assert (rc == 4);
+    rc = zmq_send (xrep_socket, addr, 8, ZMQ_SNDLABEL);
+    assert (rc == 8);
     rc = zmq_send (xrep_socket, seqn, 4, ZMQ_SNDLABEL);
     assert (rc == 4);
     rc = zmq_send (xrep_socket, "b", 1, 0);
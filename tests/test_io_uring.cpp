@@ -0,0 +1,115 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+
+#include "testutil.hpp"
+
+int main (int argc, char *argv [])
+{
+    //  A context with no sockets can be terminated straight away.
+    void *ctx = zmq_init (1);
+    assert (ctx);
+    int rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    //  The option is accepted even if io_uring is not available, in which
+    //  case the I/O thread falls back to epoll.
+    ctx = zmq_init (1);
+    assert (ctx);
+    rc = zmq_ctx_get (ctx, ZMQ_IO_URING);
+    assert (rc == 0);
+    rc = zmq_ctx_set (ctx, ZMQ_IO_URING, 1);
+    assert (rc == 0);
+    rc = zmq_ctx_get (ctx, ZMQ_IO_URING);
+    assert (rc == 1);
+
+    void *sb = zmq_socket (ctx, ZMQ_REP);
+    assert (sb);
+
+    //  Once the I/O threads are running, the option can't be changed.
+    rc = zmq_ctx_set (ctx, ZMQ_IO_URING, 0);
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_ctx_get (ctx, ZMQ_IO_URING);
+    assert (rc == 1);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5572");
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_REQ);
+    assert (sc);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5572");
+    assert (rc == 0);
+
+    for (int i = 0; i != 100; i++)
+        bounce (sb, sc);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    //  Stream enough data with low high water marks to make the I/O thread
+    //  switch polling for output on and off repeatedly.
+    sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int hwm = 10;
+    rc = zmq_setsockopt (sb, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5573");
+    assert (rc == 0);
+
+    sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5573");
+    assert (rc == 0);
+
+    const int count = 5000;
+    const size_t size = 10000;
+    static char buf [size];
+    for (int i = 0; i != count; i++) {
+        memset (buf, (unsigned char) i, size);
+        rc = zmq_send (sc, buf, size, 0);
+        assert (rc == (int) size);
+
+        if (i % 50 == 49) {
+            for (int j = i - 49; j <= i; j++) {
+                rc = zmq_recv (sb, buf, size, 0);
+                assert (rc == (int) size);
+                assert (buf [0] == (char) j && buf [size - 1] == (char) j);
+            }
+        }
+    }
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,190 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+
+static void send_str (void *s_, const char *str_, int flags_)
+{
+    int rc = zmq_send (s_, str_, strlen (str_), flags_);
+    assert (rc == (int) strlen (str_));
+}
+
+static void recv_str (void *s_, const char *str_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), 0);
+    assert (rc == (int) strlen (str_));
+    assert (memcmp (buff, str_, rc) == 0);
+}
+
+static void recv_none (void *s_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (0);
+    assert (ctx);
+
+    //  Publisher caching the last message of each topic. The topic is
+    //  the first byte of the message.
+    void *pub = zmq_socket (ctx, ZMQ_XPUB);
+    assert (pub);
+    int length = 1;
+    int rc = zmq_setsockopt (pub, ZMQ_TOPIC_LENGTH, &length, sizeof (int));
+    assert (rc == 0);
+    int last_value = 1;
+    rc = zmq_setsockopt (pub, ZMQ_LAST_VALUE, &last_value, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_bind (pub, "inproc://a");
+    assert (rc == 0);
+
+    //  Publish before there are any subscribers.
+    send_str (pub, "A1", 0);
+    send_str (pub, "B1", 0);
+    send_str (pub, "A2", 0);
+    send_str (pub, "C", ZMQ_SNDMORE);
+    send_str (pub, "body", 0);
+
+    //  New subscriber gets the last message of the subscribed topic. Wait
+    //  till the publisher processes the subscription.
+    void *sub1 = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub1);
+    rc = zmq_connect (sub1, "inproc://a");
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub1, ZMQ_SUBSCRIBE, "A", 1);
+    assert (rc == 0);
+    recv_str (pub, "\1A");
+    recv_str (sub1, "A2");
+    recv_none (sub1);
+
+    //  Subscriber to all the topics gets all the cached messages,
+    //  including the multi-part one.
+    void *sub2 = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub2);
+    rc = zmq_connect (sub2, "inproc://a");
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub2, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    recv_str (pub, "\1");
+    recv_str (sub2, "A2");
+    recv_str (sub2, "B1");
+    recv_str (sub2, "C");
+    int more;
+    size_t more_size = sizeof (more);
+    rc = zmq_getsockopt (sub2, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0 && more);
+    recv_str (sub2, "body");
+    recv_none (sub2);
+
+    //  Live messages update the cache and reach the existing subscribers.
+    send_str (pub, "B2", 0);
+    recv_str (sub2, "B2");
+    recv_none (sub1);
+
+    //  Only publishers can cache the messages.
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    rc = zmq_setsockopt (push, ZMQ_LAST_VALUE, &last_value, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+
+    //  The topics have to be defined for the cache to be bounded.
+    void *pub2 = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub2);
+    rc = zmq_setsockopt (pub2, ZMQ_LAST_VALUE, &last_value, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+    int delimiter = '.';
+    rc = zmq_setsockopt (pub2, ZMQ_TOPIC_DELIMITER, &delimiter, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_setsockopt (pub2, ZMQ_LAST_VALUE, &last_value, sizeof (int));
+    assert (rc == 0);
+    delimiter = -1;
+    rc = zmq_setsockopt (pub2, ZMQ_TOPIC_DELIMITER, &delimiter, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+
+    rc = zmq_close (pub2);
+    assert (rc == 0);
+
+    //  More cached messages than the pipe to the subscriber can hold. The
+    //  rest is dropped, but the pipe is activated once the subscriber reads
+    //  the messages and the live messages get through again.
+    void *pub3 = zmq_socket (ctx, ZMQ_XPUB);
+    assert (pub3);
+    int hwm = 2;
+    rc = zmq_setsockopt (pub3, ZMQ_SNDHWM, &hwm, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_setsockopt (pub3, ZMQ_TOPIC_LENGTH, &length, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_setsockopt (pub3, ZMQ_LAST_VALUE, &last_value, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_bind (pub3, "inproc://b");
+    assert (rc == 0);
+    char topic [2] = {0, 0};
+    for (int i = 0; i != 20; i++) {
+        topic [0] = 'a' + i;
+        send_str (pub3, topic, 0);
+    }
+    void *sub3 = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub3);
+    rc = zmq_setsockopt (sub3, ZMQ_RCVHWM, &hwm, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_connect (sub3, "inproc://b");
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub3, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    recv_str (pub3, "\1");
+    char buff [32];
+    int count = 0;
+    while (zmq_recv (sub3, buff, sizeof (buff), ZMQ_DONTWAIT) == 1)
+        count++;
+    assert (count > 0 && count < 20);
+
+    //  Let the publisher process the activation of the pipe.
+    int events;
+    size_t events_size = sizeof (events);
+    rc = zmq_getsockopt (pub3, ZMQ_EVENTS, &events, &events_size);
+    assert (rc == 0);
+    send_str (pub3, "z", 0);
+    recv_str (sub3, "z");
+
+    rc = zmq_close (sub3);
+    assert (rc == 0);
+    rc = zmq_close (pub3);
+    assert (rc == 0);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+    rc = zmq_close (sub1);
+    assert (rc == 0);
+    rc = zmq_close (sub2);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,165 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+#include "../src/stdint.hpp"
+
+#if defined ZMQ_HAVE_MEMFD
+
+//  Returns true if the data are mapped from a memory file created by 0MQ.
+static bool is_memfd (void *data_)
+{
+    FILE *maps = fopen ("/proc/self/maps", "r");
+    assert (maps);
+    char line [512];
+    bool found = false;
+    while (!found && fgets (line, sizeof (line), maps)) {
+        unsigned long start, end;
+        if (sscanf (line, "%lx-%lx", &start, &end) == 2 &&
+              (unsigned long) data_ >= start && (unsigned long) data_ < end)
+            found = strstr (line, "memfd:zmq-msg") != NULL;
+    }
+    fclose (maps);
+    return found;
+}
+
+#endif
+
+static void send_buf (void *s_, unsigned char *buf_, size_t size_,
+    int fill_, int flags_)
+{
+    memset (buf_, fill_, size_);
+    int rc = zmq_send (s_, buf_, size_, flags_);
+    assert (rc == (int) size_);
+}
+
+static void recv_buf (void *s_, size_t size_, int fill_, bool more_)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init (&msg);
+    assert (rc == 0);
+    rc = zmq_recvmsg (s_, &msg, 0);
+    assert (rc == (int) size_);
+    unsigned char *data = (unsigned char*) zmq_msg_data (&msg);
+    for (size_t i = 0; i != size_; i++)
+        assert (data [i] == fill_);
+
+    //  The content can be modified even if it's mapped from a memory file.
+    if (size_)
+        data [0] = ~fill_;
+
+    int more;
+    size_t more_size = sizeof (int);
+    rc = zmq_getsockopt (s_, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0 && (more ? true : false) == more_);
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    int64_t threshold = -1;
+    int rc = zmq_setsockopt (sb, ZMQ_MEMFD_THRESHOLD, &threshold,
+        sizeof (threshold));
+    assert (rc == -1 && errno == EINVAL);
+    threshold = 65536;
+    rc = zmq_setsockopt (sb, ZMQ_MEMFD_THRESHOLD, &threshold,
+        sizeof (threshold));
+    assert (rc == 0);
+    threshold = 0;
+    size_t size = sizeof (threshold);
+    rc = zmq_getsockopt (sb, ZMQ_MEMFD_THRESHOLD, &threshold, &size);
+    assert (rc == 0 && size == sizeof (threshold) && threshold == 65536);
+    rc = zmq_bind (sb, "ipc:///tmp/test_memfd");
+    assert (rc == 0);
+
+    //  The connecting side sends all the messages through the socket.
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    rc = zmq_connect (sc, "ipc:///tmp/test_memfd");
+    assert (rc == 0);
+
+    const size_t sizes [] = {0, 10, 65535, 65536, 1000000, 5000000};
+    const int count = sizeof (sizes) / sizeof (sizes [0]);
+    unsigned char *buf = (unsigned char*) malloc (5000000);
+    assert (buf);
+    for (int i = 0; i != count; i++) {
+        send_buf (sb, buf, sizes [i], i + 1, 0);
+        recv_buf (sc, sizes [i], i + 1, false);
+        send_buf (sc, buf, sizes [i], i + 2, 0);
+        recv_buf (sb, sizes [i], i + 2, false);
+    }
+
+#if defined ZMQ_HAVE_MEMFD
+    //  Check that the large messages are actually passed as memory files
+    //  and the small ones are not.
+    send_buf (sb, buf, 100000, 'E', 0);
+    send_buf (sb, buf, 100, 'F', 0);
+    zmq_msg_t msg;
+    rc = zmq_msg_init (&msg);
+    assert (rc == 0);
+    rc = zmq_recvmsg (sc, &msg, 0);
+    assert (rc == 100000);
+    assert (is_memfd (zmq_msg_data (&msg)));
+    rc = zmq_recvmsg (sc, &msg, 0);
+    assert (rc == 100);
+    assert (!is_memfd (zmq_msg_data (&msg)));
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+#endif
+
+    //  Multi-part messages mixing both kinds of message parts.
+    send_buf (sb, buf, 10, 'A', ZMQ_SNDMORE);
+    send_buf (sb, buf, 100000, 'B', ZMQ_SNDMORE);
+    send_buf (sb, buf, 200000, 'C', ZMQ_SNDMORE);
+    send_buf (sb, buf, 20, 'D', 0);
+    recv_buf (sc, 10, 'A', true);
+    recv_buf (sc, 100000, 'B', true);
+    recv_buf (sc, 200000, 'C', true);
+    recv_buf (sc, 20, 'D', false);
+
+    //  Many memory files queued at once.
+    for (int i = 0; i != 100; i++)
+        send_buf (sb, buf, i % 2 ? 100 : 100000, i, 0);
+    for (int i = 0; i != 100; i++)
+        recv_buf (sc, i % 2 ? 100 : 100000, i, false);
+
+    free (buf);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,183 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+
+#include "../include/zmq.h"
+
+const int batch = 10;
+
+static void fill (zmq_msg_t *msgs_, int count_, int first_)
+{
+    for (int i = 0; i != count_; i++) {
+        int rc = zmq_msg_init_size (&msgs_ [i], sizeof (int));
+        assert (rc == 0);
+        int value = first_ + i;
+        memcpy (zmq_msg_data (&msgs_ [i]), &value, sizeof (int));
+    }
+}
+
+static void check (zmq_msg_t *msgs_, int count_, int first_)
+{
+    for (int i = 0; i != count_; i++) {
+        assert (zmq_msg_size (&msgs_ [i]) == sizeof (int));
+        int value;
+        memcpy (&value, zmq_msg_data (&msgs_ [i]), sizeof (int));
+        assert (value == first_ + i);
+    }
+}
+
+static void close_all (zmq_msg_t *msgs_, int count_)
+{
+    for (int i = 0; i != count_; i++) {
+        int rc = zmq_msg_close (&msgs_ [i]);
+        assert (rc == 0);
+    }
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int rc = zmq_bind (sb, "inproc://mmsg_test");
+    assert (rc == 0);
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_connect (sc, "inproc://mmsg_test");
+    assert (rc == 0);
+
+    zmq_msg_t out [batch];
+    zmq_msg_t in [batch];
+    for (int i = 0; i != batch; i++) {
+        rc = zmq_msg_init (&in [i]);
+        assert (rc == 0);
+    }
+
+    //  Empty batches are rejected.
+    rc = zmq_sendmmsg (sc, out, 0, 0);
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_recvmmsg (sb, in, 0, 0);
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_recvmmsg (sb, in, batch, ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  Batch sent is received as a whole and in order.
+    fill (out, batch, 0);
+    rc = zmq_sendmmsg (sc, out, batch, 0);
+    assert (rc == batch);
+    close_all (out, batch);
+    rc = zmq_recvmmsg (sb, in, batch, 0);
+    assert (rc == batch);
+    check (in, batch, 0);
+
+    //  Batches can be received in smaller chunks.
+    fill (out, batch, 100);
+    rc = zmq_sendmmsg (sc, out, batch, 0);
+    assert (rc == batch);
+    close_all (out, batch);
+    rc = zmq_recvmmsg (sb, in, 3, 0);
+    assert (rc == 3);
+    check (in, 3, 100);
+    rc = zmq_recvmmsg (sb, in, batch, 0);
+    assert (rc == batch - 3);
+    check (in, batch - 3, 103);
+
+    //  Messages sent one by one are received in a batch.
+    for (int i = 0; i != 5; i++) {
+        fill (out, 1, 200 + i);
+        rc = zmq_sendmsg (sc, &out [0], 0);
+        assert (rc == sizeof (int));
+        close_all (out, 1);
+    }
+    rc = zmq_recvmmsg (sb, in, batch, 0);
+    assert (rc == 5);
+    check (in, 5, 200);
+
+    //  Reception stops at the first part of a multipart message.
+    fill (out, 3, 300);
+    rc = zmq_sendmmsg (sc, out, 3, ZMQ_SNDMORE);
+    assert (rc == 3);
+    close_all (out, 3);
+    fill (out, 1, 303);
+    rc = zmq_sendmsg (sc, &out [0], 0);
+    assert (rc == sizeof (int));
+    close_all (out, 1);
+    rc = zmq_recvmmsg (sb, in, batch, 0);
+    assert (rc == 3);
+    check (in, 3, 300);
+    int more;
+    size_t more_size = sizeof (more);
+    rc = zmq_getsockopt (sb, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0 && more);
+    rc = zmq_recvmmsg (sb, in, batch, 0);
+    assert (rc == 1);
+    check (in, 1, 303);
+    rc = zmq_getsockopt (sb, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0 && !more);
+
+    close_all (in, batch);
+
+    //  Batches are distributed to all the subscribers.
+    void *pub = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub);
+    rc = zmq_bind (pub, "inproc://mmsg_pub");
+    assert (rc == 0);
+    void *subs [2];
+    for (int i = 0; i != 2; i++) {
+        subs [i] = zmq_socket (ctx, ZMQ_SUB);
+        assert (subs [i]);
+        rc = zmq_setsockopt (subs [i], ZMQ_SUBSCRIBE, "", 0);
+        assert (rc == 0);
+        rc = zmq_connect (subs [i], "inproc://mmsg_pub");
+        assert (rc == 0);
+    }
+    fill (out, batch, 400);
+    rc = zmq_sendmmsg (pub, out, batch, 0);
+    assert (rc == batch);
+    close_all (out, batch);
+    for (int i = 0; i != 2; i++) {
+        for (int j = 0; j != batch; j++) {
+            rc = zmq_msg_init (&in [j]);
+            assert (rc == 0);
+        }
+        rc = zmq_recvmmsg (subs [i], in, batch, 0);
+        assert (rc == batch);
+        check (in, batch, 400);
+        close_all (in, batch);
+        rc = zmq_close (subs [i]);
+        assert (rc == 0);
+    }
+
+    rc = zmq_close (pub);
+    assert (rc == 0);
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,113 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+
+#include "../include/zmq.h"
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  The pool is off by default and unknown options are rejected.
+    int rc = zmq_ctx_get (ctx, ZMQ_MSG_POOL);
+    assert (rc == 0);
+    rc = zmq_ctx_set (ctx, 1000, 1);
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 1);
+    assert (rc == 0);
+    rc = zmq_ctx_get (ctx, ZMQ_MSG_POOL);
+    assert (rc == 1);
+
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5570");
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5570");
+    assert (rc == 0);
+
+    //  Messages of various sizes, including ones bigger than the largest
+    //  pooled block, are allocated in this thread, released by the I/O
+    //  thread and re-allocated by the decoder, so that blocks have to move
+    //  between threads in batches.
+    const int count = 20000;
+    const size_t sizes [] = {30, 100, 500, 2000, 9000, 70000};
+    const int nsizes = sizeof (sizes) / sizeof (sizes [0]);
+    for (int i = 0; i != count; i++) {
+        size_t size = sizes [i % nsizes];
+        zmq_msg_t msg;
+        rc = zmq_msg_init_size (&msg, size);
+        assert (rc == 0);
+        memset (zmq_msg_data (&msg), (unsigned char) i, size);
+        rc = zmq_sendmsg (sc, &msg, 0);
+        assert (rc == (int) size);
+        rc = zmq_msg_close (&msg);
+        assert (rc == 0);
+
+        //  Keep the number of messages in flight bounded.
+        if (i % 100 == 99) {
+            for (int j = i - 99; j <= i; j++) {
+                size_t expected = sizes [j % nsizes];
+                rc = zmq_msg_init (&msg);
+                assert (rc == 0);
+                rc = zmq_recvmsg (sb, &msg, 0);
+                assert (rc == (int) expected);
+                unsigned char *data = (unsigned char*) zmq_msg_data (&msg);
+                assert (data [0] == (unsigned char) j);
+                assert (data [expected - 1] == (unsigned char) j);
+                rc = zmq_msg_close (&msg);
+                assert (rc == 0);
+            }
+        }
+    }
+
+    //  Copies of a pooled message share the same block.
+    zmq_msg_t msg1, msg2;
+    rc = zmq_msg_init_size (&msg1, 1000);
+    assert (rc == 0);
+    memset (zmq_msg_data (&msg1), 'x', 1000);
+    rc = zmq_msg_init (&msg2);
+    assert (rc == 0);
+    rc = zmq_msg_copy (&msg2, &msg1);
+    assert (rc == 0);
+    assert (zmq_msg_data (&msg1) == zmq_msg_data (&msg2));
+    rc = zmq_msg_close (&msg1);
+    assert (rc == 0);
+    assert (((char*) zmq_msg_data (&msg2)) [999] == 'x');
+    rc = zmq_msg_close (&msg2);
+    assert (rc == 0);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
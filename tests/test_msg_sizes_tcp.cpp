@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+
+//  Sizes chosen to hit the boundaries of the wire format (one and eight
+//  byte length), of the batch buffers and of the sizes above which message
+//  bodies are written and read directly from and to the message.
+static const size_t sizes [] = {0, 1, 29, 30, 253, 254, 1023, 1024, 1025,
+    5000, 8191, 8192, 8193, 100000};
+static const int nsizes = sizeof (sizes) / sizeof (sizes [0]);
+
+static void fill (unsigned char *data_, size_t size_, int seed_)
+{
+    for (size_t i = 0; i != size_; i++)
+        data_ [i] = (unsigned char) (seed_ + i * 7);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    int rc = zmq_bind (sb, "tcp://127.0.0.1:5571");
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5571");
+    assert (rc == 0);
+
+    //  Send all the sizes in different orders, every third message being
+    //  a multi-part one, so that small and large chunks get interleaved
+    //  within the same batch.
+    for (int round = 0; round != 10; round++) {
+        for (int i = 0; i != nsizes; i++) {
+            size_t size = sizes [(i * (round + 1)) % nsizes];
+            zmq_msg_t msg;
+            rc = zmq_msg_init_size (&msg, size);
+            assert (rc == 0);
+            fill ((unsigned char*) zmq_msg_data (&msg), size, round + i);
+            rc = zmq_sendmsg (sc, &msg, i % 3 == 0 ? ZMQ_SNDMORE : 0);
+            assert (rc == (int) size);
+            rc = zmq_msg_close (&msg);
+            assert (rc == 0);
+        }
+        rc = zmq_send (sc, NULL, 0, 0);
+        assert (rc == 0);
+    }
+
+    //  Receive them and check the content byte by byte.
+    unsigned char *expected = new unsigned char [100000];
+    for (int round = 0; round != 10; round++) {
+        for (int i = 0; i != nsizes; i++) {
+            size_t size = sizes [(i * (round + 1)) % nsizes];
+            zmq_msg_t msg;
+            rc = zmq_msg_init (&msg);
+            assert (rc == 0);
+            rc = zmq_recvmsg (sb, &msg, 0);
+            assert (rc == (int) size);
+            fill (expected, size, round + i);
+            assert (memcmp (zmq_msg_data (&msg), expected, size) == 0);
+            int rcvmore;
+            size_t sz = sizeof (rcvmore);
+            rc = zmq_getsockopt (sb, ZMQ_RCVMORE, &rcvmore, &sz);
+            assert (rc == 0);
+            assert ((rcvmore != 0) == (i % 3 == 0));
+            rc = zmq_msg_close (&msg);
+            assert (rc == 0);
+        }
+        rc = zmq_recv (sb, NULL, 0, 0);
+        assert (rc == 0);
+    }
+    delete [] expected;
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+
+#include "../src/mtrie.hpp"
+
+namespace zmq
+{
+    class pipe_t;
+}
+
+//  The trie only stores the pipe pointers, so any distinct addresses do.
+static char pipes [2];
+static zmq::pipe_t *p1 = (zmq::pipe_t*) &pipes [0];
+static zmq::pipe_t *p2 = (zmq::pipe_t*) &pipes [1];
+
+struct matched_t
+{
+    int p1;
+    int p2;
+};
+
+static void count_pipe (zmq::pipe_t *pipe_, void *arg_)
+{
+    matched_t *matched = (matched_t*) arg_;
+    if (pipe_ == p1)
+        matched->p1++;
+    else if (pipe_ == p2)
+        matched->p2++;
+    else
+        assert (false);
+}
+
+static void count_removed (unsigned char *data_, size_t size_, void *arg_)
+{
+    (*(int*) arg_)++;
+}
+
+//  Matches the topic and checks how many times each pipe was signalled.
+static void check_match (zmq::mtrie_t &trie_, const char *topic_,
+    int p1_, int p2_)
+{
+    matched_t matched = {0, 0};
+    trie_.match ((unsigned char*) topic_, strlen (topic_), count_pipe,
+        &matched);
+    assert (matched.p1 == p1_);
+    assert (matched.p2 == p2_);
+}
+
+static bool add (zmq::mtrie_t &trie_, const char *topic_, zmq::pipe_t *pipe_)
+{
+    return trie_.add ((unsigned char*) topic_, strlen (topic_), pipe_);
+}
+
+static bool rm (zmq::mtrie_t &trie_, const char *topic_, zmq::pipe_t *pipe_)
+{
+    return trie_.rm ((unsigned char*) topic_, strlen (topic_), pipe_);
+}
+
+int main (int argc, char *argv [])
+{
+    //  Nodes without children are looked up and removed from safely.
+    {
+        zmq::mtrie_t trie;
+        check_match (trie, "abc", 0, 0);
+        assert (!rm (trie, "abc", p1));
+        int removed = 0;
+        trie.rm (p1, count_removed, &removed);
+        assert (removed == 0);
+
+        assert (add (trie, "abc", p1));
+        assert (!rm (trie, "abd", p1));
+        assert (!rm (trie, "abcd", p1));
+        assert (rm (trie, "abc", p1));
+        check_match (trie, "abc", 0, 0);
+        assert (!rm (trie, "abc", p1));
+    }
+
+    //  Prefixes, duplicates and nodes split by a shorter subscription.
+    {
+        zmq::mtrie_t trie;
+        assert (add (trie, "abcd", p1));
+        assert (add (trie, "ab", p1));
+        assert (!add (trie, "ab", p2));
+        assert (add (trie, "b", p2));
+        assert (add (trie, "", p2));
+        check_match (trie, "abcde", 2, 2);
+        check_match (trie, "abc", 1, 2);
+        check_match (trie, "a", 0, 1);
+        check_match (trie, "bcd", 0, 2);
+
+        //  The subscription stays while another pipe holds it.
+        assert (!rm (trie, "ab", p1));
+        check_match (trie, "abcde", 1, 2);
+        assert (rm (trie, "ab", p2));
+        check_match (trie, "abcde", 1, 1);
+        assert (rm (trie, "abcd", p1));
+        check_match (trie, "abcde", 0, 1);
+        assert (rm (trie, "", p2));
+        assert (rm (trie, "b", p2));
+        check_match (trie, "bcd", 0, 0);
+    }
+
+    //  Enough children for the node to switch to the table. Removing a pipe
+    //  converts it back to the array and adding children switches it again.
+    {
+        zmq::mtrie_t trie;
+        char topic [3] = "x?";
+        for (int i = 0; i != 40; i++) {
+            topic [1] = (char) ('A' + i);
+            assert (add (trie, topic, p1));
+            if (i % 10 == 0)
+                assert (!add (trie, topic, p2));
+        }
+        int removed = 0;
+        trie.rm (p1, count_removed, &removed);
+        assert (removed == 36);
+        for (int i = 0; i != 40; i++) {
+            topic [1] = (char) ('A' + i);
+            check_match (trie, topic, 0, i % 10 == 0 ? 1 : 0);
+        }
+
+        for (int i = 0; i != 40; i++) {
+            topic [1] = (char) ('A' + i);
+            assert (add (trie, topic, p1) == (i % 10 != 0));
+        }
+        removed = 0;
+        trie.rm (p2, count_removed, &removed);
+        assert (removed == 0);
+        for (int i = 0; i != 40; i++) {
+            topic [1] = (char) ('A' + i);
+            check_match (trie, topic, 1, 0);
+        }
+
+        //  Remove the subscriptions one by one, down to an empty trie.
+        for (int i = 0; i != 40; i++) {
+            topic [1] = (char) ('A' + i);
+            assert (rm (trie, topic, p1));
+            check_match (trie, topic, 0, 0);
+            if (i != 39) {
+                topic [1] = (char) ('A' + 39);
+                check_match (trie, topic, 1, 0);
+            }
+        }
+        check_match (trie, "x", 0, 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+
+static void recv_str (void *s_, const char *str_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), ZMQ_DONTWAIT);
+    assert (rc == (int) strlen (str_));
+    assert (memcmp (buff, str_, rc) == 0);
+}
+
+static void recv_none (void *s_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (0);
+    assert (ctx);
+
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    int hwm = 5;
+    int rc = zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_bind (push, "inproc://a");
+    assert (rc == 0);
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_connect (pull, "inproc://a");
+    assert (rc == 0);
+
+    //  Messages sent without flushing are not passed to the peer till
+    //  the socket is flushed.
+    rc = zmq_send (push, "A", 1, ZMQ_NOFLUSH);
+    assert (rc == 1);
+    rc = zmq_send (push, "B", 1, ZMQ_NOFLUSH);
+    assert (rc == 1);
+    recv_none (pull);
+    rc = zmq_flush (push);
+    assert (rc == 0);
+    recv_str (pull, "A");
+    recv_str (pull, "B");
+    recv_none (pull);
+
+    //  Messages are flushed when the queue is full so that the peer can
+    //  make room for more.
+    int count = 0;
+    while (true) {
+        rc = zmq_send (push, "C", 1, ZMQ_NOFLUSH | ZMQ_DONTWAIT);
+        if (rc == -1)
+            break;
+        assert (rc == 1);
+        count++;
+        recv_none (pull);
+    }
+    assert (errno == EAGAIN && count > 0);
+    for (int i = 0; i != count; i++)
+        recv_str (pull, "C");
+    recv_none (pull);
+
+    //  The same applies to batches of messages.
+    zmq_msg_t msgs [3];
+    for (int i = 0; i != 3; i++) {
+        rc = zmq_msg_init_size (&msgs [i], 1);
+        assert (rc == 0);
+        memcpy (zmq_msg_data (&msgs [i]), "E", 1);
+    }
+    rc = zmq_sendmmsg (push, msgs, 3, ZMQ_NOFLUSH);
+    assert (rc == 3);
+    recv_none (pull);
+    rc = zmq_flush (push);
+    assert (rc == 0);
+    for (int i = 0; i != 3; i++)
+        recv_str (pull, "E");
+    recv_none (pull);
+
+    //  Polling the socket flushes it as well.
+    rc = zmq_send (push, "G", 1, ZMQ_NOFLUSH);
+    assert (rc == 1);
+    recv_none (pull);
+    zmq_pollitem_t item = {push, 0, ZMQ_POLLOUT, 0};
+    rc = zmq_poll (&item, 1, 0);
+    assert (rc == 1);
+    recv_str (pull, "G");
+    recv_none (pull);
+
+    //  The same applies to the sockets polled using zmq_poller.
+    void *pa = zmq_socket (ctx, ZMQ_PAIR);
+    assert (pa);
+    rc = zmq_bind (pa, "inproc://b");
+    assert (rc == 0);
+    void *pb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (pb);
+    rc = zmq_connect (pb, "inproc://b");
+    assert (rc == 0);
+
+    //  Let the socket process the connection of the peer first so that
+    //  the poller has no reason to check the socket but the send.
+    int events;
+    size_t events_size = sizeof (events);
+    rc = zmq_getsockopt (pa, ZMQ_EVENTS, &events, &events_size);
+    assert (rc == 0);
+    void *poller = zmq_poller_new ();
+    assert (poller);
+    rc = zmq_poller_add (poller, pa, NULL, ZMQ_POLLIN);
+    assert (rc == 0);
+    zmq_poller_event_t event;
+    rc = zmq_poller_wait (poller, &event, 1, 0);
+    assert (rc == 0);
+    rc = zmq_send (pa, "H", 1, ZMQ_NOFLUSH);
+    assert (rc == 1);
+    recv_none (pb);
+    rc = zmq_poller_wait (poller, &event, 1, 0);
+    assert (rc == 0);
+    recv_str (pb, "H");
+    recv_none (pb);
+    rc = zmq_poller_destroy (poller);
+    assert (rc == 0);
+    rc = zmq_close (pb);
+    assert (rc == 0);
+    rc = zmq_close (pa);
+    assert (rc == 0);
+
+    //  Only the pipes written to are flushed, but each of them is.
+    void *pull2 = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull2);
+    rc = zmq_connect (pull2, "inproc://a");
+    assert (rc == 0);
+    for (int i = 0; i != 4; i++) {
+        rc = zmq_send (push, "F", 1, ZMQ_NOFLUSH);
+        assert (rc == 1);
+    }
+    recv_none (pull);
+    recv_none (pull2);
+    rc = zmq_flush (push);
+    assert (rc == 0);
+    count = 0;
+    char buff [32];
+    while (zmq_recv (pull, buff, sizeof (buff), ZMQ_DONTWAIT) == 1)
+        count++;
+    assert (count > 0);
+    while (zmq_recv (pull2, buff, sizeof (buff), ZMQ_DONTWAIT) == 1)
+        count++;
+    assert (count == 4);
+    rc = zmq_close (pull2);
+    assert (rc == 0);
+
+    //  Invalid socket.
+    rc = zmq_flush (NULL);
+    assert (rc == -1 && errno == ENOTSOCK);
+
+    rc = zmq_close (push);
+    assert (rc == 0);
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
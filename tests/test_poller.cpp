@@ -0,0 +1,192 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+const int socket_count = 100;
+
+extern "C"
+{
+    void *sender (void *ctx)
+    {
+        //  Give the main thread time to start waiting.
+        zmq_sleep (1);
+        void *s = zmq_socket (ctx, ZMQ_PUSH);
+        assert (s);
+        int rc = zmq_connect (s, "inproc://poller_test_50");
+        assert (rc == 0);
+        rc = zmq_send (s, "ABC", 3, 0);
+        assert (rc == 3);
+        rc = zmq_close (s);
+        assert (rc == 0);
+        return NULL;
+    }
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *poller = zmq_poller_new ();
+    assert (poller);
+
+    //  Create a set of PULL sockets, each with a single PUSH peer.
+    void *pulls [socket_count];
+    void *pushes [socket_count];
+    for (int i = 0; i != socket_count; i++) {
+        char endpoint [32];
+        sprintf (endpoint, "inproc://poller_test_%d", i);
+        pulls [i] = zmq_socket (ctx, ZMQ_PULL);
+        assert (pulls [i]);
+        int rc = zmq_bind (pulls [i], endpoint);
+        assert (rc == 0);
+        rc = zmq_poller_add (poller, pulls [i], &pulls [i], ZMQ_POLLIN);
+        assert (rc == 0);
+        if (i == 50) {
+            pushes [i] = NULL;
+            continue;
+        }
+        pushes [i] = zmq_socket (ctx, ZMQ_PUSH);
+        assert (pushes [i]);
+        rc = zmq_connect (pushes [i], endpoint);
+        assert (rc == 0);
+    }
+
+    //  Adding the same socket twice fails.
+    int rc = zmq_poller_add (poller, pulls [0], NULL, ZMQ_POLLIN);
+    assert (rc == -1 && zmq_errno () == EINVAL);
+
+    //  Nothing is ready.
+    zmq_poller_event_t events [4];
+    rc = zmq_poller_wait (poller, events, 4, 0);
+    assert (rc == 0);
+
+    //  Only the sockets with messages are reported.
+    rc = zmq_send (pushes [10], "ABC", 3, 0);
+    assert (rc == 3);
+    rc = zmq_send (pushes [20], "ABC", 3, 0);
+    assert (rc == 3);
+    rc = zmq_send (pushes [20], "DEF", 3, 0);
+    assert (rc == 3);
+    int found = 0;
+    while (found != 2) {
+        rc = zmq_poller_wait (poller, events, 1, -1);
+        assert (rc == 1);
+        assert (events [0].events == ZMQ_POLLIN);
+        assert (events [0].socket == pulls [10] ||
+            events [0].socket == pulls [20]);
+        assert (events [0].user_data == &pulls [10] ||
+            events [0].user_data == &pulls [20]);
+        char buf [3];
+        rc = zmq_recv (events [0].socket, buf, 3, 0);
+        assert (rc == 3);
+        if (events [0].socket == pulls [10] || memcmp (buf, "DEF", 3) == 0)
+            found++;
+    }
+    rc = zmq_poller_wait (poller, events, 4, 0);
+    assert (rc == 0);
+
+    //  Socket that is not polled for any events is not reported.
+    rc = zmq_poller_modify (poller, pulls [30], 0);
+    assert (rc == 0);
+    rc = zmq_send (pushes [30], "ABC", 3, 0);
+    assert (rc == 3);
+    rc = zmq_poller_wait (poller, events, 4, 100);
+    assert (rc == 0);
+    rc = zmq_poller_modify (poller, pulls [30], ZMQ_POLLIN);
+    assert (rc == 0);
+    rc = zmq_poller_wait (poller, events, 4, 0);
+    assert (rc == 1 && events [0].socket == pulls [30]);
+    char buf [3];
+    rc = zmq_recv (pulls [30], buf, 3, 0);
+    assert (rc == 3);
+
+    //  The wait is woken up by a message sent from a different thread.
+    pthread_t thread;
+    rc = pthread_create (&thread, NULL, sender, ctx);
+    assert (rc == 0);
+    rc = zmq_poller_wait (poller, events, 4, -1);
+    assert (rc == 1 && events [0].socket == pulls [50]);
+    rc = zmq_recv (pulls [50], buf, 3, 0);
+    assert (rc == 3);
+    rc = pthread_join (thread, NULL);
+    assert (rc == 0);
+
+    //  Raw file descriptors are reported as well.
+    int fds [2];
+    rc = pipe (fds);
+    assert (rc == 0);
+    rc = zmq_poller_add_fd (poller, fds [0], NULL, ZMQ_POLLIN);
+    assert (rc == 0);
+    rc = zmq_poller_wait (poller, events, 4, 0);
+    assert (rc == 0);
+    rc = write (fds [1], "A", 1);
+    assert (rc == 1);
+    rc = zmq_poller_wait (poller, events, 4, 0);
+    assert (rc == 1);
+    assert (events [0].socket == NULL && events [0].fd == fds [0]);
+    assert (events [0].events == ZMQ_POLLIN);
+    rc = zmq_poller_remove_fd (poller, fds [0]);
+    assert (rc == 0);
+    rc = zmq_poller_wait (poller, events, 4, 0);
+    assert (rc == 0);
+    close (fds [0]);
+    close (fds [1]);
+
+    //  Sockets removed from the poller or closed are not reported.
+    rc = zmq_poller_remove (poller, pulls [40]);
+    assert (rc == 0);
+    rc = zmq_poller_remove (poller, pulls [40]);
+    assert (rc == -1 && zmq_errno () == EINVAL);
+    rc = zmq_send (pushes [40], "ABC", 3, 0);
+    assert (rc == 3);
+    rc = zmq_close (pulls [60]);
+    assert (rc == 0);
+    pulls [60] = NULL;
+    rc = zmq_poller_wait (poller, events, 4, 100);
+    assert (rc == 0);
+
+    rc = zmq_poller_destroy (poller);
+    assert (rc == 0);
+
+    for (int i = 0; i != socket_count; i++) {
+        if (pulls [i]) {
+            rc = zmq_close (pulls [i]);
+            assert (rc == 0);
+        }
+        if (pushes [i]) {
+            rc = zmq_close (pushes [i]);
+            assert (rc == 0);
+        }
+    }
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+
+static void bounce (void *req_, void *rep_)
+{
+    char buff [32];
+    int rc = zmq_send (req_, "ABC", 3, 0);
+    assert (rc == 3);
+    rc = zmq_recv (rep_, buff, sizeof (buff), 0);
+    assert (rc == 3 && memcmp (buff, "ABC", 3) == 0);
+    rc = zmq_send (rep_, "DEF", 3, 0);
+    assert (rc == 3);
+    rc = zmq_recv (req_, buff, sizeof (buff), 0);
+    assert (rc == 3 && memcmp (buff, "DEF", 3) == 0);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    int rc = zmq_ctx_get (ctx, ZMQ_RESOLVE_TTL);
+    assert (rc == 60000);
+    rc = zmq_ctx_set (ctx, ZMQ_RESOLVE_TTL, -1);
+    assert (rc == -1 && errno == EINVAL);
+
+    void *rep = zmq_socket (ctx, ZMQ_REP);
+    assert (rep);
+    rc = zmq_bind (rep, "tcp://127.0.0.1:5578");
+    assert (rc == 0);
+
+    //  Host names are looked up by the resolver thread.
+    void *req = zmq_socket (ctx, ZMQ_REQ);
+    assert (req);
+    rc = zmq_connect (req, "tcp://localhost:5578");
+    assert (rc == 0);
+    bounce (req, rep);
+    rc = zmq_close (req);
+    assert (rc == 0);
+
+    //  With caching switched off, each connection is looked up anew.
+    rc = zmq_ctx_set (ctx, ZMQ_RESOLVE_TTL, 0);
+    assert (rc == 0);
+    rc = zmq_ctx_get (ctx, ZMQ_RESOLVE_TTL);
+    assert (rc == 0);
+    req = zmq_socket (ctx, ZMQ_REQ);
+    assert (req);
+    rc = zmq_connect (req, "tcp://localhost:5578");
+    assert (rc == 0);
+    bounce (req, rep);
+
+    //  Socket waiting for a lookup can be closed.
+    void *dealer = zmq_socket (ctx, ZMQ_DEALER);
+    assert (dealer);
+    rc = zmq_connect (dealer, "tcp://localhost:5579");
+    assert (rc == 0);
+    rc = zmq_close (dealer);
+    assert (rc == 0);
+
+    rc = zmq_close (req);
+    assert (rc == 0);
+    rc = zmq_close (rep);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,84 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (4);
+    assert (ctx);
+
+    //  Listen in all the I/O threads.
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+    int reuseport = 1;
+    int rc = zmq_setsockopt (pull, ZMQ_REUSEPORT, &reuseport, sizeof (int));
+    assert (rc == 0);
+    reuseport = 0;
+    size_t size = sizeof (int);
+    rc = zmq_getsockopt (pull, ZMQ_REUSEPORT, &reuseport, &size);
+    assert (rc == 0 && reuseport == 1);
+    rc = zmq_bind (pull, "tcp://127.0.0.1:5576");
+    assert (rc == 0);
+
+    //  Binding the same port without the option fails.
+    void *other = zmq_socket (ctx, ZMQ_PULL);
+    assert (other);
+    rc = zmq_bind (other, "tcp://127.0.0.1:5576");
+    assert (rc == -1);
+    rc = zmq_close (other);
+    assert (rc == 0);
+
+    //  Connections accepted by any of the listeners are delivered.
+    const int count = 20;
+    void *push [count];
+    for (int i = 0; i != count; i++) {
+        push [i] = zmq_socket (ctx, ZMQ_PUSH);
+        assert (push [i]);
+        rc = zmq_connect (push [i], "tcp://127.0.0.1:5576");
+        assert (rc == 0);
+        rc = zmq_send (push [i], &i, sizeof (int), 0);
+        assert (rc == sizeof (int));
+    }
+
+    int received [count];
+    memset (received, 0, sizeof (received));
+    for (int i = 0; i != count; i++) {
+        int value;
+        rc = zmq_recv (pull, &value, sizeof (int), 0);
+        assert (rc == sizeof (int));
+        assert (value >= 0 && value < count && !received [value]);
+        received [value] = 1;
+    }
+
+    for (int i = 0; i != count; i++) {
+        rc = zmq_close (push [i]);
+        assert (rc == 0);
+    }
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+const int peer_count = 100;
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *router = zmq_socket (ctx, ZMQ_ROUTER);
+    assert (router);
+    int rc = zmq_bind (router, "inproc://router_test");
+    assert (rc == 0);
+
+    //  Connect a set of peers with explicit identities.
+    void *peers [peer_count];
+    for (int i = 0; i != peer_count; i++) {
+        peers [i] = zmq_socket (ctx, ZMQ_DEALER);
+        assert (peers [i]);
+        char identity [16];
+        sprintf (identity, "peer%d", i);
+        rc = zmq_setsockopt (peers [i], ZMQ_IDENTITY, identity,
+            strlen (identity));
+        assert (rc == 0);
+        rc = zmq_connect (peers [i], "inproc://router_test");
+        assert (rc == 0);
+    }
+
+    //  Route a message to each peer, in reverse order.
+    for (int i = peer_count - 1; i >= 0; i--) {
+        char identity [16];
+        sprintf (identity, "peer%d", i);
+        rc = zmq_send (router, identity, strlen (identity), ZMQ_SNDMORE);
+        assert (rc == (int) strlen (identity));
+        rc = zmq_send (router, &i, sizeof (i), 0);
+        assert (rc == sizeof (i));
+    }
+    for (int i = 0; i != peer_count; i++) {
+        int value;
+        rc = zmq_recv (peers [i], &value, sizeof (value), 0);
+        assert (rc == sizeof (value));
+        assert (value == i);
+    }
+
+    //  Messages for unknown peers are dropped.
+    rc = zmq_send (router, "unknown", 7, ZMQ_SNDMORE);
+    assert (rc == 7);
+    rc = zmq_send (router, "ABC", 3, 0);
+    assert (rc == 3);
+
+    //  Disconnect every other peer. The remaining ones are still reachable.
+    for (int i = 0; i < peer_count; i += 2) {
+        rc = zmq_close (peers [i]);
+        assert (rc == 0);
+        peers [i] = NULL;
+    }
+    zmq_sleep (1);
+    for (int i = 1; i < peer_count; i += 2) {
+        char identity [16];
+        sprintf (identity, "peer%d", i);
+        rc = zmq_send (router, identity, strlen (identity), ZMQ_SNDMORE);
+        assert (rc == (int) strlen (identity));
+        rc = zmq_send (router, &i, sizeof (i), 0);
+        assert (rc == sizeof (i));
+    }
+    for (int i = 1; i < peer_count; i += 2) {
+        int value;
+        rc = zmq_recv (peers [i], &value, sizeof (value), 0);
+        assert (rc == sizeof (value));
+        assert (value == i);
+        rc = zmq_close (peers [i]);
+        assert (rc == 0);
+    }
+
+    rc = zmq_close (router);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+#include "../src/stdint.hpp"
+
+static void send_buf (void *s_, unsigned char *buf_, size_t size_,
+    int fill_, int flags_)
+{
+    memset (buf_, fill_, size_);
+    int rc = zmq_send (s_, buf_, size_, flags_);
+    assert (rc == (int) size_);
+}
+
+static void recv_buf (void *s_, size_t size_, int fill_, bool more_)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init (&msg);
+    assert (rc == 0);
+    rc = zmq_recvmsg (s_, &msg, 0);
+    assert (rc == (int) size_);
+    unsigned char *data = (unsigned char*) zmq_msg_data (&msg);
+    for (size_t i = 0; i != size_; i++)
+        assert (data [i] == fill_);
+    int more;
+    size_t more_size = sizeof (int);
+    rc = zmq_getsockopt (s_, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0 && (more ? true : false) == more_);
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    int rc = zmq_bind (sb, "shm:///tmp/test_shm");
+
+    //  The transport is not available on all the platforms.
+    if (rc == -1 && errno == EPROTONOSUPPORT) {
+        rc = zmq_close (sb);
+        assert (rc == 0);
+        rc = zmq_term (ctx);
+        assert (rc == 0);
+        return 0;
+    }
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    rc = zmq_connect (sc, "shm:///tmp/test_shm");
+    assert (rc == 0);
+
+    //  Small messages are copied through the ring, larger ones are passed
+    //  via slots and the largest ones in chunks.
+    const size_t sizes [] = {0, 10, 8191, 8192, 100000, 1048576, 1048577,
+        3000000};
+    const int count = sizeof (sizes) / sizeof (sizes [0]);
+    unsigned char *buf = (unsigned char*) malloc (3000000);
+    assert (buf);
+    for (int i = 0; i != count; i++) {
+        send_buf (sc, buf, sizes [i], i + 1, 0);
+        recv_buf (sb, sizes [i], i + 1, false);
+        send_buf (sb, buf, sizes [i], i + 2, 0);
+        recv_buf (sc, sizes [i], i + 2, false);
+    }
+
+    //  Multi-part messages.
+    send_buf (sc, buf, 10, 'A', ZMQ_SNDMORE);
+    send_buf (sc, buf, 100000, 'B', ZMQ_SNDMORE);
+    send_buf (sc, buf, 2000000, 'C', 0);
+    recv_buf (sb, 10, 'A', true);
+    recv_buf (sb, 100000, 'B', true);
+    recv_buf (sb, 2000000, 'C', false);
+
+    //  More large messages than there are slots. The ones that don't get
+    //  a slot are passed in chunks.
+    zmq_msg_t msgs [20];
+    for (int i = 0; i != 20; i++)
+        send_buf (sc, buf, 50000, i, 0);
+    for (int i = 0; i != 20; i++) {
+        rc = zmq_msg_init (&msgs [i]);
+        assert (rc == 0);
+        rc = zmq_recvmsg (sb, &msgs [i], 0);
+        assert (rc == 50000);
+    }
+    for (int i = 0; i != 20; i++) {
+        unsigned char *data = (unsigned char*) zmq_msg_data (&msgs [i]);
+        assert (data [0] == i && data [49999] == i);
+        rc = zmq_msg_close (&msgs [i]);
+        assert (rc == 0);
+    }
+
+    //  Fill the rings up to make the peers wait for each other.
+    for (int i = 0; i != 1000; i++)
+        send_buf (sc, buf, 1000, i % 256, 0);
+    for (int i = 0; i != 1000; i++)
+        recv_buf (sb, 1000, i % 256, false);
+
+    //  Messages larger than ZMQ_MAXMSGSIZE are not allocated. The peer
+    //  sending them is disconnected instead.
+    void *sb2 = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb2);
+    int64_t maxmsgsize = 1000000;
+    rc = zmq_setsockopt (sb2, ZMQ_MAXMSGSIZE, &maxmsgsize, sizeof (int64_t));
+    assert (rc == 0);
+    int timeout = 100;
+    rc = zmq_setsockopt (sb2, ZMQ_RCVTIMEO, &timeout, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_bind (sb2, "shm:///tmp/test_shm2");
+    assert (rc == 0);
+    void *sc2 = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc2);
+    rc = zmq_connect (sc2, "shm:///tmp/test_shm2");
+    assert (rc == 0);
+    send_buf (sc2, buf, 3000000, 'D', 0);
+    rc = zmq_recv (sb2, buf, 3000000, 0);
+    assert (rc == -1 && errno == EAGAIN);
+    rc = zmq_close (sc2);
+    assert (rc == 0);
+    rc = zmq_close (sb2);
+    assert (rc == 0);
+
+    free (buf);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
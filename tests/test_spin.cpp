@@ -0,0 +1,139 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+const int roundtrip_count = 10000;
+
+extern "C"
+{
+    void *worker (void *ctx)
+    {
+        //  Echo the requests back.
+        void *s = zmq_socket (ctx, ZMQ_REP);
+        assert (s);
+        int spin = 50;
+        int rc = zmq_setsockopt (s, ZMQ_SPIN, &spin, sizeof (spin));
+        assert (rc == 0);
+        rc = zmq_connect (s, "inproc://spin_test");
+        assert (rc == 0);
+        char buf [32];
+        for (int i = 0; i != roundtrip_count; i++) {
+            rc = zmq_recv (s, buf, 32, 0);
+            assert (rc == 32);
+            rc = zmq_send (s, buf, 32, 0);
+            assert (rc == 32);
+        }
+        rc = zmq_close (s);
+        assert (rc == 0);
+        return NULL;
+    }
+
+    void *blocker (void *ctx)
+    {
+        //  Block until the context is terminated.
+        void *s = zmq_socket (ctx, ZMQ_PULL);
+        assert (s);
+        int spin = 50;
+        int rc = zmq_setsockopt (s, ZMQ_SPIN, &spin, sizeof (spin));
+        assert (rc == 0);
+        char buf [32];
+        rc = zmq_recv (s, buf, 32, 0);
+        assert (rc == -1);
+        assert (zmq_errno () == ETERM);
+        rc = zmq_close (s);
+        assert (rc == 0);
+        return NULL;
+    }
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_REQ);
+    assert (sb);
+    int rc = zmq_bind (sb, "inproc://spin_test");
+    assert (rc == 0);
+
+    //  Check the option value.
+    int spin = -1;
+    rc = zmq_setsockopt (sb, ZMQ_SPIN, &spin, sizeof (spin));
+    assert (rc == -1 && zmq_errno () == EINVAL);
+    spin = 50;
+    rc = zmq_setsockopt (sb, ZMQ_SPIN, &spin, sizeof (spin));
+    assert (rc == 0);
+    spin = 0;
+    size_t spin_size = sizeof (spin);
+    rc = zmq_getsockopt (sb, ZMQ_SPIN, &spin, &spin_size);
+    assert (rc == 0);
+    assert (spin == 50);
+
+    //  Check whether recv timeout is honoured while spinning.
+    char buf [] = "12345678ABCDEFGH12345678abcdefgh";
+    void *s = zmq_socket (ctx, ZMQ_PULL);
+    assert (s);
+    rc = zmq_setsockopt (s, ZMQ_SPIN, &spin, sizeof (spin));
+    assert (rc == 0);
+    int timeout = 500;
+    rc = zmq_setsockopt (s, ZMQ_RCVTIMEO, &timeout, sizeof (timeout));
+    assert (rc == 0);
+    void *watch = zmq_stopwatch_start ();
+    rc = zmq_recv (s, buf, 32, 0);
+    assert (rc == -1);
+    assert (zmq_errno () == EAGAIN);
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    assert (elapsed > 440000 && elapsed < 550000);
+    rc = zmq_close (s);
+    assert (rc == 0);
+
+    //  Ping-pong with the worker, both sides spinning.
+    pthread_t thread;
+    rc = pthread_create (&thread, NULL, worker, ctx);
+    assert (rc == 0);
+    for (int i = 0; i != roundtrip_count; i++) {
+        rc = zmq_send (sb, buf, 32, 0);
+        assert (rc == 32);
+        rc = zmq_recv (sb, buf, 32, 0);
+        assert (rc == 32);
+        assert (memcmp (buf, "12345678ABCDEFGH12345678abcdefgh", 32) == 0);
+    }
+    rc = pthread_join (thread, NULL);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    //  Check that a thread blocked while spinning is woken up by zmq_term.
+    rc = pthread_create (&thread, NULL, blocker, ctx);
+    assert (rc == 0);
+    zmq_sleep (1);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+    rc = pthread_join (thread, NULL);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,179 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+
+static void send_str (void *s_, const char *str_)
+{
+    int rc = zmq_send (s_, str_, strlen (str_), 0);
+    assert (rc == (int) strlen (str_));
+}
+
+static void recv_str (void *s_, const char *str_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), 0);
+    assert (rc == (int) strlen (str_));
+    assert (memcmp (buff, str_, rc) == 0);
+}
+
+//  Unsubscriptions start with a zero byte, so they are passed with
+//  the leading byte separately.
+static void send_unsub (void *s_, const char *topic_)
+{
+    char buff [32];
+    buff [0] = 0;
+    memcpy (buff + 1, topic_, strlen (topic_));
+    int rc = zmq_send (s_, buff, strlen (topic_) + 1, 0);
+    assert (rc == (int) strlen (topic_) + 1);
+}
+
+static void recv_unsub (void *s_, const char *topic_)
+{
+    char buff [32];
+    int rc = zmq_recv (s_, buff, sizeof (buff), 0);
+    assert (rc == (int) strlen (topic_) + 1);
+    assert (buff [0] == 0 && memcmp (buff + 1, topic_, rc - 1) == 0);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (0);
+    assert (ctx);
+
+    //  Publisher matching the first three bytes of the message exactly.
+    void *xpub = zmq_socket (ctx, ZMQ_XPUB);
+    assert (xpub);
+    int length = 3;
+    int rc = zmq_setsockopt (xpub, ZMQ_TOPIC_LENGTH, &length, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_bind (xpub, "inproc://a");
+    assert (rc == 0);
+
+    //  XSUB doesn't filter messages, so all the filtering is done by
+    //  the publisher.
+    void *xsub = zmq_socket (ctx, ZMQ_XSUB);
+    assert (xsub);
+    rc = zmq_connect (xsub, "inproc://a");
+    assert (rc == 0);
+    send_str (xsub, "\1ABC");
+    recv_str (xpub, "\1ABC");
+
+    send_str (xpub, "AB");
+    send_str (xpub, "ABD1");
+    send_str (xpub, "ABC1");
+    send_str (xpub, "ABCD");
+    recv_str (xsub, "ABC1");
+    recv_str (xsub, "ABCD");
+
+    //  Duplicate subscriptions are not passed to the user and the topic
+    //  is unsubscribed once all the subscriptions are removed.
+    send_str (xsub, "\1ABC");
+    send_unsub (xsub, "ABC");
+    send_str (xsub, "\1XYZ");
+    recv_str (xpub, "\1XYZ");
+    send_unsub (xsub, "ABC");
+    recv_unsub (xpub, "ABC");
+    send_str (xpub, "ABC2");
+    send_str (xpub, "XYZ2");
+    recv_str (xsub, "XYZ2");
+
+    //  Subscriber matching the part of the message before the delimiter.
+    //  The publisher does prefix matching. XPUB is used so that we can wait
+    //  for the subscriptions to arrive.
+    void *pub = zmq_socket (ctx, ZMQ_XPUB);
+    assert (pub);
+    rc = zmq_bind (pub, "inproc://b");
+    assert (rc == 0);
+    void *sub = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub);
+    int delimiter = '|';
+    rc = zmq_setsockopt (sub, ZMQ_TOPIC_DELIMITER, &delimiter, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_connect (sub, "inproc://b");
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "ABC", 3);
+    assert (rc == 0);
+    recv_str (pub, "\1ABC");
+
+    send_str (pub, "ABCD|1");
+    send_str (pub, "ABC|2");
+    send_str (pub, "ABCD");
+    send_str (pub, "ABC");
+    recv_str (sub, "ABC|2");
+    recv_str (sub, "ABC");
+
+    //  Empty subscription matches all the messages.
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    recv_str (pub, "\1");
+    send_str (pub, "XYZ|3");
+    recv_str (sub, "XYZ|3");
+
+    //  The options can't be changed once there are peers.
+    delimiter = '#';
+    rc = zmq_setsockopt (sub, ZMQ_TOPIC_DELIMITER, &delimiter, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+    length = 2;
+    rc = zmq_setsockopt (xpub, ZMQ_TOPIC_LENGTH, &length, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+
+    //  Nor once there are subscriptions, even without peers.
+    void *sub2 = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub2);
+    rc = zmq_setsockopt (sub2, ZMQ_TOPIC_LENGTH, &length, sizeof (int));
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub2, ZMQ_SUBSCRIBE, "AB", 2);
+    assert (rc == 0);
+    length = 3;
+    rc = zmq_setsockopt (sub2, ZMQ_TOPIC_LENGTH, &length, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_setsockopt (sub2, ZMQ_UNSUBSCRIBE, "AB", 2);
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub2, ZMQ_TOPIC_LENGTH, &length, sizeof (int));
+    assert (rc == 0);
+
+    //  Invalid option values.
+    delimiter = 256;
+    rc = zmq_setsockopt (sub2, ZMQ_TOPIC_DELIMITER, &delimiter, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+    length = -1;
+    rc = zmq_setsockopt (sub2, ZMQ_TOPIC_LENGTH, &length, sizeof (int));
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_close (sub2);
+    assert (rc == 0);
+
+    rc = zmq_close (xpub);
+    assert (rc == 0);
+    rc = zmq_close (xsub);
+    assert (rc == 0);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+    rc = zmq_close (sub);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
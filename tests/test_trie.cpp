@@ -0,0 +1,177 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+#include <string>
+#include <set>
+
+#include "../src/trie.hpp"
+
+static bool add (zmq::trie_t &trie_, const char *topic_)
+{
+    return trie_.add ((unsigned char*) topic_, strlen (topic_));
+}
+
+static bool rm (zmq::trie_t &trie_, const char *topic_)
+{
+    return trie_.rm ((unsigned char*) topic_, strlen (topic_));
+}
+
+static bool check (zmq::trie_t &trie_, const char *data_)
+{
+    return trie_.check ((unsigned char*) data_, strlen (data_));
+}
+
+static void collect (unsigned char *data_, size_t size_, void *arg_)
+{
+    std::set <std::string> *topics = (std::set <std::string>*) arg_;
+    bool inserted = topics->insert (std::string ((char*) data_, size_)).second;
+    assert (inserted);
+}
+
+//  Checks that the trie holds exactly the topics listed and, unless
+//  a node may still be a table for fewer children than it would be
+//  created with, that it's laid out the same way as a trie built from
+//  them afresh.
+static void check_topics (zmq::trie_t &trie_, const char **topics_,
+    int count_, bool same_layout_ = true)
+{
+    std::set <std::string> topics;
+    trie_.apply (collect, &topics);
+    assert ((int) topics.size () == count_);
+
+    zmq::trie_t fresh;
+    for (int i = 0; i != count_; i++) {
+        assert (topics.count (topics_ [i]) == 1);
+        add (fresh, topics_ [i]);
+    }
+    if (same_layout_)
+        assert (trie_.get_memory () == fresh.get_memory ());
+}
+
+int main (int argc, char *argv [])
+{
+    //  Nodes without children are looked up and removed from safely.
+    {
+        zmq::trie_t trie;
+        assert (!check (trie, "abc"));
+        assert (!rm (trie, "abc"));
+
+        assert (add (trie, "abc"));
+        assert (!check (trie, "ab"));
+        assert (check (trie, "abc"));
+        assert (check (trie, "abcd"));
+        assert (!rm (trie, "abd"));
+        assert (!rm (trie, "abcd"));
+        assert (rm (trie, "abc"));
+        assert (!check (trie, "abcd"));
+        assert (!rm (trie, "abc"));
+        check_topics (trie, NULL, 0);
+    }
+
+    //  Duplicates are reference counted.
+    {
+        zmq::trie_t trie;
+        assert (add (trie, "abc"));
+        assert (!add (trie, "abc"));
+        assert (!rm (trie, "abc"));
+        assert (check (trie, "abc"));
+        assert (rm (trie, "abc"));
+        assert (!check (trie, "abc"));
+    }
+
+    //  Removing a prefix of another subscription leaves the longer one.
+    {
+        zmq::trie_t trie;
+        assert (add (trie, "abc"));
+        assert (add (trie, "abcdef"));
+        assert (rm (trie, "abc"));
+        assert (!check (trie, "abcd"));
+        assert (check (trie, "abcdefg"));
+        const char *topics [] = {"abcdef"};
+        check_topics (trie, topics, 1);
+
+        //  The empty subscription matches everything.
+        assert (add (trie, ""));
+        assert (check (trie, "x"));
+        assert (rm (trie, ""));
+        assert (!check (trie, "x"));
+        check_topics (trie, topics, 1);
+    }
+
+    //  Nodes split by the subscriptions are merged again on removal.
+    {
+        zmq::trie_t trie;
+        assert (add (trie, "abcd"));
+        assert (add (trie, "abxy"));
+        assert (add (trie, "ab"));
+        assert (add (trie, "a"));
+        assert (rm (trie, "ab"));
+        const char *topics1 [] = {"abcd", "abxy", "a"};
+        check_topics (trie, topics1, 3);
+        assert (rm (trie, "abxy"));
+        const char *topics2 [] = {"abcd", "a"};
+        check_topics (trie, topics2, 2);
+        assert (rm (trie, "a"));
+        assert (!check (trie, "abc"));
+        assert (check (trie, "abcde"));
+        const char *topics3 [] = {"abcd"};
+        check_topics (trie, topics3, 1);
+    }
+
+    //  Enough children for the node to switch to the table. Removing them
+    //  converts it back to the array, adding them switches it again.
+    {
+        zmq::trie_t trie;
+        char buf [40][3];
+        const char *topics [40];
+        for (int i = 0; i != 40; i++) {
+            buf [i][0] = 'x';
+            buf [i][1] = (char) ('A' + i);
+            buf [i][2] = 0;
+            topics [i] = buf [i];
+            assert (add (trie, topics [i]));
+        }
+        check_topics (trie, topics, 40);
+
+        for (int i = 39; i != 1; i--) {
+            assert (rm (trie, topics [i]));
+            assert (!check (trie, topics [i]));
+            assert (check (trie, topics [0]));
+            check_topics (trie, topics, i, i > 16 || i <= 8);
+        }
+
+        for (int i = 2; i != 40; i++)
+            assert (add (trie, topics [i]));
+        check_topics (trie, topics, 40);
+
+        //  With the last but one child removed, the node merges with the
+        //  remaining one.
+        for (int i = 0; i != 39; i++)
+            assert (rm (trie, topics [i]));
+        assert (check (trie, topics [39]));
+        check_topics (trie, topics + 39, 1);
+        assert (rm (trie, topics [39]));
+        check_topics (trie, NULL, 0);
+    }
+
+    return 0;
+}
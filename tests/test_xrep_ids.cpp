@@ -0,0 +1,107 @@
+/*
+    Copyright (c) 2007-2011 iMatix Corporation
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+//  Receives a message from the XREP socket and stores the peer ID.
+static void recv_request (void *xrep, unsigned char *peer_id, char body)
+{
+    int rc = zmq_recv (xrep, peer_id, 8, 0);
+    assert (rc == 8);
+    int rcvlabel;
+    size_t sz = sizeof (rcvlabel);
+    rc = zmq_getsockopt (xrep, ZMQ_RCVLABEL, &rcvlabel, &sz);
+    assert (rc == 0);
+    assert (rcvlabel);
+    char buf [1];
+    rc = zmq_recv (xrep, buf, 1, 0);
+    assert (rc == 1);
+    assert (buf [0] == body);
+}
+
+int main (int argc, char *argv [])
+{
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *xrep = zmq_socket (ctx, ZMQ_XREP);
+    assert (xrep);
+    int rc = zmq_bind (xrep, "inproc://xrep_ids");
+    assert (rc == 0);
+
+    //  Get the ID of the first peer.
+    void *a = zmq_socket (ctx, ZMQ_XREQ);
+    assert (a);
+    rc = zmq_connect (a, "inproc://xrep_ids");
+    assert (rc == 0);
+    rc = zmq_send (a, "A", 1, 0);
+    assert (rc == 1);
+    unsigned char id_a [8];
+    recv_request (xrep, id_a, 'A');
+
+    //  Disconnect the first peer and let XREP process the disconnection.
+    rc = zmq_close (a);
+    assert (rc == 0);
+    zmq_sleep (1);
+    char buf [1];
+    rc = zmq_recv (xrep, buf, 1, ZMQ_DONTWAIT);
+    assert (rc == -1 && zmq_errno () == EAGAIN);
+
+    //  The second peer must not get the ID of the first one even though
+    //  the ID of the first one is not used any more.
+    void *b = zmq_socket (ctx, ZMQ_XREQ);
+    assert (b);
+    rc = zmq_connect (b, "inproc://xrep_ids");
+    assert (rc == 0);
+    rc = zmq_send (b, "B", 1, 0);
+    assert (rc == 1);
+    unsigned char id_b [8];
+    recv_request (xrep, id_b, 'B');
+    assert (memcmp (id_a, id_b, 8) != 0);
+
+    //  The reply to the first peer is dropped, the reply to the second one
+    //  is delivered.
+    rc = zmq_send (xrep, id_a, 8, ZMQ_SNDLABEL);
+    assert (rc == 8);
+    rc = zmq_send (xrep, "X", 1, 0);
+    assert (rc == 1);
+    rc = zmq_send (xrep, id_b, 8, ZMQ_SNDLABEL);
+    assert (rc == 8);
+    rc = zmq_send (xrep, "Y", 1, 0);
+    assert (rc == 1);
+    rc = zmq_recv (b, buf, 1, 0);
+    assert (rc == 1);
+    assert (buf [0] == 'Y');
+
+    rc = zmq_close (b);
+    assert (rc == 0);
+
+    rc = zmq_close (xrep);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}